@@ -13,6 +13,7 @@
 #define BITSET_H
 
 #include <cassert>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -25,6 +26,11 @@ class BitsetView {
     BitsetView(const uint8_t* data, size_t num_bits) : bits_(data), num_bits_(num_bits) {
     }
 
+    // `num_filtered_out_bits` is the known popcount of the bitset, so that count() does not scan it again.
+    BitsetView(const uint8_t* data, size_t num_bits, size_t num_filtered_out_bits)
+        : bits_(data), num_bits_(num_bits), num_filtered_out_bits_(num_filtered_out_bits) {
+    }
+
     BitsetView(const std::nullptr_t) : BitsetView() {
     }
 
@@ -55,6 +61,9 @@ class BitsetView {
 
     size_t
     count() const {
+        if (num_filtered_out_bits_ != kUnknownCount) {
+            return num_filtered_out_bits_;
+        }
         size_t ret = 0;
         auto len_uint8 = byte_size();
         auto len_uint64 = len_uint8 >> 3;
@@ -82,6 +91,22 @@ class BitsetView {
         return ret;
     }
 
+    // Return a view of the same bits with the popcount computed once and cached, so that per-query strategy
+    // decisions do not rescan the bitset.
+    BitsetView
+    with_cached_count() const {
+        if (empty() || num_filtered_out_bits_ != kUnknownCount) {
+            return *this;
+        }
+        return BitsetView(bits_, num_bits_, count());
+    }
+
+    // fraction of the bits that are set, i.e. of the rows filtered out
+    float
+    filter_ratio() const {
+        return empty() ? 0.0f : static_cast<float>(count()) / num_bits_;
+    }
+
     std::string
     to_string(size_t from, size_t to) const {
         if (empty()) {
@@ -96,8 +121,11 @@ class BitsetView {
     }
 
  private:
+    static constexpr size_t kUnknownCount = std::numeric_limits<size_t>::max();
+
     const uint8_t* bits_ = nullptr;
     size_t num_bits_ = 0;
+    size_t num_filtered_out_bits_ = kUnknownCount;
 };
 }  // namespace knowhere
 
@@ -22,6 +22,12 @@ class BruteForce {
     static expected<DataSetPtr>
     Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const Json& config, const BitsetView& bitset);
 
+    // Search only the base rows whose ids are listed in `ids_dataset` (see GenIdsDataSet), which is much cheaper than
+    // Search with a bitset when the filter leaves few candidates.
+    static expected<DataSetPtr>
+    SearchByIds(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const DataSetPtr ids_dataset,
+                const Json& config);
+
     static Status
     SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_dataset, int64_t* ids, float* dis,
                   const Json& config, const BitsetView& bitset);
@@ -29,6 +35,12 @@ class BruteForce {
     static expected<DataSetPtr>
     RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const Json& config,
                 const BitsetView& bitset);
+
+    // One iterator per query over all unfiltered base rows, float metrics only. The distances are computed up front,
+    // the iterators only order them as they are consumed.
+    static expected<std::vector<IndexNode::IteratorPtr>>
+    AnnIterator(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const Json& config,
+                const BitsetView& bitset);
 };
 
 }  // namespace knowhere
@@ -0,0 +1,131 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "knowhere/comp/index_param.h"
+#include "knowhere/config.h"
+
+namespace knowhere {
+
+namespace calibration {
+// name of the binset entry holding the recall curve of a calibrated index
+constexpr const char* RECALL_CURVE = "RECALL_CURVE";
+}  // namespace calibration
+
+// Recall@k measured by Index::Calibrate for increasing values of the search width parameter of an index (ef,
+// nprobe or search_list_size), used to resolve the `target_recall` of a search.
+struct RecallCurve {
+    std::string param;
+    int32_t k = 0;
+    // (width, recall), sorted by width, recall is non-decreasing up to measurement noise
+    std::vector<std::pair<int32_t, float>> points;
+
+    // Smallest measured width reaching `target_recall`, none when the target is above every measured recall: the
+    // sweep stopped at the target of Calibrate or at the plateau of the index, a larger width is not known to reach it.
+    std::optional<int32_t>
+    WidthFor(float target_recall) const {
+        for (const auto& [width, recall] : points) {
+            if (recall >= target_recall) {
+                return width;
+            }
+        }
+        return std::nullopt;
+    }
+
+    float
+    BestRecall() const {
+        float best = 0.0f;
+        for (const auto& point : points) {
+            best = std::max(best, point.second);
+        }
+        return best;
+    }
+
+    Json
+    ToJson() const {
+        Json json;
+        json["param"] = param;
+        json["k"] = k;
+        json["points"] = points;
+        return json;
+    }
+
+    static std::optional<RecallCurve>
+    FromJson(const Json& json) {
+        try {
+            RecallCurve curve;
+            curve.param = json.at("param").get<std::string>();
+            curve.k = json.at("k").get<int32_t>();
+            curve.points = json.at("points").get<std::vector<std::pair<int32_t, float>>>();
+            if (curve.points.empty()) {
+                return std::nullopt;
+            }
+            return curve;
+        } catch (const Json::exception&) {
+            return std::nullopt;
+        }
+    }
+};
+
+// Search width parameter swept by Index::Calibrate for an index type, `at_least_k` when the parameter must not be
+// below k. Exact indexes (FLAT, BIN_FLAT) have none.
+struct CalibrationParam {
+    std::string name;
+    bool at_least_k;
+};
+
+inline std::optional<CalibrationParam>
+GetCalibrationParam(const std::string& index_type) {
+    static const std::unordered_set<std::string> nprobe_indexes = {
+        IndexEnum::INDEX_FAISS_IVFFLAT, IndexEnum::INDEX_FAISS_IVFFLAT_CC, IndexEnum::INDEX_FAISS_IVFPQ,
+        IndexEnum::INDEX_FAISS_IVFSQ8,  IndexEnum::INDEX_FAISS_SCANN,      IndexEnum::INDEX_FAISS_BIN_IVFFLAT,
+    };
+    if (index_type == IndexEnum::INDEX_HNSW) {
+        return CalibrationParam{indexparam::EF, true};
+    } else if (index_type == IndexEnum::INDEX_DISKANN) {
+        return CalibrationParam{"search_list_size", true};
+    } else if (nprobe_indexes.count(index_type)) {
+        return CalibrationParam{indexparam::NPROBE, false};
+    }
+    return std::nullopt;
+}
+
+// Fraction of the valid ground truth ids of `nq` queries found among the `k` result ids of the same query.
+inline float
+RecallAtK(const int64_t* gt_ids, const int64_t* ids, int64_t nq, int64_t k) {
+    int64_t hits = 0, total = 0;
+    for (int64_t i = 0; i < nq; ++i) {
+        const int64_t* gt_row = gt_ids + i * k;
+        const int64_t* row = ids + i * k;
+        for (int64_t j = 0; j < k; ++j) {
+            if (gt_row[j] < 0) {
+                continue;
+            }
+            total++;
+            hits += std::find(row, row + k, gt_row[j]) != row + k;
+        }
+    }
+    return total == 0 ? 1.0f : static_cast<float>(hits) / total;
+}
+
+}  // namespace knowhere
+
+#endif /* CALIBRATION_H */
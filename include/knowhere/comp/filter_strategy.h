@@ -0,0 +1,162 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef FILTER_STRATEGY_H
+#define FILTER_STRATEGY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "knowhere/bitsetview.h"
+
+namespace knowhere {
+
+// How a search with a non-empty bitset is executed.
+enum class FilterStrategy {
+    // pick one of the strategies below from the filter selectivity
+    kAuto = 0,
+    // regular graph / IVF search, filtered ids are tested inline
+    kFilter = 1,
+    // regular graph / IVF search with ef / nprobe enlarged by the inverse selectivity
+    kExpandedSearch = 2,
+    // exhaustive scan over the unfiltered ids only
+    kBruteForce = 3,
+};
+
+namespace filter_strategy {
+constexpr const char* AUTO = "auto";
+constexpr const char* FILTER = "filter";
+constexpr const char* EXPANDED_SEARCH = "expanded_search";
+constexpr const char* BRUTE_FORCE = "brute_force";
+}  // namespace filter_strategy
+
+inline std::optional<FilterStrategy>
+Str2FilterStrategy(const std::string& str) {
+    if (str == filter_strategy::AUTO) {
+        return FilterStrategy::kAuto;
+    } else if (str == filter_strategy::FILTER) {
+        return FilterStrategy::kFilter;
+    } else if (str == filter_strategy::EXPANDED_SEARCH) {
+        return FilterStrategy::kExpandedSearch;
+    } else if (str == filter_strategy::BRUTE_FORCE) {
+        return FilterStrategy::kBruteForce;
+    }
+    return std::nullopt;
+}
+
+struct FilterSearchPlan {
+    FilterStrategy strategy = FilterStrategy::kFilter;
+    // ef for graph indexes, nprobe for IVF indexes, search list size for DiskANN
+    int64_t search_width = 0;
+};
+
+// below this fraction of unfiltered rows, ef / nprobe is enlarged
+inline constexpr float kExpandSelectivityThreshold = 0.5f;
+// upper bound of the ef / nprobe enlargement
+inline constexpr float kMaxSearchWidthExpansion = 8.0f;
+
+// Enlarged search width for the given fraction of unfiltered rows, kept in [width, min(width * 8, max_width)].
+inline int64_t
+ExpandSearchWidth(int64_t width, float selectivity, int64_t max_width) {
+    auto expanded = static_cast<float>(width) / std::max(selectivity, 1.0f / kMaxSearchWidthExpansion);
+    return std::max(width, std::min(static_cast<int64_t>(std::ceil(expanded)), max_width));
+}
+
+// Cost model for graph indexes (HNSW, DiskANN).
+// A filtered graph search has to walk roughly 1 / selectivity more nodes to collect `ef` unfiltered candidates,
+// each costing `degree` distance computations, while brute force over the unfiltered ids costs one distance
+// computation per unfiltered row. When at least `bf_ratio` of the rows are filtered out the graph is considered
+// disconnected and brute force is always used.
+inline FilterSearchPlan
+PlanGraphFilteredSearch(FilterStrategy requested, const BitsetView& bitset, int64_t nb, int64_t ef, int64_t degree,
+                        float bf_ratio, int64_t max_ef = std::numeric_limits<int32_t>::max()) {
+    FilterSearchPlan plan{FilterStrategy::kFilter, ef};
+    if (bitset.empty() || nb <= 0) {
+        return plan;
+    }
+    const auto filtered = std::min<int64_t>(bitset.count(), nb);
+    const auto valid = nb - filtered;
+    const auto selectivity = static_cast<float>(valid) / nb;
+    switch (requested) {
+        case FilterStrategy::kFilter:
+            return plan;
+        case FilterStrategy::kExpandedSearch:
+            return {FilterStrategy::kExpandedSearch, ExpandSearchWidth(ef, selectivity, max_ef)};
+        case FilterStrategy::kBruteForce:
+            return {FilterStrategy::kBruteForce, ef};
+        default:
+            break;
+    }
+    if (filtered >= nb * bf_ratio) {
+        return {FilterStrategy::kBruteForce, ef};
+    }
+    if (selectivity < kExpandSelectivityThreshold) {
+        plan = {FilterStrategy::kExpandedSearch, ExpandSearchWidth(ef, selectivity, max_ef)};
+    }
+    const auto graph_cost = static_cast<float>(plan.search_width) * degree / std::max(selectivity, 1e-6f);
+    const auto bf_cost = static_cast<float>(valid);
+    if (bf_cost <= graph_cost) {
+        return {FilterStrategy::kBruteForce, ef};
+    }
+    return plan;
+}
+
+// Cost model for IVF indexes.
+// Filtered rows are skipped inside the inverted lists, so an IVF search costs the coarse quantization (`nlist`) plus
+// the unfiltered rows of the probed lists; brute force here means probing every list. nprobe is enlarged when the
+// probed lists are expected to hold too few unfiltered rows.
+inline FilterSearchPlan
+PlanIvfFilteredSearch(FilterStrategy requested, const BitsetView& bitset, int64_t nb, int64_t nprobe, int64_t nlist) {
+    FilterSearchPlan plan{FilterStrategy::kFilter, nprobe};
+    if (bitset.empty() || nb <= 0 || nlist <= 0) {
+        return plan;
+    }
+    const auto filtered = std::min<int64_t>(bitset.count(), nb);
+    const auto valid = nb - filtered;
+    const auto selectivity = static_cast<float>(valid) / nb;
+    switch (requested) {
+        case FilterStrategy::kFilter:
+            return plan;
+        case FilterStrategy::kExpandedSearch:
+            return {FilterStrategy::kExpandedSearch, ExpandSearchWidth(nprobe, selectivity, nlist)};
+        case FilterStrategy::kBruteForce:
+            return {FilterStrategy::kBruteForce, nlist};
+        default:
+            break;
+    }
+    if (selectivity < kExpandSelectivityThreshold) {
+        plan = {FilterStrategy::kExpandedSearch, ExpandSearchWidth(nprobe, selectivity, nlist)};
+    }
+    const auto ivf_cost = static_cast<float>(nlist) + static_cast<float>(plan.search_width) * valid / nlist;
+    const auto bf_cost = static_cast<float>(valid);
+    if (plan.search_width >= nlist || bf_cost <= ivf_cost) {
+        return {FilterStrategy::kBruteForce, nlist};
+    }
+    return plan;
+}
+
+// Update the prometheus counters of the strategy chosen by a filtered search.
+void
+RecordFilterSearchPlan(const FilterSearchPlan& plan);
+
+// Ids in [0, nb) not set in the bitset, in increasing order. Gathered once per search batch by the brute force
+// strategy, which then only computes the distances of these rows.
+std::vector<int64_t>
+GatherUnfilteredIds(const BitsetView& bitset, int64_t nb);
+
+}  // namespace knowhere
+
+#endif /* FILTER_STRATEGY_H */
@@ -0,0 +1,53 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef HUGE_PAGE_H
+#define HUGE_PAGE_H
+
+#include <cstddef>
+
+namespace knowhere {
+
+// Size of a transparent huge page on x86_64 / aarch64 with 4 KB base pages.
+constexpr size_t kHugePageSize = 2UL << 20;
+
+// Allocate `size` bytes for a large index array. When huge pages are enabled and `size` is at least one huge page,
+// the memory is aligned to kHugePageSize and advised with MADV_HUGEPAGE, otherwise this is a plain malloc.
+// The result is released with free() and may be passed to realloc().
+void*
+HugePageAlloc(size_t size);
+
+// Advise the huge page aligned interior of an existing allocation with MADV_HUGEPAGE, for arrays whose allocation
+// is owned by a third party container. Returns the number of bytes advised. Callers publish the metric with
+// UpdateHugePageMetric once they are done advising.
+size_t
+AdviseHugePages(void* ptr, size_t size);
+
+// Enable or disable the two functions above, enabled by default. Without transparent huge page support in the kernel
+// the advice is ignored and the memory stays on regular pages.
+void
+SetHugePageEnabled(bool enabled);
+
+bool
+IsHugePageEnabled();
+
+// Anonymous memory of this process currently backed by huge pages, in bytes, read from /proc/self/smaps_rollup.
+size_t
+GetHugePageBytes();
+
+// Publish GetHugePageBytes() as the knowhere_huge_page_bytes gauge. HugePageAlloc does it after every advised
+// allocation. Reading smaps_rollup is not free, call it once per loaded index rather than per array.
+void
+UpdateHugePageMetric();
+
+}  // namespace knowhere
+
+#endif /* HUGE_PAGE_H */
@@ -50,6 +50,7 @@ constexpr const char* INDEX_TYPE = "index_type";
 constexpr const char* METRIC_TYPE = "metric_type";
 constexpr const char* DIM = "dim";
 constexpr const char* TENSOR = "tensor";
+constexpr const char* TENSOR_DATA_TYPE = "tensor_data_type";
 constexpr const char* ROWS = "rows";
 constexpr const char* IDS = "ids";
 constexpr const char* DISTANCE = "distance";
@@ -57,6 +58,8 @@ constexpr const char* LIMS = "lims";
 constexpr const char* TOPK = "k";
 constexpr const char* RADIUS = "radius";
 constexpr const char* RANGE_FILTER = "range_filter";
+constexpr const char* RADII = "radii";
+constexpr const char* KNN_BOUNDS = "knn_bounds";
 constexpr const char* INPUT_IDS = "input_ids";
 constexpr const char* OUTPUT_TENSOR = "output_tensor";
 constexpr const char* DEVICE_ID = "gpu_id";
@@ -64,6 +67,12 @@ constexpr const char* NUM_BUILD_THREAD = "num_build_thread";
 constexpr const char* TRACE_VISIT = "trace_visit";
 constexpr const char* JSON_INFO = "json_info";
 constexpr const char* JSON_ID_SET = "json_id_set";
+constexpr const char* FILTER_STRATEGY = "filter_strategy";
+constexpr const char* TRAIN_SAMPLE_ROWS = "train_sample_rows";
+constexpr const char* BUILD_CHUNK_ROWS = "build_chunk_rows";
+constexpr const char* EARLY_ABANDON = "early_abandon";
+constexpr const char* RANGE_SEARCH_K = "range_search_k";
+constexpr const char* TARGET_RECALL = "target_recall";
 };  // namespace meta
 
 namespace indexparam {
@@ -74,12 +83,16 @@ constexpr const char* NBITS = "nbits";  // PQ/SQ
 constexpr const char* M = "m";          // PQ param for IVFPQ
 constexpr const char* SSIZE = "ssize";
 constexpr const char* REORDER_K = "reorder_k";
+constexpr const char* MMAP_LIST_CACHE_MB = "mmap_list_cache_mb";
+constexpr const char* SHARED_CENTROIDS = "shared_centroids";
 
 // HNSW Params
 constexpr const char* EFCONSTRUCTION = "efConstruction";
 constexpr const char* HNSW_M = "M";
 constexpr const char* EF = "ef";
 constexpr const char* OVERVIEW_LEVELS = "overview_levels";
+constexpr const char* GRAPH_REORDER = "graph_reorder";
+constexpr const char* RANGE_ADAPTIVE_EF = "range_adaptive_ef";
 }  // namespace indexparam
 
 using MetricType = std::string;
@@ -40,6 +40,16 @@ class KnowhereConfig {
     static std::string
     SetSimdType(const SimdType simd_type);
 
+    /**
+     * Name of the SIMD kernel computing the `metric_type` distances of `index_type` on `data_type` vectors ("float32",
+     * "float16", "bfloat16"), as installed by the last SetSimdType: the SQ distance computer for the indexes keeping
+     * SQ codes, the distance table kernel for IVF_PQ. Empty when no index of the type takes such vectors or no
+     * kernel is registered.
+     */
+    static std::string
+    GetActiveKernel(const std::string& index_type, const std::string& metric_type,
+                    const std::string& data_type = "float32");
+
     /**
      * Set openblas threshold
      *   if nq < use_blas_threshold, calculated by omp
@@ -84,6 +94,21 @@ class KnowhereConfig {
     static bool
     SetAioContextPool(size_t num_ctx);
 
+    /**
+     * Back large index arrays (HNSW level 0, IVF inverted lists, DiskANN PQ codes) with transparent huge pages.
+     * Enabled by default, it only takes effect when the kernel THP mode is `always` or `madvise`.
+     */
+    static void
+    SetHugePageEnabled(const bool enabled);
+
+    /**
+     * Cache knn search results per query, keyed by the index contents, search config, bitset and query.
+     * `capacity_bytes` bounds the memory of the cached results, 0 (the default) disables the cache.
+     * `ttl_ms` is the lifetime of a cached result, 0 keeps results until they are evicted.
+     */
+    static void
+    SetSearchResultCache(const size_t capacity_bytes, const int64_t ttl_ms = 0);
+
     /**
      * init GPU Resource
      */
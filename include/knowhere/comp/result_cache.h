@@ -0,0 +1,89 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "knowhere/bitsetview.h"
+#include "knowhere/config.h"
+#include "knowhere/dataset.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// Process wide cache of knn search results, one entry per query, disabled by default.
+//
+// An entry is keyed by the contents of the index (renewed by Build, Train, Add and Deserialize), the search config,
+// the bitset and the query vector, so that a hit returns exactly what the search would have. Entries are evicted
+// least recently used first once the cache holds more than its capacity in bytes, and expire after the TTL if one
+// is set.
+class SearchResultCache {
+ public:
+    static SearchResultCache&
+    Instance();
+
+    // Bound of the memory held by the cached results, 0 disables the cache and drops its entries.
+    void
+    SetCapacity(size_t bytes);
+
+    // Lifetime of an entry in milliseconds, 0 for entries that only leave the cache when evicted.
+    void
+    SetTtl(int64_t ms);
+
+    bool
+    Enabled() const;
+
+    // Queries answered from the cache and searched since the start of the process, counted while it is enabled.
+    uint64_t
+    Hits() const;
+
+    uint64_t
+    Misses() const;
+
+    void
+    Clear();
+
+    // Key shared by the queries of one search, from the epoch of the index contents, the search params of the parsed
+    // config (so that defaults and key order don't split entries) and a hash of the whole bitset (a sampled one could
+    // serve results holding filtered out ids).
+    static uint64_t
+    ContextKey(uint64_t index_epoch, const Config& cfg, const BitsetView& bitset);
+
+    // Answer the queries of `dataset` found in the cache and search the others with `search`, caching their top
+    // `k` results. `row_bytes` is the size of one query in the tensor of `dataset`.
+    expected<DataSetPtr>
+    Search(const DataSet& dataset, uint64_t context, size_t row_bytes, int64_t k,
+           const std::function<expected<DataSetPtr>(const DataSet&)>& search);
+
+ private:
+    SearchResultCache();
+    ~SearchResultCache();
+
+    struct Shard;
+
+    static constexpr size_t kNumShards = 16;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<size_t> capacity_{0};
+    std::atomic<int64_t> ttl_ms_{0};
+    std::atomic<int64_t> bytes_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace knowhere
+
+#endif /* RESULT_CACHE_H */
@@ -0,0 +1,60 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SEGMENT_GROUP_H
+#define SEGMENT_GROUP_H
+
+#include <cstdint>
+#include <vector>
+
+#include "knowhere/bitsetview.h"
+#include "knowhere/dataset.h"
+#include "knowhere/expected.h"
+#include "knowhere/index.h"
+
+namespace knowhere {
+
+// Indexes (segments) of one collection searched as a whole. The segments are searched by blocks of queries on the
+// search thread pool and each result is merged into a running global top k as it arrives. The k-th distance of a
+// full row is passed to the later segment searches of that query as a bound (see DataSet::SetKnnBounds), which the
+// flat and IVF indexes prune their scans with.
+class SegmentGroup {
+ public:
+    // `id_offsets[i]` is added to the ids found in segment i so that the merged ids are global, no offsets keeps the
+    // ids of each segment as they are.
+    explicit SegmentGroup(std::vector<Index<IndexNode>> segments, std::vector<int64_t> id_offsets = {});
+
+    // Search every segment with the same config, which must hold k, `bitsets[i]` filters segment i, no bitsets
+    // filters nothing. The result has the shape of a single index search: nq rows of k ids and distances, padded
+    // with -1 ids.
+    expected<DataSetPtr>
+    Search(const DataSet& dataset, const Json& json, const std::vector<BitsetView>& bitsets = {}) const;
+
+    size_t
+    Size() const {
+        return segments_.size();
+    }
+
+ private:
+    std::vector<Index<IndexNode>> segments_;
+    std::vector<int64_t> id_offsets_;
+};
+
+// Merge `n` top k lists of `nq` queries into one, ids of list i are shifted by `id_offsets[i]` (may be null). Each
+// list holds nq rows of k results sorted closest first, a negative id ends a row.
+void
+MergeTopK(const std::vector<const int64_t*>& ids, const std::vector<const float*>& distances,
+          const int64_t* id_offsets, int64_t nq, int64_t k, bool larger_is_closer, int64_t* out_ids,
+          float* out_distances);
+
+}  // namespace knowhere
+
+#endif /* SEGMENT_GROUP_H */
@@ -0,0 +1,51 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SHARED_CENTROIDS_H
+#define SHARED_CENTROIDS_H
+
+#include <cstdint>
+#include <string>
+
+#include "knowhere/dataset.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// Coarse centroids trained once per collection and shared by its float IVF indexes (IVF_FLAT, IVF_FLAT_CC, IVF_PQ,
+// IVF_SQ8) built with the `shared_centroids` parameter set to their name. Such an index skips the k-means of its
+// Train, references the centroids instead of holding a copy, serializes the name instead of the centroids, and
+// reuses the coarse assignment of a query computed by another index sharing the centroids.
+//
+// The centroids must be registered under the same name before an index built on them is deserialized. A binset
+// also holds a hash of the centroids, loading it on other centroids registered under the name fails.
+class SharedCentroids {
+ public:
+    // Register the rows of `centroids` under `name`. Fails if centroids are registered under the same name, they
+    // must be unregistered first. Indexes already built on unregistered centroids keep them.
+    static Status
+    Register(const std::string& name, const DataSet& centroids, const std::string& metric_type);
+
+    // Train `nlist` centroids on `dataset` with k-means and register them under `name`.
+    static Status
+    Train(const std::string& name, const DataSet& dataset, int64_t nlist, const std::string& metric_type);
+
+    static Status
+    Unregister(const std::string& name);
+
+    // copy of the centroids registered under `name`
+    static expected<DataSetPtr>
+    Get(const std::string& name);
+};
+
+}  // namespace knowhere
+
+#endif /* SHARED_CENTROIDS_H */
@@ -15,9 +15,11 @@
 #include <pthread.h>
 
 #include <memory>
+#include <string>
 #include <utility>
 
 #include "folly/executors/CPUThreadPoolExecutor.h"
+#include "folly/executors/InlineExecutor.h"
 #include "folly/futures/Future.h"
 #include "knowhere/log.h"
 
@@ -27,10 +29,16 @@ class ThreadPool {
  private:
     class LowPriorityThreadFactory : public folly::NamedThreadFactory {
      public:
-        using folly::NamedThreadFactory::NamedThreadFactory;
+        LowPriorityThreadFactory(const std::string& prefix, const ThreadPool* pool)
+            : folly::NamedThreadFactory(prefix), pool_(pool) {
+        }
+
         std::thread
         newThread(folly::Func&& func) override {
-            auto thread = folly::NamedThreadFactory::newThread(std::move(func));
+            auto thread = folly::NamedThreadFactory::newThread([pool = pool_, func = std::move(func)]() mutable {
+                current_pool_ = pool;
+                func();
+            });
             sched_param sch_params;
             int policy = SCHED_FIFO;
             sch_params.sched_priority = sched_get_priority_min(policy);
@@ -44,6 +52,9 @@ class ThreadPool {
             }
             return thread;
         }
+
+     private:
+        const ThreadPool* pool_;
     };
 
  public:
@@ -53,7 +64,7 @@ class ThreadPool {
               std::make_unique<
                   folly::LifoSemMPMCQueue<folly::CPUThreadPoolExecutor::CPUTask, folly::QueueBehaviorIfFull::BLOCK>>(
                   num_threads * kTaskQueueFactor),
-              std::make_shared<LowPriorityThreadFactory>("LowPrioKWPool"))) {
+              std::make_shared<LowPriorityThreadFactory>("LowPrioKWPool", this))) {
     }
 
     ThreadPool(const ThreadPool&) = delete;
@@ -66,10 +77,16 @@ class ThreadPool {
     ThreadPool&
     operator=(ThreadPool&&) noexcept = delete;
 
+    // A task pushed from a thread of this pool runs inline: the pushing task would otherwise wait for tasks queued
+    // behind it, and the pool deadlocks once all of its threads wait.
     template <typename Func, typename... Args>
     auto
     push(Func&& func, Args&&... args) {
-        return folly::makeSemiFuture().via(&pool_).then(
+        folly::Executor* executor = &pool_;
+        if (current_pool_ == this) {
+            executor = &folly::InlineExecutor::instance();
+        }
+        return folly::makeSemiFuture().via(executor).then(
             [func = std::forward<Func>(func), &args...](auto&&) mutable { return func(std::forward<Args>(args)...); });
     }
 
@@ -163,6 +180,7 @@ class ThreadPool {
     inline static uint32_t global_build_thread_pool_size_ = 0;
     inline static uint32_t global_search_thread_pool_size_ = 0;
     inline static std::mutex global_thread_pool_mutex_;
+    inline static thread_local const ThreadPool* current_pool_ = nullptr;
     constexpr static size_t kTaskQueueFactor = 16;
 };
 }  // namespace knowhere
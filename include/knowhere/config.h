@@ -499,6 +499,18 @@ class BaseConfig : public Config {
     CFG_BOOL trace_visit;
     CFG_BOOL enable_mmap;
     CFG_BOOL for_tuning;
+    // How a search with a bitset is executed: "auto" picks one of "filter", "expanded_search" and "brute_force"
+    // from the filter selectivity, see knowhere/comp/filter_strategy.h.
+    CFG_STRING filter_strategy;
+    // training sample and chunk size of a build from a DataSetReader
+    CFG_INT train_sample_rows;
+    CFG_INT build_chunk_rows;
+    // L2 distances of FLAT, IVF_FLAT and brute force scans stop accumulating once above the current k-th best
+    CFG_BOOL early_abandon;
+    CFG_INT range_search_k;
+    // recall@k to reach instead of an explicit ef / nprobe / search_list_size, the index must have been calibrated
+    // with Index::Calibrate, see knowhere/comp/calibration.h.
+    CFG_FLOAT target_recall;
     KNOHWERE_DECLARE_CONFIG(BaseConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(metric_type).set_default("L2").description("metric type").for_train_and_search();
         KNOWHERE_CONFIG_DECLARE_FIELD(k)
@@ -529,6 +541,34 @@ class BaseConfig : public Config {
             .description("enable mmap for load index")
             .for_deserialize_from_file();
         KNOWHERE_CONFIG_DECLARE_FIELD(for_tuning).set_default(false).description("for tuning").for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(filter_strategy)
+            .set_default("auto")
+            .description("strategy of search with bitset: auto, filter, expanded_search or brute_force")
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(train_sample_rows)
+            .set_default(1000000)
+            .description("max number of rows sampled for training in a streaming build")
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(build_chunk_rows)
+            .set_default(65536)
+            .description("number of rows added at a time in a streaming build")
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(early_abandon)
+            .set_default(false)
+            .description("abandon L2 distances of flat scans once above the k-th best")
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(range_search_k)
+            .set_default(-1)
+            .description("limit the number of similar results returned by range_search. -1 means no limitations.")
+            .set_range(-1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(target_recall)
+            .description("target recall of a search on a calibrated index, replaces its search width parameter")
+            .allow_empty_without_default()
+            .set_range(0.0, 1.0)
+            .for_search();
     }
 
     virtual Status
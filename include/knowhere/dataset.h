@@ -21,6 +21,7 @@
 #include <variant>
 
 #include "comp/index_param.h"
+#include "operands.h"
 
 namespace knowhere {
 
@@ -78,6 +79,21 @@ class DataSet {
         this->data_[meta::IDS] = Var(std::in_place_index<2>, ids);
     }
 
+    // per query range search radius, owned like the other arrays
+    void
+    SetRadii(const float* radii) {
+        std::unique_lock lock(mutex_);
+        this->data_[meta::RADII] = Var(std::in_place_index<0>, radii);
+    }
+
+    // per query k-th distance bound for top-k search; results not closer than
+    // the bound are dropped, so result rows may end with -1 ids
+    void
+    SetKnnBounds(const float* bounds) {
+        std::unique_lock lock(mutex_);
+        this->data_[meta::KNN_BOUNDS] = Var(std::in_place_index<0>, bounds);
+    }
+
     void
     SetTensor(const void* tensor) {
         std::unique_lock lock(mutex_);
@@ -96,6 +112,12 @@ class DataSet {
         this->data_[meta::DIM] = Var(std::in_place_index<4>, dim);
     }
 
+    void
+    SetTensorDataType(const DataType type) {
+        std::unique_lock lock(mutex_);
+        this->data_[meta::TENSOR_DATA_TYPE] = Var(std::in_place_index<4>, static_cast<int64_t>(type));
+    }
+
     void
     SetJsonInfo(const std::string& info) {
         std::unique_lock lock(mutex_);
@@ -119,6 +141,28 @@ class DataSet {
         return nullptr;
     }
 
+    const float*
+    GetRadii() const {
+        std::shared_lock lock(mutex_);
+        auto it = this->data_.find(meta::RADII);
+        if (it != this->data_.end()) {
+            const float* res = *std::get_if<0>(&it->second);
+            return res;
+        }
+        return nullptr;
+    }
+
+    const float*
+    GetKnnBounds() const {
+        std::shared_lock lock(mutex_);
+        auto it = this->data_.find(meta::KNN_BOUNDS);
+        if (it != this->data_.end()) {
+            const float* res = *std::get_if<0>(&it->second);
+            return res;
+        }
+        return nullptr;
+    }
+
     const size_t*
     GetLims() const {
         std::shared_lock lock(mutex_);
@@ -174,6 +218,17 @@ class DataSet {
         return 0;
     }
 
+    // element type of the tensor, fp32 unless set explicitly
+    DataType
+    GetTensorDataType() const {
+        std::shared_lock lock(mutex_);
+        auto it = this->data_.find(meta::TENSOR_DATA_TYPE);
+        if (it != this->data_.end()) {
+            return static_cast<DataType>(*std::get_if<4>(&it->second));
+        }
+        return DataType::kFloat32;
+    }
+
     std::string
     GetJsonInfo() const {
         std::shared_lock lock(mutex_);
@@ -0,0 +1,118 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef DATASET_READER_H
+#define DATASET_READER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "knowhere/dataset.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// Source of the base vectors of a streaming build, read sequentially in chunks so that the whole dataset never
+// has to be held in memory.
+class DataSetReader {
+ public:
+    virtual ~DataSetReader() {
+    }
+
+    // total number of rows, known before the first chunk is read
+    virtual int64_t
+    Rows() const = 0;
+
+    virtual int64_t
+    Dim() const = 0;
+
+    // next chunk of at most max_rows rows, owned by the returned DataSet; nullptr once all rows are read
+    virtual DataSetPtr
+    Next(int64_t max_rows) = 0;
+
+    // restart from the first row
+    virtual Status
+    Reset() = 0;
+};
+
+// Chunks of a DataSet already in memory, each chunk is a view of the source tensor.
+class MemoryDataSetReader : public DataSetReader {
+ public:
+    explicit MemoryDataSetReader(DataSetPtr dataset) : dataset_(std::move(dataset)) {
+    }
+
+    int64_t
+    Rows() const override {
+        return dataset_->GetRows();
+    }
+
+    int64_t
+    Dim() const override {
+        return dataset_->GetDim();
+    }
+
+    DataSetPtr
+    Next(int64_t max_rows) override;
+
+    Status
+    Reset() override {
+        offset_ = 0;
+        return Status::success;
+    }
+
+ private:
+    DataSetPtr dataset_;
+    int64_t offset_ = 0;
+};
+
+// Float vectors in the .fbin layout: int32 row count, int32 dim, then rows * dim float32 values.
+class FbinDataSetReader : public DataSetReader {
+ public:
+    explicit FbinDataSetReader(const std::string& path);
+
+    // false if the file could not be opened or its header is invalid
+    bool
+    Valid() const {
+        return rows_ >= 0;
+    }
+
+    int64_t
+    Rows() const override {
+        return rows_;
+    }
+
+    int64_t
+    Dim() const override {
+        return dim_;
+    }
+
+    DataSetPtr
+    Next(int64_t max_rows) override;
+
+    Status
+    Reset() override;
+
+ private:
+    std::ifstream in_;
+    int64_t rows_ = -1;
+    int64_t dim_ = 0;
+    int64_t offset_ = 0;
+};
+
+// Uniform random sample of at most max_rows rows of the reader (reservoir sampling over one pass), in the element
+// type of its chunks. The reader is left at its end.
+DataSetPtr
+SampleDataSet(DataSetReader& reader, int64_t max_rows, int64_t chunk_rows, uint64_t seed = 42);
+
+}  // namespace knowhere
+
+#endif /* DATASET_READER_H */
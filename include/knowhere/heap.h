@@ -11,52 +11,253 @@
 
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <optional>
-#include <queue>
 #include <utility>
+#include <vector>
 
 namespace knowhere {
 
-// Maintain intermediate top-k results via maxheap
-// TODO: this naive implementation might be optimzed later
-//     1. Based on top-k and pushed element count to swtich strategy
-//     2. Combine `pop` and `push` operation to `replace`
+// Top-k selectors keep the k smallest distances pushed to them and share one interface:
+//   Push(dis, id)     offer a candidate
+//   Threshold()       only candidates with a smaller distance are kept
+//   Size()            number of candidates kept so far, at most k
+//   SortedResults()   the kept candidates in ascending distance order, ends the selection
+// WithTopKSelector picks the selector suited to k.
+
+// up to this k a sorted buffer beats a heap
+constexpr size_t kSortedBufferMaxK = 32;
+// from this k on candidates are filtered against a threshold and compacted with quickselect
+constexpr size_t kQuickselectMinK = 1000;
+
+// Small k: candidates are kept sorted, the insert position is found with a branch-free rank count.
 template <typename DisT, typename IdT>
-class ResultMaxHeap {
+class SortedBufferTopK {
  public:
-    ResultMaxHeap(size_t k) : k_(k){};
+    explicit SortedBufferTopK(size_t k) : k_(k), dis_(k), ids_(k) {
+    }
+
+    inline void
+    Push(DisT dis, IdT id) {
+        if (size_ == k_ && (k_ == 0 || !(dis < dis_[k_ - 1]))) {
+            return;
+        }
+        size_t pos = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            pos += !(dis < dis_[i]);
+        }
+        const size_t end = std::min(size_ + 1, k_);
+        std::copy_backward(dis_.begin() + pos, dis_.begin() + end - 1, dis_.begin() + end);
+        std::copy_backward(ids_.begin() + pos, ids_.begin() + end - 1, ids_.begin() + end);
+        dis_[pos] = dis;
+        ids_[pos] = id;
+        size_ = end;
+    }
+
+    inline DisT
+    Threshold() const {
+        return size_ == k_ && k_ > 0 ? dis_[k_ - 1] : std::numeric_limits<DisT>::max();
+    }
+
+    inline size_t
+    Size() const {
+        return size_;
+    }
+
+    std::vector<std::pair<DisT, IdT>>
+    SortedResults() {
+        std::vector<std::pair<DisT, IdT>> res(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            res[i] = {dis_[i], ids_[i]};
+        }
+        return res;
+    }
 
+ private:
+    size_t k_;
+    size_t size_ = 0;
+    std::vector<DisT> dis_;
+    std::vector<IdT> ids_;
+};
+
+// Medium k: binary max-heap, a better candidate replaces the top in a single sift-down.
+template <typename DisT, typename IdT>
+class BinaryHeapTopK {
+ public:
+    explicit BinaryHeapTopK(size_t k) : k_(k) {
+        heap_.reserve(k);
+    }
+
+    inline void
+    Push(DisT dis, IdT id) {
+        if (heap_.size() < k_) {
+            heap_.emplace_back(dis, id);
+            SiftUp(heap_.size() - 1);
+        } else if (k_ > 0 && dis < heap_[0].first) {
+            heap_[0] = {dis, id};
+            SiftDown(0);
+        }
+    }
+
+    // Pop the largest kept candidate.
     inline std::optional<std::pair<DisT, IdT>>
     Pop() {
-        if (pq.empty()) {
+        if (heap_.empty()) {
             return std::nullopt;
         }
-        std::optional<std::pair<DisT, IdT>> res = pq.top();
-        pq.pop();
+        std::optional<std::pair<DisT, IdT>> res = heap_[0];
+        heap_[0] = heap_.back();
+        heap_.pop_back();
+        if (!heap_.empty()) {
+            SiftDown(0);
+        }
+        return res;
+    }
+
+    inline DisT
+    Threshold() const {
+        return heap_.size() == k_ && k_ > 0 ? heap_[0].first : std::numeric_limits<DisT>::max();
+    }
+
+    inline size_t
+    Size() const {
+        return heap_.size();
+    }
+
+    std::vector<std::pair<DisT, IdT>>
+    SortedResults() {
+        std::vector<std::pair<DisT, IdT>> res(heap_.size());
+        for (auto i = static_cast<int64_t>(res.size()) - 1; i >= 0; --i) {
+            res[i] = Pop().value();
+        }
         return res;
     }
 
+ private:
+    inline void
+    SiftUp(size_t i) {
+        auto elem = heap_[i];
+        while (i > 0) {
+            const size_t parent = (i - 1) / 2;
+            if (!(heap_[parent] < elem)) {
+                break;
+            }
+            heap_[i] = heap_[parent];
+            i = parent;
+        }
+        heap_[i] = elem;
+    }
+
+    inline void
+    SiftDown(size_t i) {
+        const size_t n = heap_.size();
+        auto elem = heap_[i];
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) {
+                break;
+            }
+            if (child + 1 < n && heap_[child] < heap_[child + 1]) {
+                child++;
+            }
+            if (!(elem < heap_[child])) {
+                break;
+            }
+            heap_[i] = heap_[child];
+            i = child;
+        }
+        heap_[i] = elem;
+    }
+
+    size_t k_;
+    std::vector<std::pair<DisT, IdT>> heap_;
+};
+
+// Large k: candidates below the threshold are appended to a buffer of 2k, a quickselect keeps the best k and
+// tightens the threshold whenever the buffer fills up.
+template <typename DisT, typename IdT>
+class QuickselectTopK {
+ public:
+    explicit QuickselectTopK(size_t k) : k_(k), capacity_(std::max<size_t>(2 * k, 1)), buf_(capacity_ + 1) {
+    }
+
     inline void
     Push(DisT dis, IdT id) {
-        if (pq.size() < k_) {
-            pq.emplace(dis, id);
-            return;
+        buf_[size_] = {dis, id};
+        size_ += dis < threshold_;
+        if (size_ == capacity_) {
+            Compact();
         }
+    }
 
-        if (dis < pq.top().first) {
-            pq.pop();
-            pq.emplace(dis, id);
+    // Push n candidates, the threshold test is branch-free so the filter loop stays tight.
+    inline void
+    PushBatch(const DisT* dis, const IdT* ids, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            Push(dis[i], ids[i]);
         }
     }
 
+    inline DisT
+    Threshold() const {
+        return threshold_;
+    }
+
     inline size_t
-    Size() {
-        return pq.size();
+    Size() const {
+        return std::min(size_, k_);
+    }
+
+    std::vector<std::pair<DisT, IdT>>
+    SortedResults() {
+        if (size_ > k_) {
+            Compact();
+        }
+        std::vector<std::pair<DisT, IdT>> res(buf_.begin(), buf_.begin() + size_);
+        std::sort(res.begin(), res.end());
+        return res;
     }
 
  private:
+    void
+    Compact() {
+        if (k_ == 0) {
+            size_ = 0;
+            threshold_ = std::numeric_limits<DisT>::lowest();
+            return;
+        }
+        std::nth_element(buf_.begin(), buf_.begin() + k_ - 1, buf_.begin() + size_);
+        threshold_ = buf_[k_ - 1].first;
+        size_ = k_;
+    }
+
     size_t k_;
-    std::priority_queue<std::pair<DisT, IdT>> pq;
+    size_t capacity_;
+    size_t size_ = 0;
+    DisT threshold_ = std::numeric_limits<DisT>::max();
+    // one slot past the capacity takes the unconditional write of Push
+    std::vector<std::pair<DisT, IdT>> buf_;
 };
 
+// Run func with the top-k selector suited to k and return its result.
+template <typename DisT, typename IdT, typename Func>
+inline auto
+WithTopKSelector(size_t k, Func&& func) {
+    if (k <= kSortedBufferMaxK) {
+        SortedBufferTopK<DisT, IdT> selector(k);
+        return func(selector);
+    }
+    if (k >= kQuickselectMinK) {
+        QuickselectTopK<DisT, IdT> selector(k);
+        return func(selector);
+    }
+    BinaryHeapTopK<DisT, IdT> selector(k);
+    return func(selector);
+}
+
+// Maintain intermediate top-k results via maxheap
+template <typename DisT, typename IdT>
+using ResultMaxHeap = BinaryHeapTopK<DisT, IdT>;
+
 }  // namespace knowhere
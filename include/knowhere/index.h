@@ -118,6 +118,10 @@ class Index {
     Status
     Build(const DataSet& dataset, const Json& json);
 
+    // Build from vectors read in chunks, see IndexNode::BuildFromReader.
+    Status
+    BuildFromReader(DataSetReader& reader, const Json& json);
+
     Status
     Train(const DataSet& dataset, const Json& json);
 
@@ -130,6 +134,19 @@ class Index {
     expected<DataSetPtr>
     RangeSearch(const DataSet& dataset, const Json& json, const BitsetView& bitset) const;
 
+    // Measure recall@k of the search width parameter of the index (ef, nprobe or search_list_size) on
+    // `sample_queries` against brute force ground truth, and keep the recall curve up to the smallest width reaching
+    // `target_recall`. Searches may then give `target_recall` instead of the width, up to the best recall measured,
+    // a higher one fails with invalid_args. `json` holds the other search params (k, metric_type, ...). The ground
+    // truth is computed on `base`, or on the raw data of the index when it is null. The curve is serialized with the
+    // index.
+    Status
+    Calibrate(const DataSet& sample_queries, float target_recall, const Json& json, const DataSet* base = nullptr);
+
+    // One resumable search per query, see IndexNode::AnnIterator.
+    expected<std::vector<IndexNode::IteratorPtr>>
+    AnnIterator(const DataSet& dataset, const Json& json, const BitsetView& bitset) const;
+
     expected<DataSetPtr>
     GetVectorByIds(const DataSet& dataset) const;
 
@@ -12,10 +12,20 @@
 #ifndef INDEX_NODE_H
 #define INDEX_NODE_H
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "knowhere/binaryset.h"
 #include "knowhere/bitsetview.h"
+#include "knowhere/comp/calibration.h"
 #include "knowhere/config.h"
 #include "knowhere/dataset.h"
+#include "knowhere/dataset_reader.h"
 #include "knowhere/expected.h"
 #include "knowhere/object.h"
 
@@ -23,6 +33,22 @@ namespace knowhere {
 
 class IndexNode : public Object {
  public:
+    // Results of one query, closest first (largest similarity first for IP / COSINE), computed as they are asked
+    // for. An iterator refers to the index and to the bitset it was created with, both must outlive it.
+    class iterator {
+     public:
+        // (id, distance) of the next result, only valid when HasNext() is true
+        virtual std::pair<int64_t, float>
+        Next() = 0;
+
+        virtual bool
+        HasNext() = 0;
+
+        virtual ~iterator() {
+        }
+    };
+    using IteratorPtr = std::shared_ptr<iterator>;
+
     virtual Status
     Build(const DataSet& dataset, const Config& cfg) {
         RETURN_IF_ERROR(Train(dataset, cfg));
@@ -35,12 +61,26 @@ class IndexNode : public Object {
     virtual Status
     Add(const DataSet& dataset, const Config& cfg) = 0;
 
+    // Build from vectors read in chunks instead of one DataSet holding all of them. Indexes that support it
+    // override this, most of them with TrainAndAddInChunks.
+    virtual Status
+    BuildFromReader(DataSetReader& reader, const Config& cfg) {
+        return Status::not_implemented;
+    }
+
     virtual expected<DataSetPtr>
     Search(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const = 0;
 
     virtual expected<DataSetPtr>
     RangeSearch(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const = 0;
 
+    // One iterator per query of `dataset`, each resuming its search where the previous Next() stopped instead of
+    // searching again with a larger k.
+    virtual expected<std::vector<IteratorPtr>>
+    AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const {
+        return expected<std::vector<IteratorPtr>>::Err(Status::not_implemented, "AnnIterator not implemented");
+    }
+
     virtual expected<DataSetPtr>
     GetVectorByIds(const DataSet& dataset) const = 0;
 
@@ -74,8 +114,99 @@ class IndexNode : public Object {
     virtual std::string
     Type() const = 0;
 
+    // Identity of the index contents for the search result cache, unique across indexes and renewed whenever the
+    // contents change.
+    uint64_t
+    CacheEpoch() const {
+        return cache_epoch_.load(std::memory_order_relaxed);
+    }
+
+    void
+    RenewCacheEpoch() {
+        cache_epoch_.store(NextCacheEpoch(), std::memory_order_relaxed);
+    }
+
+    // Recall curve measured by Index::Calibrate, null for an index never calibrated.
+    std::shared_ptr<const RecallCurve>
+    GetRecallCurve() const {
+        return std::atomic_load(&recall_curve_);
+    }
+
+    void
+    SetRecallCurve(std::shared_ptr<const RecallCurve> curve) {
+        std::atomic_store(&recall_curve_, std::move(curve));
+    }
+
     virtual ~IndexNode() {
     }
+
+ protected:
+    // Train on a random sample of at most `train_sample_rows` rows, then Add the vectors `build_chunk_rows` at a
+    // time, so the build holds the index, the sample and one chunk instead of the whole dataset. Only for indexes
+    // whose Add appends to the trained index.
+    Status
+    TrainAndAddInChunks(DataSetReader& reader, const Config& cfg) {
+        const auto& base_cfg = static_cast<const BaseConfig&>(cfg);
+        const auto chunk_rows = base_cfg.build_chunk_rows.value();
+        auto sample = SampleDataSet(reader, base_cfg.train_sample_rows.value(), chunk_rows);
+        if (sample == nullptr) {
+            return Status::invalid_args;
+        }
+        RETURN_IF_ERROR(Train(*sample, cfg));
+        sample.reset();
+        RETURN_IF_ERROR(reader.Reset());
+        int64_t added = 0;
+        while (auto chunk = reader.Next(chunk_rows)) {
+            RETURN_IF_ERROR(Add(*chunk, cfg));
+            added += chunk->GetRows();
+        }
+        // a reader that stops early (e.g. a truncated file) must not leave a partial index behind silently
+        return added == reader.Rows() ? Status::success : Status::invalid_args;
+    }
+
+ private:
+    static uint64_t
+    NextCacheEpoch() {
+        static std::atomic<uint64_t> epoch{0};
+        return epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    std::atomic<uint64_t> cache_epoch_{NextCacheEpoch()};
+    std::shared_ptr<const RecallCurve> recall_curve_;
+};
+
+// Iterator over distances that are all known up front, e.g. computed by brute force. They are ordered lazily, a
+// heap is built once and one result is popped per Next().
+class PrecomputedDistanceIterator : public IndexNode::iterator {
+ public:
+    PrecomputedDistanceIterator(std::vector<std::pair<float, int64_t>>&& results, bool larger_is_closer)
+        : results_(std::move(results)), sign_(larger_is_closer ? -1.0f : 1.0f) {
+        // a min-heap on sign * distance keeps the closest result on top for both orders
+        for (auto& result : results_) {
+            result.first *= sign_;
+        }
+        std::make_heap(results_.begin(), results_.end(), std::greater<>());
+    }
+
+    std::pair<int64_t, float>
+    Next() override {
+        if (results_.empty()) {
+            return {-1, std::numeric_limits<float>::infinity() * sign_};
+        }
+        std::pop_heap(results_.begin(), results_.end(), std::greater<>());
+        auto [dist, id] = results_.back();
+        results_.pop_back();
+        return {id, dist * sign_};
+    }
+
+    bool
+    HasNext() override {
+        return !results_.empty();
+    }
+
+ private:
+    std::vector<std::pair<float, int64_t>> results_;
+    const float sign_;
 };
 
 }  // namespace knowhere
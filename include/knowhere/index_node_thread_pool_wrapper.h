@@ -33,12 +33,20 @@ class IndexNodeThreadPoolWrapper : public IndexNode {
         return index_node_->Add(dataset, cfg);
     }
 
+    Status
+    BuildFromReader(DataSetReader& reader, const Config& cfg) override {
+        return index_node_->BuildFromReader(reader, cfg);
+    }
+
     expected<DataSetPtr>
     Search(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override;
 
     expected<DataSetPtr>
     RangeSearch(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override;
 
+    expected<std::vector<IteratorPtr>>
+    AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override;
+
     expected<DataSetPtr>
     GetVectorByIds(const DataSet& dataset) const override {
         return index_node_->GetVectorByIds(dataset);
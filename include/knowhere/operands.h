@@ -0,0 +1,215 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef OPERANDS_H
+#define OPERANDS_H
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+
+namespace knowhere {
+
+// Element type of a float vector tensor.
+enum class DataType {
+    kFloat32 = 0,
+    kFloat16 = 1,
+    kBFloat16 = 2,
+};
+
+namespace data_type {
+constexpr const char* FLOAT32 = "float32";
+constexpr const char* FLOAT16 = "float16";
+constexpr const char* BFLOAT16 = "bfloat16";
+}  // namespace data_type
+
+inline std::optional<DataType>
+Str2DataType(const std::string& str) {
+    if (str == data_type::FLOAT32) {
+        return DataType::kFloat32;
+    } else if (str == data_type::FLOAT16) {
+        return DataType::kFloat16;
+    } else if (str == data_type::BFLOAT16) {
+        return DataType::kBFloat16;
+    }
+    return std::nullopt;
+}
+
+inline size_t
+DataTypeSize(DataType type) {
+    return type == DataType::kFloat32 ? sizeof(float) : sizeof(uint16_t);
+}
+
+inline uint16_t
+Fp32ToFp16(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    const uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t mant = x & 0x007fffff;
+    const int32_t exp = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+    if (((x >> 23) & 0xff) == 0xff) {
+        // inf or NaN
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    }
+    if (exp >= 0x1f) {
+        return sign | 0x7c00;
+    }
+    if (exp <= 0) {
+        // subnormal half or zero
+        if (exp < -10) {
+            return sign;
+        }
+        mant |= 0x00800000;
+        const uint32_t shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        const uint32_t rem = mant & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1))) {
+            half++;
+        }
+        return sign | half;
+    }
+    uint32_t half = sign | ((uint32_t)exp << 10) | (mant >> 13);
+    const uint32_t rem = mant & 0x1fff;
+    // round to nearest even, a carry into the exponent is the correct result
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return half;
+}
+
+inline float
+Fp16ToFp32(uint16_t h) {
+    const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t x;
+    if (exp == 0) {
+        if (mant == 0) {
+            x = sign;
+        } else {
+            // normalize the subnormal half
+            exp = 127 - 15 + 1;
+            while (!(mant & 0x400)) {
+                mant <<= 1;
+                exp--;
+            }
+            x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+        }
+    } else if (exp == 0x1f) {
+        x = sign | 0x7f800000 | (mant << 13);
+    } else {
+        x = sign | ((exp - 15 + 127) << 23) | (mant << 13);
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+inline uint16_t
+Fp32ToBf16(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    if ((x & 0x7fffffff) > 0x7f800000) {
+        // keep NaN a quiet NaN
+        return (x >> 16) | 0x40;
+    }
+    // round to nearest even
+    x += 0x7fff + ((x >> 16) & 1);
+    return x >> 16;
+}
+
+inline float
+Bf16ToFp32(uint16_t b) {
+    const uint32_t x = (uint32_t)b << 16;
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+// IEEE 754 half precision value.
+struct fp16 {
+    uint16_t bits = 0;
+
+    fp16() = default;
+    explicit fp16(float f) : bits(Fp32ToFp16(f)) {
+    }
+    operator float() const {
+        return Fp16ToFp32(bits);
+    }
+};
+
+// bfloat16 value, the upper half of a float32.
+struct bf16 {
+    uint16_t bits = 0;
+
+    bf16() = default;
+    explicit bf16(float f) : bits(Fp32ToBf16(f)) {
+    }
+    operator float() const {
+        return Bf16ToFp32(bits);
+    }
+};
+
+static_assert(sizeof(fp16) == 2 && sizeof(bf16) == 2, "half types must be 2 bytes");
+
+// Convert n elements of type `type` at src to float.
+inline void
+ConvertToFloat(const void* src, DataType type, float* dst, size_t n) {
+    switch (type) {
+        case DataType::kFloat16: {
+            auto x = (const uint16_t*)src;
+            for (size_t i = 0; i < n; i++) {
+                dst[i] = Fp16ToFp32(x[i]);
+            }
+            break;
+        }
+        case DataType::kBFloat16: {
+            auto x = (const uint16_t*)src;
+            for (size_t i = 0; i < n; i++) {
+                dst[i] = Bf16ToFp32(x[i]);
+            }
+            break;
+        }
+        default:
+            memcpy(dst, src, n * sizeof(float));
+            break;
+    }
+}
+
+// Convert n floats at src to elements of type `type`.
+inline void
+ConvertFromFloat(const float* src, DataType type, void* dst, size_t n) {
+    switch (type) {
+        case DataType::kFloat16: {
+            auto y = (uint16_t*)dst;
+            for (size_t i = 0; i < n; i++) {
+                y[i] = Fp32ToFp16(src[i]);
+            }
+            break;
+        }
+        case DataType::kBFloat16: {
+            auto y = (uint16_t*)dst;
+            for (size_t i = 0; i < n; i++) {
+                y[i] = Fp32ToBf16(src[i]);
+            }
+            break;
+        }
+        default:
+            memcpy(dst, src, n * sizeof(float));
+            break;
+    }
+}
+
+}  // namespace knowhere
+
+#endif /* OPERANDS_H */
@@ -78,5 +78,12 @@ DECLARE_PROMETHEUS_COUNTER(knowhere_build_count);
 DECLARE_PROMETHEUS_COUNTER(knowhere_search_count);
 DECLARE_PROMETHEUS_COUNTER(knowhere_range_search_count);
 DECLARE_PROMETHEUS_HISTOGRAM(knowhere_search_topk);
+DECLARE_PROMETHEUS_COUNTER(knowhere_filter_search_count);
+DECLARE_PROMETHEUS_COUNTER(knowhere_filter_expanded_search_count);
+DECLARE_PROMETHEUS_COUNTER(knowhere_filter_brute_force_search_count);
+DECLARE_PROMETHEUS_GAUGE(knowhere_huge_page_bytes);
+DECLARE_PROMETHEUS_COUNTER(knowhere_search_cache_hit_count);
+DECLARE_PROMETHEUS_COUNTER(knowhere_search_cache_miss_count);
+DECLARE_PROMETHEUS_GAUGE(knowhere_search_cache_bytes);
 
 }  // namespace knowhere
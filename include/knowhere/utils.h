@@ -32,31 +32,39 @@ NormalizeVec(float* x, int32_t d);
 extern std::vector<float>
 NormalizeVecs(float* x, size_t rows, int32_t dim);
 
+// Normalize the rows of the dataset in place, large datasets in parallel on the global build thread pool.
 extern void
 Normalize(const DataSet& dataset);
 
 std::unique_ptr<float[]>
 CopyAndNormalizeFloatVec(const float* x, int32_t dim);
 
-constexpr inline uint64_t seed = 0xc70f6907UL;
+// Normalized copy of x in a buffer of the calling thread, valid until the next call on the same thread. Saves the
+// allocation of CopyAndNormalizeFloatVec for a query normalized once per search task.
+const float*
+NormalizeQuery(const float* x, int32_t dim);
+
+// fp32 copy of a fp16 / bf16 dataset, for indexes that only store fp32 vectors
+DataSetPtr
+ConvertToFloatDataSet(const DataSet& dataset);
+
+// Normalized fp32 copy of the dataset, the caller's buffer is left untouched
+DataSetPtr
+CopyAndNormalize(const DataSet& dataset);
+
+// 64-bit hash of n bytes for cache keys, computed by the SIMD kernel of the running CPU
+uint64_t
+hash_bytes(const void* x, size_t n);
 
 inline uint64_t
 hash_vec(const float* x, size_t d) {
-    uint64_t h = seed;
-    for (size_t i = 0; i < d; ++i) {
-        h = h * 13331 + *(uint32_t*)(x + i);
-    }
-    return h;
+    return hash_bytes(x, d * sizeof(float));
 }
 
+// hash of a binary vector of d bits
 inline uint64_t
 hash_binary_vec(const uint8_t* x, size_t d) {
-    size_t len = (d + 7) / 8;
-    uint64_t h = seed;
-    for (size_t i = 0; i < len; ++i) {
-        h = h * 13331 + x[i];
-    }
-    return h;
+    return hash_bytes(x, (d + 7) / 8);
 }
 
 template <typename T>
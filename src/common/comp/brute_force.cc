@@ -11,6 +11,8 @@
 
 #include "knowhere/comp/brute_force.h"
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 
 #include "common/metric.h"
@@ -18,11 +20,13 @@
 #include "faiss/MetricType.h"
 #include "faiss/utils/binary_distances.h"
 #include "faiss/utils/distances.h"
+#include "knowhere/comp/filter_strategy.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/config.h"
 #include "knowhere/expected.h"
 #include "knowhere/log.h"
 #include "knowhere/utils.h"
+#include "simd/hook.h"
 
 namespace knowhere {
 
@@ -30,6 +34,145 @@ namespace knowhere {
 
 class BruteForceConfig : public BaseConfig {};
 
+namespace {
+// Below this fraction of unfiltered rows, the unfiltered ids are gathered once from the bitset and distances are only
+// computed for them, instead of scanning all rows and testing the bitset per row.
+constexpr float kIdListSearchMaxSelectivity = 0.1f;
+
+bool
+UseIdListSearch(const BitsetView& bitset, int64_t nb) {
+    return !bitset.empty() && static_cast<int64_t>(bitset.count()) > nb * (1.0f - kIdListSearchMaxSelectivity);
+}
+
+// From this number of queries on, float queries are searched in blocks with the BLAS kernels, which turns brute force
+// from bandwidth bound into compute bound.
+constexpr int64_t kBlasSearchMinQueryNum = 64;
+// number of queries searched by one task of the blocked BLAS path
+constexpr int64_t kBlasSearchQueryBlockSize = 256;
+
+bool
+UseBlasSearch(faiss::MetricType metric_type, int64_t nq) {
+    return (metric_type == faiss::METRIC_L2 || metric_type == faiss::METRIC_INNER_PRODUCT) &&
+           nq >= kBlasSearchMinQueryNum;
+}
+
+// Split the queries into blocks searched in parallel, each block against the whole base with the faiss BLAS kernels
+// (query block x base block GEMM tiles and a top-k heap per query). Every block is waited for before returning, the
+// first failure is returned.
+Status
+BlasSearch(faiss::MetricType metric_type, bool is_cosine, const float* xb, int64_t nb, const float* xq, int64_t nq,
+           int64_t dim, int topk, int64_t* labels, float* distances, const BitsetView& bitset) {
+    // base norms are shared by all the blocks, squared for L2
+    std::unique_ptr<float[]> base_norms;
+    if (metric_type == faiss::METRIC_L2) {
+        base_norms = std::make_unique<float[]>(nb);
+        faiss::fvec_norms_L2sqr(base_norms.get(), xb, dim, nb);
+    } else if (is_cosine) {
+        base_norms = std::make_unique<float[]>(nb);
+        faiss::fvec_norms_L2(base_norms.get(), xb, dim, nb);
+    }
+
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    std::vector<folly::Future<Status>> futs;
+    futs.reserve((nq + kBlasSearchQueryBlockSize - 1) / kBlasSearchQueryBlockSize);
+    for (int64_t q0 = 0; q0 < nq; q0 += kBlasSearchQueryBlockSize) {
+        futs.emplace_back(pool->push([&, q0] {
+            ThreadPool::ScopedOmpSetter setter(1);
+            auto n = static_cast<size_t>(std::min(kBlasSearchQueryBlockSize, nq - q0));
+            auto block_query = xq + q0 * dim;
+            auto block_labels = labels + q0 * topk;
+            auto block_distances = distances + q0 * topk;
+            try {
+                if (metric_type == faiss::METRIC_L2) {
+                    faiss::float_maxheap_array_t buf{n, (size_t)topk, block_labels, block_distances};
+                    faiss::knn_L2sqr_blas(block_query, xb, dim, n, nb, &buf, base_norms.get(), bitset);
+                } else if (is_cosine) {
+                    auto copied_query = std::make_unique<float[]>(n * dim);
+                    std::copy_n(block_query, n * dim, copied_query.get());
+                    NormalizeVecs(copied_query.get(), n, dim);
+                    faiss::float_minheap_array_t buf{n, (size_t)topk, block_labels, block_distances};
+                    faiss::knn_cosine_blas(copied_query.get(), xb, dim, n, nb, &buf, base_norms.get(), bitset);
+                } else {
+                    faiss::float_minheap_array_t buf{n, (size_t)topk, block_labels, block_distances};
+                    faiss::knn_inner_product_blas(block_query, xb, dim, n, nb, &buf, bitset);
+                }
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return Status::faiss_inner_error;
+            }
+            return Status::success;
+        }));
+    }
+    Status status = Status::success;
+    for (auto& fut : futs) {
+        fut.wait();
+        auto ret = fut.result().value();
+        if (status == Status::success) {
+            status = ret;
+        }
+    }
+    return status;
+}
+
+// Search the base rows listed in `ids` for the query `index`, ids < 0 end the list.
+Status
+SearchByIdsForOneNq(faiss::MetricType metric_type, bool is_cosine, const void* xb, const void* xq, int64_t dim,
+                    int64_t index, const std::vector<int64_t>& ids, int topk, int64_t* cur_labels,
+                    float* cur_distances) {
+    switch (metric_type) {
+        case faiss::METRIC_L2: {
+            auto cur_query = (const float*)xq + dim * index;
+            faiss::float_maxheap_array_t buf{(size_t)1, (size_t)topk, cur_labels, cur_distances};
+            faiss::knn_L2sqr_by_idx(cur_query, (const float*)xb, ids.data(), dim, 1, ids.size(), &buf);
+            break;
+        }
+        case faiss::METRIC_INNER_PRODUCT: {
+            auto cur_query = (const float*)xq + dim * index;
+            faiss::float_minheap_array_t buf{(size_t)1, (size_t)topk, cur_labels, cur_distances};
+            if (is_cosine) {
+                auto normalized_query = NormalizeQuery(cur_query, dim);
+                faiss::knn_cosine_by_idx(normalized_query, (const float*)xb, ids.data(), dim, 1, ids.size(), &buf);
+            } else {
+                faiss::knn_inner_products_by_idx(cur_query, (const float*)xb, ids.data(), dim, 1, ids.size(), &buf);
+            }
+            break;
+        }
+        case faiss::METRIC_Jaccard:
+        case faiss::METRIC_TLSH: {
+            auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
+            faiss::float_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, cur_distances};
+            faiss::binary_knn_hc_by_idx(metric_type, &res, cur_query, (const uint8_t*)xb, ids.data(), ids.size(),
+                                        dim / 8);
+            break;
+        }
+        case faiss::METRIC_Hamming: {
+            auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
+            std::vector<int32_t> int_distances(topk);
+            faiss::int_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, int_distances.data()};
+            faiss::binary_knn_hc_by_idx(faiss::METRIC_Hamming, &res, cur_query, (const uint8_t*)xb, ids.data(),
+                                        ids.size(), dim / 8);
+            for (int i = 0; i < topk; ++i) {
+                cur_distances[i] = int_distances[i];
+            }
+            break;
+        }
+        case faiss::METRIC_Substructure:
+        case faiss::METRIC_Superstructure: {
+            // only matched ids will be chosen, not to use heap
+            auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
+            faiss::binary_knn_mc_by_idx(metric_type, cur_query, (const uint8_t*)xb, ids.data(), 1, ids.size(), topk,
+                                        dim / 8, cur_distances, cur_labels);
+            break;
+        }
+        default: {
+            LOG_KNOWHERE_ERROR_ << "Invalid metric type: " << metric_type;
+            return Status::invalid_metric_type;
+        }
+    }
+    return Status::success;
+}
+}  // namespace
+
 expected<DataSetPtr>
 BruteForce::Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const Json& config,
                    const BitsetView& bitset) {
@@ -59,14 +202,39 @@ BruteForce::Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset
     auto labels = new int64_t[nq * topk];
     auto distances = new float[nq * topk];
 
+    const bool use_id_list = UseIdListSearch(bitset, nb);
+    const auto unfiltered_ids = use_id_list ? GatherUnfilteredIds(bitset, nb) : std::vector<int64_t>();
+    if (!use_id_list && UseBlasSearch(faiss_metric_type, nq)) {
+        std::string error = "failed to brute force search";
+        try {
+            status = BlasSearch(faiss_metric_type, is_cosine, (const float*)xb, nb, (const float*)xq, nq, dim, topk,
+                                labels, distances, bitset);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            status = Status::faiss_inner_error;
+            error = e.what();
+        }
+        if (status != Status::success) {
+            delete[] labels;
+            delete[] distances;
+            return expected<DataSetPtr>::Err(status, error);
+        }
+        return GenResultDataSet(nq, cfg.k.value(), labels, distances);
+    }
+
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
     std::vector<folly::Future<Status>> futs;
     futs.reserve(nq);
     for (int i = 0; i < nq; ++i) {
         futs.emplace_back(pool->push([&, index = i] {
             ThreadPool::ScopedOmpSetter setter(1);
+            faiss::ScopedEarlyAbandon early_abandon(cfg.early_abandon.value());
             auto cur_labels = labels + topk * index;
             auto cur_distances = distances + topk * index;
+            if (use_id_list) {
+                return SearchByIdsForOneNq(faiss_metric_type, is_cosine, xb, xq, dim, index, unfiltered_ids, topk,
+                                           cur_labels, cur_distances);
+            }
             switch (faiss_metric_type) {
                 case faiss::METRIC_L2: {
                     auto cur_query = (const float*)xq + dim * index;
@@ -78,8 +246,8 @@ BruteForce::Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset
                     auto cur_query = (const float*)xq + dim * index;
                     faiss::float_minheap_array_t buf{(size_t)1, (size_t)topk, cur_labels, cur_distances};
                     if (is_cosine) {
-                        auto copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        faiss::knn_cosine(copied_query.get(), (const float*)xb, dim, 1, nb, &buf, bitset);
+                        auto normalized_query = NormalizeQuery(cur_query, dim);
+                        faiss::knn_cosine(normalized_query, (const float*)xb, dim, 1, nb, &buf, bitset);
                     } else {
                         faiss::knn_inner_product(cur_query, (const float*)xb, dim, 1, nb, &buf, bitset);
                     }
@@ -134,6 +302,69 @@ BruteForce::Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset
     return GenResultDataSet(nq, cfg.k.value(), labels, distances);
 }
 
+expected<DataSetPtr>
+BruteForce::SearchByIds(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const DataSetPtr ids_dataset,
+                        const Json& config) {
+    auto xb = base_dataset->GetTensor();
+    auto nb = base_dataset->GetRows();
+    auto dim = base_dataset->GetDim();
+
+    auto xq = query_dataset->GetTensor();
+    auto nq = query_dataset->GetRows();
+
+    BruteForceConfig cfg;
+    std::string msg;
+    auto status = Config::Load(cfg, config, knowhere::SEARCH, &msg);
+    if (status != Status::success) {
+        return expected<DataSetPtr>::Err(status, msg);
+    }
+
+    std::string metric_str = cfg.metric_type.value();
+    auto result = Str2FaissMetricType(metric_str);
+    if (result.error() != Status::success) {
+        return expected<DataSetPtr>::Err(result.error(), result.what());
+    }
+    faiss::MetricType faiss_metric_type = result.value();
+    bool is_cosine = IsMetricType(metric_str, metric::COSINE);
+
+    auto p_ids = ids_dataset->GetIds();
+    std::vector<int64_t> ids(p_ids, p_ids + ids_dataset->GetRows());
+    for (const auto id : ids) {
+        if (id >= nb) {
+            msg = "id " + std::to_string(id) + " is out of range, row count is " + std::to_string(nb);
+            LOG_KNOWHERE_ERROR_ << msg;
+            return expected<DataSetPtr>::Err(Status::invalid_args, msg);
+        }
+    }
+    // negative ids end the list
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [](int64_t id) { return id < 0; }), ids.end());
+
+    int topk = cfg.k.value();
+    auto labels = new int64_t[nq * topk];
+    auto distances = new float[nq * topk];
+
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    std::vector<folly::Future<Status>> futs;
+    futs.reserve(nq);
+    for (int i = 0; i < nq; ++i) {
+        futs.emplace_back(pool->push([&, index = i] {
+            ThreadPool::ScopedOmpSetter setter(1);
+            return SearchByIdsForOneNq(faiss_metric_type, is_cosine, xb, xq, dim, index, ids, topk,
+                                       labels + topk * index, distances + topk * index);
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.wait();
+        auto ret = fut.result().value();
+        if (ret != Status::success) {
+            delete[] labels;
+            delete[] distances;
+            return expected<DataSetPtr>::Err(ret, "failed to brute force search by ids");
+        }
+    }
+    return GenResultDataSet(nq, cfg.k.value(), labels, distances);
+}
+
 Status
 BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_dataset, int64_t* ids, float* dis,
                           const Json& config, const BitsetView& bitset) {
@@ -159,14 +390,31 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
     auto labels = ids;
     auto distances = dis;
 
+    const bool use_id_list = UseIdListSearch(bitset, nb);
+    const auto unfiltered_ids = use_id_list ? GatherUnfilteredIds(bitset, nb) : std::vector<int64_t>();
+    if (!use_id_list && UseBlasSearch(faiss_metric_type, nq)) {
+        try {
+            return BlasSearch(faiss_metric_type, is_cosine, (const float*)xb, nb, (const float*)xq, nq, dim, topk,
+                              labels, distances, bitset);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+    }
+
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
     std::vector<folly::Future<Status>> futs;
     futs.reserve(nq);
     for (int i = 0; i < nq; ++i) {
         futs.emplace_back(pool->push([&, index = i] {
             ThreadPool::ScopedOmpSetter setter(1);
+            faiss::ScopedEarlyAbandon early_abandon(cfg.early_abandon.value());
             auto cur_labels = labels + topk * index;
             auto cur_distances = distances + topk * index;
+            if (use_id_list) {
+                return SearchByIdsForOneNq(faiss_metric_type, is_cosine, xb, xq, dim, index, unfiltered_ids, topk,
+                                           cur_labels, cur_distances);
+            }
             switch (faiss_metric_type) {
                 case faiss::METRIC_L2: {
                     auto cur_query = (const float*)xq + dim * index;
@@ -178,8 +426,8 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
                     auto cur_query = (const float*)xq + dim * index;
                     faiss::float_minheap_array_t buf{(size_t)1, (size_t)topk, cur_labels, cur_distances};
                     if (is_cosine) {
-                        auto copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        faiss::knn_cosine(copied_query.get(), (const float*)xb, dim, 1, nb, &buf, bitset);
+                        auto normalized_query = NormalizeQuery(cur_query, dim);
+                        faiss::knn_cosine(normalized_query, (const float*)xb, dim, 1, nb, &buf, bitset);
                     } else {
                         faiss::knn_inner_product(cur_query, (const float*)xb, dim, 1, nb, &buf, bitset);
                     }
@@ -260,15 +508,12 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
     bool is_cosine = IsMetricType(metric_str, metric::COSINE);
 
     auto radius = cfg.radius.value();
-    bool is_ip = false;
+    bool is_ip = (faiss_metric_type == faiss::METRIC_INNER_PRODUCT);
     float range_filter = cfg.range_filter.value();
 
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
 
-    std::vector<std::vector<int64_t>> result_id_array(nq);
-    std::vector<std::vector<float>> result_dist_array(nq);
-    std::vector<size_t> result_size(nq);
-    std::vector<size_t> result_lims(nq + 1);
+    RangeSearchResultBuilder builder(nq, is_ip, radius, range_filter, cfg.range_search_k.value());
     std::vector<folly::Future<Status>> futs;
     futs.reserve(nq);
     for (int i = 0; i < nq; ++i) {
@@ -282,11 +527,10 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
                     break;
                 }
                 case faiss::METRIC_INNER_PRODUCT: {
-                    is_ip = true;
                     auto cur_query = (const float*)xq + dim * index;
                     if (is_cosine) {
-                        auto copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        faiss::range_search_cosine(copied_query.get(), (const float*)xb, dim, 1, nb, radius, &res,
+                        auto normalized_query = NormalizeQuery(cur_query, dim);
+                        faiss::range_search_cosine(normalized_query, (const float*)xb, dim, 1, nb, radius, &res,
                                                    bitset);
                     } else {
                         faiss::range_search_inner_product(cur_query, (const float*)xb, dim, 1, nb, radius, &res,
@@ -318,18 +562,7 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
                     return Status::invalid_metric_type;
                 }
             }
-            auto elem_cnt = res.lims[1];
-            result_dist_array[index].resize(elem_cnt);
-            result_id_array[index].resize(elem_cnt);
-            result_size[index] = elem_cnt;
-            for (size_t j = 0; j < elem_cnt; j++) {
-                result_dist_array[index][j] = res.distances[j];
-                result_id_array[index][j] = res.labels[j];
-            }
-            if (cfg.range_filter.value() != defaultRangeFilter) {
-                FilterRangeSearchResultForOneNq(result_dist_array[index], result_id_array[index], is_ip, radius,
-                                                range_filter);
-            }
+            builder.SetResult(index, res);
             return Status::success;
         }));
     }
@@ -344,7 +577,80 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
     int64_t* ids = nullptr;
     float* distances = nullptr;
     size_t* lims = nullptr;
-    GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius, range_filter, distances, ids, lims);
+    builder.Assemble(distances, ids, lims);
     return GenResultDataSet(nq, ids, distances, lims);
 }
+
+expected<std::vector<IndexNode::IteratorPtr>>
+BruteForce::AnnIterator(const DataSetPtr base_dataset, const DataSetPtr query_dataset, const Json& config,
+                        const BitsetView& bitset) {
+    auto xb = (const float*)base_dataset->GetTensor();
+    auto nb = base_dataset->GetRows();
+    auto dim = base_dataset->GetDim();
+
+    auto xq = (const float*)query_dataset->GetTensor();
+    auto nq = query_dataset->GetRows();
+
+    BruteForceConfig cfg;
+    std::string msg;
+    auto status = Config::Load(cfg, config, knowhere::SEARCH, &msg);
+    if (status != Status::success) {
+        return expected<std::vector<IndexNode::IteratorPtr>>::Err(status, msg);
+    }
+
+    std::string metric_str = cfg.metric_type.value();
+    auto result = Str2FaissMetricType(metric_str);
+    if (result.error() != Status::success) {
+        return expected<std::vector<IndexNode::IteratorPtr>>::Err(result.error(), result.what());
+    }
+    faiss::MetricType faiss_metric_type = result.value();
+    if (faiss_metric_type != faiss::METRIC_L2 && faiss_metric_type != faiss::METRIC_INNER_PRODUCT) {
+        msg = "brute force iterator does not support metric " + metric_str;
+        LOG_KNOWHERE_ERROR_ << msg;
+        return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::invalid_metric_type, msg);
+    }
+    bool is_cosine = IsMetricType(metric_str, metric::COSINE);
+
+    std::unique_ptr<float[]> base_norms;
+    if (is_cosine) {
+        base_norms = std::make_unique<float[]>(nb);
+        faiss::fvec_norms_L2(base_norms.get(), xb, dim, nb);
+    }
+
+    std::vector<IndexNode::IteratorPtr> iterators(nq);
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    std::vector<folly::Future<folly::Unit>> futs;
+    futs.reserve(nq);
+    for (int64_t i = 0; i < nq; ++i) {
+        futs.emplace_back(pool->push([&, index = i] {
+            ThreadPool::ScopedOmpSetter setter(1);
+            auto cur_query = xq + dim * index;
+            std::vector<float> distances(nb);
+            if (faiss_metric_type == faiss::METRIC_L2) {
+                faiss::fvec_L2sqr_ny(distances.data(), cur_query, xb, dim, nb);
+            } else if (is_cosine) {
+                auto normalized_query = NormalizeQuery(cur_query, dim);
+                faiss::fvec_inner_products_ny(distances.data(), normalized_query, xb, dim, nb);
+                for (int64_t j = 0; j < nb; ++j) {
+                    distances[j] /= base_norms[j];
+                }
+            } else {
+                faiss::fvec_inner_products_ny(distances.data(), cur_query, xb, dim, nb);
+            }
+            std::vector<std::pair<float, int64_t>> results;
+            results.reserve(nb);
+            for (int64_t j = 0; j < nb; ++j) {
+                if (bitset.empty() || !bitset.test(j)) {
+                    results.emplace_back(distances[j], j);
+                }
+            }
+            iterators[index] = std::make_shared<PrecomputedDistanceIterator>(
+                std::move(results), faiss_metric_type == faiss::METRIC_INNER_PRODUCT);
+        }));
+    }
+    for (auto& fut : futs) {
+        fut.wait();
+    }
+    return iterators;
+}
 }  // namespace knowhere
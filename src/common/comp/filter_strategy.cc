@@ -0,0 +1,62 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "knowhere/comp/filter_strategy.h"
+
+#include <cstring>
+
+#ifdef NOT_COMPILE_FOR_SWIG
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+void
+RecordFilterSearchPlan(const FilterSearchPlan& plan) {
+#ifdef NOT_COMPILE_FOR_SWIG
+    switch (plan.strategy) {
+        case FilterStrategy::kExpandedSearch:
+            knowhere_filter_expanded_search_count.Increment();
+            break;
+        case FilterStrategy::kBruteForce:
+            knowhere_filter_brute_force_search_count.Increment();
+            break;
+        default:
+            knowhere_filter_search_count.Increment();
+            break;
+    }
+#endif
+}
+
+std::vector<int64_t>
+GatherUnfilteredIds(const BitsetView& bitset, int64_t nb) {
+    std::vector<int64_t> ids;
+    ids.reserve(nb - std::min<int64_t>(bitset.count(), nb));
+    const auto data = bitset.data();
+    const int64_t num_words = nb / 64;
+    for (int64_t w = 0; w < num_words; ++w) {
+        uint64_t word;
+        std::memcpy(&word, data + w * 8, sizeof(word));
+        word = ~word;
+        while (word) {
+            ids.push_back(w * 64 + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+    }
+    for (int64_t i = num_words * 64; i < nb; ++i) {
+        if (!bitset.test(i)) {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,103 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "knowhere/comp/huge_page.h"
+
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include "knowhere/log.h"
+#ifdef NOT_COMPILE_FOR_SWIG
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+std::atomic<bool> huge_page_enabled{true};
+}  // namespace
+
+void*
+HugePageAlloc(size_t size) {
+    if (!huge_page_enabled.load(std::memory_order_relaxed) || size < kHugePageSize) {
+        return malloc(size);
+    }
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, kHugePageSize, size) != 0) {
+        return nullptr;
+    }
+    if (AdviseHugePages(ptr, size) > 0) {
+        UpdateHugePageMetric();
+    }
+    return ptr;
+}
+
+size_t
+AdviseHugePages(void* ptr, size_t size) {
+#ifdef MADV_HUGEPAGE
+    if (!huge_page_enabled.load(std::memory_order_relaxed) || ptr == nullptr) {
+        return 0;
+    }
+    auto begin = (reinterpret_cast<uintptr_t>(ptr) + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    auto end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(kHugePageSize - 1);
+    if (end <= begin) {
+        return 0;
+    }
+    if (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) != 0) {
+        LOG_KNOWHERE_DEBUG_ << "madvise(MADV_HUGEPAGE) failed, errno " << errno;
+        return 0;
+    }
+    return end - begin;
+#else
+    return 0;
+#endif
+}
+
+void
+SetHugePageEnabled(bool enabled) {
+    huge_page_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool
+IsHugePageEnabled() {
+    return huge_page_enabled.load(std::memory_order_relaxed);
+}
+
+size_t
+GetHugePageBytes() {
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string key;
+    while (smaps >> key) {
+        if (key == "AnonHugePages:") {
+            size_t kb = 0;
+            smaps >> kb;
+            return kb << 10;
+        }
+        smaps.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 0;
+}
+
+void
+UpdateHugePageMetric() {
+#ifdef NOT_COMPILE_FOR_SWIG
+    knowhere_huge_page_bytes.Set(GetHugePageBytes());
+#endif
+}
+
+}  // namespace knowhere
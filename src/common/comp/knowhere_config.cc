@@ -11,14 +11,21 @@
 
 #include "knowhere/comp/knowhere_config.h"
 
+#include <algorithm>
+#include <cctype>
 #include <string>
 
 #ifdef KNOWHERE_WITH_DISKANN
 #include "diskann/aio_context_pool.h"
 #endif
 #include "faiss/Clustering.h"
+#include "faiss/FaissHook.h"
 #include "faiss/utils/distances.h"
+#include "knowhere/comp/huge_page.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/result_cache.h"
 #include "knowhere/log.h"
+#include "knowhere/operands.h"
 #ifdef KNOWHERE_WITH_GPU
 #include "index/gpu/gpu_res_mgr.h"
 #endif
@@ -84,10 +91,63 @@ KnowhereConfig::SetSimdType(const SimdType simd_type) {
 #endif
     std::string simd_str;
     faiss::fvec_hook(simd_str);
+    faiss::sq_hook();
     LOG_KNOWHERE_INFO_ << "FAISS hook " << simd_str;
     return simd_str;
 }
 
+namespace {
+
+// implementation installed in the hook slot `hook`
+std::string
+ActiveHook(const std::string& hook) {
+    for (const auto& [slot, active] : faiss::active_kernels()) {
+        if (slot == hook) {
+            return active;
+        }
+    }
+    return "";
+}
+
+}  // namespace
+
+std::string
+KnowhereConfig::GetActiveKernel(const std::string& index_type, const std::string& metric_type,
+                                const std::string& data_type) {
+    std::string metric = metric_type;
+    std::transform(metric.begin(), metric.end(), metric.begin(), ::toupper);
+    // COSINE is an inner product on normalized vectors, or scaled by their inverse norms
+    if (metric == metric::COSINE) {
+        metric = metric::IP;
+    }
+    std::string type = data_type;
+    if (metric == metric::HAMMING || metric == metric::JACCARD || metric == metric::TLSH ||
+        metric == metric::SUBSTRUCTURE || metric == metric::SUPERSTRUCTURE) {
+        type = "binary";
+    } else {
+        bool is_half = data_type == data_type::FLOAT16 || data_type == data_type::BFLOAT16;
+        if (!is_half && data_type != data_type::FLOAT32) {
+            // no index takes int8 vectors yet, their kernels are only reachable through the hooks
+            return "";
+        }
+        // SQ codes, and the fp16 / bf16 rows FLAT and IVF_FLAT keep as SQ codes, are scanned by the SQ distance
+        // computer
+        if (index_type == IndexEnum::INDEX_FAISS_IVFSQ8 ||
+            (is_half && (index_type == IndexEnum::INDEX_FAISS_IDMAP || index_type == IndexEnum::INDEX_FAISS_IVFFLAT))) {
+            return faiss::sq_active_kernel();
+        }
+        // PQ codes are scored from the distance tables of the sub-quantizers
+        if (index_type == IndexEnum::INDEX_FAISS_IVFPQ) {
+            return ActiveHook(metric == metric::L2 ? "fvec_L2sqr_ny" : "fvec_inner_products_ny");
+        }
+        if (index_type.rfind("IVF_", 0) == 0 || index_type == IndexEnum::INDEX_FAISS_SCANN) {
+            // the other IVF indexes widen fp16 / bf16 input to fp32
+            type = data_type::FLOAT32;
+        }
+    }
+    return faiss::active_kernel(metric, type);
+}
+
 void
 KnowhereConfig::SetBlasThreshold(const int64_t use_blas_threshold) {
     LOG_KNOWHERE_INFO_ << "Set faiss::distance_compute_blas_threshold to " << use_blas_threshold;
@@ -132,6 +192,19 @@ KnowhereConfig::SetAioContextPool(size_t num_ctx) {
     return true;
 }
 
+void
+KnowhereConfig::SetHugePageEnabled(const bool enabled) {
+    LOG_KNOWHERE_INFO_ << "Set huge page enabled to " << enabled;
+    knowhere::SetHugePageEnabled(enabled);
+}
+
+void
+KnowhereConfig::SetSearchResultCache(const size_t capacity_bytes, const int64_t ttl_ms) {
+    LOG_KNOWHERE_INFO_ << "Set search result cache capacity to " << capacity_bytes << " bytes, ttl " << ttl_ms << " ms";
+    SearchResultCache::Instance().SetTtl(ttl_ms);
+    SearchResultCache::Instance().SetCapacity(capacity_bytes);
+}
+
 void
 KnowhereConfig::InitGPUResource(int64_t gpu_id, int64_t res_num) {
 #ifdef KNOWHERE_WITH_GPU
@@ -0,0 +1,283 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "knowhere/comp/result_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "knowhere/utils.h"
+#ifdef NOT_COMPILE_FOR_SWIG
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+
+inline uint64_t
+HashCombine(uint64_t seed, uint64_t h) {
+    return seed ^ (h + 0x9e3779b97f4a7c15UL + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+struct SearchResultCache::Shard {
+    struct Entry {
+        uint64_t key;
+        uint64_t context;
+        std::vector<uint8_t> query;
+        std::vector<int64_t> ids;
+        std::vector<float> distances;
+        std::chrono::steady_clock::time_point inserted;
+
+        size_t
+        Bytes() const {
+            return sizeof(Entry) + query.size() + ids.size() * sizeof(int64_t) + distances.size() * sizeof(float);
+        }
+    };
+
+    std::mutex mtx;
+    std::list<Entry> lru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> map;
+    size_t bytes = 0;
+
+    // returns the change of the bytes held
+    int64_t
+    Erase(std::list<Entry>::iterator it) {
+        auto freed = it->Bytes();
+        bytes -= freed;
+        map.erase(it->key);
+        lru.erase(it);
+        return -static_cast<int64_t>(freed);
+    }
+
+    bool
+    Lookup(uint64_t key, uint64_t context, const uint8_t* query, size_t row_bytes, int64_t k, int64_t ttl_ms,
+           int64_t* ids, float* distances, int64_t& freed) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto found = map.find(key);
+        if (found == map.end()) {
+            return false;
+        }
+        auto it = found->second;
+        if (ttl_ms > 0 && std::chrono::steady_clock::now() - it->inserted > std::chrono::milliseconds(ttl_ms)) {
+            freed += Erase(it);
+            return false;
+        }
+        // the key is a hash, the context key and the query itself tell collisions apart
+        if (it->context != context || it->ids.size() != static_cast<size_t>(k) || it->query.size() != row_bytes ||
+            std::memcmp(it->query.data(), query, row_bytes) != 0) {
+            return false;
+        }
+        lru.splice(lru.begin(), lru, it);
+        std::copy(it->ids.begin(), it->ids.end(), ids);
+        std::copy(it->distances.begin(), it->distances.end(), distances);
+        return true;
+    }
+
+    // returns the change of the bytes held
+    int64_t
+    Insert(Entry&& entry, size_t capacity) {
+        std::lock_guard<std::mutex> lock(mtx);
+        int64_t delta = 0;
+        auto found = map.find(entry.key);
+        if (found != map.end()) {
+            delta += Erase(found->second);
+        }
+        auto entry_bytes = entry.Bytes();
+        if (entry_bytes > capacity) {
+            return delta;
+        }
+        lru.push_front(std::move(entry));
+        map[lru.front().key] = lru.begin();
+        bytes += entry_bytes;
+        delta += entry_bytes;
+        while (bytes > capacity) {
+            delta += Erase(std::prev(lru.end()));
+        }
+        return delta;
+    }
+
+    int64_t
+    Clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto freed = static_cast<int64_t>(bytes);
+        lru.clear();
+        map.clear();
+        bytes = 0;
+        return -freed;
+    }
+};
+
+SearchResultCache::SearchResultCache() : shards_(std::make_unique<Shard[]>(kNumShards)) {
+}
+
+SearchResultCache::~SearchResultCache() = default;
+
+SearchResultCache&
+SearchResultCache::Instance() {
+    static SearchResultCache cache;
+    return cache;
+}
+
+void
+SearchResultCache::SetCapacity(size_t bytes) {
+    capacity_.store(bytes, std::memory_order_relaxed);
+    // shrink the shards to the new capacity, they are only trimmed on insertion otherwise
+    Clear();
+}
+
+void
+SearchResultCache::SetTtl(int64_t ms) {
+    ttl_ms_.store(std::max<int64_t>(ms, 0), std::memory_order_relaxed);
+}
+
+bool
+SearchResultCache::Enabled() const {
+    return capacity_.load(std::memory_order_relaxed) > 0;
+}
+
+uint64_t
+SearchResultCache::Hits() const {
+    return hits_.load(std::memory_order_relaxed);
+}
+
+uint64_t
+SearchResultCache::Misses() const {
+    return misses_.load(std::memory_order_relaxed);
+}
+
+void
+SearchResultCache::Clear() {
+    for (size_t i = 0; i < kNumShards; ++i) {
+        bytes_.fetch_add(shards_[i].Clear(), std::memory_order_relaxed);
+    }
+#ifdef NOT_COMPILE_FOR_SWIG
+    knowhere_search_cache_bytes.Set(bytes_.load(std::memory_order_relaxed));
+#endif
+}
+
+uint64_t
+SearchResultCache::ContextKey(uint64_t index_epoch, const Config& cfg, const BitsetView& bitset) {
+    // the object keys of a Json are sorted, its dump doesn't depend on the order of the config fields
+    Json params;
+    for (const auto& [name, var] : cfg.__DICT__) {
+        std::visit(
+            [&params, &name = name](const auto& entry) {
+                if ((entry.type & PARAM_TYPE::SEARCH) && entry.val->has_value()) {
+                    params[name] = entry.val->value();
+                }
+            },
+            var);
+    }
+    auto key = HashCombine(index_epoch, std::hash<std::string>{}(params.dump()));
+    if (!bitset.empty()) {
+        key = HashCombine(key, bitset.size());
+        key = HashCombine(key, hash_binary_vec(bitset.data(), bitset.size()));
+    }
+    return key;
+}
+
+expected<DataSetPtr>
+SearchResultCache::Search(const DataSet& dataset, uint64_t context, size_t row_bytes, int64_t k,
+                          const std::function<expected<DataSetPtr>(const DataSet&)>& search) {
+    const auto rows = dataset.GetRows();
+    const auto capacity = capacity_.load(std::memory_order_relaxed);
+    if (capacity == 0 || rows <= 0 || k <= 0 || row_bytes == 0) {
+        return search(dataset);
+    }
+    const auto ttl_ms = ttl_ms_.load(std::memory_order_relaxed);
+    const auto shard_capacity = capacity / kNumShards;
+    auto tensor = static_cast<const uint8_t*>(dataset.GetTensor());
+
+    std::vector<uint64_t> keys(rows);
+    std::vector<int64_t> misses;
+    std::unique_ptr<int64_t[]> ids(new int64_t[rows * k]);
+    std::unique_ptr<float[]> distances(new float[rows * k]);
+    int64_t freed = 0;
+    for (int64_t i = 0; i < rows; ++i) {
+        auto query = tensor + i * row_bytes;
+        keys[i] = HashCombine(context, hash_binary_vec(query, row_bytes * 8));
+        if (!shards_[keys[i] % kNumShards].Lookup(keys[i], context, query, row_bytes, k, ttl_ms, ids.get() + i * k,
+                                                  distances.get() + i * k, freed)) {
+            misses.push_back(i);
+        }
+    }
+    bytes_.fetch_add(freed, std::memory_order_relaxed);
+    hits_.fetch_add(rows - misses.size(), std::memory_order_relaxed);
+    misses_.fetch_add(misses.size(), std::memory_order_relaxed);
+#ifdef NOT_COMPILE_FOR_SWIG
+    knowhere_search_cache_hit_count.Increment(rows - misses.size());
+    knowhere_search_cache_miss_count.Increment(misses.size());
+#endif
+    if (misses.empty()) {
+        return GenResultDataSet(rows, k, ids.release(), distances.release());
+    }
+
+    // search the missed queries only, in a dataset of their own unless all of them missed
+    DataSetPtr miss_ds;
+    if (misses.size() < static_cast<size_t>(rows)) {
+        auto miss_tensor = new char[misses.size() * row_bytes];
+        for (size_t j = 0; j < misses.size(); ++j) {
+            std::memcpy(miss_tensor + j * row_bytes, tensor + misses[j] * row_bytes, row_bytes);
+        }
+        miss_ds = GenDataSet(misses.size(), dataset.GetDim(), miss_tensor);
+        miss_ds->SetIsOwner(true);
+        miss_ds->SetTensorDataType(dataset.GetTensorDataType());
+    }
+    auto res = search(miss_ds ? *miss_ds : dataset);
+    if (!res.has_value()) {
+        return res;
+    }
+    auto miss_res = res.value();
+    if (miss_res->GetRows() != static_cast<int64_t>(misses.size()) || miss_res->GetDim() != k) {
+        // results of an unexpected shape are not cached
+        if (miss_ds) {
+            return search(dataset);
+        }
+        return res;
+    }
+
+    int64_t delta = 0;
+    auto now = std::chrono::steady_clock::now();
+    for (size_t j = 0; j < misses.size(); ++j) {
+        auto i = misses[j];
+        auto miss_ids = miss_res->GetIds() + j * k;
+        auto miss_distances = miss_res->GetDistance() + j * k;
+        Shard::Entry entry{keys[i],
+                           context,
+                           std::vector<uint8_t>(tensor + i * row_bytes, tensor + (i + 1) * row_bytes),
+                           std::vector<int64_t>(miss_ids, miss_ids + k),
+                           std::vector<float>(miss_distances, miss_distances + k),
+                           now};
+        delta += shards_[keys[i] % kNumShards].Insert(std::move(entry), shard_capacity);
+        std::copy(miss_ids, miss_ids + k, ids.get() + i * k);
+        std::copy(miss_distances, miss_distances + k, distances.get() + i * k);
+    }
+    bytes_.fetch_add(delta, std::memory_order_relaxed);
+#ifdef NOT_COMPILE_FOR_SWIG
+    knowhere_search_cache_bytes.Set(bytes_.load(std::memory_order_relaxed));
+#endif
+    if (!miss_ds) {
+        return res;
+    }
+    return GenResultDataSet(rows, k, ids.release(), distances.release());
+}
+
+}  // namespace knowhere
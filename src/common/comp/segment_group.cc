@@ -0,0 +1,204 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "knowhere/comp/segment_group.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/log.h"
+#include "knowhere/utils.h"
+
+namespace knowhere {
+
+namespace {
+// Bytes of one query of `dataset`, 0 when its rows can't be told apart and the queries must stay in one block.
+size_t
+QueryRowBytes(const std::string& metric_type, const DataSet& dataset) {
+    if (IsMetricType(metric_type, metric::TLSH)) {
+        return 0;
+    }
+    if (IsMetricType(metric_type, metric::HAMMING) || IsMetricType(metric_type, metric::JACCARD) ||
+        IsMetricType(metric_type, metric::SUBSTRUCTURE) || IsMetricType(metric_type, metric::SUPERSTRUCTURE)) {
+        return static_cast<size_t>(dataset.GetDim() / 8);
+    }
+    return dataset.GetDim() * DataTypeSize(dataset.GetTensorDataType());
+}
+}  // namespace
+
+SegmentGroup::SegmentGroup(std::vector<Index<IndexNode>> segments, std::vector<int64_t> id_offsets)
+    : segments_(std::move(segments)), id_offsets_(std::move(id_offsets)) {
+}
+
+expected<DataSetPtr>
+SegmentGroup::Search(const DataSet& dataset, const Json& json, const std::vector<BitsetView>& bitsets) const {
+    const auto num_segments = segments_.size();
+    if (num_segments == 0) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "segment group is empty");
+    }
+    if (!id_offsets_.empty() && id_offsets_.size() != num_segments) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "one id offset per segment is required");
+    }
+    if (!bitsets.empty() && bitsets.size() != num_segments) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "one bitset per segment is required");
+    }
+    if (!json.contains(meta::TOPK) || !json[meta::TOPK].is_number_integer()) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "k is required to search a segment group");
+    }
+
+    const int64_t k = json[meta::TOPK];
+    const auto nq = dataset.GetRows();
+    std::string metric_type = metric::L2;
+    if (json.contains(meta::METRIC_TYPE) && json[meta::METRIC_TYPE].is_string()) {
+        metric_type = json[meta::METRIC_TYPE];
+    }
+    const bool larger_is_closer = IsMetricType(metric_type, metric::IP) || IsMetricType(metric_type, metric::COSINE);
+
+    // running global top k, each segment result is merged into it as soon as it is found
+    auto out_ids = std::make_unique<int64_t[]>(nq * k);
+    auto out_distances = std::make_unique<float[]>(nq * k);
+    std::fill_n(out_ids.get(), nq * k, -1);
+    std::fill_n(out_distances.get(), nq * k,
+                larger_is_closer ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity());
+    // k-th distance of the full running rows, passed to the next segment searches of the query to prune with
+    std::vector<float> bounds(nq, std::numeric_limits<float>::quiet_NaN());
+
+    // one task per segment and block of queries on the search thread pool, the segment searches run their per query
+    // tasks inline there. The blocks keep the pool busy on few segments and let a merge lock only its own rows.
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    const auto row_bytes = QueryRowBytes(metric_type, dataset);
+    const int64_t num_blocks = row_bytes == 0 ? 1 : std::clamp<int64_t>(pool->size(), 1, std::max<int64_t>(nq, 1));
+    const int64_t block_rows = (nq + num_blocks - 1) / num_blocks;
+    std::vector<std::mutex> block_mutexes(num_blocks);
+
+    std::atomic<bool> failed{false};
+    std::mutex status_mutex;
+    size_t failed_segment = num_segments;
+    Status failed_status = Status::success;
+    std::string failed_msg;
+
+    auto search_block = [&](size_t s, int64_t b) {
+        if (failed.load()) {
+            return;
+        }
+        const auto begin = b * block_rows;
+        const auto rows = std::min(block_rows, nq - begin);
+        std::vector<float> block_bounds(rows);
+        {
+            std::lock_guard lock(block_mutexes[b]);
+            std::copy_n(bounds.begin() + begin, rows, block_bounds.begin());
+        }
+        auto queries =
+            GenDataSet(rows, dataset.GetDim(), static_cast<const uint8_t*>(dataset.GetTensor()) + begin * row_bytes);
+        queries->SetTensorDataType(dataset.GetTensorDataType());
+        queries->SetKnnBounds(block_bounds.data());
+        auto res = segments_[s].Search(*queries, json, bitsets.empty() ? BitsetView() : bitsets[s]);
+        if (res.has_value() && res.value()->GetDim() != k) {
+            res = expected<DataSetPtr>::Err(Status::invalid_args, "segment returned an unexpected top k");
+        }
+        if (!res.has_value()) {
+            failed = true;
+            std::lock_guard lock(status_mutex);
+            if (s < failed_segment) {
+                failed_segment = s;
+                failed_status = res.error();
+                failed_msg = res.what();
+            }
+            return;
+        }
+
+        std::vector<int64_t> merged_ids(rows * k);
+        std::vector<float> merged_distances(rows * k);
+        const int64_t offsets[2] = {0, id_offsets_.empty() ? 0 : id_offsets_[s]};
+        std::lock_guard lock(block_mutexes[b]);
+        MergeTopK({out_ids.get() + begin * k, res.value()->GetIds()},
+                  {out_distances.get() + begin * k, res.value()->GetDistance()}, offsets, rows, k, larger_is_closer,
+                  merged_ids.data(), merged_distances.data());
+        std::copy(merged_ids.begin(), merged_ids.end(), out_ids.get() + begin * k);
+        std::copy(merged_distances.begin(), merged_distances.end(), out_distances.get() + begin * k);
+        for (int64_t q = 0; k > 0 && q < rows; ++q) {
+            if (merged_ids[q * k + k - 1] >= 0) {
+                bounds[begin + q] = merged_distances[q * k + k - 1];
+            }
+        }
+    };
+
+    // segment major, so that the first segments tighten the bounds of the later ones
+    std::vector<folly::Future<folly::Unit>> futs;
+    futs.reserve(num_segments * num_blocks);
+    for (size_t s = 0; s < num_segments; ++s) {
+        for (int64_t b = 0; b < num_blocks && b * block_rows < nq; ++b) {
+            futs.emplace_back(pool->push([&, s, b] { search_block(s, b); }));
+        }
+    }
+    for (auto& fut : futs) {
+        fut.wait();
+    }
+
+    if (failed_segment < num_segments) {
+        LOG_KNOWHERE_WARNING_ << "search on segment " << failed_segment << " failed: " << failed_msg;
+        return expected<DataSetPtr>::Err(failed_status, failed_msg);
+    }
+    return GenResultDataSet(nq, k, out_ids.release(), out_distances.release());
+}
+
+void
+MergeTopK(const std::vector<const int64_t*>& ids, const std::vector<const float*>& distances,
+          const int64_t* id_offsets, int64_t nq, int64_t k, bool larger_is_closer, int64_t* out_ids,
+          float* out_distances) {
+    const auto n = ids.size();
+    // (sign * distance, list), a min-heap on the sign keeps the closest head on top for both orders
+    using Head = std::pair<float, size_t>;
+    const float sign = larger_is_closer ? -1.0f : 1.0f;
+    std::vector<int64_t> cursors(n);
+    std::vector<Head> heap;
+    heap.reserve(n);
+    for (int64_t q = 0; q < nq; ++q) {
+        const auto row = q * k;
+        heap.clear();
+        for (size_t i = 0; i < n; ++i) {
+            cursors[i] = 0;
+            if (k > 0 && ids[i][row] >= 0) {
+                heap.emplace_back(sign * distances[i][row], i);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), std::greater<>());
+        int64_t filled = 0;
+        while (filled < k && !heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+            const auto i = heap.back().second;
+            heap.pop_back();
+            const auto pos = row + cursors[i];
+            out_ids[row + filled] = ids[i][pos] + (id_offsets ? id_offsets[i] : 0);
+            out_distances[row + filled] = distances[i][pos];
+            ++filled;
+            if (++cursors[i] < k && ids[i][pos + 1] >= 0) {
+                heap.emplace_back(sign * distances[i][pos + 1], i);
+                std::push_heap(heap.begin(), heap.end(), std::greater<>());
+            }
+        }
+        for (; filled < k; ++filled) {
+            out_ids[row + filled] = -1;
+            out_distances[row + filled] = larger_is_closer ? -std::numeric_limits<float>::infinity()
+                                                           : std::numeric_limits<float>::infinity();
+        }
+    }
+}
+
+}  // namespace knowhere
@@ -0,0 +1,115 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "knowhere/dataset_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "knowhere/log.h"
+
+namespace knowhere {
+
+namespace {
+constexpr int64_t kFbinHeaderSize = 2 * sizeof(int32_t);
+
+size_t
+RowSize(const DataSet& dataset) {
+    return dataset.GetDim() * DataTypeSize(dataset.GetTensorDataType());
+}
+}  // namespace
+
+DataSetPtr
+MemoryDataSetReader::Next(int64_t max_rows) {
+    auto rows = std::min(max_rows, dataset_->GetRows() - offset_);
+    if (rows <= 0) {
+        return nullptr;
+    }
+    auto chunk = GenDataSet(rows, dataset_->GetDim(),
+                            (const char*)dataset_->GetTensor() + offset_ * RowSize(*dataset_));
+    chunk->SetTensorDataType(dataset_->GetTensorDataType());
+    offset_ += rows;
+    return chunk;
+}
+
+FbinDataSetReader::FbinDataSetReader(const std::string& path) : in_(path, std::ios::binary) {
+    int32_t header[2] = {0, 0};
+    if (!in_.read(reinterpret_cast<char*>(header), kFbinHeaderSize) || header[0] < 0 || header[1] <= 0) {
+        LOG_KNOWHERE_ERROR_ << "invalid fbin file " << path;
+        return;
+    }
+    rows_ = header[0];
+    dim_ = header[1];
+}
+
+DataSetPtr
+FbinDataSetReader::Next(int64_t max_rows) {
+    auto rows = std::min(max_rows, rows_ - offset_);
+    if (!Valid() || rows <= 0) {
+        return nullptr;
+    }
+    auto data = new char[rows * dim_ * sizeof(float)];
+    if (!in_.read(data, rows * dim_ * sizeof(float))) {
+        LOG_KNOWHERE_ERROR_ << "fbin file truncated at row " << offset_;
+        delete[] data;
+        return nullptr;
+    }
+    offset_ += rows;
+    return GenResultDataSet(rows, dim_, data);
+}
+
+Status
+FbinDataSetReader::Reset() {
+    if (!Valid()) {
+        return Status::invalid_args;
+    }
+    in_.clear();
+    in_.seekg(kFbinHeaderSize);
+    offset_ = 0;
+    return in_ ? Status::success : Status::invalid_args;
+}
+
+DataSetPtr
+SampleDataSet(DataSetReader& reader, int64_t max_rows, int64_t chunk_rows, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    const auto target = std::min(max_rows, reader.Rows());
+    char* data = nullptr;
+    size_t row_size = 0;
+    DataType type = DataType::kFloat32;
+    int64_t seen = 0;
+    while (auto chunk = reader.Next(chunk_rows)) {
+        if (data == nullptr) {
+            type = chunk->GetTensorDataType();
+            row_size = RowSize(*chunk);
+            data = new char[target * row_size];
+        }
+        auto src = (const char*)chunk->GetTensor();
+        for (int64_t i = 0; i < chunk->GetRows(); i++, seen++) {
+            int64_t slot = seen;
+            if (seen >= target) {
+                slot = std::uniform_int_distribution<int64_t>(0, seen)(rng);
+                if (slot >= target) {
+                    continue;
+                }
+            }
+            memcpy(data + slot * row_size, src + i * row_size, row_size);
+        }
+    }
+    if (data == nullptr) {
+        return nullptr;
+    }
+    auto sample = GenResultDataSet(std::min(seen, target), reader.Dim(), data);
+    sample->SetTensorDataType(type);
+    return sample;
+}
+
+}  // namespace knowhere
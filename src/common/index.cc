@@ -11,9 +11,17 @@
 
 #include "knowhere/index.h"
 
+#include <map>
+#include <numeric>
+
+#include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/calibration.h"
+#include "knowhere/comp/filter_strategy.h"
+#include "knowhere/comp/result_cache.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
 #include "knowhere/log.h"
+#include "knowhere/utils.h"
 
 #ifdef NOT_COMPILE_FOR_SWIG
 #include "knowhere/prometheus_client.h"
@@ -31,6 +39,34 @@ LoadConfig(BaseConfig* cfg, const Json& json, knowhere::PARAM_TYPE param_type, c
     return Config::Load(*cfg, json_, param_type, msg);
 }
 
+// Replace the `target_recall` of a search json by the width the recall curve of the index gives for it.
+inline Status
+ResolveTargetRecall(const IndexNode& node, const BaseConfig& cfg, const Json& json, Json* resolved,
+                    std::string* const msg) {
+    auto curve = node.GetRecallCurve();
+    if (curve == nullptr) {
+        *msg = "target_recall needs an index calibrated with Calibrate";
+        LOG_KNOWHERE_ERROR_ << *msg;
+        return Status::invalid_args;
+    }
+    auto found = curve->WidthFor(cfg.target_recall.value());
+    if (!found.has_value()) {
+        *msg = "target_recall " + std::to_string(cfg.target_recall.value()) + " is above the best recall " +
+               std::to_string(curve->BestRecall()) + " measured by Calibrate, calibrate the index for it";
+        LOG_KNOWHERE_ERROR_ << *msg;
+        return Status::invalid_args;
+    }
+    int32_t width = found.value();
+    auto param = GetCalibrationParam(node.Type());
+    if (param.has_value() && param->at_least_k) {
+        width = std::max(width, cfg.k.value());
+    }
+    *resolved = json;
+    resolved->erase(meta::TARGET_RECALL);
+    (*resolved)[curve->param] = width;
+    return Status::success;
+}
+
 template <typename T>
 inline Status
 Index<T>::Build(const DataSet& dataset, const Json& json) {
@@ -41,7 +77,26 @@ Index<T>::Build(const DataSet& dataset, const Json& json) {
 #ifdef NOT_COMPILE_FOR_SWIG
     knowhere_build_count.Increment();
 #endif
-    return this->node->Build(dataset, *cfg);
+    auto status = this->node->Build(dataset, *cfg);
+    this->node->SetRecallCurve(nullptr);
+    this->node->RenewCacheEpoch();
+    return status;
+}
+
+template <typename T>
+inline Status
+Index<T>::BuildFromReader(DataSetReader& reader, const Json& json) {
+    auto cfg = this->node->CreateConfig();
+    RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "BuildFromReader"));
+    RETURN_IF_ERROR(cfg->CheckAndAdjustForBuild());
+
+#ifdef NOT_COMPILE_FOR_SWIG
+    knowhere_build_count.Increment();
+#endif
+    auto status = this->node->BuildFromReader(reader, *cfg);
+    this->node->SetRecallCurve(nullptr);
+    this->node->RenewCacheEpoch();
+    return status;
 }
 
 template <typename T>
@@ -49,7 +104,10 @@ inline Status
 Index<T>::Train(const DataSet& dataset, const Json& json) {
     auto cfg = this->node->CreateConfig();
     RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "Train"));
-    return this->node->Train(dataset, *cfg);
+    auto status = this->node->Train(dataset, *cfg);
+    this->node->SetRecallCurve(nullptr);
+    this->node->RenewCacheEpoch();
+    return status;
 }
 
 template <typename T>
@@ -57,7 +115,9 @@ inline Status
 Index<T>::Add(const DataSet& dataset, const Json& json) {
     auto cfg = this->node->CreateConfig();
     RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "Add"));
-    return this->node->Add(dataset, *cfg);
+    auto status = this->node->Add(dataset, *cfg);
+    this->node->RenewCacheEpoch();
+    return status;
 }
 
 template <typename T>
@@ -65,20 +125,51 @@ inline expected<DataSetPtr>
 Index<T>::Search(const DataSet& dataset, const Json& json, const BitsetView& bitset) const {
     auto cfg = this->node->CreateConfig();
     std::string msg;
-    const Status load_status = LoadConfig(cfg.get(), json, knowhere::SEARCH, "Search", &msg);
+    Status load_status = LoadConfig(cfg.get(), json, knowhere::SEARCH, "Search", &msg);
     if (load_status != Status::success) {
         return expected<DataSetPtr>::Err(load_status, msg);
     }
+    Json resolved_json;
+    if (cfg->target_recall.has_value()) {
+        load_status = ResolveTargetRecall(*this->node, *cfg, json, &resolved_json, &msg);
+        if (load_status == Status::success) {
+            cfg = this->node->CreateConfig();
+            load_status = LoadConfig(cfg.get(), resolved_json, knowhere::SEARCH, "Search", &msg);
+        }
+        if (load_status != Status::success) {
+            return expected<DataSetPtr>::Err(load_status, msg);
+        }
+    }
     const Status search_status = cfg->CheckAndAdjustForSearch(&msg);
     if (search_status != Status::success) {
         return expected<DataSetPtr>::Err(search_status, msg);
     }
+    if (!Str2FilterStrategy(cfg->filter_strategy.value()).has_value()) {
+        msg = "unknown filter_strategy: " + cfg->filter_strategy.value();
+        LOG_KNOWHERE_ERROR_ << msg;
+        return expected<DataSetPtr>::Err(Status::invalid_args, msg);
+    }
 
 #ifdef NOT_COMPILE_FOR_SWIG
     knowhere_search_count.Increment();
     knowhere_search_topk.Observe(cfg->k.value());
 #endif
-    return this->node->Search(dataset, *cfg, bitset);
+    auto& cache = SearchResultCache::Instance();
+    // the cache only keeps ids and distances: traced searches also return their visits, and results cut by per query
+    // k-th distance bounds are not the plain top k
+    if (!cache.Enabled() || cfg->trace_visit.value() || dataset.GetKnnBounds() != nullptr) {
+        return this->node->Search(dataset, *cfg, bitset.with_cached_count());
+    }
+    const auto& metric_type = cfg->metric_type.value();
+    const bool is_float = IsMetricType(metric_type, metric::L2) || IsMetricType(metric_type, metric::IP) ||
+                          IsMetricType(metric_type, metric::COSINE);
+    const size_t row_bytes = is_float ? dataset.GetDim() * DataTypeSize(dataset.GetTensorDataType())
+                                      : static_cast<size_t>((dataset.GetDim() + 7) / 8);
+    auto context = SearchResultCache::ContextKey(this->node->CacheEpoch(), *cfg, bitset);
+    auto cached_count_bitset = bitset.with_cached_count();
+    return cache.Search(dataset, context, row_bytes, cfg->k.value(), [&](const DataSet& queries) {
+        return this->node->Search(queries, *cfg, cached_count_bitset);
+    });
 }
 
 template <typename T>
@@ -98,7 +189,161 @@ Index<T>::RangeSearch(const DataSet& dataset, const Json& json, const BitsetView
 #ifdef NOT_COMPILE_FOR_SWIG
     knowhere_range_search_count.Increment();
 #endif
-    return this->node->RangeSearch(dataset, *cfg, bitset);
+    return this->node->RangeSearch(dataset, *cfg, bitset.with_cached_count());
+}
+
+template <typename T>
+inline Status
+Index<T>::Calibrate(const DataSet& sample_queries, float target_recall, const Json& json, const DataSet* base) {
+    const auto param = GetCalibrationParam(this->node->Type());
+    if (!param.has_value()) {
+        LOG_KNOWHERE_ERROR_ << this->node->Type() << " has no search width to calibrate";
+        return Status::invalid_args;
+    }
+    if (!(target_recall > 0.0f && target_recall <= 1.0f)) {
+        LOG_KNOWHERE_ERROR_ << "target_recall should be in (0, 1], got " << target_recall;
+        return Status::invalid_args;
+    }
+    Json search_json(json);
+    search_json.erase(meta::TARGET_RECALL);
+    search_json.erase(param->name);
+    auto cfg = this->node->CreateConfig();
+    RETURN_IF_ERROR(LoadConfig(cfg.get(), search_json, knowhere::SEARCH, "Calibrate"));
+    const auto width_it = cfg->__DICT__.find(param->name);
+    const auto width_entry =
+        width_it == cfg->__DICT__.end() ? nullptr : std::get_if<Entry<CFG_INT>>(&width_it->second);
+    if (width_entry == nullptr) {
+        LOG_KNOWHERE_ERROR_ << param->name << " is not an integer search param of " << this->node->Type();
+        return Status::invalid_args;
+    }
+    const auto& metric_type = cfg->metric_type.value();
+    const int32_t k = cfg->k.value();
+    const int64_t nq = sample_queries.GetRows();
+
+    // brute force ground truth on the given base or on the raw data of the index, float vectors widened to fp32
+    const bool is_float = IsMetricType(metric_type, metric::L2) || IsMetricType(metric_type, metric::IP) ||
+                          IsMetricType(metric_type, metric::COSINE);
+    DataSetPtr base_ds;
+    if (base != nullptr) {
+        base_ds =
+            is_float ? ConvertToFloatDataSet(*base) : GenDataSet(base->GetRows(), base->GetDim(), base->GetTensor());
+    } else if (this->node->HasRawData(metric_type)) {
+        std::vector<int64_t> ids(this->node->Count());
+        std::iota(ids.begin(), ids.end(), 0);
+        auto vectors = this->node->GetVectorByIds(*GenIdsDataSet(ids.size(), ids.data()));
+        if (!vectors.has_value()) {
+            return vectors.error();
+        }
+        base_ds = is_float ? ConvertToFloatDataSet(*vectors.value()) : vectors.value();
+    } else {
+        LOG_KNOWHERE_ERROR_ << this->node->Type() << " keeps no raw data for " << metric_type
+                            << ", the base vectors should be given to Calibrate";
+        return Status::invalid_args;
+    }
+    auto query_ds = is_float ? ConvertToFloatDataSet(sample_queries)
+                             : GenDataSet(nq, sample_queries.GetDim(), sample_queries.GetTensor());
+    const Json gt_json = {{meta::METRIC_TYPE, metric_type}, {meta::TOPK, k}};
+    auto gt = BruteForce::Search(base_ds, query_ds, gt_json, BitsetView());
+    if (!gt.has_value()) {
+        return gt.error();
+    }
+
+    std::map<int32_t, float> recalls;
+    auto measure = [&](int32_t width, float* recall) -> Status {
+        if (auto it = recalls.find(width); it != recalls.end()) {
+            *recall = it->second;
+            return Status::success;
+        }
+        Json width_json(search_json);
+        width_json[param->name] = width;
+        auto width_cfg = this->node->CreateConfig();
+        std::string msg;
+        RETURN_IF_ERROR(LoadConfig(width_cfg.get(), width_json, knowhere::SEARCH, "Calibrate", &msg));
+        RETURN_IF_ERROR(width_cfg->CheckAndAdjustForSearch(&msg));
+        auto res = this->node->Search(sample_queries, *width_cfg, BitsetView());
+        if (!res.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "search with " << param->name << " = " << width << " failed: " << res.what();
+            return res.error();
+        }
+        *recall = RecallAtK(gt.value()->GetIds(), res.value()->GetIds(), nq, k);
+        recalls[width] = *recall;
+        return Status::success;
+    };
+
+    const int64_t start = param->at_least_k ? k : 1;
+    int64_t max_width = std::max<int64_t>(this->node->Count(), start);
+    if (width_entry->range.has_value()) {
+        max_width = std::min<int64_t>(max_width, width_entry->range->second);
+    }
+    // double the width until the target is reached, the recall stops improving or the width can't grow, ...
+    int64_t lo = start - 1, hi = start;
+    float recall = 0.0f, best = -1.0f;
+    int32_t stalled = 0;
+    while (true) {
+        RETURN_IF_ERROR(measure(hi, &recall));
+        if (recall >= target_recall) {
+            break;
+        }
+        stalled = recall > best ? 0 : stalled + 1;
+        best = std::max(best, recall);
+        if (hi >= max_width || stalled >= 2) {
+            break;
+        }
+        lo = hi;
+        hi = std::min(hi * 2, max_width);
+    }
+    if (recall >= target_recall) {
+        // ... then binary search the smallest width reaching it, recall(lo) < target_recall <= recall(hi)
+        while (hi - lo > 1) {
+            const int64_t mid = lo + (hi - lo) / 2;
+            RETURN_IF_ERROR(measure(mid, &recall));
+            if (recall >= target_recall) {
+                hi = mid;
+            } else {
+                lo = mid;
+            }
+        }
+    } else {
+        LOG_KNOWHERE_WARNING_ << this->node->Type() << " reaches a recall of " << best << " at most, below the target "
+                              << target_recall;
+    }
+
+    auto curve = std::make_shared<RecallCurve>();
+    curve->param = param->name;
+    curve->k = k;
+    curve->points.assign(recalls.begin(), recalls.end());
+    LOG_KNOWHERE_INFO_ << "calibrated " << this->node->Type() << ": " << curve->ToJson().dump();
+    this->node->SetRecallCurve(std::move(curve));
+    // searches given a target_recall resolve to a new width
+    this->node->RenewCacheEpoch();
+    return Status::success;
+}
+
+template <typename T>
+inline expected<std::vector<IndexNode::IteratorPtr>>
+Index<T>::AnnIterator(const DataSet& dataset, const Json& json, const BitsetView& bitset) const {
+    auto cfg = this->node->CreateConfig();
+    std::string msg;
+    auto status = LoadConfig(cfg.get(), json, knowhere::SEARCH, "AnnIterator", &msg);
+    if (status != Status::success) {
+        return expected<std::vector<IndexNode::IteratorPtr>>::Err(status, msg);
+    }
+    if (cfg->target_recall.has_value()) {
+        Json resolved_json;
+        status = ResolveTargetRecall(*this->node, *cfg, json, &resolved_json, &msg);
+        if (status == Status::success) {
+            cfg = this->node->CreateConfig();
+            status = LoadConfig(cfg.get(), resolved_json, knowhere::SEARCH, "AnnIterator", &msg);
+        }
+        if (status != Status::success) {
+            return expected<std::vector<IndexNode::IteratorPtr>>::Err(status, msg);
+        }
+    }
+    status = cfg->CheckAndAdjustForSearch(&msg);
+    if (status != Status::success) {
+        return expected<std::vector<IndexNode::IteratorPtr>>::Err(status, msg);
+    }
+    return this->node->AnnIterator(dataset, *cfg, bitset.with_cached_count());
 }
 
 template <typename T>
@@ -128,7 +373,14 @@ Index<T>::GetIndexMeta(const Json& json) const {
 template <typename T>
 inline Status
 Index<T>::Serialize(BinarySet& binset) const {
-    return this->node->Serialize(binset);
+    RETURN_IF_ERROR(this->node->Serialize(binset));
+    if (auto curve = this->node->GetRecallCurve(); curve != nullptr) {
+        const auto dump = curve->ToJson().dump();
+        std::shared_ptr<uint8_t[]> data(new uint8_t[dump.size()]);
+        std::copy(dump.begin(), dump.end(), data.get());
+        binset.Append(calibration::RECALL_CURVE, data, dump.size());
+    }
+    return Status::success;
 }
 
 template <typename T>
@@ -147,7 +399,20 @@ Index<T>::Deserialize(const BinarySet& binset, const Json& json) {
     if (res != Status::success) {
         return res;
     }
-    return this->node->Deserialize(binset, *cfg);
+    res = this->node->Deserialize(binset, *cfg);
+    std::shared_ptr<const RecallCurve> curve;
+    if (auto binary = binset.GetByName(calibration::RECALL_CURVE); res == Status::success && binary != nullptr) {
+        auto parsed = RecallCurve::FromJson(Json::parse(binary->data.get(), binary->data.get() + binary->size, nullptr,
+                                                        false));
+        if (parsed.has_value()) {
+            curve = std::make_shared<const RecallCurve>(std::move(parsed.value()));
+        } else {
+            LOG_KNOWHERE_WARNING_ << "ignore a malformed " << calibration::RECALL_CURVE;
+        }
+    }
+    this->node->SetRecallCurve(std::move(curve));
+    this->node->RenewCacheEpoch();
+    return res;
 }
 
 template <typename T>
@@ -166,7 +431,11 @@ Index<T>::DeserializeFromFile(const std::string& filename, const Json& json) {
     if (res != Status::success) {
         return res;
     }
-    return this->node->DeserializeFromFile(filename, *cfg);
+    res = this->node->DeserializeFromFile(filename, *cfg);
+    // the recall curve is only kept in a BinarySet
+    this->node->SetRecallCurve(nullptr);
+    this->node->RenewCacheEpoch();
+    return res;
 }
 
 template <typename T>
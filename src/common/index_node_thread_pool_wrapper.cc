@@ -45,4 +45,9 @@ IndexNodeThreadPoolWrapper::RangeSearch(const DataSet& dataset, const Config& cf
     return thread_pool_->push([&]() { return this->index_node_->RangeSearch(dataset, cfg, bitset); }).get();
 }
 
+expected<std::vector<IndexNode::IteratorPtr>>
+IndexNodeThreadPoolWrapper::AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const {
+    return thread_pool_->push([&]() { return this->index_node_->AnnIterator(dataset, cfg, bitset); }).get();
+}
+
 }  // namespace knowhere
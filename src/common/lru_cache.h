@@ -45,6 +45,13 @@ class lru_cache {
         }
     }
 
+    void
+    clear() {
+        std::unique_lock lk(mtx);
+        list.clear();
+        map.clear();
+    }
+
     bool
     try_get(const key_t& key, value_t& val) {
         std::unique_lock lk(mtx);
@@ -29,5 +29,13 @@ DEFINE_PROMETHEUS_COUNTER(knowhere_build_count, "knowhere index build count")
 DEFINE_PROMETHEUS_COUNTER(knowhere_search_count, "knowhere search count")
 DEFINE_PROMETHEUS_COUNTER(knowhere_range_search_count, "knowhere range search count")
 DEFINE_PROMETHEUS_HISTOGRAM(knowhere_search_topk, "knowhere search topk")
+DEFINE_PROMETHEUS_COUNTER(knowhere_filter_search_count, "knowhere filtered search count using index search")
+DEFINE_PROMETHEUS_COUNTER(knowhere_filter_expanded_search_count,
+                          "knowhere filtered search count using index search with expanded ef/nprobe")
+DEFINE_PROMETHEUS_COUNTER(knowhere_filter_brute_force_search_count, "knowhere filtered search count using brute force")
+DEFINE_PROMETHEUS_GAUGE(knowhere_huge_page_bytes, "anonymous memory of the process backed by huge pages in bytes")
+DEFINE_PROMETHEUS_COUNTER(knowhere_search_cache_hit_count, "knowhere search queries answered by the result cache")
+DEFINE_PROMETHEUS_COUNTER(knowhere_search_cache_miss_count, "knowhere search queries not found in the result cache")
+DEFINE_PROMETHEUS_GAUGE(knowhere_search_cache_bytes, "memory held by the knowhere search result cache in bytes")
 
 }  // namespace knowhere
@@ -13,7 +13,9 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <functional>
 
+#include "knowhere/config.h"
 #include "knowhere/log.h"
 namespace knowhere {
 
@@ -74,55 +76,83 @@ GetRangeSearchResult(const faiss::RangeSearchResult& res, const bool is_ip, cons
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// for HNSW and DiskANN
+// RangeSearchResultBuilder
+RangeSearchResultBuilder::RangeSearchResultBuilder(int64_t nq, bool is_ip, float radius, float range_filter,
+                                                   int64_t range_search_k)
+    : is_ip_(is_ip), radius_(radius), range_filter_(range_filter), range_search_k_(range_search_k), results_(nq) {
+}
+
 void
-FilterRangeSearchResultForOneNq(std::vector<float>& distances, std::vector<int64_t>& labels, const bool is_ip,
-                                const float radius, const float range_filter) {
-    KNOWHERE_THROW_IF_NOT_FMT(distances.size() == labels.size(), "distances' size %ld not equal to labels' size %ld",
-                              distances.size(), labels.size());
-    auto len = distances.size();
-    size_t valid_cnt = 0;
-    for (size_t i = 0; i < len; i++) {
-        auto dist = distances[i];
-        auto id = labels[i];
-        if (distance_in_range(dist, radius, range_filter, is_ip)) {
-            distances[valid_cnt] = dist;
-            labels[valid_cnt] = id;
-            valid_cnt++;
+RangeSearchResultBuilder::SetResult(int64_t i, faiss::RangeSearchResult& res) {
+    KNOWHERE_THROW_IF_NOT_FMT(res.nq == 1, "expect a single query result, got %zu queries", res.nq);
+    auto& result = results_[i];
+    result.size = res.labels == nullptr ? 0 : res.lims[1];
+    result.distances.reset(res.distances);
+    result.labels.reset(res.labels);
+    res.distances = nullptr;
+    res.labels = nullptr;
+    Finalize(i);
+}
+
+void
+RangeSearchResultBuilder::Finalize(int64_t i) {
+    auto& result = results_[i];
+    auto distances = result.distances.get();
+    auto labels = result.labels.get();
+    if (range_filter_ != defaultRangeFilter) {
+        const float radius = radii_ ? radii_[i] : radius_;
+        size_t valid_cnt = 0;
+        for (size_t j = 0; j < result.size; j++) {
+            if (distance_in_range(distances[j], radius, range_filter_, is_ip_)) {
+                distances[valid_cnt] = distances[j];
+                labels[valid_cnt] = labels[j];
+                valid_cnt++;
+            }
         }
+        result.size = valid_cnt;
     }
-    if (valid_cnt != distances.size()) {
-        distances.resize(valid_cnt);
-        labels.resize(valid_cnt);
+    if (range_search_k_ >= 0 && result.size > (size_t)range_search_k_) {
+        std::vector<std::pair<float, int64_t>> hits(result.size);
+        for (size_t j = 0; j < result.size; j++) {
+            hits[j] = {distances[j], labels[j]};
+        }
+        auto kth = hits.begin() + range_search_k_;
+        if (is_ip_) {
+            std::nth_element(hits.begin(), kth, hits.end(), std::greater<>());
+        } else {
+            std::nth_element(hits.begin(), kth, hits.end());
+        }
+        result.size = range_search_k_;
+        for (size_t j = 0; j < result.size; j++) {
+            distances[j] = hits[j].first;
+            labels[j] = hits[j].second;
+        }
     }
 }
 
 void
-GetRangeSearchResult(const std::vector<std::vector<float>>& result_distances,
-                     const std::vector<std::vector<int64_t>>& result_labels, const bool is_ip, const int64_t nq,
-                     const float radius, const float range_filter, float*& distances, int64_t*& labels, size_t*& lims) {
-    KNOWHERE_THROW_IF_NOT_FMT(result_distances.size() == (size_t)nq, "result distances size %ld not equal to %" SCNd64,
-                              result_distances.size(), nq);
-    KNOWHERE_THROW_IF_NOT_FMT(result_labels.size() == (size_t)nq, "result labels size %ld not equal to %" SCNd64,
-                              result_labels.size(), nq);
-
+RangeSearchResultBuilder::Assemble(float*& distances, int64_t*& labels, size_t*& lims) {
+    const int64_t nq = results_.size();
     lims = new size_t[nq + 1];
     lims[0] = 0;
-    // all distances must be in range scope
     for (int64_t i = 0; i < nq; i++) {
-        lims[i + 1] = lims[i] + result_distances[i].size();
+        lims[i + 1] = lims[i] + results_[i].size;
     }
 
     size_t total_valid = lims[nq];
-    LOG_KNOWHERE_DEBUG_ << "Range search: is_ip " << (is_ip ? "True" : "False") << ", radius " << radius
-                        << ", range_filter " << range_filter << ", total result num " << total_valid;
+    LOG_KNOWHERE_DEBUG_ << "Range search: is_ip " << (is_ip_ ? "True" : "False") << ", radius " << radius_
+                        << ", range_filter " << range_filter_ << ", total result num " << total_valid;
 
     distances = new float[total_valid];
     labels = new int64_t[total_valid];
 
-    for (auto i = 0; i < nq; i++) {
-        std::copy_n(result_distances[i].data(), lims[i + 1] - lims[i], distances + lims[i]);
-        std::copy_n(result_labels[i].data(), lims[i + 1] - lims[i], labels + lims[i]);
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < nq; i++) {
+        auto& result = results_[i];
+        std::copy_n(result.distances.get(), result.size, distances + lims[i]);
+        std::copy_n(result.labels.get(), result.size, labels + lims[i]);
+        result.distances.reset();
+        result.labels.reset();
     }
 }
 
@@ -13,6 +13,7 @@
 
 #include <faiss/impl/AuxIndexStructures.h>
 
+#include <memory>
 #include <vector>
 
 #include "knowhere/bitsetview.h"
@@ -29,13 +30,56 @@ GetRangeSearchResult(const faiss::RangeSearchResult& res, const bool is_ip, cons
                      const float range_filter, float*& distances, int64_t*& labels, size_t*& lims,
                      const BitsetView& bitset);
 
-void
-FilterRangeSearchResultForOneNq(std::vector<float>& distances, std::vector<int64_t>& labels, const bool is_ip,
-                                const float radius, const float range_filter);
+// Collects the range search hits of nq queries, each query set by one search task, and assembles the flat result
+// arrays. The hits of a query are filtered by range_filter and capped in place when they are set, so every hit is
+// copied once into the final arrays, by a parallel scatter.
+class RangeSearchResultBuilder {
+ public:
+    // range_search_k < 0 keeps every hit, otherwise only the range_search_k closest hits of each query are kept
+    RangeSearchResultBuilder(int64_t nq, bool is_ip, float radius, float range_filter, int64_t range_search_k = -1);
 
-void
-GetRangeSearchResult(const std::vector<std::vector<float>>& result_distances,
-                     const std::vector<std::vector<int64_t>>& result_labels, const bool is_ip, const int64_t nq,
-                     const float radius, const float range_filter, float*& distances, int64_t*& labels, size_t*& lims);
+    // Per query radius used by the range_filter check instead of radius, indexed by query.
+    void
+    SetRadii(const float* radii) {
+        radii_ = radii;
+    }
+
+    // Take over the buffers of a single query faiss result.
+    void
+    SetResult(int64_t i, faiss::RangeSearchResult& res);
+
+    // Set the n hits of query i, written by fill(float* distances, int64_t* labels).
+    template <typename Fill>
+    void
+    SetResult(int64_t i, size_t n, Fill&& fill) {
+        auto& result = results_[i];
+        result.distances.reset(new float[n]);
+        result.labels.reset(new int64_t[n]);
+        fill(result.distances.get(), result.labels.get());
+        result.size = n;
+        Finalize(i);
+    }
+
+    // Allocate the result arrays and move the hits of every query into them.
+    void
+    Assemble(float*& distances, int64_t*& labels, size_t*& lims);
+
+ private:
+    struct QueryResult {
+        std::unique_ptr<float[]> distances;
+        std::unique_ptr<int64_t[]> labels;
+        size_t size = 0;
+    };
+
+    void
+    Finalize(int64_t i);
+
+    bool is_ip_;
+    float radius_;
+    const float* radii_ = nullptr;
+    float range_filter_;
+    int64_t range_search_k_;
+    std::vector<QueryResult> results_;
+};
 
 }  // namespace knowhere
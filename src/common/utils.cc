@@ -15,6 +15,7 @@
 #include <cmath>
 #include <cstdint>
 
+#include "knowhere/comp/thread_pool.h"
 #include "knowhere/log.h"
 #include "simd/hook.h"
 
@@ -22,14 +23,19 @@ namespace knowhere {
 
 const float FloatAccuracy = 0.00001;
 
+namespace {
+// datasets of fewer rows are normalized on the calling thread
+constexpr int64_t kParallelNormalizeRows = 4096;
+// rows normalized by one task of the build thread pool
+constexpr int64_t kNormalizeRowsPerTask = 1024;
+}  // namespace
+
 float
 NormalizeVec(float* x, int32_t d) {
     float norm_l2_sqr = faiss::fvec_norm_L2sqr(x, d);
     if (norm_l2_sqr > 0 && std::abs(1.0f - norm_l2_sqr) > FloatAccuracy) {
         float norm_l2 = std::sqrt(norm_l2_sqr);
-        for (int32_t i = 0; i < d; i++) {
-            x[i] = x[i] / norm_l2;
-        }
+        faiss::fvec_scale(x, d, 1.0f / norm_l2);
         return norm_l2;
     }
     return 1.0f;
@@ -49,12 +55,40 @@ void
 Normalize(const DataSet& dataset) {
     auto rows = dataset.GetRows();
     auto dim = dataset.GetDim();
-    float* data = (float*)dataset.GetTensor();
+    auto type = dataset.GetTensorDataType();
 
     LOG_KNOWHERE_DEBUG_ << "vector normalize, rows " << rows << ", dim " << dim;
 
-    for (int32_t i = 0; i < rows; i++) {
-        NormalizeVec(data + i * dim, dim);
+    auto data = (uint8_t*)dataset.GetTensor();
+    auto row_size = dim * DataTypeSize(type);
+    auto normalize_rows = [&](int64_t begin, int64_t end) {
+        if (type == DataType::kFloat32) {
+            for (int64_t i = begin; i < end; i++) {
+                NormalizeVec((float*)data + i * dim, dim);
+            }
+            return;
+        }
+        // fp16 / bf16 rows are normalized in fp32 and rounded back in place
+        std::vector<float> buf(dim);
+        for (int64_t i = begin; i < end; i++) {
+            ConvertToFloat(data + i * row_size, type, buf.data(), dim);
+            NormalizeVec(buf.data(), dim);
+            ConvertFromFloat(buf.data(), type, data + i * row_size, dim);
+        }
+    };
+    if (rows < kParallelNormalizeRows) {
+        normalize_rows(0, rows);
+        return;
+    }
+    auto pool = ThreadPool::GetGlobalBuildThreadPool();
+    std::vector<folly::Future<folly::Unit>> futs;
+    futs.reserve((rows + kNormalizeRowsPerTask - 1) / kNormalizeRowsPerTask);
+    for (int64_t begin = 0; begin < rows; begin += kNormalizeRowsPerTask) {
+        auto end = std::min(begin + kNormalizeRowsPerTask, rows);
+        futs.emplace_back(pool->push([&, begin, end] { normalize_rows(begin, end); }));
+    }
+    for (auto& fut : futs) {
+        fut.wait();
     }
 }
 
@@ -66,4 +100,43 @@ CopyAndNormalizeFloatVec(const float* x, int32_t dim) {
     return x_norm;
 }
 
+const float*
+NormalizeQuery(const float* x, int32_t dim) {
+    thread_local std::vector<float> scratch;
+    if (scratch.size() < static_cast<size_t>(dim)) {
+        scratch.resize(dim);
+    }
+    std::copy_n(x, dim, scratch.data());
+    NormalizeVec(scratch.data(), dim);
+    return scratch.data();
+}
+
+DataSetPtr
+ConvertToFloatDataSet(const DataSet& dataset) {
+    auto rows = dataset.GetRows();
+    auto dim = dataset.GetDim();
+    auto data = new float[rows * dim];
+    ConvertToFloat(dataset.GetTensor(), dataset.GetTensorDataType(), data, rows * dim);
+    auto res = GenResultDataSet(rows, dim, data);
+    // the converted queries keep their k-th distance bounds
+    if (auto knn_bounds = dataset.GetKnnBounds(); knn_bounds != nullptr) {
+        auto bounds = new float[rows];
+        std::copy_n(knn_bounds, rows, bounds);
+        res->SetKnnBounds(bounds);
+    }
+    return res;
+}
+
+DataSetPtr
+CopyAndNormalize(const DataSet& dataset) {
+    auto normalized = ConvertToFloatDataSet(dataset);
+    Normalize(*normalized);
+    return normalized;
+}
+
+uint64_t
+hash_bytes(const void* x, size_t n) {
+    return faiss::bvec_hash(static_cast<const uint8_t*>(x), n);
+}
+
 }  // namespace knowhere
@@ -18,6 +18,7 @@
 #include "diskann/pq_flash_index.h"
 #include "fmt/core.h"
 #include "index/diskann/diskann_config.h"
+#include "knowhere/comp/filter_strategy.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/dataset.h"
@@ -525,6 +526,23 @@ DiskANNIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const Bit
     auto beamwidth = static_cast<uint64_t>(search_conf.beamwidth.value());
     auto filter_ratio = static_cast<float>(search_conf.filter_threshold.value());
     auto for_tuning = static_cast<bool>(search_conf.for_tuning.value());
+    if (!bitset.empty()) {
+        auto strategy = Str2FilterStrategy(search_conf.filter_strategy.value()).value_or(FilterStrategy::kAuto);
+        // an explicit filter_threshold keeps the PQ + Refine switch under user control
+        if (strategy != FilterStrategy::kAuto || filter_ratio < 0) {
+            auto plan = PlanGraphFilteredSearch(strategy, bitset, pq_flash_index_->get_num_points(), lsearch,
+                                                pq_flash_index_->get_max_degree(), 1.0f, max_search_list_size);
+            if (plan.strategy == FilterStrategy::kBruteForce) {
+                // every non-empty bitset passes a zero threshold, i.e. always use PQ + Refine
+                filter_ratio = 0.0f;
+            } else if (strategy != FilterStrategy::kAuto) {
+                // a threshold of 1.0 is never reached by a partially filtered bitset
+                filter_ratio = 1.0f;
+            }
+            lsearch = static_cast<uint64_t>(plan.search_width);
+            RecordFilterSearchPlan(plan);
+        }
+    }
 
     auto nq = dataset.GetRows();
     auto dim = dataset.GetDim();
@@ -611,8 +629,7 @@ DiskANNIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, cons
     float* p_dist = nullptr;
     size_t* p_lims = nullptr;
 
-    std::vector<std::vector<int64_t>> result_id_array(nq);
-    std::vector<std::vector<float>> result_dist_array(nq);
+    RangeSearchResultBuilder builder(nq, is_ip, radius, range_filter, search_conf.range_search_k.value());
 
     std::vector<folly::Future<folly::Unit>> futures;
     futures.reserve(nq);
@@ -621,13 +638,12 @@ DiskANNIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, cons
         futures.emplace_back(search_pool_->push([&, index = row]() {
             std::vector<int64_t> indices;
             std::vector<float> distances;
-            pq_flash_index_->range_search(xq + (index * dim), radius, min_k, max_k, result_id_array[index],
-                                          result_dist_array[index], beamwidth, search_list_and_k_ratio, bitset);
-            // filter range search result
-            if (search_conf.range_filter.value() != defaultRangeFilter) {
-                FilterRangeSearchResultForOneNq(result_dist_array[index], result_id_array[index], is_ip, radius,
-                                                range_filter);
-            }
+            pq_flash_index_->range_search(xq + (index * dim), radius, min_k, max_k, indices, distances, beamwidth,
+                                          search_list_and_k_ratio, bitset);
+            builder.SetResult(index, indices.size(), [&](float* o_distances, int64_t* o_labels) {
+                std::copy_n(distances.data(), distances.size(), o_distances);
+                std::copy_n(indices.data(), indices.size(), o_labels);
+            });
         }));
     }
     for (auto& future : futures) {
@@ -639,8 +655,7 @@ DiskANNIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, cons
         return expected<DataSetPtr>::Err(Status::diskann_inner_error, "some search failed");
     }
 
-    GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius, search_conf.range_filter.value(),
-                         p_dist, p_id, p_lims);
+    builder.Assemble(p_dist, p_id, p_lims);
     return GenResultDataSet(nq, p_id, p_dist, p_lims);
 }
 
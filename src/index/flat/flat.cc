@@ -13,7 +13,9 @@
 #include "common/range_util.h"
 #include "faiss/IndexBinaryFlat.h"
 #include "faiss/IndexFlat.h"
+#include "faiss/IndexScalarQuantizer.h"
 #include "faiss/index_io.h"
+#include "faiss/utils/distances.h"
 #include "index/flat/flat_config.h"
 #include "io/FaissIO.h"
 #include "knowhere/comp/thread_pool.h"
@@ -25,6 +27,10 @@ namespace knowhere {
 
 template <typename T>
 class FlatIndexNode : public IndexNode {
+    // fp32 vectors are kept in a faiss::IndexFlat, fp16 / bf16 ones in a faiss::IndexScalarQuantizer with the
+    // matching quantizer type, both are flat code arrays
+    using IndexType = std::conditional_t<std::is_same<T, faiss::IndexFlat>::value, faiss::IndexFlatCodes, T>;
+
  public:
     FlatIndexNode(const Object&) : index_(nullptr) {
         static_assert(std::is_same<T, faiss::IndexFlat>::value || std::is_same<T, faiss::IndexBinaryFlat>::value,
@@ -36,17 +42,33 @@ class FlatIndexNode : public IndexNode {
     Train(const DataSet& dataset, const Config& cfg) override {
         const FlatConfig& f_cfg = static_cast<const FlatConfig&>(cfg);
 
-        // do normalize for COSINE metric type
-        if (IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE)) {
-            Normalize(dataset);
-        }
-
         auto metric = Str2FaissMetricType(f_cfg.metric_type.value());
         if (!metric.has_value()) {
             LOG_KNOWHERE_WARNING_ << "please check metric type: " << f_cfg.metric_type.value();
             return metric.error();
         }
-        index_ = std::make_unique<T>(dataset.GetDim(), metric.value());
+        if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
+            switch (dataset.GetTensorDataType()) {
+                case DataType::kFloat16:
+                    index_ = std::make_unique<faiss::IndexScalarQuantizer>(
+                        dataset.GetDim(), faiss::QuantizerType::QT_fp16, metric.value());
+                    break;
+                case DataType::kBFloat16:
+                    index_ = std::make_unique<faiss::IndexScalarQuantizer>(
+                        dataset.GetDim(), faiss::QuantizerType::QT_bf16, metric.value());
+                    break;
+                default:
+                    // COSINE keeps the raw vectors and scales inner products by their inverse norms
+                    if (IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE)) {
+                        index_ = std::make_unique<faiss::IndexFlatCosine>(dataset.GetDim());
+                    } else {
+                        index_ = std::make_unique<faiss::IndexFlat>(dataset.GetDim(), metric.value());
+                    }
+                    break;
+            }
+        } else {
+            index_ = std::make_unique<T>(dataset.GetDim(), metric.value());
+        }
         return Status::success;
     }
 
@@ -55,7 +77,37 @@ class FlatIndexNode : public IndexNode {
         auto x = dataset.GetTensor();
         auto n = dataset.GetRows();
         if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
-            index_->add(n, (const float*)x);
+            auto type = dataset.GetTensorDataType();
+            if (type != StorageDataType()) {
+                LOG_KNOWHERE_WARNING_ << "data type of the added vectors does not match the index";
+                return Status::invalid_args;
+            }
+            // fp32 COSINE rows are added as is to an IndexFlatCosine, fp16 / bf16 ones are normalized in the widened
+            // copy, and so are the fp32 ones of a COSINE index built before IndexFlatCosine
+            const FlatConfig& f_cfg = static_cast<const FlatConfig&>(cfg);
+            bool is_cosine = IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE);
+            if (type == DataType::kFloat32) {
+                if (is_cosine && dynamic_cast<const faiss::IndexFlatCosine*>(index_.get()) == nullptr) {
+                    auto normalized = CopyAndNormalize(dataset);
+                    index_->add(n, (const float*)normalized->GetTensor());
+                } else {
+                    index_->add(n, (const float*)x);
+                }
+            } else {
+                // faiss encodes from fp32, widen the input chunk by chunk, the rounding back is exact
+                auto dim = dataset.GetDim();
+                auto row_size = dim * DataTypeSize(type);
+                auto chunk = std::min<int64_t>(n, kAddChunkSize);
+                auto buf = std::make_unique<float[]>(chunk * dim);
+                for (int64_t i = 0; i < n; i += chunk) {
+                    auto rows = std::min<int64_t>(chunk, n - i);
+                    ConvertToFloat((const uint8_t*)x + i * row_size, type, buf.get(), rows * dim);
+                    if (is_cosine) {
+                        NormalizeVecs(buf.get(), rows, dim);
+                    }
+                    index_->add(rows, buf.get());
+                }
+            }
         }
         if constexpr (std::is_same<T, faiss::IndexBinaryFlat>::value) {
             index_->add(n, (const uint8_t*)x);
@@ -63,6 +115,11 @@ class FlatIndexNode : public IndexNode {
         return Status::success;
     }
 
+    Status
+    BuildFromReader(DataSetReader& reader, const Config& cfg) override {
+        return TrainAndAddInChunks(reader, cfg);
+    }
+
     expected<DataSetPtr>
     Search(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override {
         if (!index_) {
@@ -78,6 +135,8 @@ class FlatIndexNode : public IndexNode {
         auto nq = dataset.GetRows();
         auto x = dataset.GetTensor();
         auto dim = dataset.GetDim();
+        auto type = dataset.GetTensorDataType();
+        auto knn_bounds = dataset.GetKnnBounds();
 
         auto len = k * nq;
         int64_t* ids = nullptr;
@@ -90,14 +149,15 @@ class FlatIndexNode : public IndexNode {
             for (int i = 0; i < nq; ++i) {
                 futs.emplace_back(search_pool_->push([&, index = i] {
                     ThreadPool::ScopedOmpSetter setter(1);
+                    faiss::ScopedEarlyAbandon early_abandon(f_cfg.early_abandon.value());
                     auto cur_ids = ids + k * index;
                     auto cur_dis = distances + k * index;
                     if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
-                        auto cur_query = (const float*)x + dim * index;
-                        std::unique_ptr<float[]> copied_query = nullptr;
+                        faiss::ScopedKnnBound knn_bound(knn_bounds ? knn_bounds[index]
+                                                                   : std::numeric_limits<float>::quiet_NaN());
+                        auto cur_query = QueryToFloat(x, type, dim, index);
                         if (is_cosine) {
-                            copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                            cur_query = copied_query.get();
+                            cur_query = NormalizeQuery(cur_query, dim);
                         }
                         index_->search(1, cur_query, k, cur_dis, cur_ids, bitset);
                     }
@@ -138,6 +198,7 @@ class FlatIndexNode : public IndexNode {
         auto nq = dataset.GetRows();
         auto xq = dataset.GetTensor();
         auto dim = dataset.GetDim();
+        auto type = dataset.GetTensorDataType();
 
         float radius = f_cfg.radius.value();
         float range_filter = f_cfg.range_filter.value();
@@ -147,10 +208,7 @@ class FlatIndexNode : public IndexNode {
         float* distances = nullptr;
         size_t* lims = nullptr;
 
-        std::vector<std::vector<int64_t>> result_id_array(nq);
-        std::vector<std::vector<float>> result_dist_array(nq);
-        std::vector<size_t> result_size(nq);
-        std::vector<size_t> result_lims(nq + 1);
+        RangeSearchResultBuilder builder(nq, is_ip, radius, range_filter, f_cfg.range_search_k.value());
 
         try {
             std::vector<folly::Future<folly::Unit>> futs;
@@ -160,36 +218,22 @@ class FlatIndexNode : public IndexNode {
                     ThreadPool::ScopedOmpSetter setter(1);
                     faiss::RangeSearchResult res(1);
                     if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
-                        auto cur_query = (const float*)xq + dim * index;
-                        std::unique_ptr<float[]> copied_query = nullptr;
+                        auto cur_query = QueryToFloat(xq, type, dim, index);
                         if (is_cosine) {
-                            copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                            cur_query = copied_query.get();
+                            cur_query = NormalizeQuery(cur_query, dim);
                         }
                         index_->range_search(1, cur_query, radius, &res, bitset);
                     }
                     if constexpr (std::is_same<T, faiss::IndexBinaryFlat>::value) {
                         index_->range_search(1, (const uint8_t*)xq + index * dim / 8, radius, &res, bitset);
                     }
-                    auto elem_cnt = res.lims[1];
-                    result_dist_array[index].resize(elem_cnt);
-                    result_id_array[index].resize(elem_cnt);
-                    result_size[index] = elem_cnt;
-                    for (size_t j = 0; j < elem_cnt; j++) {
-                        result_dist_array[index][j] = res.distances[j];
-                        result_id_array[index][j] = res.labels[j];
-                    }
-                    if (f_cfg.range_filter.value() != defaultRangeFilter) {
-                        FilterRangeSearchResultForOneNq(result_dist_array[index], result_id_array[index], is_ip, radius,
-                                                        range_filter);
-                    }
+                    builder.SetResult(index, res);
                 }));
             }
             for (auto& fut : futs) {
                 fut.wait();
             }
-            GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius, range_filter, distances, ids,
-                                 lims);
+            builder.Assemble(distances, ids, lims);
         } catch (const std::exception& e) {
             LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
             return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
@@ -204,6 +248,26 @@ class FlatIndexNode : public IndexNode {
         auto rows = dataset.GetRows();
         auto ids = dataset.GetIds();
         if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
+            auto type = StorageDataType();
+            if (type != DataType::kFloat32) {
+                // the codes of fp16 / bf16 storage are the vectors themselves
+                uint8_t* data = nullptr;
+                try {
+                    auto code_size = index_->code_size;
+                    data = new uint8_t[rows * code_size];
+                    for (int64_t i = 0; i < rows; i++) {
+                        FAISS_THROW_IF_NOT(ids[i] >= 0 && ids[i] < index_->ntotal);
+                        memcpy(data + i * code_size, index_->codes.data() + ids[i] * code_size, code_size);
+                    }
+                    auto res = GenResultDataSet(rows, dim, data);
+                    res->SetTensorDataType(type);
+                    return res;
+                } catch (const std::exception& e) {
+                    std::unique_ptr<uint8_t[]> auto_del(data);
+                    LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                    return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+                }
+            }
             float* data = nullptr;
             try {
                 data = new float[rows * dim];
@@ -236,7 +300,9 @@ class FlatIndexNode : public IndexNode {
     bool
     HasRawData(const std::string& metric_type) const override {
         if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
-            return !IsMetricType(metric_type, metric::COSINE);
+            // COSINE indexes built before IndexFlatCosine, and fp16 / bf16 ones, hold normalized vectors
+            return !IsMetricType(metric_type, metric::COSINE) || index_ == nullptr ||
+                   dynamic_cast<const faiss::IndexFlatCosine*>(index_.get()) != nullptr;
         }
         if constexpr (std::is_same<T, faiss::IndexBinaryFlat>::value) {
             return true;
@@ -287,7 +353,7 @@ class FlatIndexNode : public IndexNode {
         reader.data_ = binary->data.get();
         if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
             faiss::Index* index = faiss::read_index(&reader);
-            index_.reset(static_cast<T*>(index));
+            index_.reset(static_cast<IndexType*>(index));
         }
         if constexpr (std::is_same<T, faiss::IndexBinaryFlat>::value) {
             faiss::IndexBinary* index = faiss::read_index_binary(&reader);
@@ -307,7 +373,7 @@ class FlatIndexNode : public IndexNode {
 
         if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
             faiss::Index* index = faiss::read_index(filename.data(), io_flags);
-            index_.reset(static_cast<T*>(index));
+            index_.reset(static_cast<IndexType*>(index));
         }
         if constexpr (std::is_same<T, faiss::IndexBinaryFlat>::value) {
             faiss::IndexBinary* index = faiss::read_index_binary(filename.data(), io_flags);
@@ -328,6 +394,9 @@ class FlatIndexNode : public IndexNode {
 
     int64_t
     Size() const override {
+        if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
+            return index_->ntotal * index_->code_size;
+        }
         return index_->ntotal * index_->d * sizeof(float);
     }
 
@@ -347,7 +416,34 @@ class FlatIndexNode : public IndexNode {
     }
 
  private:
-    std::unique_ptr<T> index_;
+    static constexpr int64_t kAddChunkSize = 65536;
+
+    // element type the vectors are stored in
+    DataType
+    StorageDataType() const {
+        if constexpr (std::is_same<T, faiss::IndexFlat>::value) {
+            if (auto sq = dynamic_cast<const faiss::IndexScalarQuantizer*>(index_.get())) {
+                return sq->sq.qtype == faiss::QuantizerType::QT_bf16 ? DataType::kBFloat16 : DataType::kFloat16;
+            }
+        }
+        return DataType::kFloat32;
+    }
+
+    // query `index` of x as fp32, fp16 / bf16 queries are widened into a buffer of the calling thread
+    static const float*
+    QueryToFloat(const void* x, DataType type, int64_t dim, int64_t index) {
+        if (type == DataType::kFloat32) {
+            return (const float*)x + dim * index;
+        }
+        thread_local std::vector<float> scratch;
+        if (scratch.size() < static_cast<size_t>(dim)) {
+            scratch.resize(dim);
+        }
+        ConvertToFloat((const uint8_t*)x + dim * index * DataTypeSize(type), type, scratch.data(), dim);
+        return scratch.data();
+    }
+
+    std::unique_ptr<IndexType> index_;
     std::shared_ptr<ThreadPool> search_pool_;
 };
 
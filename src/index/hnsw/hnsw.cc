@@ -20,6 +20,7 @@
 #include "hnswlib/hnswalg.h"
 #include "hnswlib/hnswlib.h"
 #include "index/hnsw/hnsw_config.h"
+#include "knowhere/comp/filter_strategy.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/comp/time_recorder.h"
@@ -30,6 +31,43 @@
 #include "knowhere/utils.h"
 
 namespace knowhere {
+// Resumable level 0 search of one query, see HierarchicalNSW::getIteratorNext. The next result is looked up ahead by
+// HasNext, so that it can tell whether the reachable nodes are exhausted.
+class HnswIterator : public IndexNode::iterator {
+ public:
+    HnswIterator(const hnswlib::HierarchicalNSW<float>* index, const void* query, size_t ef, bool transform,
+                 const BitsetView& bitset)
+        : index_(index), workspace_(index->getIteratorWorkspace(query, ef, bitset)), transform_(transform) {
+    }
+
+    std::pair<int64_t, float>
+    Next() override {
+        if (!HasNext()) {
+            return {-1, transform_ ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity()};
+        }
+        auto [dist, id] = *next_;
+        next_.reset();
+        return {id, transform_ ? -dist : dist};
+    }
+
+    bool
+    HasNext() override {
+        if (!next_.has_value()) {
+            std::pair<float, hnswlib::labeltype> result;
+            if (index_->getIteratorNext(workspace_.get(), result)) {
+                next_ = result;
+            }
+        }
+        return next_.has_value();
+    }
+
+ private:
+    const hnswlib::HierarchicalNSW<float>* index_;
+    std::unique_ptr<hnswlib::HierarchicalNSW<float>::IteratorWorkspace> workspace_;
+    const bool transform_;
+    std::optional<std::pair<float, hnswlib::labeltype>> next_;
+};
+
 class HnswIndexNode : public IndexNode {
  public:
     HnswIndexNode(const Object& object) : index_(nullptr) {
@@ -38,38 +76,8 @@ class HnswIndexNode : public IndexNode {
 
     Status
     Train(const DataSet& dataset, const Config& cfg) override {
-        auto rows = dataset.GetRows();
-        auto dim = dataset.GetDim();
-        auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
-        hnswlib::SpaceInterface<float>* space = nullptr;
-        if (IsMetricType(hnsw_cfg.metric_type.value(), metric::L2)) {
-            space = new (std::nothrow) hnswlib::L2Space(dim);
-        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::IP)) {
-            space = new (std::nothrow) hnswlib::InnerProductSpace(dim);
-        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::COSINE)) {
-            space = new (std::nothrow) hnswlib::CosineSpace(dim);
-        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::HAMMING)) {
-            space = new (std::nothrow) hnswlib::HammingSpace(dim);
-        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::JACCARD)) {
-            space = new (std::nothrow) hnswlib::JaccardSpace(dim);
-        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::TLSH)) {
-            space = new (std::nothrow) hnswlib::TLSHSpace(dim);
-        } else {
-            LOG_KNOWHERE_WARNING_ << "metric type not support in hnsw: " << hnsw_cfg.metric_type.value();
-            return Status::invalid_metric_type;
-        }
-        auto index = new (std::nothrow)
-            hnswlib::HierarchicalNSW<float>(space, rows, hnsw_cfg.M.value(), hnsw_cfg.efConstruction.value());
-        if (index == nullptr) {
-            LOG_KNOWHERE_WARNING_ << "memory malloc error.";
-            return Status::malloc_error;
-        }
-        if (this->index_) {
-            delete this->index_;
-            LOG_KNOWHERE_WARNING_ << "index not empty, deleted old index";
-        }
-        this->index_ = index;
-        return Status::success;
+        return CreateIndex(dataset.GetRows(), dataset.GetDim(), dataset.GetTensorDataType(),
+                           static_cast<const HnswConfig&>(cfg));
     }
 
     Status
@@ -80,20 +88,30 @@ class HnswIndexNode : public IndexNode {
         }
 
         knowhere::TimeRecorder build_time("Building HNSW cost");
-        auto rows = dataset.GetRows();
-        auto tensor = dataset.GetTensor();
-        auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
-        index_->addPoint(tensor, 0);
+        RETURN_IF_ERROR(AddPoints(dataset, 0));
+        build_time.RecordSection("");
+        return FinishBuild(static_cast<const HnswConfig&>(cfg), build_time);
+    }
 
-#pragma omp parallel for
-        for (int i = 1; i < rows; ++i) {
-            index_->addPoint(((const char*)tensor + index_->data_size_ * i), i);
+    Status
+    BuildFromReader(DataSetReader& reader, const Config& cfg) override {
+        auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
+        knowhere::TimeRecorder build_time("Building HNSW cost");
+        int64_t added = 0;
+        while (auto chunk = reader.Next(hnsw_cfg.build_chunk_rows.value())) {
+            if (added == 0) {
+                // the graph needs no training, it is sized for all rows of the reader up front
+                RETURN_IF_ERROR(CreateIndex(reader.Rows(), reader.Dim(), chunk->GetTensorDataType(), hnsw_cfg));
+            }
+            RETURN_IF_ERROR(AddPoints(*chunk, added));
+            added += chunk->GetRows();
+        }
+        if (added == 0 || added != reader.Rows()) {
+            LOG_KNOWHERE_WARNING_ << "reader returned " << added << " rows, expected " << reader.Rows();
+            return Status::invalid_args;
         }
         build_time.RecordSection("");
-        LOG_KNOWHERE_INFO_ << "HNSW built with #points num:" << index_->max_elements_ << " #M:" << index_->M_
-                           << " #max level:" << index_->maxlevel_ << " #ef_construction:" << index_->ef_construction_
-                           << " #dim:" << *(size_t*)(index_->space_->get_dist_func_param());
-        return Status::success;
+        return FinishBuild(hnsw_cfg, build_time);
     }
 
     expected<DataSetPtr>
@@ -104,6 +122,7 @@ class HnswIndexNode : public IndexNode {
         }
         auto nq = dataset.GetRows();
         auto xq = dataset.GetTensor();
+        auto type = dataset.GetTensorDataType();
 
         auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
         auto k = hnsw_cfg.k.value();
@@ -120,6 +139,21 @@ class HnswIndexNode : public IndexNode {
         auto p_dist = new float[k * nq];
 
         hnswlib::SearchParam param{(size_t)hnsw_cfg.ef.value(), hnsw_cfg.for_tuning.value()};
+        std::vector<hnswlib::labeltype> unfiltered_labels;
+        if (!bitset.empty()) {
+            // resolve the strategy once for the whole batch, hnswlib applies it per query
+            auto plan = PlanGraphFilteredSearch(Str2FilterStrategy(hnsw_cfg.filter_strategy.value())
+                                                    .value_or(FilterStrategy::kAuto),
+                                                bitset, index_->cur_element_count, std::max<int64_t>(param.ef_, k),
+                                                index_->maxM0_, hnswlib::kHnswSearchKnnBFThreshold);
+            param.filter_strategy_ = plan.strategy;
+            param.ef_ = plan.search_width;
+            if (plan.strategy == FilterStrategy::kBruteForce) {
+                unfiltered_labels = GatherUnfilteredIds(bitset, index_->cur_element_count);
+                param.unfiltered_labels_ = &unfiltered_labels;
+            }
+            RecordFilterSearchPlan(plan);
+        }
         bool transform =
             (index_->metric_type_ == hnswlib::Metric::INNER_PRODUCT || index_->metric_type_ == hnswlib::Metric::COSINE);
 
@@ -127,7 +161,7 @@ class HnswIndexNode : public IndexNode {
         futs.reserve(nq);
         for (int i = 0; i < nq; ++i) {
             futs.emplace_back(search_pool_->push([&, idx = i]() {
-                auto single_query = (const char*)xq + idx * index_->data_size_;
+                auto single_query = QueryForSearch(xq, type, idx);
                 auto rst = index_->searchKnn(single_query, k, bitset, &param, feder_result);
                 size_t rst_size = rst.size();
                 auto p_single_dis = p_dist + idx * k;
@@ -169,14 +203,14 @@ class HnswIndexNode : public IndexNode {
 
         auto nq = dataset.GetRows();
         auto xq = dataset.GetTensor();
+        auto type = dataset.GetTensorDataType();
 
         auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
         bool is_ip =
             (index_->metric_type_ == hnswlib::Metric::INNER_PRODUCT || index_->metric_type_ == hnswlib::Metric::COSINE);
         float range_filter = hnsw_cfg.range_filter.value();
-
-        float radius_for_calc = (is_ip ? -hnsw_cfg.radius.value() : hnsw_cfg.radius.value());
-        float radius_for_filter = hnsw_cfg.radius.value();
+        // a radius per query takes precedence over the radius of the config
+        auto radii = dataset.GetRadii();
 
         feder::hnsw::FederResultUniq feder_result;
         if (hnsw_cfg.trace_visit.value()) {
@@ -187,44 +221,37 @@ class HnswIndexNode : public IndexNode {
         }
 
         hnswlib::SearchParam param{(size_t)hnsw_cfg.ef.value()};
+        param.range_search_k_ = hnsw_cfg.range_search_k.value();
+        param.range_adaptive_ef_ = hnsw_cfg.range_adaptive_ef.value();
 
         int64_t* ids = nullptr;
         float* dis = nullptr;
         size_t* lims = nullptr;
 
-        std::vector<std::vector<int64_t>> result_id_array(nq);
-        std::vector<std::vector<float>> result_dist_array(nq);
-        std::vector<size_t> result_size(nq);
-        std::vector<size_t> result_lims(nq + 1);
+        RangeSearchResultBuilder builder(nq, is_ip, hnsw_cfg.radius.value(), range_filter,
+                                         hnsw_cfg.range_search_k.value());
+        builder.SetRadii(radii);
 
         std::vector<folly::Future<folly::Unit>> futs;
         futs.reserve(nq);
         for (int64_t i = 0; i < nq; ++i) {
             futs.emplace_back(search_pool_->push([&, idx = i]() {
-                auto single_query = (const char*)xq + idx * index_->data_size_;
-                auto rst = index_->searchRange(single_query, radius_for_calc, bitset, &param, feder_result);
-                auto elem_cnt = rst.size();
-                result_dist_array[idx].resize(elem_cnt);
-                result_id_array[idx].resize(elem_cnt);
-                for (size_t j = 0; j < elem_cnt; j++) {
-                    auto& p = rst[j];
-                    result_dist_array[idx][j] = (is_ip ? (-p.first) : p.first);
-                    result_id_array[idx][j] = p.second;
-                }
-                result_size[idx] = rst.size();
-                if (hnsw_cfg.range_filter.value() != defaultRangeFilter) {
-                    FilterRangeSearchResultForOneNq(result_dist_array[idx], result_id_array[idx], is_ip,
-                                                    radius_for_filter, range_filter);
-                }
+                auto single_query = QueryForSearch(xq, type, idx);
+                float radius = radii ? radii[idx] : hnsw_cfg.radius.value();
+                auto rst = index_->searchRange(single_query, is_ip ? -radius : radius, bitset, &param, feder_result);
+                builder.SetResult(idx, rst.size(), [&](float* distances, int64_t* labels) {
+                    for (size_t j = 0; j < rst.size(); j++) {
+                        distances[j] = (is_ip ? (-rst[j].first) : rst[j].first);
+                        labels[j] = rst[j].second;
+                    }
+                });
             }));
         }
         for (auto& fut : futs) {
             fut.wait();
         }
 
-        // filter range search result
-        GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius_for_filter, range_filter, dis, ids,
-                             lims);
+        builder.Assemble(dis, ids, lims);
 
         auto res = GenResultDataSet(nq, ids, dis, lims);
 
@@ -239,6 +266,36 @@ class HnswIndexNode : public IndexNode {
         return res;
     }
 
+    expected<std::vector<IteratorPtr>>
+    AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_WARNING_ << "creating iterator on empty index";
+            return expected<std::vector<IteratorPtr>>::Err(Status::empty_index, "index not loaded");
+        }
+        auto nq = dataset.GetRows();
+        auto xq = dataset.GetTensor();
+        auto type = dataset.GetTensorDataType();
+
+        auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
+        auto ef = hnsw_cfg.ef.value();
+        bool transform =
+            (index_->metric_type_ == hnswlib::Metric::INNER_PRODUCT || index_->metric_type_ == hnswlib::Metric::COSINE);
+
+        std::vector<IteratorPtr> iterators(nq);
+        std::vector<folly::Future<folly::Unit>> futs;
+        futs.reserve(nq);
+        for (int64_t i = 0; i < nq; ++i) {
+            futs.emplace_back(search_pool_->push([&, idx = i]() {
+                auto single_query = QueryForSearch(xq, type, idx);
+                iterators[idx] = std::make_shared<HnswIterator>(index_, single_query, ef, transform, bitset);
+            }));
+        }
+        for (auto& fut : futs) {
+            fut.wait();
+        }
+        return iterators;
+    }
+
     expected<DataSetPtr>
     GetVectorByIds(const DataSet& dataset) const override {
         if (!index_) {
@@ -255,9 +312,12 @@ class HnswIndexNode : public IndexNode {
             for (int64_t i = 0; i < rows; i++) {
                 int64_t id = ids[i];
                 assert(id >= 0 && id < (int64_t)index_->cur_element_count);
-                std::copy_n(index_->getDataByInternalId(id), index_->data_size_, data + i * index_->data_size_);
+                std::copy_n(index_->getDataByInternalId(index_->getInternalId(id)), index_->data_size_,
+                            data + i * index_->data_size_);
             }
-            return GenResultDataSet(rows, dim, data);
+            auto res = GenResultDataSet(rows, dim, data);
+            res->SetTensorDataType(index_->data_type_);
+            return res;
         } catch (std::exception& e) {
             LOG_KNOWHERE_WARNING_ << "hnsw inner error: " << e.what();
             std::unique_ptr<char> auto_del(data);
@@ -280,7 +340,7 @@ class HnswIndexNode : public IndexNode {
         auto hnsw_cfg = static_cast<const HnswConfig&>(cfg);
         auto overview_levels = hnsw_cfg.overview_levels.value();
         feder::hnsw::HNSWMeta meta(index_->ef_construction_, index_->M_, index_->cur_element_count, index_->maxlevel_,
-                                   index_->enterpoint_node_, overview_levels);
+                                   index_->getExternalLabel(index_->enterpoint_node_), overview_levels);
         std::unordered_set<int64_t> id_set;
 
         for (int i = 0; i < overview_levels; i++) {
@@ -404,6 +464,99 @@ class HnswIndexNode : public IndexNode {
     }
 
  private:
+    Status
+    CreateIndex(int64_t rows, int64_t dim, DataType type, const HnswConfig& hnsw_cfg) {
+        hnswlib::SpaceInterface<float>* space = nullptr;
+        if (IsMetricType(hnsw_cfg.metric_type.value(), metric::L2)) {
+            space = new (std::nothrow) hnswlib::L2Space(dim, type);
+        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::IP)) {
+            space = new (std::nothrow) hnswlib::InnerProductSpace(dim, type);
+        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::COSINE)) {
+            space = new (std::nothrow) hnswlib::CosineSpace(dim, type);
+        } else if (type != DataType::kFloat32) {
+            LOG_KNOWHERE_WARNING_ << "fp16 / bf16 vectors are not supported with metric type: "
+                                  << hnsw_cfg.metric_type.value();
+            return Status::invalid_metric_type;
+        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::HAMMING)) {
+            space = new (std::nothrow) hnswlib::HammingSpace(dim);
+        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::JACCARD)) {
+            space = new (std::nothrow) hnswlib::JaccardSpace(dim);
+        } else if (IsMetricType(hnsw_cfg.metric_type.value(), metric::TLSH)) {
+            space = new (std::nothrow) hnswlib::TLSHSpace(dim);
+        } else {
+            LOG_KNOWHERE_WARNING_ << "metric type not support in hnsw: " << hnsw_cfg.metric_type.value();
+            return Status::invalid_metric_type;
+        }
+        auto index = new (std::nothrow)
+            hnswlib::HierarchicalNSW<float>(space, rows, hnsw_cfg.M.value(), hnsw_cfg.efConstruction.value());
+        if (index == nullptr) {
+            LOG_KNOWHERE_WARNING_ << "memory malloc error.";
+            return Status::malloc_error;
+        }
+        if (this->index_) {
+            delete this->index_;
+            LOG_KNOWHERE_WARNING_ << "index not empty, deleted old index";
+        }
+        this->index_ = index;
+        return Status::success;
+    }
+
+    // add the rows of dataset with labels starting at `offset`
+    Status
+    AddPoints(const DataSet& dataset, int64_t offset) {
+        auto rows = dataset.GetRows();
+        auto tensor = (const char*)dataset.GetTensor();
+        if (dataset.GetTensorDataType() != index_->data_type_) {
+            LOG_KNOWHERE_WARNING_ << "data type of the added vectors does not match the index";
+            return Status::invalid_args;
+        }
+        if (offset + rows > (int64_t)index_->max_elements_) {
+            LOG_KNOWHERE_WARNING_ << "adding " << rows << " rows at " << offset << " exceeds the index capacity "
+                                  << index_->max_elements_;
+            return Status::invalid_args;
+        }
+        int64_t begin = 0;
+        if (offset == 0 && rows > 0) {
+            // the first point becomes the entry point, the others are linked to it concurrently
+            index_->addPoint(tensor, 0);
+            begin = 1;
+        }
+
+#pragma omp parallel for
+        for (int64_t i = begin; i < rows; ++i) {
+            index_->addPoint(tensor + index_->data_size_ * i, offset + i);
+        }
+        return Status::success;
+    }
+
+    Status
+    FinishBuild(const HnswConfig& hnsw_cfg, knowhere::TimeRecorder& build_time) {
+        if (hnsw_cfg.graph_reorder.value()) {
+            index_->reorderByBFS();
+            build_time.RecordSection("graph reorder");
+        }
+        LOG_KNOWHERE_INFO_ << "HNSW built with #points num:" << index_->max_elements_ << " #M:" << index_->M_
+                           << " #max level:" << index_->maxlevel_ << " #ef_construction:" << index_->ef_construction_
+                           << " #dim:" << *(size_t*)(index_->space_->get_dist_func_param());
+        return Status::success;
+    }
+
+    // query `idx` of xq as the graph compares it: fp32 for fp32, fp16 and bf16 indexes, which keeps the precision
+    // of fp32 queries on half data. fp16 / bf16 queries are widened into a buffer of the calling thread.
+    const char*
+    QueryForSearch(const void* xq, DataType type, int64_t idx) const {
+        if (type == DataType::kFloat32) {
+            return (const char*)xq + idx * index_->querySize();
+        }
+        auto dim = Dim();
+        thread_local std::vector<float> scratch;
+        if (scratch.size() < static_cast<size_t>(dim)) {
+            scratch.resize(dim);
+        }
+        ConvertToFloat((const char*)xq + idx * dim * DataTypeSize(type), type, scratch.data(), dim);
+        return (const char*)scratch.data();
+    }
+
     void
     UpdateLevelLinkList(int32_t level, feder::hnsw::HNSWMeta& meta, std::unordered_set<int64_t>& id_set) const {
         if (!(level > 0 && level <= index_->maxlevel_)) {
@@ -432,11 +585,12 @@ class HnswIndexNode : public IndexNode {
             std::vector<int64_t> neighbors(size);
             for (int i = 0; i < size; i++) {
                 hnswlib::tableint cand = datal[i];
-                neighbors[i] = cand;
+                neighbors[i] = index_->getExternalLabel(cand);
             }
-            id_set.insert(curr_id);
+            auto curr_label = index_->getExternalLabel(curr_id);
+            id_set.insert(curr_label);
             id_set.insert(neighbors.begin(), neighbors.end());
-            meta.AddNodeInfo(level, curr_id, std::move(neighbors));
+            meta.AddNodeInfo(level, curr_label, std::move(neighbors));
         }
     }
 
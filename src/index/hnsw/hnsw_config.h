@@ -30,6 +30,8 @@ class HnswConfig : public BaseConfig {
     CFG_INT efConstruction;
     CFG_INT ef;
     CFG_INT overview_levels;
+    CFG_BOOL graph_reorder;
+    CFG_BOOL range_adaptive_ef;
     KNOHWERE_DECLARE_CONFIG(HnswConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(M).description("hnsw M").set_default(30).set_range(1, 2048).for_train();
         KNOWHERE_CONFIG_DECLARE_FIELD(efConstruction)
@@ -48,6 +50,14 @@ class HnswConfig : public BaseConfig {
             .set_default(3)
             .set_range(1, 5)
             .for_feder();
+        KNOWHERE_CONFIG_DECLARE_FIELD(graph_reorder)
+            .description("renumber hnsw nodes in graph order after build for memory locality")
+            .set_default(false)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(range_adaptive_ef)
+            .description("range search doubles ef while all candidates are in range instead of expanding from them")
+            .set_default(false)
+            .for_range_search();
     }
 
     inline Status
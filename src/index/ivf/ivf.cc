@@ -9,6 +9,9 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <cstring>
+#include <fstream>
+
 #include "common/metric.h"
 #include "common/range_util.h"
 #include "faiss/IndexBinaryFlat.h"
@@ -20,8 +23,14 @@
 #include "faiss/IndexScaNN.h"
 #include "faiss/IndexScalarQuantizer.h"
 #include "faiss/index_io.h"
+#include "faiss/utils/distances.h"
+#include "faiss/invlists/MmapInvertedLists.h"
 #include "index/ivf/ivf_config.h"
+#include "index/ivf/shared_quantizer.h"
 #include "io/FaissIO.h"
+#include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/filter_strategy.h"
+#include "knowhere/comp/huge_page.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
@@ -42,6 +51,107 @@ struct QuantizerT<faiss::IndexBinaryIVF> {
     using type = faiss::IndexBinaryFlat;
 };
 
+// Scans the inverted lists of one query in increasing distance of their centroids, `nprobe` lists at a time, and
+// yields the scanned rows closest first. The next lists are only scanned once every row of the scanned ones has been
+// returned, so the first results are those of a regular search with the same nprobe.
+class IvfIterator : public IndexNode::iterator {
+ public:
+    // `codes_arranged` is set for IVF_FLAT, whose vectors live in arranged_codes instead of the inverted lists
+    IvfIterator(const faiss::IndexIVF* index, const float* query, size_t nprobe, bool codes_arranged,
+                const BitsetView& bitset)
+        : index_(index),
+          query_(query, query + index->d),
+          nprobe_(std::max<size_t>(nprobe, 1)),
+          codes_arranged_(codes_arranged),
+          bitset_(bitset),
+          sign_(index->metric_type == faiss::METRIC_INNER_PRODUCT ? -1.0f : 1.0f),
+          scanner_(index->get_InvertedListScanner(false)),
+          lists_(index->nlist),
+          coarse_dis_(index->nlist) {
+        index_->quantizer->search(1, query_.data(), index_->nlist, coarse_dis_.data(), lists_.data());
+        scanner_->set_query(query_.data());
+        ScanNextLists();
+    }
+
+    std::pair<int64_t, float>
+    Next() override {
+        if (!HasNext()) {
+            return {-1, std::numeric_limits<float>::infinity() * sign_};
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+        auto [dist, id] = heap_.back();
+        heap_.pop_back();
+        return {id, dist * sign_};
+    }
+
+    bool
+    HasNext() override {
+        while (heap_.empty() && next_list_ < lists_.size()) {
+            ScanNextLists();
+        }
+        return !heap_.empty();
+    }
+
+ private:
+    void
+    ScanNextLists() {
+        const auto invlists = index_->invlists;
+        const auto code_size = index_->code_size;
+        const auto end = std::min(next_list_ + nprobe_, lists_.size());
+        for (; next_list_ < end; ++next_list_) {
+            const auto list_no = lists_[next_list_];
+            // not enough centroids
+            if (list_no < 0) {
+                continue;
+            }
+            const auto list_size = invlists->list_size(list_no);
+            if (list_size == 0) {
+                continue;
+            }
+            scanner_->set_list(list_no, coarse_dis_[next_list_]);
+            std::unique_ptr<faiss::InvertedLists::ScopedCodes> scodes;
+            const uint8_t* codes = nullptr;
+            if (codes_arranged_) {
+                scodes = std::make_unique<faiss::InvertedLists::ScopedCodes>(invlists, list_no,
+                                                                             index_->arranged_codes.data());
+                codes = scodes->get() + code_size * index_->prefix_sum[list_no];
+            } else {
+                scodes = std::make_unique<faiss::InvertedLists::ScopedCodes>(invlists, list_no);
+                codes = scodes->get();
+            }
+            // raw COSINE vectors of IVF_FLAT, fp32 or half, are scaled by their inverse norms
+            const float* inverse_norms = index_->code_inverse_norms(list_no);
+            faiss::InvertedLists::ScopedIds ids(invlists, list_no);
+            for (size_t j = 0; j < list_size; ++j) {
+                const auto id = ids[j];
+                if (!bitset_.empty() && bitset_.test(id)) {
+                    continue;
+                }
+                auto dis = scanner_->distance_to_code(codes + j * code_size);
+                if (inverse_norms != nullptr) {
+                    dis *= inverse_norms[j];
+                }
+                // a min-heap on sign * distance keeps the closest row on top for both metrics
+                heap_.emplace_back(sign_ * dis, id);
+                std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+            }
+        }
+    }
+
+    const faiss::IndexIVF* index_;
+    const std::vector<float> query_;
+    const size_t nprobe_;
+    const bool codes_arranged_;
+    const BitsetView bitset_;
+    const float sign_;
+    std::unique_ptr<faiss::InvertedListScanner> scanner_;
+    // all lists, closest centroid first
+    std::vector<faiss::Index::idx_t> lists_;
+    std::vector<float> coarse_dis_;
+    size_t next_list_ = 0;
+    std::vector<std::pair<float, int64_t>> heap_;
+};
+
 template <typename T>
 class IvfIndexNode : public IndexNode {
  public:
@@ -53,20 +163,35 @@ class IvfIndexNode : public IndexNode {
                       "not support");
         search_pool_ = ThreadPool::GetGlobalSearchThreadPool();
     }
+    // IVF_SQ with `sq_type` codes, QT_fp16 / QT_bf16 ones hold the rows of a half IVF_FLAT
+    IvfIndexNode(const Object& object, faiss::QuantizerType sq_type) : IvfIndexNode(object) {
+        sq_type_ = sq_type;
+    }
+    Status
+    Build(const DataSet& dataset, const Config& cfg) override;
+    Status
+    Train(const DataSet& dataset, const Config& cfg) override {
+        return Train(dataset, cfg, false);
+    }
     Status
-    Train(const DataSet& dataset, const Config& cfg) override;
+    Add(const DataSet& dataset, const Config& cfg) override {
+        return Add(dataset, cfg, false);
+    }
     Status
-    Add(const DataSet& dataset, const Config& cfg) override;
+    BuildFromReader(DataSetReader& reader, const Config& cfg) override;
     expected<DataSetPtr>
     Search(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override;
     expected<DataSetPtr>
     RangeSearch(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override;
+    expected<std::vector<IteratorPtr>>
+    AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override;
     expected<DataSetPtr>
     GetVectorByIds(const DataSet& dataset) const override;
     bool
     HasRawData(const std::string& metric_type) const override {
         if constexpr (std::is_same<faiss::IndexIVFFlat, T>::value) {
-            return !IsMetricType(metric_type, metric::COSINE);
+            // COSINE indexes built before the inverse norms were kept hold normalized vectors
+            return !IsMetricType(metric_type, metric::COSINE) || index_ == nullptr || index_->use_inverse_norms;
         }
         if constexpr (std::is_same<faiss::IndexIVFFlatCC, T>::value) {
             return true;
@@ -78,7 +203,9 @@ class IvfIndexNode : public IndexNode {
             return true;
         }
         if constexpr (std::is_same<faiss::IndexIVFScalarQuantizer, T>::value) {
-            return false;
+            // fp16 / bf16 codes are the rows themselves, COSINE ones are kept raw with their inverse norms
+            return HalfCodesType() != DataType::kFloat32 &&
+                   (!IsMetricType(metric_type, metric::COSINE) || index_->use_inverse_norms);
         }
         if constexpr (std::is_same<faiss::IndexBinaryIVF, T>::value) {
             return true;
@@ -174,6 +301,14 @@ class IvfIndexNode : public IndexNode {
         }
         return index_->ntotal;
     };
+    int64_t
+    Nlist() const {
+        if constexpr (std::is_same<T, faiss::IndexScaNN>::value) {
+            return static_cast<const faiss::IndexIVFPQFastScan*>(index_->base_index)->nlist;
+        } else {
+            return index_->nlist;
+        }
+    }
     std::string
     Type() const override {
         if constexpr (std::is_same<T, faiss::IndexIVFFlat>::value) {
@@ -197,8 +332,52 @@ class IvfIndexNode : public IndexNode {
     };
 
  private:
+    // `unit_rows` tells the COSINE rows of `dataset` are normalized already, by a Build sharing its copy
+    Status
+    Train(const DataSet& dataset, const Config& cfg, bool unit_rows);
+    Status
+    Add(const DataSet& dataset, const Config& cfg, bool unit_rows);
+    // whether Add encodes the COSINE rows from a normalized copy, IVF_FLAT keeps them raw with their inverse norms,
+    // fp32 or half, except for indexes built before the inverse norms were kept
+    bool
+    AddsNormalizedRows() const {
+        if constexpr (std::is_same_v<faiss::IndexIVFFlat, T> || std::is_same_v<faiss::IndexIVFScalarQuantizer, T>) {
+            return index_ != nullptr && !index_->use_inverse_norms;
+        } else {
+            return !std::is_same_v<faiss::IndexIVFFlatCC, T> && !std::is_same_v<faiss::IndexScaNN, T>;
+        }
+    }
+    // shared centroids named in the binset or the config, looked up before reading an index built on them
+    Status
+    FindSharedQuantizer(const BinarySet* binset, const Config& config, std::string& name,
+                        std::shared_ptr<SharedQuantizer>& quantizer) const;
+    // keep the shared centroids referenced by the index just read, fail if it was built on centroids not found
+    Status
+    AttachSharedQuantizer(std::string name, std::shared_ptr<SharedQuantizer> quantizer);
+    // brute force strategy of a filtered search, scans the raw vectors of the unfiltered ids only
+    expected<DataSetPtr>
+    SearchUnfilteredIds(const DataSet& dataset, const IvfConfig& cfg, const BitsetView& bitset) const;
+    // data type of the rows held by fp16 / bf16 IVF_SQ codes, kFloat32 for lossy codes
+    DataType
+    HalfCodesType() const {
+        if constexpr (std::is_same<T, faiss::IndexIVFScalarQuantizer>::value) {
+            if (index_ != nullptr && index_->sq.qtype == faiss::QuantizerType::QT_fp16) {
+                return DataType::kFloat16;
+            }
+            if (index_ != nullptr && index_->sq.qtype == faiss::QuantizerType::QT_bf16) {
+                return DataType::kBFloat16;
+            }
+        }
+        return DataType::kFloat32;
+    }
+
+    // declared before index_, which references it without owning it
+    std::shared_ptr<SharedQuantizer> shared_quantizer_;
+    std::string shared_centroids_;
     std::unique_ptr<T> index_;
     std::shared_ptr<ThreadPool> search_pool_;
+    // codes of IVF_SQ, QT_fp16 / QT_bf16 for the rows of a half IVF_FLAT
+    faiss::QuantizerType sq_type_ = faiss::QuantizerType::QT_8bit;
 };
 
 }  // namespace knowhere
@@ -237,18 +416,142 @@ MatchNbits(int64_t size, int64_t nbits) {
     return nbits;
 }
 
+// half IVF_FLAT is written as an IVF_SQ index, told apart from the raw one by its leading fourcc
+inline bool
+IsIvfSqFourcc(const uint8_t* data, size_t size) {
+    uint32_t h = 0;
+    if (size < sizeof(h)) {
+        return false;
+    }
+    memcpy(&h, data, sizeof(h));
+    return h == faiss::fourcc("IwSq") || h == faiss::fourcc("IwSQ") || h == faiss::fourcc("IwSn");
+}
+
+template <typename T>
+faiss::InvertedLists*
+GetInvertedLists(T* index) {
+    if constexpr (std::is_same<T, faiss::IndexScaNN>::value) {
+        if (auto ivf = dynamic_cast<faiss::IndexIVF*>(index->base_index)) {
+            return ivf->invlists;
+        }
+        return nullptr;
+    } else {
+        return index->invlists;
+    }
+}
+
+template <typename T>
+void
+ReplaceInvertedLists(T* index, faiss::InvertedLists* invlists) {
+    if constexpr (std::is_same<T, faiss::IndexScaNN>::value) {
+        dynamic_cast<faiss::IndexIVF*>(index->base_index)->replace_invlists(invlists, true);
+    } else {
+        index->replace_invlists(invlists, true);
+    }
+}
+
+// Back the inverted lists of a loaded index with huge pages. A list is usually far below the size of a huge page, so
+// the lists are moved into one contiguous buffer for the codes and one for the ids, which are advised once. Lists are
+// moved one at a time to keep the peak memory close to the size of the index. Callers publish the metric once the
+// index is loaded.
+template <typename T>
+void
+AdviseInvertedListsHugePages(T* index) {
+    auto array_invlists = dynamic_cast<faiss::ArrayInvertedLists*>(GetInvertedLists(index));
+    if (array_invlists == nullptr || !IsHugePageEnabled()) {
+        return;
+    }
+    const size_t nlist = array_invlists->nlist;
+    std::vector<size_t> lengths(nlist);
+    size_t total = 0, code_bytes = 0;
+    for (size_t i = 0; i < nlist; i++) {
+        lengths[i] = array_invlists->ids[i].size();
+        total += lengths[i];
+        code_bytes += array_invlists->codes[i].size();
+    }
+    if (code_bytes + total * sizeof(faiss::idx_t) < kHugePageSize) {
+        return;
+    }
+    auto contiguous =
+        std::make_unique<faiss::ReadOnlyArrayInvertedLists>(nlist, array_invlists->code_size, lengths);
+    if (code_bytes == 0) {
+        // IVF_FLAT keeps its vectors out of the lists
+        std::vector<uint8_t>().swap(contiguous->readonly_codes);
+    }
+    for (size_t i = 0; i < nlist; i++) {
+        auto& codes = array_invlists->codes[i];
+        auto& ids = array_invlists->ids[i];
+        contiguous->readonly_codes.insert(contiguous->readonly_codes.end(), codes.begin(), codes.end());
+        contiguous->readonly_ids.insert(contiguous->readonly_ids.end(), ids.begin(), ids.end());
+        std::vector<uint8_t>().swap(codes);
+        std::vector<faiss::idx_t>().swap(ids);
+    }
+    AdviseHugePages(contiguous->readonly_codes.data(), contiguous->readonly_codes.size());
+    AdviseHugePages(contiguous->readonly_ids.data(), contiguous->readonly_ids.size() * sizeof(faiss::idx_t));
+    ReplaceInvertedLists(index, contiguous.release());
+}
+
+// Lists made contiguous on load are read only, give them back a vector per list before adding to them
+template <typename T>
+void
+MakeInvertedListsWritable(T* index) {
+    auto contiguous = dynamic_cast<faiss::ReadOnlyArrayInvertedLists*>(GetInvertedLists(index));
+    if (contiguous == nullptr) {
+        return;
+    }
+    auto array_invlists = std::make_unique<faiss::ArrayInvertedLists>(contiguous->nlist, contiguous->code_size);
+    for (size_t i = 0; i < contiguous->nlist; i++) {
+        auto n = contiguous->list_size(i);
+        if (contiguous->readonly_codes.empty()) {
+            array_invlists->add_entries_without_codes(i, n, contiguous->get_ids(i));
+        } else {
+            array_invlists->add_entries(i, n, contiguous->get_ids(i), contiguous->get_codes(i));
+        }
+    }
+    ReplaceInvertedLists(index, array_invlists.release());
+}
+
 template <typename T>
 Status
-IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg) {
+IvfIndexNode<T>::Build(const DataSet& dataset, const Config& cfg) {
+    // widened and normalized once, the copies are shared by Train and Add
+    if (dataset.GetTensorDataType() != DataType::kFloat32) {
+        return Build(*ConvertToFloatDataSet(dataset), cfg);
+    }
+    const BaseConfig& base_cfg = static_cast<const IvfConfig&>(cfg);
+    if constexpr (std::is_same_v<faiss::IndexIVFFlatCC, T> || std::is_same_v<faiss::IndexScaNN, T>) {
+        return IndexNode::Build(dataset, cfg);
+    } else {
+        if (!IsMetricType(base_cfg.metric_type.value(), knowhere::metric::COSINE)) {
+            return IndexNode::Build(dataset, cfg);
+        }
+        auto normalized = CopyAndNormalize(dataset);
+        RETURN_IF_ERROR(Train(*normalized, cfg, true));
+        if (AddsNormalizedRows()) {
+            return Add(*normalized, cfg, true);
+        }
+        return Add(dataset, cfg, false);
+    }
+}
+
+template <typename T>
+Status
+IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg, bool unit_rows) {
+    // IVF indexes store fp32 vectors or codes encoded from them, fp16 / bf16 input is widened up front
+    if (dataset.GetTensorDataType() != DataType::kFloat32) {
+        return Train(*ConvertToFloatDataSet(dataset), cfg, unit_rows);
+    }
     const BaseConfig& base_cfg = static_cast<const IvfConfig&>(cfg);
     std::unique_ptr<ThreadPool::ScopedOmpSetter> setter;
     if (base_cfg.num_build_thread.has_value()) {
         setter = std::make_unique<ThreadPool::ScopedOmpSetter>(base_cfg.num_build_thread.value());
     }
-    // do normalize for COSINE metric type
-    if (IsMetricType(base_cfg.metric_type.value(), knowhere::metric::COSINE)) {
+    // COSINE centroids are trained on unit vectors, normalized in a copy so the caller's data is never rewritten
+    const bool is_cosine = IsMetricType(base_cfg.metric_type.value(), knowhere::metric::COSINE);
+    DataSetPtr normalized;
+    if (is_cosine && !unit_rows) {
         if constexpr (!(std::is_same_v<faiss::IndexIVFFlatCC, T>)&&!(std::is_same_v<faiss::IndexScaNN, T>)) {
-            Normalize(dataset);
+            normalized = CopyAndNormalize(dataset);
         }
     }
 
@@ -260,7 +563,26 @@ IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg) {
 
     auto rows = dataset.GetRows();
     auto dim = dataset.GetDim();
-    auto data = dataset.GetTensor();
+    auto data = normalized ? normalized->GetTensor() : dataset.GetTensor();
+
+    // shared centroids replace the k-means of the index, faiss skips training a quantizer of nlist centroids
+    const auto& shared_centroids = static_cast<const IvfConfig&>(cfg).shared_centroids.value();
+    std::shared_ptr<SharedQuantizer> shared_quantizer;
+    if (!shared_centroids.empty()) {
+        if constexpr (std::is_same<faiss::IndexScaNN, T>::value || std::is_same<faiss::IndexBinaryIVF, T>::value) {
+            LOG_KNOWHERE_ERROR_ << Type() << " does not support shared centroids";
+            return Status::invalid_args;
+        }
+        shared_quantizer = GetSharedQuantizer(shared_centroids);
+        if (shared_quantizer == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "shared centroids " << shared_centroids << " are not registered";
+            return Status::invalid_args;
+        }
+        if (shared_quantizer->d != dim || shared_quantizer->metric_type != metric.value()) {
+            LOG_KNOWHERE_ERROR_ << "shared centroids " << shared_centroids << " do not match the dim or metric type";
+            return Status::invalid_args;
+        }
+    }
 
     typename QuantizerT<T>::type* qzr = nullptr;
     faiss::IndexIVFPQFastScan* base_index = nullptr;
@@ -268,32 +590,35 @@ IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg) {
     try {
         if constexpr (std::is_same<faiss::IndexIVFFlat, T>::value) {
             const IvfFlatConfig& ivf_flat_cfg = static_cast<const IvfFlatConfig&>(cfg);
-            auto nlist = MatchNlist(rows, ivf_flat_cfg.nlist.value());
-            qzr = new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
+            auto nlist = shared_quantizer ? shared_quantizer->ntotal : MatchNlist(rows, ivf_flat_cfg.nlist.value());
+            qzr = shared_quantizer ? shared_quantizer.get()
+                                   : new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
             index = std::make_unique<faiss::IndexIVFFlat>(qzr, dim, nlist, metric.value());
+            index->use_inverse_norms = is_cosine;
             index->train(rows, (const float*)data);
         }
         if constexpr (std::is_same<faiss::IndexIVFFlatCC, T>::value) {
             const IvfFlatCcConfig& ivf_flat_cc_cfg = static_cast<const IvfFlatCcConfig&>(cfg);
-            auto nlist = MatchNlist(rows, ivf_flat_cc_cfg.nlist.value());
-            qzr = new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
-            bool is_cosine = base_cfg.metric_type.value() == metric::COSINE;
+            auto nlist =
+                shared_quantizer ? shared_quantizer->ntotal : MatchNlist(rows, ivf_flat_cc_cfg.nlist.value());
+            qzr = shared_quantizer ? shared_quantizer.get()
+                                   : new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
             index = std::make_unique<faiss::IndexIVFFlatCC>(qzr, dim, nlist, ivf_flat_cc_cfg.ssize.value(), is_cosine,
                                                             metric.value());
             index->train(rows, (const float*)data);
         }
         if constexpr (std::is_same<faiss::IndexIVFPQ, T>::value) {
             const IvfPqConfig& ivf_pq_cfg = static_cast<const IvfPqConfig&>(cfg);
-            auto nlist = MatchNlist(rows, ivf_pq_cfg.nlist.value());
+            auto nlist = shared_quantizer ? shared_quantizer->ntotal : MatchNlist(rows, ivf_pq_cfg.nlist.value());
             auto nbits = MatchNbits(rows, ivf_pq_cfg.nbits.value());
-            qzr = new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
+            qzr = shared_quantizer ? shared_quantizer.get()
+                                   : new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
             index = std::make_unique<faiss::IndexIVFPQ>(qzr, dim, nlist, ivf_pq_cfg.m.value(), nbits, metric.value());
             index->train(rows, (const float*)data);
         }
         if constexpr (std::is_same<faiss::IndexScaNN, T>::value) {
             const ScannConfig& scann_cfg = static_cast<const ScannConfig&>(cfg);
             auto nlist = MatchNlist(rows, scann_cfg.nlist.value());
-            bool is_cosine = base_cfg.metric_type.value() == metric::COSINE;
             qzr = new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
             base_index =
                 new (std::nothrow) faiss::IndexIVFPQFastScan(qzr, dim, nlist, dim / 2, 4, is_cosine, metric.value());
@@ -303,10 +628,14 @@ IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg) {
         }
         if constexpr (std::is_same<faiss::IndexIVFScalarQuantizer, T>::value) {
             const IvfSqConfig& ivf_sq_cfg = static_cast<const IvfSqConfig&>(cfg);
-            auto nlist = MatchNlist(rows, ivf_sq_cfg.nlist.value());
-            qzr = new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
-            index = std::make_unique<faiss::IndexIVFScalarQuantizer>(qzr, dim, nlist, faiss::QuantizerType::QT_8bit,
-                                                                     metric.value());
+            auto nlist = shared_quantizer ? shared_quantizer->ntotal : MatchNlist(rows, ivf_sq_cfg.nlist.value());
+            qzr = shared_quantizer ? shared_quantizer.get()
+                                   : new (std::nothrow) typename QuantizerT<T>::type(dim, metric.value());
+            // fp16 / bf16 codes store the rows losslessly, encoded without residual and raw for COSINE
+            const bool half_codes = sq_type_ != faiss::QuantizerType::QT_8bit;
+            index = std::make_unique<faiss::IndexIVFScalarQuantizer>(qzr, dim, nlist, sq_type_, metric.value(),
+                                                                     !half_codes);
+            index->use_inverse_norms = is_cosine && half_codes;
             index->train(rows, (const float*)data);
         }
         if constexpr (std::is_same<faiss::IndexBinaryIVF, T>::value) {
@@ -316,9 +645,9 @@ IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg) {
             index = std::make_unique<faiss::IndexBinaryIVF>(qzr, dim, nlist, metric.value());
             index->train(rows, (const uint8_t*)data);
         }
-        index->own_fields = true;
+        index->own_fields = shared_quantizer == nullptr;
     } catch (std::exception& e) {
-        if (qzr) {
+        if (qzr && shared_quantizer == nullptr) {
             delete qzr;
         }
         if (base_index) {
@@ -328,25 +657,35 @@ IvfIndexNode<T>::Train(const DataSet& dataset, const Config& cfg) {
         return Status::faiss_inner_error;
     }
     index_ = std::move(index);
+    shared_quantizer_ = std::move(shared_quantizer);
+    shared_centroids_ = shared_centroids;
 
     return Status::success;
 }
 
 template <typename T>
 Status
-IvfIndexNode<T>::Add(const DataSet& dataset, const Config& cfg) {
+IvfIndexNode<T>::Add(const DataSet& dataset, const Config& cfg, bool unit_rows) {
+    if (dataset.GetTensorDataType() != DataType::kFloat32) {
+        return Add(*ConvertToFloatDataSet(dataset), cfg, unit_rows);
+    }
     if (!this->index_) {
         LOG_KNOWHERE_ERROR_ << "Can not add data to empty IVF index.";
         expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
     }
-    auto data = dataset.GetTensor();
     auto rows = dataset.GetRows();
     const BaseConfig& base_cfg = static_cast<const IvfConfig&>(cfg);
     std::unique_ptr<ThreadPool::ScopedOmpSetter> setter;
     if (base_cfg.num_build_thread.has_value()) {
         setter = std::make_unique<ThreadPool::ScopedOmpSetter>(base_cfg.num_build_thread.value());
     }
+    DataSetPtr normalized;
+    if (IsMetricType(base_cfg.metric_type.value(), knowhere::metric::COSINE) && !unit_rows && AddsNormalizedRows()) {
+        normalized = CopyAndNormalize(dataset);
+    }
+    auto data = normalized ? normalized->GetTensor() : dataset.GetTensor();
     try {
+        MakeInvertedListsWritable(index_.get());
         if constexpr (std::is_same<T, faiss::IndexIVFFlat>::value) {
             index_->add_without_codes(rows, (const float*)data);
         } else if constexpr (std::is_same<faiss::IndexBinaryIVF, T>::value) {
@@ -354,7 +693,6 @@ IvfIndexNode<T>::Add(const DataSet& dataset, const Config& cfg) {
         } else {
             index_->add(rows, (const float*)data);
         }
-
     } catch (std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
         return Status::faiss_inner_error;
@@ -362,9 +700,23 @@ IvfIndexNode<T>::Add(const DataSet& dataset, const Config& cfg) {
     return Status::success;
 }
 
+template <typename T>
+Status
+IvfIndexNode<T>::BuildFromReader(DataSetReader& reader, const Config& cfg) {
+    if constexpr (std::is_same<T, faiss::IndexScaNN>::value) {
+        // ScaNN refines against a pointer to the whole raw data, which a chunked build never holds
+        return Status::not_implemented;
+    } else {
+        return TrainAndAddInChunks(reader, cfg);
+    }
+}
+
 template <typename T>
 expected<DataSetPtr>
 IvfIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const {
+    if (dataset.GetTensorDataType() != DataType::kFloat32) {
+        return Search(*ConvertToFloatDataSet(dataset), cfg, bitset);
+    }
     if (!this->index_) {
         LOG_KNOWHERE_WARNING_ << "search on empty index";
         expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
@@ -377,12 +729,25 @@ IvfIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const BitsetV
     auto dim = dataset.GetDim();
     auto rows = dataset.GetRows();
     auto data = dataset.GetTensor();
+    // ScaNN reports refined distances, which its fast scan heap can't be bounded with
+    auto knn_bounds = std::is_same<T, faiss::IndexScaNN>::value ? nullptr : dataset.GetKnnBounds();
 
     const IvfConfig& ivf_cfg = static_cast<const IvfConfig&>(cfg);
     bool is_cosine = IsMetricType(ivf_cfg.metric_type.value(), knowhere::metric::COSINE);
 
     auto k = ivf_cfg.k.value();
     auto nprobe = ivf_cfg.nprobe.value();
+    if (!bitset.empty()) {
+        auto plan =
+            PlanIvfFilteredSearch(Str2FilterStrategy(ivf_cfg.filter_strategy.value()).value_or(FilterStrategy::kAuto),
+                                  bitset, index_->ntotal, nprobe, Nlist());
+        RecordFilterSearchPlan(plan);
+        if (plan.strategy == FilterStrategy::kBruteForce && HasRawData(ivf_cfg.metric_type.value())) {
+            return SearchUnfilteredIds(dataset, ivf_cfg, bitset);
+        }
+        // without raw data, brute force probes all the lists
+        nprobe = static_cast<int32_t>(plan.search_width);
+    }
 
     int64_t* ids(new (std::nothrow) int64_t[rows * k]);
     float* distances(new (std::nothrow) float[rows * k]);
@@ -393,8 +758,10 @@ IvfIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const BitsetV
         for (int i = 0; i < rows; ++i) {
             futs.emplace_back(search_pool_->push([&, index = i] {
                 ThreadPool::ScopedOmpSetter setter(1);
+                faiss::ScopedEarlyAbandon early_abandon(ivf_cfg.early_abandon.value());
+                faiss::ScopedKnnBound knn_bound(knn_bounds ? knn_bounds[index]
+                                                           : std::numeric_limits<float>::quiet_NaN());
                 auto offset = k * index;
-                std::unique_ptr<float[]> copied_query = nullptr;
                 if constexpr (std::is_same<T, faiss::IndexBinaryIVF>::value) {
                     auto cur_data = (const uint8_t*)data + index * dim / 8;
                     index_->search_thread_safe(1, cur_data, k, i_distances + offset, ids + offset, nprobe, bitset);
@@ -406,8 +773,7 @@ IvfIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const BitsetV
                 } else if constexpr (std::is_same<T, faiss::IndexIVFFlat>::value) {
                     auto cur_query = (const float*)data + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        cur_query = copied_query.get();
+                        cur_query = NormalizeQuery(cur_query, dim);
                     }
                     index_->search_without_codes_thread_safe(1, cur_query, k, distances + offset, ids + offset, nprobe,
                                                              0, bitset);
@@ -415,16 +781,14 @@ IvfIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const BitsetV
                     auto cur_query = (const float*)data + index * dim;
                     const ScannConfig& scann_cfg = static_cast<const ScannConfig&>(cfg);
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        cur_query = copied_query.get();
+                        cur_query = NormalizeQuery(cur_query, dim);
                     }
                     index_->search_thread_safe(1, cur_query, k, distances + offset, ids + offset, nprobe,
                                                scann_cfg.reorder_k.value(), bitset);
                 } else {
                     auto cur_query = (const float*)data + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        cur_query = copied_query.get();
+                        cur_query = NormalizeQuery(cur_query, dim);
                     }
                     index_->search_thread_safe(1, cur_query, k, distances + offset, ids + offset, nprobe, 0, bitset);
                 }
@@ -444,9 +808,43 @@ IvfIndexNode<T>::Search(const DataSet& dataset, const Config& cfg, const BitsetV
     return res;
 }
 
+template <typename T>
+expected<DataSetPtr>
+IvfIndexNode<T>::SearchUnfilteredIds(const DataSet& dataset, const IvfConfig& cfg, const BitsetView& bitset) const {
+    auto unfiltered_ids = GatherUnfilteredIds(bitset, index_->ntotal);
+    auto vectors = GetVectorByIds(*GenIdsDataSet(unfiltered_ids.size(), unfiltered_ids.data()));
+    if (!vectors.has_value()) {
+        return vectors;
+    }
+    auto base = vectors.value();
+    if (base->GetTensorDataType() != DataType::kFloat32) {
+        base = ConvertToFloatDataSet(*base);
+    }
+    auto rows = dataset.GetRows();
+    auto k = cfg.k.value();
+    auto ids = std::make_unique<int64_t[]>(rows * k);
+    auto distances = std::make_unique<float[]>(rows * k);
+    const Json json = {{meta::METRIC_TYPE, cfg.metric_type.value()}, {meta::TOPK, k}};
+    auto status = BruteForce::SearchWithBuf(base, GenDataSet(rows, dataset.GetDim(), dataset.GetTensor()),
+                                            ids.get(), distances.get(), json, nullptr);
+    if (status != Status::success) {
+        return expected<DataSetPtr>::Err(status, "brute force over the unfiltered ids failed");
+    }
+    // positions in the gathered vectors back to ids
+    for (int64_t i = 0; i < rows * k; ++i) {
+        if (ids[i] >= 0) {
+            ids[i] = unfiltered_ids[ids[i]];
+        }
+    }
+    return GenResultDataSet(rows, k, ids.release(), distances.release());
+}
+
 template <typename T>
 expected<DataSetPtr>
 IvfIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const {
+    if (dataset.GetTensorDataType() != DataType::kFloat32) {
+        return RangeSearch(*ConvertToFloatDataSet(dataset), cfg, bitset);
+    }
     if (!this->index_) {
         LOG_KNOWHERE_WARNING_ << "range search on empty index";
         expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
@@ -471,10 +869,7 @@ IvfIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, const Bi
     float* distances = nullptr;
     size_t* lims = nullptr;
 
-    std::vector<std::vector<int64_t>> result_id_array(nq);
-    std::vector<std::vector<float>> result_dist_array(nq);
-    std::vector<size_t> result_size(nq);
-    std::vector<size_t> result_lims(nq + 1);
+    RangeSearchResultBuilder builder(nq, is_ip, radius, range_filter, ivf_cfg.range_search_k.value());
 
     try {
         std::vector<folly::Future<folly::Unit>> futs;
@@ -483,51 +878,36 @@ IvfIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, const Bi
             futs.emplace_back(search_pool_->push([&, index = i] {
                 ThreadPool::ScopedOmpSetter setter(1);
                 faiss::RangeSearchResult res(1);
-                std::unique_ptr<float[]> copied_query = nullptr;
                 if constexpr (std::is_same<T, faiss::IndexBinaryIVF>::value) {
                     auto cur_data = (const uint8_t*)xq + index * dim / 8;
                     index_->range_search_thread_safe(1, cur_data, radius, &res, index_->nlist, bitset);
                 } else if constexpr (std::is_same<T, faiss::IndexIVFFlat>::value) {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        cur_query = copied_query.get();
+                        cur_query = NormalizeQuery(cur_query, dim);
                     }
                     index_->range_search_without_codes_thread_safe(1, cur_query, radius, &res, index_->nlist, 0,
                                                                    bitset);
                 } else if constexpr (std::is_same<T, faiss::IndexScaNN>::value) {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        cur_query = copied_query.get();
+                        cur_query = NormalizeQuery(cur_query, dim);
                     }
                     index_->range_search_thread_safe(1, cur_query, radius, &res, bitset);
                 } else {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeFloatVec(cur_query, dim);
-                        cur_query = copied_query.get();
+                        cur_query = NormalizeQuery(cur_query, dim);
                     }
                     index_->range_search_thread_safe(1, cur_query, radius, &res, index_->nlist, 0, bitset);
                 }
-                auto elem_cnt = res.lims[1];
-                result_dist_array[index].resize(elem_cnt);
-                result_id_array[index].resize(elem_cnt);
-                result_size[index] = elem_cnt;
-                for (size_t j = 0; j < elem_cnt; j++) {
-                    result_dist_array[index][j] = res.distances[j];
-                    result_id_array[index][j] = res.labels[j];
-                }
-                if (range_filter != defaultRangeFilter) {
-                    FilterRangeSearchResultForOneNq(result_dist_array[index], result_id_array[index], is_ip, radius,
-                                                    range_filter);
-                }
+                builder.SetResult(index, res);
             }));
         }
         for (auto& fut : futs) {
             fut.wait();
         }
-        GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius, range_filter, distances, ids, lims);
+        builder.Assemble(distances, ids, lims);
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
         return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
@@ -536,6 +916,61 @@ IvfIndexNode<T>::RangeSearch(const DataSet& dataset, const Config& cfg, const Bi
     return GenResultDataSet(nq, ids, distances, lims);
 }
 
+template <typename T>
+expected<std::vector<IndexNode::IteratorPtr>>
+IvfIndexNode<T>::AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const {
+    if constexpr (std::is_same<T, faiss::IndexIVFFlatCC>::value || std::is_same<T, faiss::IndexScaNN>::value ||
+                  std::is_same<T, faiss::IndexBinaryIVF>::value) {
+        // codes of IVF_FLAT_CC are not contiguous per list, ScaNN reorders its candidates with the raw data
+        return expected<std::vector<IteratorPtr>>::Err(Status::not_implemented,
+                                                       "AnnIterator not implemented for " + Type());
+    } else {
+        if (dataset.GetTensorDataType() != DataType::kFloat32) {
+            return AnnIterator(*ConvertToFloatDataSet(dataset), cfg, bitset);
+        }
+        if (!this->index_) {
+            LOG_KNOWHERE_WARNING_ << "creating iterator on empty index";
+            return expected<std::vector<IteratorPtr>>::Err(Status::empty_index, "index not loaded");
+        }
+        if (!this->index_->is_trained) {
+            LOG_KNOWHERE_WARNING_ << "index not trained";
+            return expected<std::vector<IteratorPtr>>::Err(Status::index_not_trained, "index not trained");
+        }
+
+        auto nq = dataset.GetRows();
+        auto xq = (const float*)dataset.GetTensor();
+        auto dim = dataset.GetDim();
+
+        const IvfConfig& ivf_cfg = static_cast<const IvfConfig&>(cfg);
+        bool is_cosine = IsMetricType(ivf_cfg.metric_type.value(), knowhere::metric::COSINE);
+        auto nprobe = ivf_cfg.nprobe.value();
+
+        std::vector<IteratorPtr> iterators(nq);
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(nq);
+            for (int64_t i = 0; i < nq; ++i) {
+                futs.emplace_back(search_pool_->push([&, index = i] {
+                    ThreadPool::ScopedOmpSetter setter(1);
+                    auto cur_query = xq + index * dim;
+                    if (is_cosine) {
+                        cur_query = NormalizeQuery(cur_query, dim);
+                    }
+                    iterators[index] = std::make_shared<IvfIterator>(
+                        index_.get(), cur_query, nprobe, std::is_same<T, faiss::IndexIVFFlat>::value, bitset);
+                }));
+            }
+            for (auto& fut : futs) {
+                fut.wait();
+            }
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return expected<std::vector<IteratorPtr>>::Err(Status::faiss_inner_error, e.what());
+        }
+        return iterators;
+    }
+}
+
 template <typename T>
 expected<DataSetPtr>
 IvfIndexNode<T>::GetVectorByIds(const DataSet& dataset) const {
@@ -624,20 +1059,48 @@ IvfIndexNode<T>::GetVectorByIds(const DataSet& dataset) const {
             LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
             return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
         }
+    } else if constexpr (std::is_same<T, faiss::IndexIVFScalarQuantizer>::value) {
+        auto type = HalfCodesType();
+        if (type == DataType::kFloat32) {
+            return expected<DataSetPtr>::Err(Status::not_implemented, "GetVectorByIds not implemented");
+        }
+        auto dim = Dim();
+        auto rows = dataset.GetRows();
+        auto ids = dataset.GetIds();
+
+        // the codes of fp16 / bf16 storage are the vectors themselves
+        uint8_t* data = nullptr;
+        try {
+            auto code_size = index_->code_size;
+            data = new uint8_t[rows * code_size];
+            index_->make_direct_map(true);
+            for (int64_t i = 0; i < rows; i++) {
+                FAISS_THROW_IF_NOT(ids[i] >= 0 && ids[i] < index_->ntotal);
+                auto lo = index_->direct_map.get(ids[i]);
+                faiss::InvertedLists::ScopedCodes code(index_->invlists, faiss::lo_listno(lo), faiss::lo_offset(lo));
+                memcpy(data + i * code_size, code.get(), code_size);
+            }
+            auto res = GenResultDataSet(rows, dim, data);
+            res->SetTensorDataType(type);
+            return res;
+        } catch (const std::exception& e) {
+            std::unique_ptr<uint8_t[]> auto_del(data);
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
     } else {
         return expected<DataSetPtr>::Err(Status::not_implemented, "GetVectorByIds not implemented");
     }
 }
 
-template <>
-expected<DataSetPtr>
-IvfIndexNode<faiss::IndexIVFFlat>::GetIndexMeta(const Config& config) const {
-    if (!index_) {
+// clusters of an IVF_FLAT index, fp32 or half
+inline expected<DataSetPtr>
+GetIvfFlatIndexMeta(const faiss::IndexIVF* ivf_index) {
+    if (!ivf_index) {
         LOG_KNOWHERE_WARNING_ << "get index meta on empty index";
-        expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
     }
 
-    auto ivf_index = dynamic_cast<faiss::IndexIVF*>(index_.get());
     auto ivf_quantizer = dynamic_cast<faiss::IndexFlat*>(ivf_index->quantizer);
 
     int64_t dim = ivf_index->d;
@@ -650,10 +1113,10 @@ IvfIndexNode<faiss::IndexIVFFlat>::GetIndexMeta(const Config& config) const {
     for (int32_t i = 0; i < nlist; i++) {
         // copy from IndexIVF::search_preassigned_without_codes
         std::unique_ptr<faiss::InvertedLists::ScopedIds> sids =
-            std::make_unique<faiss::InvertedLists::ScopedIds>(index_->invlists, i);
+            std::make_unique<faiss::InvertedLists::ScopedIds>(ivf_index->invlists, i);
 
         // node ids
-        auto node_num = index_->invlists->list_size(i);
+        auto node_num = ivf_index->invlists->list_size(i);
         auto node_id_codes = sids->get();
 
         // centroid vector
@@ -668,11 +1131,29 @@ IvfIndexNode<faiss::IndexIVFFlat>::GetIndexMeta(const Config& config) const {
     return GenResultDataSet(json_meta.dump(), json_id_set.dump());
 }
 
+template <>
+expected<DataSetPtr>
+IvfIndexNode<faiss::IndexIVFFlat>::GetIndexMeta(const Config& config) const {
+    return GetIvfFlatIndexMeta(index_.get());
+}
+
+template <>
+expected<DataSetPtr>
+IvfIndexNode<faiss::IndexIVFScalarQuantizer>::GetIndexMeta(const Config& config) const {
+    // only the fp16 / bf16 codes of a half IVF_FLAT are described as its clusters
+    if (HalfCodesType() == DataType::kFloat32) {
+        return expected<DataSetPtr>::Err(Status::not_implemented, "GetIndexMeta not implemented");
+    }
+    return GetIvfFlatIndexMeta(index_.get());
+}
+
 template <typename T>
 Status
 IvfIndexNode<T>::Serialize(BinarySet& binset) const {
     try {
         MemoryIOWriter writer;
+        // the shared centroids are stored by name only
+        faiss::ScopedSharedIvfQuantizer shared_quantizer(shared_quantizer_.get());
         if constexpr (std::is_same<T, faiss::IndexBinaryIVF>::value) {
             faiss::write_index_binary(index_.get(), &writer);
         } else if constexpr (std::is_same<T, faiss::IndexIVFFlat>::value) {
@@ -682,6 +1163,15 @@ IvfIndexNode<T>::Serialize(BinarySet& binset) const {
         }
         std::shared_ptr<uint8_t[]> data(writer.data_);
         binset.Append(Type(), data, writer.rp);
+        if (shared_quantizer_ != nullptr) {
+            std::shared_ptr<uint8_t[]> name(new uint8_t[shared_centroids_.size()]);
+            std::copy(shared_centroids_.begin(), shared_centroids_.end(), name.get());
+            binset.Append(kSharedCentroidsName, name, shared_centroids_.size());
+            auto content_hash = shared_quantizer_->ContentHash();
+            std::shared_ptr<uint8_t[]> hash(new uint8_t[sizeof(content_hash)]);
+            std::memcpy(hash.get(), &content_hash, sizeof(content_hash));
+            binset.Append(kSharedCentroidsHash, hash, sizeof(content_hash));
+        }
         return Status::success;
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
@@ -701,20 +1191,26 @@ IvfIndexNode<T>::Deserialize(const BinarySet& binset, const Config& config) {
         return Status::invalid_binary_set;
     }
 
+    std::string shared_centroids;
+    std::shared_ptr<SharedQuantizer> shared_quantizer;
+    RETURN_IF_ERROR(FindSharedQuantizer(&binset, config, shared_centroids, shared_quantizer));
     MemoryIOReader reader;
     reader.total = binary->size;
     reader.data_ = binary->data.get();
     try {
+        faiss::ScopedSharedIvfQuantizer scoped_shared_quantizer(shared_quantizer.get());
         if constexpr (std::is_same<T, faiss::IndexBinaryIVF>::value) {
             index_.reset(static_cast<T*>(faiss::read_index_binary(&reader)));
         } else {
             index_.reset(static_cast<T*>(faiss::read_index(&reader)));
         }
+        AdviseInvertedListsHugePages(index_.get());
+        UpdateHugePageMetric();
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
         return Status::faiss_inner_error;
     }
-    return Status::success;
+    return AttachSharedQuantizer(std::move(shared_centroids), std::move(shared_quantizer));
 }
 
 template <typename T>
@@ -726,16 +1222,86 @@ IvfIndexNode<T>::DeserializeFromFile(const std::string& filename, const Config&
     if (cfg.enable_mmap.value()) {
         io_flags |= faiss::IO_FLAG_MMAP;
     }
+    std::string shared_centroids;
+    std::shared_ptr<SharedQuantizer> shared_quantizer;
+    RETURN_IF_ERROR(FindSharedQuantizer(nullptr, config, shared_centroids, shared_quantizer));
     try {
+        faiss::ScopedSharedIvfQuantizer scoped_shared_quantizer(shared_quantizer.get());
         if constexpr (std::is_same<T, faiss::IndexBinaryIVF>::value) {
             index_.reset(static_cast<T*>(faiss::read_index_binary(filename.data(), io_flags)));
         } else {
             index_.reset(static_cast<T*>(faiss::read_index(filename.data(), io_flags)));
         }
+        // mmapped lists are not ArrayInvertedLists and are skipped
+        AdviseInvertedListsHugePages(index_.get());
+        UpdateHugePageMetric();
+        if (auto mmap_invlists = dynamic_cast<faiss::MmapInvertedLists*>(GetInvertedLists(index_.get()))) {
+            const auto& ivf_cfg = static_cast<const IvfConfig&>(config);
+            mmap_invlists->set_cache_size(ivf_cfg.mmap_list_cache_mb.value() * 1024 * 1024);
+        }
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
         return Status::faiss_inner_error;
     }
+    return AttachSharedQuantizer(std::move(shared_centroids), std::move(shared_quantizer));
+}
+
+template <typename T>
+Status
+IvfIndexNode<T>::FindSharedQuantizer(const BinarySet* binset, const Config& config, std::string& name,
+                                     std::shared_ptr<SharedQuantizer>& quantizer) const {
+    name = static_cast<const IvfConfig&>(config).shared_centroids.value();
+    BinaryPtr hash;
+    if (binset != nullptr) {
+        if (auto binary = binset->GetByName(kSharedCentroidsName)) {
+            name.assign(reinterpret_cast<const char*>(binary->data.get()), binary->size);
+        }
+        hash = binset->GetByName(kSharedCentroidsHash);
+    }
+    if constexpr (!std::is_same<T, faiss::IndexScaNN>::value && !std::is_same<T, faiss::IndexBinaryIVF>::value) {
+        if (!name.empty()) {
+            quantizer = GetSharedQuantizer(name);
+            if (quantizer == nullptr) {
+                LOG_KNOWHERE_ERROR_ << "shared centroids " << name << " are not registered";
+                return Status::invalid_args;
+            }
+            uint64_t content_hash = 0;
+            if (hash != nullptr && hash->size == sizeof(content_hash)) {
+                std::memcpy(&content_hash, hash->data.get(), sizeof(content_hash));
+                if (content_hash != quantizer->ContentHash()) {
+                    LOG_KNOWHERE_ERROR_ << "shared centroids " << name << " are not the ones the index was built on";
+                    quantizer = nullptr;
+                    return Status::invalid_args;
+                }
+            }
+        }
+    }
+    return Status::success;
+}
+
+template <typename T>
+Status
+IvfIndexNode<T>::AttachSharedQuantizer(std::string name, std::shared_ptr<SharedQuantizer> quantizer) {
+    if constexpr (!std::is_same<T, faiss::IndexScaNN>::value && !std::is_same<T, faiss::IndexBinaryIVF>::value) {
+        if (index_->quantizer->ntotal == 0 && index_->nlist > 0) {
+            LOG_KNOWHERE_ERROR_ << "index was built on shared centroids, register them and pass shared_centroids";
+            index_ = nullptr;
+            shared_quantizer_ = nullptr;
+            return Status::invalid_args;
+        }
+        // an index with centroids of its own does not reference the shared ones
+        if (index_->quantizer != quantizer.get()) {
+            quantizer = nullptr;
+        } else if (quantizer->d != index_->d || quantizer->ntotal != index_->nlist) {
+            // a file carries no hash of the centroids, at least their shape must match
+            LOG_KNOWHERE_ERROR_ << "shared centroids " << name << " do not match the index built on them";
+            index_ = nullptr;
+            shared_quantizer_ = nullptr;
+            return Status::invalid_args;
+        }
+    }
+    shared_quantizer_ = std::move(quantizer);
+    shared_centroids_ = shared_quantizer_ ? std::move(name) : std::string();
     return Status::success;
 }
 
@@ -750,10 +1316,14 @@ IvfIndexNode<faiss::IndexIVFFlat>::Deserialize(const BinarySet& binset, const Co
         return Status::invalid_binary_set;
     }
 
+    std::string shared_centroids;
+    std::shared_ptr<SharedQuantizer> shared_quantizer;
+    RETURN_IF_ERROR(FindSharedQuantizer(&binset, config, shared_centroids, shared_quantizer));
     MemoryIOReader reader;
     reader.total = binary->size;
     reader.data_ = binary->data.get();
     try {
+        faiss::ScopedSharedIvfQuantizer scoped_shared_quantizer(shared_quantizer.get());
         index_.reset(static_cast<faiss::IndexIVFFlat*>(faiss::read_index_nm(&reader)));
 
         // Construct arranged data from original data
@@ -764,13 +1334,157 @@ IvfIndexNode<faiss::IndexIVFFlat>::Deserialize(const BinarySet& binset, const Co
         }
         size_t nb = binary->size / index_->invlists->code_size;
         index_->arrange_codes(nb, (const float*)(binary->data.get()));
+        AdviseHugePages(index_->arranged_codes.data(), index_->arranged_codes.size());
+        AdviseInvertedListsHugePages(index_.get());
+        UpdateHugePageMetric();
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
         return Status::faiss_inner_error;
     }
-    return Status::success;
+    return AttachSharedQuantizer(std::move(shared_centroids), std::move(shared_quantizer));
 }
 
+// IVF_FLAT keeps its rows in the precision they are built from: fp32 rows out of the lists, as the raw data of an
+// IndexIVFFlat, fp16 / bf16 rows in the lists, as the lossless codes of an IndexIVFScalarQuantizer. The node storing
+// them is picked by Train from the data type and by the loaders from the leading fourcc of the index.
+class IvfFlatIndexNode : public IndexNode {
+ public:
+    IvfFlatIndexNode(const Object& object) : node_(std::make_unique<IvfIndexNode<faiss::IndexIVFFlat>>(object)) {
+    }
+    Status
+    Build(const DataSet& dataset, const Config& cfg) override {
+        ResetNode(dataset.GetTensorDataType());
+        return node_->Build(dataset, cfg);
+    }
+    Status
+    Train(const DataSet& dataset, const Config& cfg) override {
+        ResetNode(dataset.GetTensorDataType());
+        return node_->Train(dataset, cfg);
+    }
+    Status
+    Add(const DataSet& dataset, const Config& cfg) override {
+        return node_->Add(dataset, cfg);
+    }
+    Status
+    BuildFromReader(DataSetReader& reader, const Config& cfg) override {
+        return TrainAndAddInChunks(reader, cfg);
+    }
+    expected<DataSetPtr>
+    Search(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override {
+        return node_->Search(dataset, cfg, bitset);
+    }
+    expected<DataSetPtr>
+    RangeSearch(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override {
+        return node_->RangeSearch(dataset, cfg, bitset);
+    }
+    expected<std::vector<IteratorPtr>>
+    AnnIterator(const DataSet& dataset, const Config& cfg, const BitsetView& bitset) const override {
+        return node_->AnnIterator(dataset, cfg, bitset);
+    }
+    expected<DataSetPtr>
+    GetVectorByIds(const DataSet& dataset) const override {
+        return node_->GetVectorByIds(dataset);
+    }
+    bool
+    HasRawData(const std::string& metric_type) const override {
+        return node_->HasRawData(metric_type);
+    }
+    expected<DataSetPtr>
+    GetIndexMeta(const Config& cfg) const override {
+        return node_->GetIndexMeta(cfg);
+    }
+    Status
+    Serialize(BinarySet& binset) const override {
+        RETURN_IF_ERROR(node_->Serialize(binset));
+        if (node_->Type() != Type()) {
+            // half rows are written with their codes under the IVF_FLAT name, no RAW_DATA is needed to load them
+            binset.Append(Type(), binset.GetByName(node_->Type()));
+            binset.Erase(node_->Type());
+        }
+        return Status::success;
+    }
+    Status
+    Deserialize(const BinarySet& binset, const Config& config) override {
+        auto binary = binset.GetByNames({"IVF",  // compatible with knowhere-1.x
+                                         Type()});
+        if (binary == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+        if (!IsIvfSqFourcc(binary->data.get(), binary->size)) {
+            return Load(std::make_unique<IvfIndexNode<faiss::IndexIVFFlat>>(nullptr),
+                        [&](IndexNode& node) { return node.Deserialize(binset, config); });
+        }
+        // half rows, read back from their codes
+        auto node = std::make_unique<IvfIndexNode<faiss::IndexIVFScalarQuantizer>>(nullptr);
+        BinarySet half_binset = binset;
+        half_binset.Append(node->Type(), binary);
+        return Load(std::move(node), [&](IndexNode& node) { return node.Deserialize(half_binset, config); });
+    }
+    Status
+    DeserializeFromFile(const std::string& filename, const Config& config) override {
+        uint8_t head[4] = {};
+        std::ifstream in(filename, std::ios::binary);
+        const bool half = in.read(reinterpret_cast<char*>(head), sizeof(head)) && IsIvfSqFourcc(head, sizeof(head));
+        in.close();
+        std::unique_ptr<IndexNode> node;
+        if (half) {
+            node = std::make_unique<IvfIndexNode<faiss::IndexIVFScalarQuantizer>>(nullptr);
+        } else {
+            node = std::make_unique<IvfIndexNode<faiss::IndexIVFFlat>>(nullptr);
+        }
+        return Load(std::move(node), [&](IndexNode& node) { return node.DeserializeFromFile(filename, config); });
+    }
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return std::make_unique<IvfFlatConfig>();
+    }
+    int64_t
+    Dim() const override {
+        return node_->Dim();
+    }
+    int64_t
+    Size() const override {
+        return node_->Size();
+    }
+    int64_t
+    Count() const override {
+        return node_->Count();
+    }
+    std::string
+    Type() const override {
+        return knowhere::IndexEnum::INDEX_FAISS_IVFFLAT;
+    }
+
+ private:
+    // an empty node for rows of `type`
+    void
+    ResetNode(DataType type) {
+        switch (type) {
+            case DataType::kFloat16:
+                node_ = std::make_unique<IvfIndexNode<faiss::IndexIVFScalarQuantizer>>(nullptr,
+                                                                                      faiss::QuantizerType::QT_fp16);
+                break;
+            case DataType::kBFloat16:
+                node_ = std::make_unique<IvfIndexNode<faiss::IndexIVFScalarQuantizer>>(nullptr,
+                                                                                      faiss::QuantizerType::QT_bf16);
+                break;
+            default:
+                node_ = std::make_unique<IvfIndexNode<faiss::IndexIVFFlat>>(nullptr);
+        }
+    }
+    // the loaded node replaces the current one only once it is read
+    template <typename LoadFunc>
+    Status
+    Load(std::unique_ptr<IndexNode> node, LoadFunc&& load) {
+        RETURN_IF_ERROR(load(*node));
+        node_ = std::move(node);
+        return Status::success;
+    }
+
+    std::unique_ptr<IndexNode> node_;
+};
+
 KNOWHERE_REGISTER_GLOBAL(IVFBIN, [](const Object& object) {
     return Index<IvfIndexNode<faiss::IndexBinaryIVF>>::Create(object);
 });
@@ -779,10 +1493,8 @@ KNOWHERE_REGISTER_GLOBAL(BIN_IVF_FLAT, [](const Object& object) {
     return Index<IvfIndexNode<faiss::IndexBinaryIVF>>::Create(object);
 });
 
-KNOWHERE_REGISTER_GLOBAL(IVFFLAT,
-                         [](const Object& object) { return Index<IvfIndexNode<faiss::IndexIVFFlat>>::Create(object); });
-KNOWHERE_REGISTER_GLOBAL(IVF_FLAT,
-                         [](const Object& object) { return Index<IvfIndexNode<faiss::IndexIVFFlat>>::Create(object); });
+KNOWHERE_REGISTER_GLOBAL(IVFFLAT, [](const Object& object) { return Index<IvfFlatIndexNode>::Create(object); });
+KNOWHERE_REGISTER_GLOBAL(IVF_FLAT, [](const Object& object) { return Index<IvfFlatIndexNode>::Create(object); });
 KNOWHERE_REGISTER_GLOBAL(IVFFLATCC, [](const Object& object) {
     return Index<IvfIndexNode<faiss::IndexIVFFlatCC>>::Create(object);
 });
@@ -19,6 +19,12 @@ class IvfConfig : public BaseConfig {
  public:
     CFG_INT nlist;
     CFG_INT nprobe;
+    // bound of the probed inverted lists kept mapped when the index is loaded with enable_mmap, 0 leaves it to the
+    // page cache
+    CFG_INT mmap_list_cache_mb;
+    // name of centroids registered with SharedCentroids, used instead of training the index's own, see
+    // knowhere/comp/shared_centroids.h
+    CFG_STRING shared_centroids;
     KNOHWERE_DECLARE_CONFIG(IvfConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(nlist)
             .set_default(128)
@@ -30,6 +36,17 @@ class IvfConfig : public BaseConfig {
             .description("number of probes at query time.")
             .for_search()
             .set_range(1, 65536);
+        KNOWHERE_CONFIG_DECLARE_FIELD(mmap_list_cache_mb)
+            .set_default(0)
+            .description("MB of probed inverted lists kept mapped with enable_mmap, 0 for no bound.")
+            .for_deserialize_from_file()
+            .set_range(0, std::numeric_limits<CFG_INT::value_type>::max());
+        KNOWHERE_CONFIG_DECLARE_FIELD(shared_centroids)
+            .set_default("")
+            .description("name of the registered shared centroids, empty to train the index's own.")
+            .for_train()
+            .for_deserialize()
+            .for_deserialize_from_file();
     }
 };
 
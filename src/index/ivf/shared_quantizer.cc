@@ -0,0 +1,163 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/shared_quantizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/metric.h"
+#include "faiss/Clustering.h"
+#include "knowhere/comp/shared_centroids.h"
+#include "knowhere/log.h"
+#include "knowhere/operands.h"
+#include "knowhere/utils.h"
+
+namespace knowhere {
+
+void
+SharedQuantizer::search(idx_t n, const float* x, idx_t k, float* distances, idx_t* labels,
+                        const BitsetView bitset) const {
+    // IVF searches run one query per task, batches and filtered searches are not cached
+    if (n != 1 || !bitset.empty()) {
+        faiss::IndexFlat::search(n, x, k, distances, labels, bitset);
+        return;
+    }
+    const auto key = hash_vec(x, d) ^ (static_cast<uint64_t>(k) * 0x9e3779b97f4a7c15UL);
+    std::shared_ptr<const Assignment> cached;
+    if (assignments_.try_get(key, cached) && cached->labels.size() == static_cast<size_t>(k) &&
+        std::memcmp(cached->query.data(), x, d * sizeof(float)) == 0) {
+        std::copy(cached->distances.begin(), cached->distances.end(), distances);
+        std::copy(cached->labels.begin(), cached->labels.end(), labels);
+        return;
+    }
+    faiss::IndexFlat::search(n, x, k, distances, labels, bitset);
+    auto assignment = std::make_shared<Assignment>();
+    assignment->query.assign(x, x + d);
+    assignment->distances.assign(distances, distances + k);
+    assignment->labels.assign(labels, labels + k);
+    assignments_.put(key, assignment);
+}
+
+uint64_t
+SharedQuantizer::ContentHash() const {
+    const auto metric = static_cast<uint64_t>(metric_type) * 0x9e3779b97f4a7c15UL;
+    return hash_bytes(xb.data(), xb.size() * sizeof(float)) ^ metric;
+}
+
+namespace {
+
+std::mutex shared_quantizers_mtx;
+std::unordered_map<std::string, std::shared_ptr<SharedQuantizer>> shared_quantizers;
+
+bool
+IsFloatMetric(const std::string& metric_type) {
+    return IsMetricType(metric_type, metric::L2) || IsMetricType(metric_type, metric::IP) ||
+           IsMetricType(metric_type, metric::COSINE);
+}
+
+}  // namespace
+
+std::shared_ptr<SharedQuantizer>
+GetSharedQuantizer(const std::string& name) {
+    std::lock_guard<std::mutex> lock(shared_quantizers_mtx);
+    auto it = shared_quantizers.find(name);
+    return it == shared_quantizers.end() ? nullptr : it->second;
+}
+
+Status
+SharedCentroids::Register(const std::string& name, const DataSet& centroids, const std::string& metric_type) {
+    if (name.empty() || centroids.GetRows() <= 0 || centroids.GetDim() <= 0) {
+        LOG_KNOWHERE_ERROR_ << "shared centroids need a name and at least one centroid";
+        return Status::invalid_args;
+    }
+    if (!IsFloatMetric(metric_type)) {
+        LOG_KNOWHERE_ERROR_ << "Invalid metric type for shared centroids: " << metric_type;
+        return Status::invalid_metric_type;
+    }
+    auto metric = Str2FaissMetricType(metric_type);
+    auto rows = centroids.GetRows();
+    auto dim = centroids.GetDim();
+    auto quantizer = std::make_shared<SharedQuantizer>(dim, metric.value());
+    if (centroids.GetTensorDataType() != DataType::kFloat32) {
+        quantizer->add(rows, (const float*)ConvertToFloatDataSet(centroids)->GetTensor());
+    } else {
+        quantizer->add(rows, (const float*)centroids.GetTensor());
+    }
+    std::lock_guard<std::mutex> lock(shared_quantizers_mtx);
+    // indexes serialized on the registered centroids would load on the new ones, the name must be freed first
+    if (!shared_quantizers.emplace(name, std::move(quantizer)).second) {
+        LOG_KNOWHERE_ERROR_ << "shared centroids " << name << " are already registered, unregister them first";
+        return Status::invalid_args;
+    }
+    return Status::success;
+}
+
+Status
+SharedCentroids::Train(const std::string& name, const DataSet& dataset, int64_t nlist,
+                       const std::string& metric_type) {
+    if (!IsFloatMetric(metric_type)) {
+        LOG_KNOWHERE_ERROR_ << "Invalid metric type for shared centroids: " << metric_type;
+        return Status::invalid_metric_type;
+    }
+    auto metric = Str2FaissMetricType(metric_type);
+    if (nlist <= 0 || dataset.GetRows() < nlist) {
+        LOG_KNOWHERE_ERROR_ << "can not train " << nlist << " shared centroids on " << dataset.GetRows() << " rows";
+        return Status::invalid_args;
+    }
+    auto rows = dataset.GetRows();
+    auto dim = dataset.GetDim();
+    // k-means on a copy, the dataset is left as is
+    std::vector<float> data(rows * dim);
+    ConvertToFloat(dataset.GetTensor(), dataset.GetTensorDataType(), data.data(), data.size());
+    auto is_cosine = IsMetricType(metric_type, metric::COSINE);
+    if (is_cosine) {
+        NormalizeVecs(data.data(), rows, dim);
+    }
+    faiss::ClusteringParameters params;
+    params.spherical = is_cosine;
+    faiss::Clustering clustering(dim, nlist, params);
+    faiss::IndexFlat assigner(dim, metric.value());
+    try {
+        clustering.train(rows, data.data(), assigner);
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+        return Status::faiss_inner_error;
+    }
+    auto centroids = GenDataSet(nlist, dim, clustering.centroids.data());
+    return Register(name, *centroids, metric_type);
+}
+
+Status
+SharedCentroids::Unregister(const std::string& name) {
+    std::lock_guard<std::mutex> lock(shared_quantizers_mtx);
+    if (shared_quantizers.erase(name) == 0) {
+        return Status::invalid_args;
+    }
+    return Status::success;
+}
+
+expected<DataSetPtr>
+SharedCentroids::Get(const std::string& name) {
+    auto quantizer = GetSharedQuantizer(name);
+    if (quantizer == nullptr) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "no shared centroids named " + name);
+    }
+    auto centroids = new float[quantizer->xb.size()];
+    std::copy(quantizer->xb.begin(), quantizer->xb.end(), centroids);
+    auto dataset = GenDataSet(quantizer->ntotal, quantizer->d, centroids);
+    dataset->SetIsOwner(true);
+    return dataset;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,59 @@
+// Copyright (C) 2019-2023 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SHARED_QUANTIZER_H
+#define SHARED_QUANTIZER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/lru_cache.h"
+#include "faiss/IndexFlat.h"
+
+namespace knowhere {
+
+// Flat coarse quantizer of registered shared centroids. The coarse assignments of single queries are cached, so
+// that the segments built on the same centroids compute them once per query instead of once per segment.
+class SharedQuantizer : public faiss::IndexFlat {
+ public:
+    SharedQuantizer(idx_t d, faiss::MetricType metric) : faiss::IndexFlat(d, metric) {
+    }
+
+    // hash of the centroids and the metric, serialized along with the name by the indexes built on them
+    uint64_t
+    ContentHash() const;
+
+    void
+    search(idx_t n, const float* x, idx_t k, float* distances, idx_t* labels,
+           const BitsetView bitset = nullptr) const override;
+
+ private:
+    struct Assignment {
+        std::vector<float> query;
+        std::vector<float> distances;
+        std::vector<idx_t> labels;
+    };
+    static constexpr size_t kAssignmentCacheSize = 4096;
+    mutable lru_cache<uint64_t, std::shared_ptr<const Assignment>> assignments_{kAssignmentCacheSize};
+};
+
+// quantizer of the centroids registered under `name`, null if there are none
+std::shared_ptr<SharedQuantizer>
+GetSharedQuantizer(const std::string& name);
+
+// binset entries of an index built on shared centroids
+constexpr const char* kSharedCentroidsName = "SHARED_CENTROIDS";
+constexpr const char* kSharedCentroidsHash = "SHARED_CENTROIDS_HASH";
+
+}  // namespace knowhere
+
+#endif /* SHARED_QUANTIZER_H */
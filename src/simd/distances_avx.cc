@@ -16,6 +16,10 @@
 #include <immintrin.h>
 
 #include <cassert>
+#include <cstring>
+
+#include "distances_ref.h"
+#include "hnswlib/tlsh_utils.h"
 
 namespace faiss {
 
@@ -113,6 +117,21 @@ fvec_L2sqr_avx(const float* x, const float* y, size_t d) {
     return _mm_cvtss_f32(msum2);
 }
 
+float
+fvec_L2sqr_early_abandon_avx(const float* x, const float* y, size_t d, float threshold) {
+    float res = 0;
+    while (d > kL2EarlyAbandonBlock) {
+        res += fvec_L2sqr_avx(x, y, kL2EarlyAbandonBlock);
+        if (res > threshold) {
+            return res;
+        }
+        x += kL2EarlyAbandonBlock;
+        y += kL2EarlyAbandonBlock;
+        d -= kL2EarlyAbandonBlock;
+    }
+    return res + fvec_L2sqr_avx(x, y, d);
+}
+
 float
 fvec_L1_avx(const float* x, const float* y, size_t d) {
     __m256 msum1 = _mm256_setzero_ps();
@@ -195,5 +214,461 @@ fvec_Linf_avx(const float* x, const float* y, size_t d) {
     return _mm_cvtss_f32(msum2);
 }
 
+namespace {
+
+// per 64-bit lane popcount through a nibble lookup table
+inline __m256i
+popcount_256(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                            2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+inline uint64_t
+reduce_add_epi64(__m256i v) {
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+}
+
+// carry-save adder: (h, l) = a + b + c
+inline void
+csa(__m256i& h, __m256i& l, __m256i a, __m256i b, __m256i c) {
+    const __m256i u = _mm256_xor_si256(a, b);
+    h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    l = _mm256_xor_si256(u, c);
+}
+
+struct XorOp {
+    __m256i
+    operator()(__m256i a, __m256i b) const {
+        return _mm256_xor_si256(a, b);
+    }
+    uint64_t
+    operator()(uint64_t a, uint64_t b) const {
+        return a ^ b;
+    }
+};
+
+struct AndOp {
+    __m256i
+    operator()(__m256i a, __m256i b) const {
+        return _mm256_and_si256(a, b);
+    }
+    uint64_t
+    operator()(uint64_t a, uint64_t b) const {
+        return a & b;
+    }
+};
+
+struct OrOp {
+    __m256i
+    operator()(__m256i a, __m256i b) const {
+        return _mm256_or_si256(a, b);
+    }
+    uint64_t
+    operator()(uint64_t a, uint64_t b) const {
+        return a | b;
+    }
+};
+
+// popcount(op(x, y)) over n bytes, Harley-Seal over groups of 8 registers (256 bytes)
+template <class Op>
+inline int
+popcount_op(const uint8_t* x, const uint8_t* y, size_t n, Op op) {
+    auto load = [&](size_t i) {
+        return op(_mm256_loadu_si256((const __m256i*)(x + i * 32)), _mm256_loadu_si256((const __m256i*)(y + i * 32)));
+    };
+    const size_t nv = n / 32;
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256();
+    __m256i twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256();
+    __m256i eights, twos_a, twos_b, fours_a, fours_b;
+    size_t i = 0;
+    for (; i + 8 <= nv; i += 8) {
+        csa(twos_a, ones, ones, load(i), load(i + 1));
+        csa(twos_b, ones, ones, load(i + 2), load(i + 3));
+        csa(fours_a, twos, twos, twos_a, twos_b);
+        csa(twos_a, ones, ones, load(i + 4), load(i + 5));
+        csa(twos_b, ones, ones, load(i + 6), load(i + 7));
+        csa(fours_b, twos, twos, twos_a, twos_b);
+        csa(eights, fours, fours, fours_a, fours_b);
+        total = _mm256_add_epi64(total, popcount_256(eights));
+    }
+    total = _mm256_slli_epi64(total, 3);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_256(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_256(twos), 1));
+    total = _mm256_add_epi64(total, popcount_256(ones));
+    for (; i < nv; i++) {
+        total = _mm256_add_epi64(total, popcount_256(load(i)));
+    }
+    auto accu = (int)reduce_add_epi64(total);
+    size_t j = nv * 32;
+    for (; j + 8 <= n; j += 8) {
+        uint64_t a, b;
+        memcpy(&a, x + j, sizeof(a));
+        memcpy(&b, y + j, sizeof(b));
+        accu += __builtin_popcountll(op(a, b));
+    }
+    for (; j < n; j++) {
+        accu += __builtin_popcount((uint32_t)op((uint64_t)x[j], (uint64_t)y[j]));
+    }
+    return accu;
+}
+
+}  // namespace
+
+void
+bvec_hamming_ny_avx(int32_t* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    for (size_t i = 0; i < ny; i++) {
+        dis[i] = popcount_op(x, y, code_size, XorOp());
+        y += code_size;
+    }
+}
+
+void
+bvec_jaccard_ny_avx(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    for (size_t i = 0; i < ny; i++) {
+        const int accu_num = popcount_op(x, y, code_size, AndOp());
+        const int accu_den = popcount_op(x, y, code_size, OrOp());
+        dis[i] = (accu_den == 0) ? 1.0f : (float)(accu_den - accu_num) / (float)accu_den;
+        y += code_size;
+    }
+}
+
+void
+bvec_tlsh_ny_avx(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    static_assert(CODE_SIZE == 32, "the TLSH body is expected to fit in one register");
+    // per 2-bit pair distance |a - b|, a difference of 3 counts as 6
+    const __m256i pair_diff = _mm256_setr_epi8(0, 1, 2, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 6, 0, 0, 0, 0, 0,
+                                               0, 0, 0, 0, 0, 0, 0);
+    const __m256i pair_mask = _mm256_set1_epi8(0x03);
+    auto lx = (const tlsh::lsh_bin_struct*)x;
+    const __m256i bx = _mm256_loadu_si256((const __m256i*)lx->tmp_code);
+    for (size_t i = 0; i < ny; i++) {
+        auto ly = (const tlsh::lsh_bin_struct*)y;
+        const __m256i by = _mm256_loadu_si256((const __m256i*)ly->tmp_code);
+        __m256i sum = _mm256_setzero_si256();
+        for (int shift = 0; shift < 8; shift += 2) {
+            const __m256i px = _mm256_and_si256(_mm256_srli_epi16(bx, shift), pair_mask);
+            const __m256i py = _mm256_and_si256(_mm256_srli_epi16(by, shift), pair_mask);
+            const __m256i d = _mm256_abs_epi8(_mm256_sub_epi8(px, py));
+            sum = _mm256_add_epi8(sum, _mm256_shuffle_epi8(pair_diff, d));
+        }
+        const auto body = reduce_add_epi64(_mm256_sad_epu8(sum, _mm256_setzero_si256()));
+        dis[i] = (float)(tlsh::diff_header(lx, ly) + (int)body);
+        y += code_size;
+    }
+}
+
+namespace {
+// widen 8 fp16 / bf16 values to fp32
+inline __m256
+load_fp16_avx(const uint16_t* x) {
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)x));
+}
+
+inline __m256
+load_bf16_avx(const uint16_t* x) {
+    const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)x));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(v, 16));
+}
+
+// zero padded copy of the last d < 8 elements
+inline void
+load_tail_u16(const uint16_t* x, size_t d, uint16_t* buf) {
+    memset(buf, 0, 8 * sizeof(uint16_t));
+    memcpy(buf, x, d * sizeof(uint16_t));
+}
+
+inline float
+reduce_add_avx(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    return _mm_cvtss_f32(s);
+}
+
+template <__m256 (*Load)(const uint16_t*)>
+inline float
+half_inner_product_avx(const uint16_t* x, const uint16_t* y, size_t d) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(Load(x + i), Load(y + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(Load(x + i + 8), Load(y + i + 8)));
+    }
+    for (; i + 8 <= d; i += 8) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(Load(x + i), Load(y + i)));
+    }
+    if (i < d) {
+        uint16_t bx[8], by[8];
+        load_tail_u16(x + i, d - i, bx);
+        load_tail_u16(y + i, d - i, by);
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(Load(bx), Load(by)));
+    }
+    return reduce_add_avx(_mm256_add_ps(acc0, acc1));
+}
+
+template <__m256 (*Load)(const uint16_t*)>
+inline float
+half_L2sqr_avx(const uint16_t* x, const uint16_t* y, size_t d) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        const __m256 d0 = _mm256_sub_ps(Load(x + i), Load(y + i));
+        const __m256 d1 = _mm256_sub_ps(Load(x + i + 8), Load(y + i + 8));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+    }
+    for (; i + 8 <= d; i += 8) {
+        const __m256 d0 = _mm256_sub_ps(Load(x + i), Load(y + i));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+    }
+    if (i < d) {
+        uint16_t bx[8], by[8];
+        load_tail_u16(x + i, d - i, bx);
+        load_tail_u16(y + i, d - i, by);
+        const __m256 d1 = _mm256_sub_ps(Load(bx), Load(by));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+    }
+    return reduce_add_avx(_mm256_add_ps(acc0, acc1));
+}
+
+// fp32 x against fp16 / bf16 y
+template <__m256 (*Load)(const uint16_t*)>
+inline float
+mixed_inner_product_avx(const float* x, const uint16_t* y, size_t d) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + i), Load(y + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(x + i + 8), Load(y + i + 8)));
+    }
+    for (; i + 8 <= d; i += 8) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + i), Load(y + i)));
+    }
+    if (i < d) {
+        float bx[8] = {};
+        uint16_t by[8];
+        memcpy(bx, x + i, (d - i) * sizeof(float));
+        load_tail_u16(y + i, d - i, by);
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(bx), Load(by)));
+    }
+    return reduce_add_avx(_mm256_add_ps(acc0, acc1));
+}
+
+template <__m256 (*Load)(const uint16_t*)>
+inline float
+mixed_L2sqr_avx(const float* x, const uint16_t* y, size_t d) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        const __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), Load(y + i));
+        const __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(x + i + 8), Load(y + i + 8));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+    }
+    for (; i + 8 <= d; i += 8) {
+        const __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), Load(y + i));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+    }
+    if (i < d) {
+        float bx[8] = {};
+        uint16_t by[8];
+        memcpy(bx, x + i, (d - i) * sizeof(float));
+        load_tail_u16(y + i, d - i, by);
+        const __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(bx), Load(by));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+    }
+    return reduce_add_avx(_mm256_add_ps(acc0, acc1));
+}
+}  // namespace
+
+float
+fp16_vec_inner_product_avx(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_inner_product_avx<load_fp16_avx>(x, y, d);
+}
+
+float
+fp16_vec_L2sqr_avx(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_L2sqr_avx<load_fp16_avx>(x, y, d);
+}
+
+float
+fp16_vec_norm_L2sqr_avx(const uint16_t* x, size_t d) {
+    return half_inner_product_avx<load_fp16_avx>(x, x, d);
+}
+
+float
+bf16_vec_inner_product_avx(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_inner_product_avx<load_bf16_avx>(x, y, d);
+}
+
+float
+bf16_vec_L2sqr_avx(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_L2sqr_avx<load_bf16_avx>(x, y, d);
+}
+
+float
+bf16_vec_norm_L2sqr_avx(const uint16_t* x, size_t d) {
+    return half_inner_product_avx<load_bf16_avx>(x, x, d);
+}
+
+float
+fvec_fp16_inner_product_avx(const float* x, const uint16_t* y, size_t d) {
+    return mixed_inner_product_avx<load_fp16_avx>(x, y, d);
+}
+
+float
+fvec_fp16_L2sqr_avx(const float* x, const uint16_t* y, size_t d) {
+    return mixed_L2sqr_avx<load_fp16_avx>(x, y, d);
+}
+
+float
+fvec_bf16_inner_product_avx(const float* x, const uint16_t* y, size_t d) {
+    return mixed_inner_product_avx<load_bf16_avx>(x, y, d);
+}
+
+float
+fvec_bf16_L2sqr_avx(const float* x, const uint16_t* y, size_t d) {
+    return mixed_L2sqr_avx<load_bf16_avx>(x, y, d);
+}
+
+uint64_t
+bvec_hash_avx(const uint8_t* x, size_t n) {
+    ALIGNED(32) uint64_t acc[kHashLanes] = {kHashSecret[1], kHashSecret[2], kHashSecret[3], kHashSecret[0]};
+    __m256i acc4 = _mm256_load_si256((const __m256i*)acc);
+    const __m256i secret = _mm256_loadu_si256((const __m256i*)kHashSecret);
+    const size_t blocks = n / kHashBlock;
+    for (size_t i = 0; i < blocks; i++) {
+        const __m256i w = _mm256_loadu_si256((const __m256i*)(x + i * kHashBlock));
+        const __m256i key = _mm256_xor_si256(w, secret);
+        // low 32 bits times high 32 bits of every lane
+        const __m256i product = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+        acc4 = _mm256_xor_si256(acc4, _mm256_srli_epi64(acc4, 29));
+        acc4 = _mm256_add_epi64(acc4, _mm256_add_epi64(w, product));
+    }
+    _mm256_store_si256((__m256i*)acc, acc4);
+    return bvec_hash_finalize_ref(acc, x + blocks * kHashBlock, n);
+}
+
+void
+fvec_scale_avx(float* x, size_t d, float s) {
+    const __m256 scale = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= d; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), scale));
+    }
+    for (; i < d; i++) {
+        x[i] *= s;
+    }
+}
+
+void
+fvec_inner_products_scaled_ny_avx(float* dis, const float* x, const float* y, const float* scale, size_t d,
+                                  size_t ny) {
+    size_t j = 0;
+    // the loads of x are shared by four y vectors
+    for (; j + 4 <= ny; j += 4) {
+        const float* y0 = y + j * d;
+        const float* y1 = y0 + d;
+        const float* y2 = y1 + d;
+        const float* y3 = y2 + d;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= d; i += 8) {
+            const __m256 mx = _mm256_loadu_ps(x + i);
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(mx, _mm256_loadu_ps(y0 + i)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(mx, _mm256_loadu_ps(y1 + i)));
+            acc2 = _mm256_add_ps(acc2, _mm256_mul_ps(mx, _mm256_loadu_ps(y2 + i)));
+            acc3 = _mm256_add_ps(acc3, _mm256_mul_ps(mx, _mm256_loadu_ps(y3 + i)));
+        }
+        // {acc0, acc1, acc2, acc3} summed horizontally into the four floats of one register
+        const __m256 s = _mm256_hadd_ps(_mm256_hadd_ps(acc0, acc1), _mm256_hadd_ps(acc2, acc3));
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+        if (i < d) {
+            float tail[4] = {0, 0, 0, 0};
+            for (; i < d; i++) {
+                tail[0] += x[i] * y0[i];
+                tail[1] += x[i] * y1[i];
+                tail[2] += x[i] * y2[i];
+                tail[3] += x[i] * y3[i];
+            }
+            sum = _mm_add_ps(sum, _mm_loadu_ps(tail));
+        }
+        _mm_storeu_ps(dis + j, _mm_mul_ps(sum, _mm_loadu_ps(scale + j)));
+    }
+    for (; j < ny; j++) {
+        dis[j] = fvec_inner_product_avx(x, y + j * d, d) * scale[j];
+    }
+}
+
+namespace {
+
+inline int32_t
+reduce_add_epi32_avx(__m256i v) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+}  // namespace
+
+int32_t
+int8_vec_inner_product_avx(const int8_t* x, const int8_t* y, size_t d) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        const __m256i mx = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + i)));
+        const __m256i my = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(mx, my));
+    }
+    int32_t res = reduce_add_epi32_avx(acc);
+    for (; i < d; i++) {
+        res += (int32_t)x[i] * (int32_t)y[i];
+    }
+    return res;
+}
+
+int32_t
+int8_vec_L2sqr_avx(const int8_t* x, const int8_t* y, size_t d) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        const __m256i mx = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + i)));
+        const __m256i my = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y + i)));
+        const __m256i diff = _mm256_sub_epi16(mx, my);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(diff, diff));
+    }
+    int32_t res = reduce_add_epi32_avx(acc);
+    for (; i < d; i++) {
+        const int32_t tmp = (int32_t)x[i] - (int32_t)y[i];
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+void
+int8_vec_inner_products_nx_ny_avx(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny) {
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < ny; j++) {
+            ip[i * ny + j] = int8_vec_inner_product_avx(x + i * d, y + j * d, d);
+        }
+    }
+}
+
 }  // namespace faiss
 #endif
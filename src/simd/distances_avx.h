@@ -21,6 +21,10 @@ namespace faiss {
 float
 fvec_L2sqr_avx(const float* x, const float* y, size_t d);
 
+/// Squared L2 distance between two vectors if it is not above threshold, otherwise a partial sum above threshold
+float
+fvec_L2sqr_early_abandon_avx(const float* x, const float* y, size_t d, float threshold);
+
 /// inner product
 float
 fvec_inner_product_avx(const float* x, const float* y, size_t d);
@@ -33,6 +37,74 @@ fvec_L1_avx(const float* x, const float* y, size_t d);
 float
 fvec_Linf_avx(const float* x, const float* y, size_t d);
 
+/// Hamming distances between x and ny contiguous codes, Harley-Seal popcount
+void
+bvec_hamming_ny_avx(int32_t* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// Jaccard distances between x and ny contiguous codes, Harley-Seal popcount
+void
+bvec_jaccard_ny_avx(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// TLSH distances between x and ny contiguous digests
+void
+bvec_tlsh_ny_avx(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// inner product, squared L2 distance and squared norm of fp16 vectors, F16C conversion to fp32
+float
+fp16_vec_inner_product_avx(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+fp16_vec_L2sqr_avx(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+fp16_vec_norm_L2sqr_avx(const uint16_t* x, size_t d);
+
+/// inner product, squared L2 distance and squared norm of bf16 vectors, widened to fp32
+float
+bf16_vec_inner_product_avx(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+bf16_vec_L2sqr_avx(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+bf16_vec_norm_L2sqr_avx(const uint16_t* x, size_t d);
+
+/// inner product and squared L2 distance of an fp32 vector x and an fp16 / bf16 vector y
+float
+fvec_fp16_inner_product_avx(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_fp16_L2sqr_avx(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_bf16_inner_product_avx(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_bf16_L2sqr_avx(const float* x, const uint16_t* y, size_t d);
+
+/// 64-bit hash of n bytes, the lanes of bvec_hash_ref in one 256-bit register
+uint64_t
+bvec_hash_avx(const uint8_t* x, size_t n);
+
+/// x[i] *= s for the d floats of x, in place
+void
+fvec_scale_avx(float* x, size_t d, float s);
+
+/// inner products between x and ny contiguous y vectors times scale[j], four y vectors per pass
+void
+fvec_inner_products_scaled_ny_avx(float* dis, const float* x, const float* y, const float* scale, size_t d, size_t ny);
+
+/// inner product and squared L2 distance of int8 vectors, widened to int16 and summed in pairs by vpmaddwd
+int32_t
+int8_vec_inner_product_avx(const int8_t* x, const int8_t* y, size_t d);
+
+int32_t
+int8_vec_L2sqr_avx(const int8_t* x, const int8_t* y, size_t d);
+
+/// ip[i * ny + j] = <x_i, y_j> for nx int8 vectors x and ny int8 vectors y
+void
+int8_vec_inner_products_nx_ny_avx(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny);
+
 }  // namespace faiss
 
 #endif /* DISTANCES_AVX_H */
@@ -14,9 +14,14 @@
 
 #include <immintrin.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <vector>
+
+#include "distances_ref.h"
 
 namespace faiss {
 
@@ -139,6 +144,21 @@ fvec_L2sqr_avx512(const float* x, const float* y, size_t d) {
     return _mm_cvtss_f32(msum2);
 }
 
+float
+fvec_L2sqr_early_abandon_avx512(const float* x, const float* y, size_t d, float threshold) {
+    float res = 0;
+    while (d > kL2EarlyAbandonBlock) {
+        res += fvec_L2sqr_avx512(x, y, kL2EarlyAbandonBlock);
+        if (res > threshold) {
+            return res;
+        }
+        x += kL2EarlyAbandonBlock;
+        y += kL2EarlyAbandonBlock;
+        d -= kL2EarlyAbandonBlock;
+    }
+    return res + fvec_L2sqr_avx512(x, y, d);
+}
+
 float
 fvec_L1_avx512(const float* x, const float* y, size_t d) {
     __m512 msum0 = _mm512_setzero_ps();
@@ -249,6 +269,459 @@ fvec_Linf_avx512(const float* x, const float* y, size_t d) {
     return _mm_cvtss_f32(msum2);
 }
 
-}  // namespace faiss
+// VPOPCNTDQ is not implied by the flags of this file, only the binary kernels below use it and they are only hooked
+// when the cpu reports it
+#define VPOPCNTDQ_TARGET __attribute__((target("avx512f,avx512bw,avx512vpopcntdq")))
+
+void VPOPCNTDQ_TARGET
+bvec_hamming_ny_avx512(int32_t* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    const __mmask64 tail_mask = _cvtu64_mask64(code_size % 64 ? (~0ULL >> (64 - code_size % 64)) : 0);
+    const size_t nv = code_size / 64;
+    for (size_t i = 0; i < ny; i++) {
+        __m512i sum = _mm512_setzero_si512();
+        for (size_t j = 0; j < nv; j++) {
+            const __m512i a = _mm512_loadu_si512(x + j * 64);
+            const __m512i b = _mm512_loadu_si512(y + j * 64);
+            sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(a, b)));
+        }
+        if (tail_mask) {
+            const __m512i a = _mm512_maskz_loadu_epi8(tail_mask, x + nv * 64);
+            const __m512i b = _mm512_maskz_loadu_epi8(tail_mask, y + nv * 64);
+            sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(_mm512_xor_si512(a, b)));
+        }
+        dis[i] = (int32_t)_mm512_reduce_add_epi64(sum);
+        y += code_size;
+    }
+}
+
+void VPOPCNTDQ_TARGET
+bvec_jaccard_ny_avx512(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    const __mmask64 tail_mask = _cvtu64_mask64(code_size % 64 ? (~0ULL >> (64 - code_size % 64)) : 0);
+    const size_t nv = code_size / 64;
+    for (size_t i = 0; i < ny; i++) {
+        __m512i num = _mm512_setzero_si512();
+        __m512i den = _mm512_setzero_si512();
+        for (size_t j = 0; j < nv; j++) {
+            const __m512i a = _mm512_loadu_si512(x + j * 64);
+            const __m512i b = _mm512_loadu_si512(y + j * 64);
+            num = _mm512_add_epi64(num, _mm512_popcnt_epi64(_mm512_and_si512(a, b)));
+            den = _mm512_add_epi64(den, _mm512_popcnt_epi64(_mm512_or_si512(a, b)));
+        }
+        if (tail_mask) {
+            const __m512i a = _mm512_maskz_loadu_epi8(tail_mask, x + nv * 64);
+            const __m512i b = _mm512_maskz_loadu_epi8(tail_mask, y + nv * 64);
+            num = _mm512_add_epi64(num, _mm512_popcnt_epi64(_mm512_and_si512(a, b)));
+            den = _mm512_add_epi64(den, _mm512_popcnt_epi64(_mm512_or_si512(a, b)));
+        }
+        const auto accu_num = _mm512_reduce_add_epi64(num);
+        const auto accu_den = _mm512_reduce_add_epi64(den);
+        dis[i] = (accu_den == 0) ? 1.0f : (float)(accu_den - accu_num) / (float)accu_den;
+        y += code_size;
+    }
+}
+
+#undef VPOPCNTDQ_TARGET
+
+namespace {
+// widen 16 fp16 / bf16 values to fp32, masked loads cover the tail
+inline __m512
+load_fp16_avx512(const uint16_t* x, __mmask16 mask) {
+    return _mm512_cvtph_ps(_mm512_castsi512_si256(_mm512_maskz_loadu_epi16(mask, x)));
+}
+
+inline __m512
+load_bf16_avx512(const uint16_t* x, __mmask16 mask) {
+    const __m512i v = _mm512_cvtepu16_epi32(_mm512_castsi512_si256(_mm512_maskz_loadu_epi16(mask, x)));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(v, 16));
+}
+
+template <__m512 (*Load)(const uint16_t*, __mmask16)>
+inline float
+half_inner_product_avx512(const uint16_t* x, const uint16_t* y, size_t d) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        acc0 = _mm512_fmadd_ps(Load(x + i, 0xffff), Load(y + i, 0xffff), acc0);
+        acc1 = _mm512_fmadd_ps(Load(x + i + 16, 0xffff), Load(y + i + 16, 0xffff), acc1);
+    }
+    for (; i < d; i += 16) {
+        const __mmask16 mask = d - i >= 16 ? 0xffff : (__mmask16)((1U << (d - i)) - 1);
+        acc0 = _mm512_fmadd_ps(Load(x + i, mask), Load(y + i, mask), acc0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+template <__m512 (*Load)(const uint16_t*, __mmask16)>
+inline float
+half_L2sqr_avx512(const uint16_t* x, const uint16_t* y, size_t d) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const __m512 d0 = _mm512_sub_ps(Load(x + i, 0xffff), Load(y + i, 0xffff));
+        const __m512 d1 = _mm512_sub_ps(Load(x + i + 16, 0xffff), Load(y + i + 16, 0xffff));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+    }
+    for (; i < d; i += 16) {
+        const __mmask16 mask = d - i >= 16 ? 0xffff : (__mmask16)((1U << (d - i)) - 1);
+        const __m512 d0 = _mm512_sub_ps(Load(x + i, mask), Load(y + i, mask));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+// fp32 x against fp16 / bf16 y
+template <__m512 (*Load)(const uint16_t*, __mmask16)>
+inline float
+mixed_inner_product_avx512(const float* x, const uint16_t* y, size_t d) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), Load(y + i, 0xffff), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), Load(y + i + 16, 0xffff), acc1);
+    }
+    for (; i < d; i += 16) {
+        const __mmask16 mask = d - i >= 16 ? 0xffff : (__mmask16)((1U << (d - i)) - 1);
+        acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), Load(y + i, mask), acc0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+template <__m512 (*Load)(const uint16_t*, __mmask16)>
+inline float
+mixed_L2sqr_avx512(const float* x, const uint16_t* y, size_t d) {
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(x + i), Load(y + i, 0xffff));
+        const __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(x + i + 16), Load(y + i + 16, 0xffff));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+    }
+    for (; i < d; i += 16) {
+        const __mmask16 mask = d - i >= 16 ? 0xffff : (__mmask16)((1U << (d - i)) - 1);
+        const __m512 d0 = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, x + i), Load(y + i, mask));
+        acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+}  // namespace
+
+float
+fp16_vec_inner_product_avx512(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_inner_product_avx512<load_fp16_avx512>(x, y, d);
+}
+
+float
+fp16_vec_L2sqr_avx512(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_L2sqr_avx512<load_fp16_avx512>(x, y, d);
+}
+
+float
+fp16_vec_norm_L2sqr_avx512(const uint16_t* x, size_t d) {
+    return half_inner_product_avx512<load_fp16_avx512>(x, x, d);
+}
+
+float
+bf16_vec_inner_product_avx512(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_inner_product_avx512<load_bf16_avx512>(x, y, d);
+}
+
+float
+bf16_vec_L2sqr_avx512(const uint16_t* x, const uint16_t* y, size_t d) {
+    return half_L2sqr_avx512<load_bf16_avx512>(x, y, d);
+}
+
+float
+bf16_vec_norm_L2sqr_avx512(const uint16_t* x, size_t d) {
+    return half_inner_product_avx512<load_bf16_avx512>(x, x, d);
+}
+
+float
+fvec_fp16_inner_product_avx512(const float* x, const uint16_t* y, size_t d) {
+    return mixed_inner_product_avx512<load_fp16_avx512>(x, y, d);
+}
+
+float
+fvec_fp16_L2sqr_avx512(const float* x, const uint16_t* y, size_t d) {
+    return mixed_L2sqr_avx512<load_fp16_avx512>(x, y, d);
+}
+
+float
+fvec_bf16_inner_product_avx512(const float* x, const uint16_t* y, size_t d) {
+    return mixed_inner_product_avx512<load_bf16_avx512>(x, y, d);
+}
+
+float
+fvec_bf16_L2sqr_avx512(const float* x, const uint16_t* y, size_t d) {
+    return mixed_L2sqr_avx512<load_bf16_avx512>(x, y, d);
+}
+
+void
+fvec_scale_avx512(float* x, size_t d, float s) {
+    const __m512 scale = _mm512_set1_ps(s);
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        _mm512_storeu_ps(x + i, _mm512_mul_ps(_mm512_loadu_ps(x + i), scale));
+    }
+    if (i < d) {
+        const __mmask16 mask = (1U << (d - i)) - 1;
+        _mm512_mask_storeu_ps(x + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, x + i), scale));
+    }
+}
+
+void
+fvec_inner_products_scaled_ny_avx512(float* dis, const float* x, const float* y, const float* scale, size_t d,
+                                     size_t ny) {
+    const size_t tail = d % 16;
+    const __mmask16 mask = (1U << tail) - 1;
+    size_t j = 0;
+    // the loads of x are shared by four y vectors
+    for (; j + 4 <= ny; j += 4) {
+        const float* y0 = y + j * d;
+        const float* y1 = y0 + d;
+        const float* y2 = y1 + d;
+        const float* y3 = y2 + d;
+        __m512 acc0 = _mm512_setzero_ps();
+        __m512 acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps();
+        __m512 acc3 = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= d; i += 16) {
+            const __m512 mx = _mm512_loadu_ps(x + i);
+            acc0 = _mm512_add_ps(acc0, _mm512_mul_ps(mx, _mm512_loadu_ps(y0 + i)));
+            acc1 = _mm512_add_ps(acc1, _mm512_mul_ps(mx, _mm512_loadu_ps(y1 + i)));
+            acc2 = _mm512_add_ps(acc2, _mm512_mul_ps(mx, _mm512_loadu_ps(y2 + i)));
+            acc3 = _mm512_add_ps(acc3, _mm512_mul_ps(mx, _mm512_loadu_ps(y3 + i)));
+        }
+        if (tail) {
+            const __m512 mx = _mm512_maskz_loadu_ps(mask, x + i);
+            acc0 = _mm512_add_ps(acc0, _mm512_mul_ps(mx, _mm512_maskz_loadu_ps(mask, y0 + i)));
+            acc1 = _mm512_add_ps(acc1, _mm512_mul_ps(mx, _mm512_maskz_loadu_ps(mask, y1 + i)));
+            acc2 = _mm512_add_ps(acc2, _mm512_mul_ps(mx, _mm512_maskz_loadu_ps(mask, y2 + i)));
+            acc3 = _mm512_add_ps(acc3, _mm512_mul_ps(mx, _mm512_maskz_loadu_ps(mask, y3 + i)));
+        }
+        const __m128 sum = _mm_setr_ps(_mm512_reduce_add_ps(acc0), _mm512_reduce_add_ps(acc1),
+                                       _mm512_reduce_add_ps(acc2), _mm512_reduce_add_ps(acc3));
+        _mm_storeu_ps(dis + j, _mm_mul_ps(sum, _mm_loadu_ps(scale + j)));
+    }
+    for (; j < ny; j++) {
+        dis[j] = fvec_inner_product_avx512(x, y + j * d, d) * scale[j];
+    }
+}
+
+namespace {
+
+// mask of the first n < 64 bytes of a tail
+inline __mmask64
+tail_mask_epi8(size_t n) {
+    return _cvtu64_mask64(n ? (~0ULL >> (64 - n)) : 0);
+}
+
+}  // namespace
+
+int32_t
+int8_vec_inner_product_avx512(const int8_t* x, const int8_t* y, size_t d) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(x + i)));
+        const __m512i my = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(y + i)));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(mx, my));
+    }
+    if (i < d) {
+        const __mmask64 mask = tail_mask_epi8(d - i);
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, x + i)));
+        const __m512i my = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, y + i)));
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(mx, my));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
 
+int32_t
+int8_vec_L2sqr_avx512(const int8_t* x, const int8_t* y, size_t d) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(x + i)));
+        const __m512i my = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(y + i)));
+        const __m512i diff = _mm512_sub_epi16(mx, my);
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(diff, diff));
+    }
+    if (i < d) {
+        const __mmask64 mask = tail_mask_epi8(d - i);
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, x + i)));
+        const __m512i my = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, y + i)));
+        const __m512i diff = _mm512_sub_epi16(mx, my);
+        acc = _mm512_add_epi32(acc, _mm512_madd_epi16(diff, diff));
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+void
+int8_vec_inner_products_nx_ny_avx512(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny) {
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < ny; j++) {
+            ip[i * ny + j] = int8_vec_inner_product_avx512(x + i * d, y + j * d, d);
+        }
+    }
+}
+
+// like VPOPCNTDQ, AVX512_VNNI is only hooked when the cpu reports it
+#define VNNI_TARGET __attribute__((target("avx512f,avx512bw,avx512vnni")))
+
+int32_t VNNI_TARGET
+int8_vec_inner_product_avx512_vnni(const int8_t* x, const int8_t* y, size_t d) {
+    // vpdpbusd multiplies unsigned by signed bytes: x + 128 is fed as the unsigned operand and 128 * sum(y) is taken
+    // off at the end
+    const __m512i offset = _mm512_set1_epi8((char)0x80);
+    const __m512i ones = _mm512_set1_epi8(1);
+    __m512i acc = _mm512_setzero_si512();
+    __m512i sum_y = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= d; i += 64) {
+        const __m512i mx = _mm512_xor_si512(_mm512_loadu_si512(x + i), offset);
+        const __m512i my = _mm512_loadu_si512(y + i);
+        acc = _mm512_dpbusd_epi32(acc, mx, my);
+        sum_y = _mm512_dpbusd_epi32(sum_y, ones, my);
+    }
+    if (i < d) {
+        const __mmask64 mask = tail_mask_epi8(d - i);
+        const __m512i mx = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, x + i), offset);
+        const __m512i my = _mm512_maskz_loadu_epi8(mask, y + i);
+        acc = _mm512_dpbusd_epi32(acc, mx, my);
+        sum_y = _mm512_dpbusd_epi32(sum_y, ones, my);
+    }
+    return _mm512_reduce_add_epi32(_mm512_sub_epi32(acc, _mm512_slli_epi32(sum_y, 7)));
+}
+
+int32_t VNNI_TARGET
+int8_vec_L2sqr_avx512_vnni(const int8_t* x, const int8_t* y, size_t d) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(x + i)));
+        const __m512i my = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(y + i)));
+        const __m512i diff = _mm512_sub_epi16(mx, my);
+        acc = _mm512_dpwssd_epi32(acc, diff, diff);
+    }
+    if (i < d) {
+        const __mmask64 mask = tail_mask_epi8(d - i);
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, x + i)));
+        const __m512i my = _mm512_cvtepi8_epi16(_mm512_castsi512_si256(_mm512_maskz_loadu_epi8(mask, y + i)));
+        const __m512i diff = _mm512_sub_epi16(mx, my);
+        acc = _mm512_dpwssd_epi32(acc, diff, diff);
+    }
+    return _mm512_reduce_add_epi32(acc);
+}
+
+void VNNI_TARGET
+int8_vec_inner_products_nx_ny_avx512_vnni(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx,
+                                          size_t ny) {
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < ny; j++) {
+            ip[i * ny + j] = int8_vec_inner_product_avx512_vnni(x + i * d, y + j * d, d);
+        }
+    }
+}
+
+#if defined(KNOWHERE_WITH_AMX_INT8)
+// AMX_INT8 is only hooked when the cpu reports it and the kernel granted the tile data state to the process
+#define AMX_TARGET __attribute__((target("avx512f,avx512bw,amx-tile,amx-int8")))
+
+namespace {
+
+// palette 1 layout of the ldtilecfg operand
+struct alignas(64) AmxTileConfig {
+    uint8_t palette_id = 1;
+    uint8_t start_row = 0;
+    uint8_t reserved[14] = {};
+    uint16_t colsb[16] = {};
+    uint8_t rows[16] = {};
+};
+
+constexpr size_t kAmxTileRows = 16;
+constexpr size_t kAmxTileBytes = 64;
+constexpr size_t kAmxTileSize = kAmxTileRows * kAmxTileBytes;
+
+// The tiles are configured once per thread and kept, nothing else in the process loads another tile config, and
+// the VNNI layout buffer of the x vectors only grows. Neither is redone for every block of a search.
+struct AmxThreadState {
+    bool configured = false;
+    std::vector<int8_t> xb;
+};
+
+thread_local AmxThreadState amx_state;
+
+}  // namespace
+
+void AMX_TARGET
+int8_vec_inner_products_nx_ny_amx(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny) {
+    // tmm0 += tmm1 * tmm2 with tmm0 the 16 x 16 int32 inner products, tmm1 16 y vectors by rows of 64 bytes and tmm2
+    // 16 x vectors in the VNNI layout: row r of a 64-dim chunk holds dims 4r .. 4r + 3 of each of the 16 x vectors
+    auto& state = amx_state;
+    if (!state.configured) {
+        AmxTileConfig cfg;
+        for (int t = 0; t < 3; t++) {
+            cfg.rows[t] = kAmxTileRows;
+            cfg.colsb[t] = kAmxTileBytes;
+        }
+        _tile_loadconfig(&cfg);
+        state.configured = true;
+    }
+
+    const size_t chunks = (d + kAmxTileBytes - 1) / kAmxTileBytes;
+    const size_t xb_size = chunks * kAmxTileSize;
+    if (state.xb.size() < xb_size) {
+        state.xb.resize(xb_size);
+    }
+    int8_t* xb = state.xb.data();
+    alignas(64) int8_t yb[kAmxTileSize];
+    alignas(64) int32_t res[kAmxTileRows * kAmxTileRows];
+    for (size_t i0 = 0; i0 < nx; i0 += kAmxTileRows) {
+        const size_t mx = std::min(kAmxTileRows, nx - i0);
+        // zero padding covers both the last partial chunk of dims and a partial block of x vectors
+        std::fill(xb, xb + xb_size, 0);
+        for (size_t n = 0; n < mx; n++) {
+            const int8_t* xn = x + (i0 + n) * d;
+            for (size_t k = 0; k < d; k++) {
+                xb[(k / kAmxTileBytes) * kAmxTileSize + (k % kAmxTileBytes) / 4 * kAmxTileBytes + n * 4 + k % 4] =
+                    xn[k];
+            }
+        }
+        for (size_t j0 = 0; j0 < ny; j0 += kAmxTileRows) {
+            const size_t my = std::min(kAmxTileRows, ny - j0);
+            const int8_t* yj = y + j0 * d;
+            _tile_zero(0);
+            for (size_t c = 0; c < chunks; c++) {
+                const size_t k0 = c * kAmxTileBytes;
+                if (my == kAmxTileRows && k0 + kAmxTileBytes <= d) {
+                    _tile_loadd(1, yj + k0, d);
+                } else {
+                    std::memset(yb, 0, sizeof(yb));
+                    const size_t len = std::min(kAmxTileBytes, d - k0);
+                    for (size_t m = 0; m < my; m++) {
+                        std::memcpy(yb + m * kAmxTileBytes, yj + m * d + k0, len);
+                    }
+                    _tile_loadd(1, yb, kAmxTileBytes);
+                }
+                _tile_loadd(2, xb + c * kAmxTileSize, kAmxTileBytes);
+                _tile_dpbssd(0, 1, 2);
+            }
+            _tile_stored(0, res, kAmxTileRows * sizeof(int32_t));
+            for (size_t n = 0; n < mx; n++) {
+                for (size_t m = 0; m < my; m++) {
+                    ip[(i0 + n) * ny + j0 + m] = res[m * kAmxTileRows + n];
+                }
+            }
+        }
+    }
+}
+#endif
+
+}  // namespace faiss
 #endif
@@ -15,11 +15,20 @@
 #include <cstddef>
 #include <cstdint>
 
+// the AMX tile intrinsics came with GCC 11 and clang 12, older compilers build without the AMX kernel
+#if (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11) || (defined(__clang__) && __clang_major__ >= 12)
+#define KNOWHERE_WITH_AMX_INT8
+#endif
+
 namespace faiss {
 
 float
 fvec_L2sqr_avx512(const float* x, const float* y, size_t d);
 
+/// Squared L2 distance between two vectors if it is not above threshold, otherwise a partial sum above threshold
+float
+fvec_L2sqr_early_abandon_avx512(const float* x, const float* y, size_t d, float threshold);
+
 /// inner product
 float
 fvec_inner_product_avx512(const float* x, const float* y, size_t d);
@@ -32,6 +41,85 @@ fvec_L1_avx512(const float* x, const float* y, size_t d);
 float
 fvec_Linf_avx512(const float* x, const float* y, size_t d);
 
+/// Hamming distances between x and ny contiguous codes, requires AVX512_VPOPCNTDQ
+void
+bvec_hamming_ny_avx512(int32_t* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// Jaccard distances between x and ny contiguous codes, requires AVX512_VPOPCNTDQ
+void
+bvec_jaccard_ny_avx512(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// inner product, squared L2 distance and squared norm of fp16 vectors, F16C conversion to fp32
+float
+fp16_vec_inner_product_avx512(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+fp16_vec_L2sqr_avx512(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+fp16_vec_norm_L2sqr_avx512(const uint16_t* x, size_t d);
+
+/// inner product, squared L2 distance and squared norm of bf16 vectors, widened to fp32
+float
+bf16_vec_inner_product_avx512(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+bf16_vec_L2sqr_avx512(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+bf16_vec_norm_L2sqr_avx512(const uint16_t* x, size_t d);
+
+/// inner product and squared L2 distance of an fp32 vector x and an fp16 / bf16 vector y
+float
+fvec_fp16_inner_product_avx512(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_fp16_L2sqr_avx512(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_bf16_inner_product_avx512(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_bf16_L2sqr_avx512(const float* x, const uint16_t* y, size_t d);
+
+/// x[i] *= s for the d floats of x, in place
+void
+fvec_scale_avx512(float* x, size_t d, float s);
+
+/// inner products between x and ny contiguous y vectors times scale[j], four y vectors per pass
+void
+fvec_inner_products_scaled_ny_avx512(float* dis, const float* x, const float* y, const float* scale, size_t d,
+                                     size_t ny);
+
+/// inner product and squared L2 distance of int8 vectors, widened to int16 and summed in pairs by vpmaddwd
+int32_t
+int8_vec_inner_product_avx512(const int8_t* x, const int8_t* y, size_t d);
+
+int32_t
+int8_vec_L2sqr_avx512(const int8_t* x, const int8_t* y, size_t d);
+
+/// ip[i * ny + j] = <x_i, y_j> for nx int8 vectors x and ny int8 vectors y
+void
+int8_vec_inner_products_nx_ny_avx512(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny);
+
+/// int8 kernels on 64 bytes per vpdpbusd / 32 int16 per vpdpwssd, requires AVX512_VNNI
+int32_t
+int8_vec_inner_product_avx512_vnni(const int8_t* x, const int8_t* y, size_t d);
+
+int32_t
+int8_vec_L2sqr_avx512_vnni(const int8_t* x, const int8_t* y, size_t d);
+
+void
+int8_vec_inner_products_nx_ny_avx512_vnni(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx,
+                                          size_t ny);
+
+#if defined(KNOWHERE_WITH_AMX_INT8)
+/// ip[i * ny + j] = <x_i, y_j> on the AMX tiles, blocks of 16 y vectors against blocks of 16 x vectors, requires
+/// AMX_INT8 and the tile data permission of the process
+void
+int8_vec_inner_products_nx_ny_amx(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny);
+#endif
+
 }  // namespace faiss
 
 #endif /* DISTANCES_AVX512_H */
@@ -9,7 +9,12 @@
 
 #include "distances_ref.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+
+#include "hnswlib/tlsh_utils.h"
+#include "knowhere/operands.h"
 namespace faiss {
 
 float
@@ -23,6 +28,23 @@ fvec_L2sqr_ref(const float* x, const float* y, size_t d) {
     return res;
 }
 
+float
+fvec_L2sqr_early_abandon_ref(const float* x, const float* y, size_t d, float threshold) {
+    float res = 0;
+    size_t i = 0;
+    while (i < d) {
+        const size_t end = std::min(d, i + kL2EarlyAbandonBlock);
+        for (; i < end; i++) {
+            const float tmp = x[i] - y[i];
+            res += tmp * tmp;
+        }
+        if (res > threshold) {
+            break;
+        }
+    }
+    return res;
+}
+
 float
 fvec_L1_ref(const float* x, const float* y, size_t d) {
     size_t i;
@@ -76,11 +98,26 @@ fvec_inner_products_ny_ref(float* ip, const float* x, const float* y, size_t d,
     }
 }
 
+void
+fvec_inner_products_scaled_ny_ref(float* ip, const float* x, const float* y, const float* scale, size_t d, size_t ny) {
+    for (size_t i = 0; i < ny; i++) {
+        ip[i] = fvec_inner_product_ref(x, y, d) * scale[i];
+        y += d;
+    }
+}
+
 void
 fvec_madd_ref(size_t n, const float* a, float bf, const float* b, float* c) {
     for (size_t i = 0; i < n; i++) c[i] = a[i] + bf * b[i];
 }
 
+void
+fvec_scale_ref(float* x, size_t d, float s) {
+    for (size_t i = 0; i < d; i++) {
+        x[i] *= s;
+    }
+}
+
 int
 fvec_madd_and_argmin_ref(size_t n, const float* a, float bf, const float* b, float* c) {
     float vmin = 1e20;
@@ -96,4 +133,236 @@ fvec_madd_and_argmin_ref(size_t n, const float* a, float bf, const float* b, flo
     return imin;
 }
 
+namespace {
+inline uint64_t
+load_u64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+}  // namespace
+
+void
+bvec_hamming_ny_ref(int32_t* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    for (size_t i = 0; i < ny; i++) {
+        int32_t accu = 0;
+        size_t j = 0;
+        for (; j + 8 <= code_size; j += 8) {
+            accu += __builtin_popcountll(load_u64(x + j) ^ load_u64(y + j));
+        }
+        for (; j < code_size; j++) {
+            accu += __builtin_popcount(x[j] ^ y[j]);
+        }
+        dis[i] = accu;
+        y += code_size;
+    }
+}
+
+void
+bvec_jaccard_ny_ref(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    for (size_t i = 0; i < ny; i++) {
+        int accu_num = 0;
+        int accu_den = 0;
+        size_t j = 0;
+        for (; j + 8 <= code_size; j += 8) {
+            const auto a = load_u64(x + j);
+            const auto b = load_u64(y + j);
+            accu_num += __builtin_popcountll(a & b);
+            accu_den += __builtin_popcountll(a | b);
+        }
+        for (; j < code_size; j++) {
+            accu_num += __builtin_popcount(x[j] & y[j]);
+            accu_den += __builtin_popcount(x[j] | y[j]);
+        }
+        dis[i] = (accu_den == 0) ? 1.0f : (float)(accu_den - accu_num) / (float)accu_den;
+        y += code_size;
+    }
+}
+
+void
+bvec_tlsh_ny_ref(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny) {
+    for (size_t i = 0; i < ny; i++) {
+        dis[i] = tlsh::diff((const tlsh::lsh_bin_struct*)x, (const tlsh::lsh_bin_struct*)y);
+        y += code_size;
+    }
+}
+
+float
+fp16_vec_inner_product_ref(const uint16_t* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        res += knowhere::Fp16ToFp32(x[i]) * knowhere::Fp16ToFp32(y[i]);
+    }
+    return res;
+}
+
+float
+fp16_vec_L2sqr_ref(const uint16_t* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const float tmp = knowhere::Fp16ToFp32(x[i]) - knowhere::Fp16ToFp32(y[i]);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+float
+fp16_vec_norm_L2sqr_ref(const uint16_t* x, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const float tmp = knowhere::Fp16ToFp32(x[i]);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+float
+bf16_vec_inner_product_ref(const uint16_t* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        res += knowhere::Bf16ToFp32(x[i]) * knowhere::Bf16ToFp32(y[i]);
+    }
+    return res;
+}
+
+float
+bf16_vec_L2sqr_ref(const uint16_t* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const float tmp = knowhere::Bf16ToFp32(x[i]) - knowhere::Bf16ToFp32(y[i]);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+float
+bf16_vec_norm_L2sqr_ref(const uint16_t* x, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const float tmp = knowhere::Bf16ToFp32(x[i]);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+float
+fvec_fp16_inner_product_ref(const float* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        res += x[i] * knowhere::Fp16ToFp32(y[i]);
+    }
+    return res;
+}
+
+float
+fvec_fp16_L2sqr_ref(const float* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const float tmp = x[i] - knowhere::Fp16ToFp32(y[i]);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+float
+fvec_bf16_inner_product_ref(const float* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        res += x[i] * knowhere::Bf16ToFp32(y[i]);
+    }
+    return res;
+}
+
+float
+fvec_bf16_L2sqr_ref(const float* x, const uint16_t* y, size_t d) {
+    float res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const float tmp = x[i] - knowhere::Bf16ToFp32(y[i]);
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+const uint64_t kHashSecret[kHashLanes] = {0x9e3779b185ebca87UL, 0xc2b2ae3d27d4eb4fUL, 0x165667b19e3779f9UL,
+                                          0x85ebca77c2b2ae63UL};
+
+namespace {
+
+inline void
+bvec_hash_block_ref(uint64_t* acc, const uint8_t* x) {
+    for (size_t j = 0; j < kHashLanes; j++) {
+        uint64_t w;
+        memcpy(&w, x + j * sizeof(uint64_t), sizeof(w));
+        const uint64_t key = w ^ kHashSecret[j];
+        // the xorshift before the add keeps the hash dependent on the order of the blocks
+        acc[j] ^= acc[j] >> 29;
+        acc[j] += w + (key & 0xffffffffUL) * (key >> 32);
+    }
+}
+
+inline uint64_t
+fmix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdUL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53UL;
+    h ^= h >> 33;
+    return h;
+}
+
+}  // namespace
+
+uint64_t
+bvec_hash_finalize_ref(uint64_t* acc, const uint8_t* tail, size_t n) {
+    const size_t tail_len = n % kHashBlock;
+    if (tail_len > 0) {
+        uint8_t block[kHashBlock] = {0};
+        memcpy(block, tail, tail_len);
+        bvec_hash_block_ref(acc, block);
+    }
+    uint64_t h = n * 0x9fb21c651e98df25UL;
+    for (size_t j = 0; j < kHashLanes; j++) {
+        h = fmix64(h ^ acc[j]);
+    }
+    return h;
+}
+
+uint64_t
+bvec_hash_ref(const uint8_t* x, size_t n) {
+    uint64_t acc[kHashLanes] = {kHashSecret[1], kHashSecret[2], kHashSecret[3], kHashSecret[0]};
+    const size_t blocks = n / kHashBlock;
+    for (size_t i = 0; i < blocks; i++) {
+        bvec_hash_block_ref(acc, x + i * kHashBlock);
+    }
+    return bvec_hash_finalize_ref(acc, x + blocks * kHashBlock, n);
+}
+
+int32_t
+int8_vec_inner_product_ref(const int8_t* x, const int8_t* y, size_t d) {
+    int32_t res = 0;
+    for (size_t i = 0; i < d; i++) {
+        res += (int32_t)x[i] * (int32_t)y[i];
+    }
+    return res;
+}
+
+int32_t
+int8_vec_L2sqr_ref(const int8_t* x, const int8_t* y, size_t d) {
+    int32_t res = 0;
+    for (size_t i = 0; i < d; i++) {
+        const int32_t tmp = (int32_t)x[i] - (int32_t)y[i];
+        res += tmp * tmp;
+    }
+    return res;
+}
+
+void
+int8_vec_inner_products_nx_ny_ref(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny) {
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < ny; j++) {
+            ip[i * ny + j] = int8_vec_inner_product_ref(x + i * d, y + j * d, d);
+        }
+    }
+}
+
 }  // namespace faiss
@@ -1,6 +1,7 @@
 #ifndef DISTANCES_REF_H
 #define DISTANCES_REF_H
 
+#include <cstdint>
 #include <cstdio>
 
 namespace faiss {
@@ -9,6 +10,13 @@ namespace faiss {
 float
 fvec_L2sqr_ref(const float* x, const float* y, size_t d);
 
+/// number of dimensions accumulated between two threshold checks of the early-abandon L2 kernels
+constexpr size_t kL2EarlyAbandonBlock = 64;
+
+/// Squared L2 distance between two vectors if it is not above threshold, otherwise a partial sum above threshold
+float
+fvec_L2sqr_early_abandon_ref(const float* x, const float* y, size_t d, float threshold);
+
 /// inner product
 float
 fvec_inner_product_ref(const float* x, const float* y, size_t d);
@@ -33,12 +41,89 @@ fvec_L2sqr_ny_ref(float* dis, const float* x, const float* y, size_t d, size_t n
 void
 fvec_inner_products_ny_ref(float* ip, const float* x, const float* y, size_t d, size_t ny);
 
+/// inner products between x and ny contiguous y vectors, the j-th one multiplied by scale[j]
+void
+fvec_inner_products_scaled_ny_ref(float* ip, const float* x, const float* y, const float* scale, size_t d, size_t ny);
+
 void
 fvec_madd_ref(size_t n, const float* a, float bf, const float* b, float* c);
 
+/// x[i] *= s for the d floats of x, in place
+void
+fvec_scale_ref(float* x, size_t d, float s);
+
 int
 fvec_madd_and_argmin_ref(size_t n, const float* a, float bf, const float* b, float* c);
 
+/// Hamming distances between the code x and ny contiguous codes y of code_size bytes
+void
+bvec_hamming_ny_ref(int32_t* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// Jaccard distances between the code x and ny contiguous codes y of code_size bytes
+void
+bvec_jaccard_ny_ref(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// TLSH distances between the digest x and ny contiguous digests y of code_size bytes
+void
+bvec_tlsh_ny_ref(float* dis, const uint8_t* x, const uint8_t* y, size_t code_size, size_t ny);
+
+/// inner product, squared L2 distance and squared norm of fp16 vectors, accumulated in fp32
+float
+fp16_vec_inner_product_ref(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+fp16_vec_L2sqr_ref(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+fp16_vec_norm_L2sqr_ref(const uint16_t* x, size_t d);
+
+/// inner product, squared L2 distance and squared norm of bf16 vectors, accumulated in fp32
+float
+bf16_vec_inner_product_ref(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+bf16_vec_L2sqr_ref(const uint16_t* x, const uint16_t* y, size_t d);
+
+float
+bf16_vec_norm_L2sqr_ref(const uint16_t* x, size_t d);
+
+/// inner product and squared L2 distance of an fp32 vector x and an fp16 / bf16 vector y
+float
+fvec_fp16_inner_product_ref(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_fp16_L2sqr_ref(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_bf16_inner_product_ref(const float* x, const uint16_t* y, size_t d);
+
+float
+fvec_bf16_L2sqr_ref(const float* x, const uint16_t* y, size_t d);
+
+/// lanes of 8 bytes of bvec_hash, the SIMD variants process the same 32-byte blocks and give the same hash
+constexpr size_t kHashLanes = 4;
+constexpr size_t kHashBlock = kHashLanes * sizeof(uint64_t);
+extern const uint64_t kHashSecret[kHashLanes];
+
+/// 64-bit hash of n bytes, a multiply-xorshift over 4 independent lanes mixed together at the end
+uint64_t
+bvec_hash_ref(const uint8_t* x, size_t n);
+
+/// hash of the remaining n % kHashBlock bytes (tail) and final mix of the lanes, shared by the SIMD variants
+uint64_t
+bvec_hash_finalize_ref(uint64_t* acc, const uint8_t* tail, size_t n);
+
+/// inner product and squared L2 distance of int8 vectors, accumulated in int32
+int32_t
+int8_vec_inner_product_ref(const int8_t* x, const int8_t* y, size_t d);
+
+int32_t
+int8_vec_L2sqr_ref(const int8_t* x, const int8_t* y, size_t d);
+
+/// inner products between nx int8 vectors x and ny int8 vectors y, ip[i * ny + j] = <x_i, y_j>
+void
+int8_vec_inner_products_nx_ny_ref(int32_t* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny);
+
 }  // namespace faiss
 
 #endif /* DISTANCES_REF_H */
@@ -277,6 +277,21 @@ fvec_L2sqr_sse(const float* x, const float* y, size_t d) {
     return _mm_cvtss_f32(msum1);
 }
 
+float
+fvec_L2sqr_early_abandon_sse(const float* x, const float* y, size_t d, float threshold) {
+    float res = 0;
+    while (d > kL2EarlyAbandonBlock) {
+        res += fvec_L2sqr_sse(x, y, kL2EarlyAbandonBlock);
+        if (res > threshold) {
+            return res;
+        }
+        x += kL2EarlyAbandonBlock;
+        y += kL2EarlyAbandonBlock;
+        d -= kL2EarlyAbandonBlock;
+    }
+    return res + fvec_L2sqr_sse(x, y, d);
+}
+
 float
 fvec_inner_product_sse(const float* x, const float* y, size_t d) {
     __m128 mx, my;
@@ -377,5 +392,29 @@ fvec_madd_and_argmin_sse(size_t n, const float* a, float bf, const float* b, flo
     return _mm_cvtsi128_si32(imin4);
 }
 
+uint64_t
+bvec_hash_sse(const uint8_t* x, size_t n) {
+    ALIGNED(16) uint64_t acc[kHashLanes] = {kHashSecret[1], kHashSecret[2], kHashSecret[3], kHashSecret[0]};
+    __m128i acc_lo = _mm_load_si128((const __m128i*)acc);
+    __m128i acc_hi = _mm_load_si128((const __m128i*)(acc + 2));
+    const __m128i secret_lo = _mm_loadu_si128((const __m128i*)kHashSecret);
+    const __m128i secret_hi = _mm_loadu_si128((const __m128i*)(kHashSecret + 2));
+    auto block = [](__m128i acc, __m128i w, __m128i secret) {
+        const __m128i key = _mm_xor_si128(w, secret);
+        const __m128i product = _mm_mul_epu32(key, _mm_srli_epi64(key, 32));
+        acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 29));
+        return _mm_add_epi64(acc, _mm_add_epi64(w, product));
+    };
+    const size_t blocks = n / kHashBlock;
+    for (size_t i = 0; i < blocks; i++) {
+        const uint8_t* p = x + i * kHashBlock;
+        acc_lo = block(acc_lo, _mm_loadu_si128((const __m128i*)p), secret_lo);
+        acc_hi = block(acc_hi, _mm_loadu_si128((const __m128i*)(p + 16)), secret_hi);
+    }
+    _mm_store_si128((__m128i*)acc, acc_lo);
+    _mm_store_si128((__m128i*)(acc + 2), acc_hi);
+    return bvec_hash_finalize_ref(acc, x + blocks * kHashBlock, n);
+}
+
 }  // namespace faiss
 #endif
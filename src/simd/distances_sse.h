@@ -12,6 +12,7 @@
 #ifndef DISTANCES_SSE_H
 #define DISTANCES_SSE_H
 
+#include <cstdint>
 #include <cstdio>
 namespace faiss {
 
@@ -19,6 +20,10 @@ namespace faiss {
 float
 fvec_L2sqr_sse(const float* x, const float* y, size_t d);
 
+/// Squared L2 distance between two vectors if it is not above threshold, otherwise a partial sum above threshold
+float
+fvec_L2sqr_early_abandon_sse(const float* x, const float* y, size_t d, float threshold);
+
 /// inner product
 float
 fvec_inner_product_sse(const float* x, const float* y, size_t d);
@@ -46,6 +51,10 @@ fvec_madd_sse(size_t n, const float* a, float bf, const float* b, float* c);
 int
 fvec_madd_and_argmin_sse(size_t n, const float* a, float bf, const float* b, float* c);
 
+/// 64-bit hash of n bytes, the lanes of bvec_hash_ref in two 128-bit registers
+uint64_t
+bvec_hash_sse(const uint8_t* x, size_t n);
+
 }  // namespace faiss
 
 #endif /* DISTANCES_SSE_H */
@@ -13,8 +13,11 @@
 
 #include "hook.h"
 
+#include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <mutex>
+#include <tuple>
 
 #include "faiss/FaissHook.h"
 
@@ -25,6 +28,11 @@
 #include "instruction_set.h"
 #endif
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "distances_ref.h"
 #include "knowhere/log.h"
 namespace faiss {
@@ -37,14 +45,37 @@ bool use_sse4_2 = true;
 
 decltype(fvec_inner_product) fvec_inner_product = fvec_inner_product_ref;
 decltype(fvec_L2sqr) fvec_L2sqr = fvec_L2sqr_ref;
+decltype(fvec_L2sqr_early_abandon) fvec_L2sqr_early_abandon = fvec_L2sqr_early_abandon_ref;
 decltype(fvec_L1) fvec_L1 = fvec_L1_ref;
 decltype(fvec_Linf) fvec_Linf = fvec_Linf_ref;
 decltype(fvec_norm_L2sqr) fvec_norm_L2sqr = fvec_norm_L2sqr_ref;
 decltype(fvec_L2sqr_ny) fvec_L2sqr_ny = fvec_L2sqr_ny_ref;
 decltype(fvec_inner_products_ny) fvec_inner_products_ny = fvec_inner_products_ny_ref;
+decltype(fvec_inner_products_scaled_ny) fvec_inner_products_scaled_ny = fvec_inner_products_scaled_ny_ref;
 decltype(fvec_madd) fvec_madd = fvec_madd_ref;
+decltype(fvec_scale) fvec_scale = fvec_scale_ref;
 decltype(fvec_madd_and_argmin) fvec_madd_and_argmin = fvec_madd_and_argmin_ref;
 
+decltype(bvec_hamming_ny) bvec_hamming_ny = bvec_hamming_ny_ref;
+decltype(bvec_jaccard_ny) bvec_jaccard_ny = bvec_jaccard_ny_ref;
+decltype(bvec_tlsh_ny) bvec_tlsh_ny = bvec_tlsh_ny_ref;
+decltype(bvec_hash) bvec_hash = bvec_hash_ref;
+
+decltype(fp16_vec_inner_product) fp16_vec_inner_product = fp16_vec_inner_product_ref;
+decltype(fp16_vec_L2sqr) fp16_vec_L2sqr = fp16_vec_L2sqr_ref;
+decltype(fp16_vec_norm_L2sqr) fp16_vec_norm_L2sqr = fp16_vec_norm_L2sqr_ref;
+decltype(bf16_vec_inner_product) bf16_vec_inner_product = bf16_vec_inner_product_ref;
+decltype(bf16_vec_L2sqr) bf16_vec_L2sqr = bf16_vec_L2sqr_ref;
+decltype(bf16_vec_norm_L2sqr) bf16_vec_norm_L2sqr = bf16_vec_norm_L2sqr_ref;
+decltype(fvec_fp16_inner_product) fvec_fp16_inner_product = fvec_fp16_inner_product_ref;
+decltype(fvec_fp16_L2sqr) fvec_fp16_L2sqr = fvec_fp16_L2sqr_ref;
+decltype(fvec_bf16_inner_product) fvec_bf16_inner_product = fvec_bf16_inner_product_ref;
+decltype(fvec_bf16_L2sqr) fvec_bf16_L2sqr = fvec_bf16_L2sqr_ref;
+
+decltype(int8_vec_inner_product) int8_vec_inner_product = int8_vec_inner_product_ref;
+decltype(int8_vec_L2sqr) int8_vec_L2sqr = int8_vec_L2sqr_ref;
+decltype(int8_vec_inner_products_nx_ny) int8_vec_inner_products_nx_ny = int8_vec_inner_products_nx_ny_ref;
+
 #if defined(__x86_64__)
 bool
 cpu_support_avx512() {
@@ -63,67 +94,298 @@ cpu_support_sse4_2() {
     InstructionSet& instruction_set_inst = InstructionSet::GetInstance();
     return (instruction_set_inst.SSE42());
 }
+
+bool
+cpu_support_avx512_vpopcntdq() {
+    InstructionSet& instruction_set_inst = InstructionSet::GetInstance();
+    return (cpu_support_avx512() && instruction_set_inst.AVX512VPOPCNTDQ());
+}
+
+bool
+cpu_support_avx512_vnni() {
+    InstructionSet& instruction_set_inst = InstructionSet::GetInstance();
+    return (cpu_support_avx512() && instruction_set_inst.AVX512VNNI());
+}
+
+bool
+cpu_support_amx_int8() {
+    InstructionSet& instruction_set_inst = InstructionSet::GetInstance();
+    if (!(cpu_support_avx512() && instruction_set_inst.AMXTILE() && instruction_set_inst.AMXINT8())) {
+        return false;
+    }
+#if defined(__linux__)
+    // Linux hands out the tile data state only to the processes asking for it, ARCH_REQ_XCOMP_PERM on
+    // XFEATURE_XTILEDATA
+    constexpr int kArchReqXcompPerm = 0x1023;
+    constexpr int kXfeatureXtiledata = 18;
+    static const bool permitted = syscall(SYS_arch_prctl, kArchReqXcompPerm, kXfeatureXtiledata) == 0;
+    return permitted;
+#else
+    return false;
+#endif
+}
 #endif
 
+namespace {
+
+// ISA a kernel is compiled for. GENERIC .. AVX512 are the SIMD levels of fvec_hook, the ones after AVX512 are
+// extensions only used at the AVX512 level when the cpu reports them.
+enum class Isa {
+    GENERIC = 0,
+    SSE4_2,
+    AVX2,
+    AVX512,
+    AVX512_VPOPCNTDQ,
+    AVX512_VNNI,
+    AMX_INT8,
+};
+
+struct KernelSlot {
+    const char* hook;
+    // distance computed between two vectors, empty for the batch and helper kernels
+    const char* metric;
+    const char* data_type;
+    // implementations best first, the last one is GENERIC
+    std::vector<std::pair<Isa, const char*>> candidates;
+    std::function<void(size_t)> install;
+    const char* active;
+};
+
+template <typename F>
+KernelSlot
+MakeSlot(const char* hook, const char* metric, const char* data_type, F* target,
+         std::initializer_list<std::tuple<Isa, F, const char*>> impls) {
+    KernelSlot slot{hook, metric, data_type, {}, {}, nullptr};
+    std::vector<F> fns;
+    for (auto& [isa, fn, name] : impls) {
+        slot.candidates.emplace_back(isa, name);
+        fns.push_back(fn);
+    }
+    slot.install = [target, fns](size_t i) { *target = fns[i]; };
+    return slot;
+}
+
+#define KERNEL(isa, fn) std::make_tuple(Isa::isa, fn, #fn)
+#if defined(__x86_64__)
+#define X86_KERNEL(isa, fn) KERNEL(isa, fn),
+#else
+#define X86_KERNEL(isa, fn)
+#endif
+// kernels built only by compilers knowing the AMX intrinsics, see distances_avx512.h
+#if defined(KNOWHERE_WITH_AMX_INT8)
+#define AMX_KERNEL(isa, fn) X86_KERNEL(isa, fn)
+#else
+#define AMX_KERNEL(isa, fn)
+#endif
+
+std::vector<KernelSlot>&
+KernelRegistry() {
+    static std::vector<KernelSlot> registry = [] {
+        std::vector<KernelSlot> slots;
+        // fp32
+        slots.push_back(MakeSlot("fvec_inner_product", "IP", "float32", &fvec_inner_product,
+                                 {X86_KERNEL(AVX512, fvec_inner_product_avx512)
+                                  X86_KERNEL(AVX2, fvec_inner_product_avx)
+                                  X86_KERNEL(SSE4_2, fvec_inner_product_sse)
+                                  KERNEL(GENERIC, fvec_inner_product_ref)}));
+        slots.push_back(MakeSlot("fvec_L2sqr", "L2", "float32", &fvec_L2sqr,
+                                 {X86_KERNEL(AVX512, fvec_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, fvec_L2sqr_avx)
+                                  X86_KERNEL(SSE4_2, fvec_L2sqr_sse)
+                                  KERNEL(GENERIC, fvec_L2sqr_ref)}));
+        slots.push_back(MakeSlot("fvec_L2sqr_early_abandon", "", "float32", &fvec_L2sqr_early_abandon,
+                                 {X86_KERNEL(AVX512, fvec_L2sqr_early_abandon_avx512)
+                                  X86_KERNEL(AVX2, fvec_L2sqr_early_abandon_avx)
+                                  X86_KERNEL(SSE4_2, fvec_L2sqr_early_abandon_sse)
+                                  KERNEL(GENERIC, fvec_L2sqr_early_abandon_ref)}));
+        slots.push_back(MakeSlot("fvec_L1", "L1", "float32", &fvec_L1,
+                                 {X86_KERNEL(AVX512, fvec_L1_avx512)
+                                  X86_KERNEL(AVX2, fvec_L1_avx)
+                                  X86_KERNEL(SSE4_2, fvec_L1_sse)
+                                  KERNEL(GENERIC, fvec_L1_ref)}));
+        slots.push_back(MakeSlot("fvec_Linf", "Linf", "float32", &fvec_Linf,
+                                 {X86_KERNEL(AVX512, fvec_Linf_avx512)
+                                  X86_KERNEL(AVX2, fvec_Linf_avx)
+                                  X86_KERNEL(SSE4_2, fvec_Linf_sse)
+                                  KERNEL(GENERIC, fvec_Linf_ref)}));
+        slots.push_back(MakeSlot("fvec_norm_L2sqr", "", "float32", &fvec_norm_L2sqr,
+                                 {X86_KERNEL(SSE4_2, fvec_norm_L2sqr_sse)
+                                  KERNEL(GENERIC, fvec_norm_L2sqr_ref)}));
+        slots.push_back(MakeSlot("fvec_L2sqr_ny", "", "float32", &fvec_L2sqr_ny,
+                                 {X86_KERNEL(SSE4_2, fvec_L2sqr_ny_sse)
+                                  KERNEL(GENERIC, fvec_L2sqr_ny_ref)}));
+        slots.push_back(MakeSlot("fvec_inner_products_ny", "", "float32", &fvec_inner_products_ny,
+                                 {X86_KERNEL(SSE4_2, fvec_inner_products_ny_sse)
+                                  KERNEL(GENERIC, fvec_inner_products_ny_ref)}));
+        slots.push_back(MakeSlot("fvec_inner_products_scaled_ny", "", "float32", &fvec_inner_products_scaled_ny,
+                                 {X86_KERNEL(AVX512, fvec_inner_products_scaled_ny_avx512)
+                                  X86_KERNEL(AVX2, fvec_inner_products_scaled_ny_avx)
+                                  KERNEL(GENERIC, fvec_inner_products_scaled_ny_ref)}));
+        slots.push_back(MakeSlot("fvec_madd", "", "float32", &fvec_madd,
+                                 {X86_KERNEL(SSE4_2, fvec_madd_sse)
+                                  KERNEL(GENERIC, fvec_madd_ref)}));
+        slots.push_back(MakeSlot("fvec_scale", "", "float32", &fvec_scale,
+                                 {X86_KERNEL(AVX512, fvec_scale_avx512)
+                                  X86_KERNEL(AVX2, fvec_scale_avx)
+                                  KERNEL(GENERIC, fvec_scale_ref)}));
+        slots.push_back(MakeSlot("fvec_madd_and_argmin", "", "float32", &fvec_madd_and_argmin,
+                                 {X86_KERNEL(SSE4_2, fvec_madd_and_argmin_sse)
+                                  KERNEL(GENERIC, fvec_madd_and_argmin_ref)}));
+
+        // binary
+        slots.push_back(MakeSlot("bvec_hamming_ny", "HAMMING", "binary", &bvec_hamming_ny,
+                                 {X86_KERNEL(AVX512_VPOPCNTDQ, bvec_hamming_ny_avx512)
+                                  X86_KERNEL(AVX2, bvec_hamming_ny_avx)
+                                  KERNEL(GENERIC, bvec_hamming_ny_ref)}));
+        slots.push_back(MakeSlot("bvec_jaccard_ny", "JACCARD", "binary", &bvec_jaccard_ny,
+                                 {X86_KERNEL(AVX512_VPOPCNTDQ, bvec_jaccard_ny_avx512)
+                                  X86_KERNEL(AVX2, bvec_jaccard_ny_avx)
+                                  KERNEL(GENERIC, bvec_jaccard_ny_ref)}));
+        slots.push_back(MakeSlot("bvec_tlsh_ny", "TLSH", "binary", &bvec_tlsh_ny,
+                                 {X86_KERNEL(AVX2, bvec_tlsh_ny_avx)
+                                  KERNEL(GENERIC, bvec_tlsh_ny_ref)}));
+        slots.push_back(MakeSlot("bvec_hash", "", "binary", &bvec_hash,
+                                 {X86_KERNEL(AVX2, bvec_hash_avx)
+                                  X86_KERNEL(SSE4_2, bvec_hash_sse)
+                                  KERNEL(GENERIC, bvec_hash_ref)}));
+
+        // fp16 / bf16
+        slots.push_back(MakeSlot("fp16_vec_inner_product", "IP", "float16", &fp16_vec_inner_product,
+                                 {X86_KERNEL(AVX512, fp16_vec_inner_product_avx512)
+                                  X86_KERNEL(AVX2, fp16_vec_inner_product_avx)
+                                  KERNEL(GENERIC, fp16_vec_inner_product_ref)}));
+        slots.push_back(MakeSlot("fp16_vec_L2sqr", "L2", "float16", &fp16_vec_L2sqr,
+                                 {X86_KERNEL(AVX512, fp16_vec_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, fp16_vec_L2sqr_avx)
+                                  KERNEL(GENERIC, fp16_vec_L2sqr_ref)}));
+        slots.push_back(MakeSlot("fp16_vec_norm_L2sqr", "", "float16", &fp16_vec_norm_L2sqr,
+                                 {X86_KERNEL(AVX512, fp16_vec_norm_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, fp16_vec_norm_L2sqr_avx)
+                                  KERNEL(GENERIC, fp16_vec_norm_L2sqr_ref)}));
+        slots.push_back(MakeSlot("bf16_vec_inner_product", "IP", "bfloat16", &bf16_vec_inner_product,
+                                 {X86_KERNEL(AVX512, bf16_vec_inner_product_avx512)
+                                  X86_KERNEL(AVX2, bf16_vec_inner_product_avx)
+                                  KERNEL(GENERIC, bf16_vec_inner_product_ref)}));
+        slots.push_back(MakeSlot("bf16_vec_L2sqr", "L2", "bfloat16", &bf16_vec_L2sqr,
+                                 {X86_KERNEL(AVX512, bf16_vec_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, bf16_vec_L2sqr_avx)
+                                  KERNEL(GENERIC, bf16_vec_L2sqr_ref)}));
+        slots.push_back(MakeSlot("bf16_vec_norm_L2sqr", "", "bfloat16", &bf16_vec_norm_L2sqr,
+                                 {X86_KERNEL(AVX512, bf16_vec_norm_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, bf16_vec_norm_L2sqr_avx)
+                                  KERNEL(GENERIC, bf16_vec_norm_L2sqr_ref)}));
+        slots.push_back(MakeSlot("fvec_fp16_inner_product", "IP", "float16", &fvec_fp16_inner_product,
+                                 {X86_KERNEL(AVX512, fvec_fp16_inner_product_avx512)
+                                  X86_KERNEL(AVX2, fvec_fp16_inner_product_avx)
+                                  KERNEL(GENERIC, fvec_fp16_inner_product_ref)}));
+        slots.push_back(MakeSlot("fvec_fp16_L2sqr", "L2", "float16", &fvec_fp16_L2sqr,
+                                 {X86_KERNEL(AVX512, fvec_fp16_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, fvec_fp16_L2sqr_avx)
+                                  KERNEL(GENERIC, fvec_fp16_L2sqr_ref)}));
+        slots.push_back(MakeSlot("fvec_bf16_inner_product", "IP", "bfloat16", &fvec_bf16_inner_product,
+                                 {X86_KERNEL(AVX512, fvec_bf16_inner_product_avx512)
+                                  X86_KERNEL(AVX2, fvec_bf16_inner_product_avx)
+                                  KERNEL(GENERIC, fvec_bf16_inner_product_ref)}));
+        slots.push_back(MakeSlot("fvec_bf16_L2sqr", "L2", "bfloat16", &fvec_bf16_L2sqr,
+                                 {X86_KERNEL(AVX512, fvec_bf16_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, fvec_bf16_L2sqr_avx)
+                                  KERNEL(GENERIC, fvec_bf16_L2sqr_ref)}));
+
+        // int8
+        slots.push_back(MakeSlot("int8_vec_inner_product", "IP", "int8", &int8_vec_inner_product,
+                                 {X86_KERNEL(AVX512_VNNI, int8_vec_inner_product_avx512_vnni)
+                                  X86_KERNEL(AVX512, int8_vec_inner_product_avx512)
+                                  X86_KERNEL(AVX2, int8_vec_inner_product_avx)
+                                  KERNEL(GENERIC, int8_vec_inner_product_ref)}));
+        slots.push_back(MakeSlot("int8_vec_L2sqr", "L2", "int8", &int8_vec_L2sqr,
+                                 {X86_KERNEL(AVX512_VNNI, int8_vec_L2sqr_avx512_vnni)
+                                  X86_KERNEL(AVX512, int8_vec_L2sqr_avx512)
+                                  X86_KERNEL(AVX2, int8_vec_L2sqr_avx)
+                                  KERNEL(GENERIC, int8_vec_L2sqr_ref)}));
+        slots.push_back(MakeSlot("int8_vec_inner_products_nx_ny", "", "int8", &int8_vec_inner_products_nx_ny,
+                                 {AMX_KERNEL(AMX_INT8, int8_vec_inner_products_nx_ny_amx)
+                                  X86_KERNEL(AVX512_VNNI, int8_vec_inner_products_nx_ny_avx512_vnni)
+                                  X86_KERNEL(AVX512, int8_vec_inner_products_nx_ny_avx512)
+                                  X86_KERNEL(AVX2, int8_vec_inner_products_nx_ny_avx)
+                                  KERNEL(GENERIC, int8_vec_inner_products_nx_ny_ref)}));
+        return slots;
+    }();
+    return registry;
+}
+
+#undef AMX_KERNEL
+#undef X86_KERNEL
+#undef KERNEL
+
+std::mutex&
+HookMutex() {
+    static std::mutex hook_mutex;
+    return hook_mutex;
+}
+
+}  // namespace
+
 void
 fvec_hook(std::string& simd_type) {
-    static std::mutex hook_mutex;
-    std::lock_guard<std::mutex> lock(hook_mutex);
+    std::lock_guard<std::mutex> lock(HookMutex());
+    Isa level = Isa::GENERIC;
+    simd_type = "GENERIC";
 #if defined(__x86_64__)
     if (use_avx512 && cpu_support_avx512()) {
-        fvec_inner_product = fvec_inner_product_avx512;
-        fvec_L2sqr = fvec_L2sqr_avx512;
-        fvec_L1 = fvec_L1_avx512;
-        fvec_Linf = fvec_Linf_avx512;
-
-        fvec_norm_L2sqr = fvec_norm_L2sqr_sse;
-        fvec_L2sqr_ny = fvec_L2sqr_ny_sse;
-        fvec_inner_products_ny = fvec_inner_products_ny_sse;
-        fvec_madd = fvec_madd_sse;
-        fvec_madd_and_argmin = fvec_madd_and_argmin_sse;
-
+        level = Isa::AVX512;
         simd_type = "AVX512";
     } else if (use_avx2 && cpu_support_avx2()) {
-        fvec_inner_product = fvec_inner_product_avx;
-        fvec_L2sqr = fvec_L2sqr_avx;
-        fvec_L1 = fvec_L1_avx;
-        fvec_Linf = fvec_Linf_avx;
-
-        fvec_norm_L2sqr = fvec_norm_L2sqr_sse;
-        fvec_L2sqr_ny = fvec_L2sqr_ny_sse;
-        fvec_inner_products_ny = fvec_inner_products_ny_sse;
-        fvec_madd = fvec_madd_sse;
-        fvec_madd_and_argmin = fvec_madd_and_argmin_sse;
-
+        level = Isa::AVX2;
         simd_type = "AVX2";
     } else if (use_sse4_2 && cpu_support_sse4_2()) {
-        fvec_inner_product = fvec_inner_product_sse;
-        fvec_L2sqr = fvec_L2sqr_sse;
-        fvec_L1 = fvec_L1_sse;
-        fvec_Linf = fvec_Linf_sse;
-
-        fvec_norm_L2sqr = fvec_norm_L2sqr_sse;
-        fvec_L2sqr_ny = fvec_L2sqr_ny_sse;
-        fvec_inner_products_ny = fvec_inner_products_ny_sse;
-        fvec_madd = fvec_madd_sse;
-        fvec_madd_and_argmin = fvec_madd_and_argmin_sse;
-
+        level = Isa::SSE4_2;
         simd_type = "SSE4_2";
-    } else {
-        fvec_inner_product = fvec_inner_product_ref;
-        fvec_L2sqr = fvec_L2sqr_ref;
-        fvec_L1 = fvec_L1_ref;
-        fvec_Linf = fvec_Linf_ref;
-
-        fvec_norm_L2sqr = fvec_norm_L2sqr_ref;
-        fvec_L2sqr_ny = fvec_L2sqr_ny_ref;
-        fvec_inner_products_ny = fvec_inner_products_ny_ref;
-        fvec_madd = fvec_madd_ref;
-        fvec_madd_and_argmin = fvec_madd_and_argmin_ref;
-
-        simd_type = "GENERIC";
     }
 #endif
+    auto supported = [level](Isa isa) {
+        switch (isa) {
+#if defined(__x86_64__)
+            case Isa::AVX512_VPOPCNTDQ:
+                return level == Isa::AVX512 && cpu_support_avx512_vpopcntdq();
+            case Isa::AVX512_VNNI:
+                return level == Isa::AVX512 && cpu_support_avx512_vnni();
+            case Isa::AMX_INT8:
+                return level == Isa::AVX512 && cpu_support_amx_int8();
+#endif
+            default:
+                return isa <= level;
+        }
+    };
+    for (auto& slot : KernelRegistry()) {
+        for (size_t i = 0; i < slot.candidates.size(); i++) {
+            if (supported(slot.candidates[i].first)) {
+                slot.install(i);
+                slot.active = slot.candidates[i].second;
+                break;
+            }
+        }
+    }
+}
+
+std::string
+active_kernel(const std::string& metric, const std::string& data_type) {
+    std::lock_guard<std::mutex> lock(HookMutex());
+    for (const auto& slot : KernelRegistry()) {
+        if (metric == slot.metric && data_type == slot.data_type) {
+            return slot.active ? slot.active : "";
+        }
+    }
+    return "";
+}
+
+std::vector<std::pair<std::string, std::string>>
+active_kernels() {
+    std::lock_guard<std::mutex> lock(HookMutex());
+    std::vector<std::pair<std::string, std::string>> kernels;
+    for (const auto& slot : KernelRegistry()) {
+        kernels.emplace_back(slot.hook, slot.active ? slot.active : "");
+    }
+    return kernels;
 }
 
 static int init_hook_ = []() {
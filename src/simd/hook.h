@@ -12,19 +12,56 @@
 #ifndef HOOK_H
 #define HOOK_H
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 namespace faiss {
 
 extern float (*fvec_inner_product)(const float*, const float*, size_t);
 extern float (*fvec_L2sqr)(const float*, const float*, size_t);
+/// squared L2 distance, abandoned with a partial sum once it is above the threshold (last argument)
+extern float (*fvec_L2sqr_early_abandon)(const float*, const float*, size_t, float);
 extern float (*fvec_L1)(const float*, const float*, size_t);
 extern float (*fvec_Linf)(const float*, const float*, size_t);
 extern float (*fvec_norm_L2sqr)(const float*, size_t);
 extern void (*fvec_L2sqr_ny)(float*, const float*, const float*, size_t, size_t);
 extern void (*fvec_inner_products_ny)(float*, const float*, const float*, size_t, size_t);
+/// inner products between x and ny contiguous y vectors, the j-th one multiplied by scale[j] (inverse norms for
+/// the cosine similarity of raw vectors)
+extern void (*fvec_inner_products_scaled_ny)(float*, const float*, const float*, const float*, size_t, size_t);
 extern void (*fvec_madd)(size_t, const float*, float, const float*, float*);
+/// x[i] *= s for the d floats of x, in place
+extern void (*fvec_scale)(float*, size_t, float);
 extern int (*fvec_madd_and_argmin)(size_t, const float*, float, const float*, float*);
 
+/// binary distances between one code and ny contiguous codes of code_size bytes
+extern void (*bvec_hamming_ny)(int32_t*, const uint8_t*, const uint8_t*, size_t, size_t);
+extern void (*bvec_jaccard_ny)(float*, const uint8_t*, const uint8_t*, size_t, size_t);
+extern void (*bvec_tlsh_ny)(float*, const uint8_t*, const uint8_t*, size_t, size_t);
+
+/// 64-bit hash of n bytes for cache keys, the same value whichever kernel is hooked
+extern uint64_t (*bvec_hash)(const uint8_t*, size_t);
+
+/// fp16 / bf16 distances between two vectors of the same element type, accumulated in fp32
+extern float (*fp16_vec_inner_product)(const uint16_t*, const uint16_t*, size_t);
+extern float (*fp16_vec_L2sqr)(const uint16_t*, const uint16_t*, size_t);
+extern float (*fp16_vec_norm_L2sqr)(const uint16_t*, size_t);
+extern float (*bf16_vec_inner_product)(const uint16_t*, const uint16_t*, size_t);
+extern float (*bf16_vec_L2sqr)(const uint16_t*, const uint16_t*, size_t);
+extern float (*bf16_vec_norm_L2sqr)(const uint16_t*, size_t);
+
+/// distances between an fp32 vector x and an fp16 / bf16 vector y, for fp32 queries on half precision data
+extern float (*fvec_fp16_inner_product)(const float*, const uint16_t*, size_t);
+extern float (*fvec_fp16_L2sqr)(const float*, const uint16_t*, size_t);
+extern float (*fvec_bf16_inner_product)(const float*, const uint16_t*, size_t);
+extern float (*fvec_bf16_L2sqr)(const float*, const uint16_t*, size_t);
+
+/// int8 distances accumulated in int32, and the inner products between nx and ny int8 vectors (ip[i * ny + j])
+extern int32_t (*int8_vec_inner_product)(const int8_t*, const int8_t*, size_t);
+extern int32_t (*int8_vec_L2sqr)(const int8_t*, const int8_t*, size_t);
+extern void (*int8_vec_inner_products_nx_ny)(int32_t*, const int8_t*, const int8_t*, size_t, size_t, size_t);
+
 #if defined(__x86_64__)
 extern bool use_avx512;
 extern bool use_avx2;
@@ -38,11 +75,30 @@ bool
 cpu_support_avx2();
 bool
 cpu_support_sse4_2();
+bool
+cpu_support_avx512_vpopcntdq();
+bool
+cpu_support_avx512_vnni();
+/// AMX_INT8 reported by the cpu and the tile data state granted to the process by the kernel
+bool
+cpu_support_amx_int8();
 #endif
 
+/// Every hook above is a slot of a kernel registry listing its implementations by ISA, best first. fvec_hook installs
+/// the first one the running cpu supports within the SIMD level allowed by use_avx512 / use_avx2 / use_sse4_2, and
+/// returns that level.
 void
 fvec_hook(std::string&);
 
+/// name of the hooked kernel computing `metric` ("L2", "IP", "HAMMING", "JACCARD", "TLSH") between two vectors of
+/// `data_type` ("float32", "float16", "bfloat16", "int8", "binary"), empty if the registry has none
+std::string
+active_kernel(const std::string& metric, const std::string& data_type);
+
+/// (hook, installed implementation) for every slot of the registry
+std::vector<std::pair<std::string, std::string>>
+active_kernels();
+
 }  // namespace faiss
 
 #endif /* HOOK_H */
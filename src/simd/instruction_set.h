@@ -41,6 +41,7 @@ class InstructionSet {
           f_1_EDX_{0},
           f_7_EBX_{0},
           f_7_ECX_{0},
+          f_7_EDX_{0},
           f_81_ECX_{0},
           f_81_EDX_{0},
           data_{},
@@ -80,6 +81,7 @@ class InstructionSet {
         if (nIds_ >= 7) {
             f_7_EBX_ = data_[7][1];
             f_7_ECX_ = data_[7][2];
+            f_7_EDX_ = data_[7][3];
         }
 
         // Calling __cpuid with 0x80000000 as the function_id argument
@@ -300,6 +302,23 @@ class InstructionSet {
     PREFETCHWT1() {
         return f_7_ECX_[0];
     }
+    bool
+    AVX512VPOPCNTDQ() {
+        return f_7_ECX_[14];
+    }
+    bool
+    AVX512VNNI() {
+        return f_7_ECX_[11];
+    }
+
+    bool
+    AMXTILE() {
+        return f_7_EDX_[24];
+    }
+    bool
+    AMXINT8() {
+        return f_7_EDX_[25];
+    }
 
     bool
     LAHF() {
@@ -358,6 +377,7 @@ class InstructionSet {
     std::bitset<32> f_1_EDX_;
     std::bitset<32> f_7_EBX_;
     std::bitset<32> f_7_ECX_;
+    std::bitset<32> f_7_EDX_;
     std::bitset<32> f_81_ECX_;
     std::bitset<32> f_81_EDX_;
     std::vector<std::array<int, 4>> data_;
@@ -69,6 +69,83 @@ TEST_CASE("Test Brute Force", "[float vector]") {
         delete[] dist;
     }
 
+    SECTION("Test Search By Ids") {
+        std::vector<int64_t> even_ids;
+        for (int64_t i = 0; i < nb; i += 2) {
+            even_ids.push_back(i);
+        }
+        auto ids_ds = GenIdsDataSet(even_ids.size(), even_ids);
+        auto res = knowhere::BruteForce::SearchByIds(train_ds, query_ds, ids_ds, conf);
+        REQUIRE(res.has_value());
+        auto ids = res.value()->GetIds();
+        auto dist = res.value()->GetDistance();
+        for (int64_t i = 0; i < nq; i++) {
+            for (int64_t j = 0; j < k; j++) {
+                REQUIRE(ids[i * k + j] % 2 == 0);
+            }
+            if (i % 2 == 0) {
+                REQUIRE(ids[i * k] == i);
+                if (metric == knowhere::metric::L2) {
+                    REQUIRE(dist[i * k] == 0);
+                } else {
+                    REQUIRE(std::abs(dist[i * k] - 1.0) < 0.00001);
+                }
+            }
+        }
+
+        std::vector<int64_t> out_of_range_ids = {0, nb};
+        auto bad_ids_ds = GenIdsDataSet(out_of_range_ids.size(), out_of_range_ids);
+        REQUIRE(knowhere::BruteForce::SearchByIds(train_ds, query_ds, bad_ids_ds, conf).error() ==
+                knowhere::Status::invalid_args);
+    }
+
+    SECTION("Test Search With Sparse Bitset") {
+        const int64_t num_filtered = nb - nb / 20;
+        auto bitset_data = GenerateBitsetWithFirstTbitsSet(nb, num_filtered);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        std::vector<int64_t> unfiltered_ids;
+        for (int64_t i = num_filtered; i < nb; i++) {
+            unfiltered_ids.push_back(i);
+        }
+        auto ids_ds = GenIdsDataSet(unfiltered_ids.size(), unfiltered_ids);
+        auto res = knowhere::BruteForce::Search(train_ds, query_ds, conf, bitset);
+        auto gt = knowhere::BruteForce::SearchByIds(train_ds, query_ds, ids_ds, conf);
+        REQUIRE(res.has_value());
+        REQUIRE(gt.has_value());
+        for (int64_t i = 0; i < nq * k; i++) {
+            REQUIRE(res.value()->GetIds()[i] >= num_filtered);
+            REQUIRE(res.value()->GetIds()[i] == gt.value()->GetIds()[i]);
+        }
+    }
+
+    SECTION("Test Search With Large Nq") {
+        // enough queries for the blocked BLAS path, with a last partial block
+        const int64_t large_nq = 300;
+        const auto large_query_ds = CopyDataSet(train_ds, large_nq);
+        auto res = knowhere::BruteForce::Search(train_ds, large_query_ds, conf, nullptr);
+        REQUIRE(res.has_value());
+        for (int64_t i = 0; i < large_nq; i++) {
+            REQUIRE(res.value()->GetIds()[i * k] == i);
+        }
+
+        // half of the rows filtered, checked against the per-query search over the unfiltered ids
+        auto bitset_data = GenerateBitsetWithFirstTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        std::vector<int64_t> unfiltered_ids;
+        for (int64_t i = nb / 2; i < nb; i++) {
+            unfiltered_ids.push_back(i);
+        }
+        auto ids_ds = GenIdsDataSet(unfiltered_ids.size(), unfiltered_ids);
+        auto filtered_res = knowhere::BruteForce::Search(train_ds, large_query_ds, conf, bitset);
+        auto gt = knowhere::BruteForce::SearchByIds(train_ds, large_query_ds, ids_ds, conf);
+        REQUIRE(filtered_res.has_value());
+        REQUIRE(gt.has_value());
+        for (int64_t i = 0; i < large_nq * k; i++) {
+            REQUIRE(filtered_res.value()->GetIds()[i] == gt.value()->GetIds()[i]);
+            REQUIRE(filtered_res.value()->GetDistance()[i] == Approx(gt.value()->GetDistance()[i]).epsilon(1e-4));
+        }
+    }
+
     SECTION("Test Range Search") {
         auto res = knowhere::BruteForce::RangeSearch(train_ds, query_ds, conf, nullptr);
         REQUIRE(res.has_value());
@@ -135,6 +212,39 @@ TEST_CASE("Test Brute Force", "[binary vector]") {
         delete[] dist;
     }
 
+    SECTION("Test Search By Ids") {
+        std::vector<int64_t> even_ids;
+        for (int64_t i = 0; i < nb; i += 2) {
+            even_ids.push_back(i);
+        }
+        auto ids_ds = GenIdsDataSet(even_ids.size(), even_ids);
+        auto res = knowhere::BruteForce::SearchByIds(train_ds, query_ds, ids_ds, conf);
+        REQUIRE(res.has_value());
+        auto ids = res.value()->GetIds();
+        auto dist = res.value()->GetDistance();
+        for (int64_t i = 0; i < nq; i++) {
+            for (int64_t j = 0; j < k; j++) {
+                REQUIRE((ids[i * k + j] == -1 || ids[i * k + j] % 2 == 0));
+            }
+            if (i % 2 == 0) {
+                REQUIRE(ids[i * k] == i);
+                REQUIRE(dist[i * k] == 0);
+            }
+        }
+    }
+
+    SECTION("Test Search With Sparse Bitset") {
+        const int64_t num_filtered = nb - nb / 20;
+        auto bitset_data = GenerateBitsetWithFirstTbitsSet(nb, num_filtered);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto res = knowhere::BruteForce::Search(train_ds, query_ds, conf, bitset);
+        REQUIRE(res.has_value());
+        for (int64_t i = 0; i < nq * k; i++) {
+            auto id = res.value()->GetIds()[i];
+            REQUIRE((id == -1 || id >= num_filtered));
+        }
+    }
+
     SECTION("Test Range Search") {
         if (metric == knowhere::metric::SUPERSTRUCTURE || metric == knowhere::metric::SUBSTRUCTURE) {
             return;
@@ -3,6 +3,7 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <random>
 
+#include "knowhere/operands.h"
 #include "simd/distances_ref.h"
 #include "simd/hook.h"
 TEST_CASE("Test Distance Compute", "[distance]") {
@@ -36,6 +37,27 @@ TEST_CASE("Test Distance Compute", "[distance]") {
         }
     }
 
+    SECTION("Test Early Abandon L2 Compute") {
+        typedef float (*FUNC)(const float*, const float*, size_t, float);
+        auto real_func = GENERATE(as<FUNC>{}, faiss::fvec_L2sqr_early_abandon, faiss::fvec_L2sqr_early_abandon_ref);
+
+        for (int i = 0; i < 1000; ++i) {
+            CAPTURE(i);
+            auto len = distrib(rng) % 2048 + 1;
+            std::vector<float> a(len);
+            std::vector<float> b(len);
+            for (int i = 0; i < len; ++i) {
+                a[i] = fill_distrib(rng);
+                b[i] = fill_distrib(rng);
+            }
+            auto gold = faiss::fvec_L2sqr_ref(a.data(), b.data(), len);
+            // exact when the distance stays under the threshold, above the threshold otherwise
+            REQUIRE_THAT(real_func(a.data(), b.data(), len, gold * 1.01f), Catch::Matchers::WithinRel(gold, 0.001f));
+            auto threshold = gold * (i % 100) / 100.0f;
+            REQUIRE(real_func(a.data(), b.data(), len, threshold) > threshold);
+        }
+    }
+
     SECTION("Test Normal Compute") {
         typedef float (*FUNC)(const float*, size_t);
         auto [real_func, gold_func] = GENERATE(table<FUNC, FUNC>({
@@ -108,4 +130,195 @@ TEST_CASE("Test Distance Compute", "[distance]") {
             }
         }
     }
+
+    SECTION("Test Binary Batch Distance Compute") {
+        // 35 bytes is the size of a TLSH digest, 256 bytes of a 2048-bit fingerprint
+        auto code_size = GENERATE(as<size_t>{}, 35, 64, 100, 256, 257);
+        const size_t ny = 100;
+        std::uniform_int_distribution<> byte_distrib(0, 255);
+        std::vector<uint8_t> x(code_size);
+        std::vector<uint8_t> y(code_size * ny);
+        for (auto& v : x) {
+            v = byte_distrib(rng);
+        }
+        for (auto& v : y) {
+            v = byte_distrib(rng);
+        }
+
+        std::vector<int32_t> hamming(ny), hamming_gold(ny);
+        faiss::bvec_hamming_ny(hamming.data(), x.data(), y.data(), code_size, ny);
+        faiss::bvec_hamming_ny_ref(hamming_gold.data(), x.data(), y.data(), code_size, ny);
+        REQUIRE(hamming == hamming_gold);
+
+        std::vector<float> jaccard(ny), jaccard_gold(ny);
+        faiss::bvec_jaccard_ny(jaccard.data(), x.data(), y.data(), code_size, ny);
+        faiss::bvec_jaccard_ny_ref(jaccard_gold.data(), x.data(), y.data(), code_size, ny);
+        for (size_t i = 0; i < ny; ++i) {
+            REQUIRE_THAT(jaccard[i], Catch::Matchers::WithinRel(jaccard_gold[i], 0.0001f));
+        }
+
+        if (code_size == 35) {
+            std::vector<float> tlsh(ny), tlsh_gold(ny);
+            faiss::bvec_tlsh_ny(tlsh.data(), x.data(), y.data(), code_size, ny);
+            faiss::bvec_tlsh_ny_ref(tlsh_gold.data(), x.data(), y.data(), code_size, ny);
+            REQUIRE(tlsh == tlsh_gold);
+        }
+    }
+
+    SECTION("Test Bytes Hash") {
+        std::uniform_int_distribution<> byte_distrib(0, 255);
+        std::vector<uint8_t> x(4096 + 1);
+        for (auto& v : x) {
+            v = byte_distrib(rng);
+        }
+        // every length around the 32-byte blocks, from an unaligned address
+        for (size_t n = 0; n < 200; ++n) {
+            REQUIRE(faiss::bvec_hash(x.data() + 1, n) == faiss::bvec_hash_ref(x.data() + 1, n));
+        }
+        REQUIRE(faiss::bvec_hash(x.data() + 1, 4096) == faiss::bvec_hash_ref(x.data() + 1, 4096));
+        // the hash depends on the order of the blocks
+        auto y = x;
+        std::swap_ranges(y.begin(), y.begin() + 32, y.begin() + 32);
+        REQUIRE(faiss::bvec_hash(x.data(), 64) != faiss::bvec_hash(y.data(), 64));
+    }
+
+    SECTION("Test Scale") {
+        for (int i = 0; i < 1000; ++i) {
+            CAPTURE(i);
+            auto len = distrib(rng) % 2048 + 1;
+            std::vector<float> a(len);
+            for (auto& v : a) {
+                v = fill_distrib(rng);
+            }
+            auto b = a;
+            const float s = 1.0f / fill_distrib(rng);
+            faiss::fvec_scale(a.data(), len, s);
+            faiss::fvec_scale_ref(b.data(), len, s);
+            for (size_t j = 0; j < len; ++j) {
+                REQUIRE(a[j] == b[j]);
+            }
+        }
+    }
+
+    SECTION("Test Scaled Inner Products") {
+        for (int i = 0; i < 200; ++i) {
+            CAPTURE(i);
+            auto dim = distrib(rng) % 512 + 1;
+            auto ny = distrib(rng) % 40 + 1;
+            std::vector<float> x(dim), y(dim * ny), scale(ny);
+            for (auto& v : x) {
+                v = fill_distrib(rng);
+            }
+            for (auto& v : y) {
+                v = fill_distrib(rng);
+            }
+            for (auto& v : scale) {
+                v = 1.0f / fill_distrib(rng);
+            }
+            std::vector<float> ip(ny), gt(ny);
+            faiss::fvec_inner_products_scaled_ny(ip.data(), x.data(), y.data(), scale.data(), dim, ny);
+            faiss::fvec_inner_products_scaled_ny_ref(gt.data(), x.data(), y.data(), scale.data(), dim, ny);
+            for (size_t j = 0; j < ny; ++j) {
+                REQUIRE_THAT(ip[j], Catch::Matchers::WithinRel(gt[j], 0.001f));
+            }
+        }
+    }
+
+    SECTION("Test Int8 Distance Compute") {
+        std::uniform_int_distribution<int> int8_distrib(-128, 127);
+        for (int i = 0; i < 1000; ++i) {
+            CAPTURE(i);
+            auto len = distrib(rng) % 1024 + 1;
+            std::vector<int8_t> a(len);
+            std::vector<int8_t> b(len);
+            for (size_t j = 0; j < len; ++j) {
+                a[j] = int8_distrib(rng);
+                b[j] = int8_distrib(rng);
+            }
+            REQUIRE(faiss::int8_vec_inner_product(a.data(), b.data(), len) ==
+                    faiss::int8_vec_inner_product_ref(a.data(), b.data(), len));
+            REQUIRE(faiss::int8_vec_L2sqr(a.data(), b.data(), len) ==
+                    faiss::int8_vec_L2sqr_ref(a.data(), b.data(), len));
+        }
+        for (int i = 0; i < 50; ++i) {
+            CAPTURE(i);
+            auto dim = distrib(rng) % 300 + 1;
+            auto nx = distrib(rng) % 40 + 1;
+            auto ny = distrib(rng) % 50 + 1;
+            std::vector<int8_t> x(nx * dim), y(ny * dim);
+            for (auto& v : x) {
+                v = int8_distrib(rng);
+            }
+            for (auto& v : y) {
+                v = int8_distrib(rng);
+            }
+            std::vector<int32_t> ip(nx * ny), gt(nx * ny);
+            faiss::int8_vec_inner_products_nx_ny(ip.data(), x.data(), y.data(), dim, nx, ny);
+            faiss::int8_vec_inner_products_nx_ny_ref(gt.data(), x.data(), y.data(), dim, nx, ny);
+            REQUIRE(ip == gt);
+        }
+    }
+
+    SECTION("Test Half Distance Compute") {
+        typedef float (*FUNC)(const uint16_t*, const uint16_t*, size_t);
+        typedef uint16_t (*CONV)(float);
+        auto [real_func, gold_func, conv] = GENERATE(table<FUNC, FUNC, CONV>({
+            make_tuple(faiss::fp16_vec_L2sqr, faiss::fp16_vec_L2sqr_ref, knowhere::Fp32ToFp16),
+            make_tuple(faiss::fp16_vec_inner_product, faiss::fp16_vec_inner_product_ref, knowhere::Fp32ToFp16),
+            make_tuple(faiss::bf16_vec_L2sqr, faiss::bf16_vec_L2sqr_ref, knowhere::Fp32ToBf16),
+            make_tuple(faiss::bf16_vec_inner_product, faiss::bf16_vec_inner_product_ref, knowhere::Fp32ToBf16),
+        }));
+        std::uniform_real_distribution<float> half_distrib(-1, 1);
+
+        for (int i = 0; i < 1000; ++i) {
+            CAPTURE(i);
+            auto len = distrib(rng) % 1024 + 1;
+            std::vector<uint16_t> a(len);
+            std::vector<uint16_t> b(len);
+            for (int i = 0; i < len; ++i) {
+                a[i] = conv(half_distrib(rng));
+                b[i] = conv(half_distrib(rng));
+            }
+            REQUIRE_THAT(real_func(a.data(), b.data(), len),
+                         Catch::Matchers::WithinAbs(gold_func(a.data(), b.data(), len), 0.001f));
+        }
+    }
+
+    SECTION("Test Mixed Precision Distance Compute") {
+        typedef float (*FUNC)(const float*, const uint16_t*, size_t);
+        typedef uint16_t (*CONV)(float);
+        auto [real_func, gold_func, conv] = GENERATE(table<FUNC, FUNC, CONV>({
+            make_tuple(faiss::fvec_fp16_L2sqr, faiss::fvec_fp16_L2sqr_ref, knowhere::Fp32ToFp16),
+            make_tuple(faiss::fvec_fp16_inner_product, faiss::fvec_fp16_inner_product_ref, knowhere::Fp32ToFp16),
+            make_tuple(faiss::fvec_bf16_L2sqr, faiss::fvec_bf16_L2sqr_ref, knowhere::Fp32ToBf16),
+            make_tuple(faiss::fvec_bf16_inner_product, faiss::fvec_bf16_inner_product_ref, knowhere::Fp32ToBf16),
+        }));
+        std::uniform_real_distribution<float> half_distrib(-1, 1);
+
+        for (int i = 0; i < 1000; ++i) {
+            CAPTURE(i);
+            auto len = distrib(rng) % 1024 + 1;
+            std::vector<float> a(len);
+            std::vector<uint16_t> b(len);
+            for (int i = 0; i < len; ++i) {
+                a[i] = half_distrib(rng);
+                b[i] = conv(half_distrib(rng));
+            }
+            REQUIRE_THAT(real_func(a.data(), b.data(), len),
+                         Catch::Matchers::WithinAbs(gold_func(a.data(), b.data(), len), 0.001f));
+        }
+    }
+
+    SECTION("Test Half Conversion") {
+        for (int i = 0; i < 1000; ++i) {
+            auto v = fill_distrib(rng) / 1000000.0f;
+            // both formats round to nearest, one ulp is 2^-11 (fp16) and 2^-8 (bf16) of the value
+            REQUIRE_THAT(knowhere::Fp16ToFp32(knowhere::Fp32ToFp16(v)), Catch::Matchers::WithinRel(v, 0.0005f));
+            REQUIRE_THAT(knowhere::Bf16ToFp32(knowhere::Fp32ToBf16(v)), Catch::Matchers::WithinRel(v, 0.004f));
+        }
+        REQUIRE(knowhere::Fp32ToFp16(65504.0f) == 0x7bff);
+        REQUIRE(knowhere::Fp32ToFp16(1e6f) == 0x7c00);
+        REQUIRE(knowhere::Fp16ToFp32(0x0001) == std::ldexp(1.0f, -24));
+        REQUIRE(knowhere::Fp32ToBf16(1.0f) == 0x3f80);
+    }
 }
@@ -55,3 +55,21 @@ TEST_CASE("Knowhere SIMD config", "[simd]") {
     res = knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AUTO);
     REQUIRE(s.find(res) != s.end());
 }
+
+TEST_CASE("Knowhere active kernels", "[simd]") {
+    knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::GENERIC);
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("FLAT", "L2") == "fvec_L2sqr_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("HNSW", "COSINE", "float16") == "fp16_vec_inner_product_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("IVF_FLAT", "IP", "bfloat16") == "sq_get_distance_computer_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("IVF_FLAT_CC", "IP", "bfloat16") == "fvec_inner_product_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("IVF_SQ8", "L2") == "sq_get_distance_computer_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("IVF_PQ", "L2") == "fvec_L2sqr_ny_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("IVF_PQ", "COSINE") == "fvec_inner_products_ny_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("BIN_FLAT", "HAMMING") == "bvec_hamming_ny_ref");
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("FLAT", "IP", "int8").empty());
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("BIN_FLAT", "SUBSTRUCTURE").empty());
+
+    knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AUTO);
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("FLAT", "L2").rfind("fvec_L2sqr_", 0) == 0);
+    REQUIRE(knowhere::KnowhereConfig::GetActiveKernel("IVF_SQ8", "L2").rfind("sq_get_distance_computer_", 0) == 0);
+}
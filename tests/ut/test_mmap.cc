@@ -14,6 +14,9 @@
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
+#include "faiss/IndexIVF.h"
+#include "faiss/index_io.h"
+#include "faiss/invlists/MmapInvertedLists.h"
 #include "faiss/utils/binary_distances.h"
 #include "hnswlib/hnswalg.h"
 #include "knowhere/bitsetview.h"
@@ -149,6 +152,46 @@ TEST_CASE("Search mmap", "[float metrics]") {
         }
     }
 
+    SECTION("Test IVF Mmap Inverted Lists") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto json = gen();
+        json[knowhere::indexparam::MMAP_LIST_CACHE_MB] = 1;
+        CAPTURE(name, json.dump());
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        auto expected = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(expected.has_value());
+
+        reload_from_file(idx, *train_ds, json);
+        auto results = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(results.value()->GetIds()[i] == expected.value()->GetIds()[i]);
+        }
+
+        // the lists of a file loaded with IO_FLAG_MMAP are served from the mapping
+        std::unique_ptr<faiss::Index> loaded(faiss::read_index((kDir / name).c_str(), faiss::IO_FLAG_MMAP));
+        auto ivf = dynamic_cast<faiss::IndexIVF*>(loaded.get());
+        REQUIRE(ivf != nullptr);
+        REQUIRE(dynamic_cast<faiss::MmapInvertedLists*>(ivf->invlists) != nullptr);
+
+        // an index loaded with mmap serializes its lists back in the layout they were read from
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto idx_copy = knowhere::IndexFactory::Instance().Create(name);
+        REQUIRE(idx_copy.Deserialize(bs) == knowhere::Status::success);
+        REQUIRE(idx_copy.Count() == nb);
+        auto copy_results = idx_copy.Search(*query_ds, json, nullptr);
+        REQUIRE(copy_results.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(copy_results.value()->GetIds()[i] == expected.value()->GetIds()[i]);
+        }
+    }
+
     SECTION("Test Range Search") {
         using std::make_tuple;
         auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
@@ -72,7 +72,7 @@ CountValidRangeSearchResult(const std::vector<std::vector<float>>& distances, co
 }
 }  // namespace
 
-TEST_CASE("Test GetRangeSearchResult for HNSW/DiskANN", "[range search]") {
+TEST_CASE("Test RangeSearchResultBuilder for HNSW/DiskANN", "[range search]") {
     const int64_t nq = 10;
     const int64_t label_min = 0, label_max = 10000;
     const float dist_min = 0.0, dist_max = 100.0;
@@ -81,18 +81,22 @@ TEST_CASE("Test GetRangeSearchResult for HNSW/DiskANN", "[range search]") {
 
     GenRangeSearchResult(gen_labels, gen_distances, nq, label_min, label_max, dist_min, dist_max);
 
-    auto GetRangeSearchResult = [](std::vector<std::vector<float>>& result_distances,
-                                   std::vector<std::vector<int64_t>>& result_labels, const bool is_ip, const int64_t nq,
-                                   const float radius, const float range_filter) -> knowhere::DataSetPtr {
+    // the hits of each query are set as these indexes collect them, and filtered by the builder
+    auto GetRangeSearchResult = [](const std::vector<std::vector<float>>& result_distances,
+                                   const std::vector<std::vector<int64_t>>& result_labels, const bool is_ip,
+                                   const int64_t nq, const float radius,
+                                   const float range_filter) -> knowhere::DataSetPtr {
         float* distances;
         int64_t* labels;
         size_t* lims;
+        knowhere::RangeSearchResultBuilder builder(nq, is_ip, radius, range_filter);
         for (auto i = 0; i < nq; i++) {
-            knowhere::FilterRangeSearchResultForOneNq(result_distances[i], result_labels[i], is_ip, radius,
-                                                      range_filter);
+            builder.SetResult(i, result_distances[i].size(), [&](float* o_distances, int64_t* o_labels) {
+                std::copy(result_distances[i].begin(), result_distances[i].end(), o_distances);
+                std::copy(result_labels[i].begin(), result_labels[i].end(), o_labels);
+            });
         }
-        knowhere::GetRangeSearchResult(result_distances, result_labels, is_ip, nq, radius, range_filter, distances,
-                                       labels, lims);
+        builder.Assemble(distances, labels, lims);
         return knowhere::GenResultDataSet(nq, labels, distances, lims);
     };
 
@@ -106,9 +110,7 @@ TEST_CASE("Test GetRangeSearchResult for HNSW/DiskANN", "[range search]") {
         for (bool is_ip : {true, false}) {
             float radius = is_ip ? std::get<0>(item) : std::get<1>(item);
             float range_filter = is_ip ? std::get<1>(item) : std::get<0>(item);
-            std::vector<std::vector<int64_t>> bak_labels = gen_labels;
-            std::vector<std::vector<float>> bak_distances = gen_distances;
-            auto result = GetRangeSearchResult(bak_distances, bak_labels, is_ip, nq, radius, range_filter);
+            auto result = GetRangeSearchResult(gen_distances, gen_labels, is_ip, nq, radius, range_filter);
             REQUIRE(result->GetLims()[nq] == CountValidRangeSearchResult(gen_distances, radius, range_filter, is_ip));
         }
     }
@@ -186,3 +188,68 @@ TEST_CASE("Test GetRangeSearchResult for Faiss", "[range search]") {
         }
     }
 }
+
+TEST_CASE("Test RangeSearchResultBuilder", "[range search]") {
+    const int64_t nq = 10;
+    const int64_t label_min = 0, label_max = 10000;
+    const float dist_min = 0.0, dist_max = 100.0;
+    std::vector<std::vector<int64_t>> gen_labels;
+    std::vector<std::vector<float>> gen_distances;
+    GenRangeSearchResult(gen_labels, gen_distances, nq, label_min, label_max, dist_min, dist_max);
+
+    auto build = [&](const bool is_ip, const float radius, const float range_filter, const int64_t range_search_k) {
+        float* distances;
+        int64_t* labels;
+        size_t* lims;
+        knowhere::RangeSearchResultBuilder builder(nq, is_ip, radius, range_filter, range_search_k);
+        for (int64_t i = 0; i < nq; i++) {
+            if (i % 2 == 0) {
+                // single query faiss results hand over their buffers
+                faiss::RangeSearchResult res(1);
+                res.lims[0] = gen_distances[i].size();
+                res.do_allocation();
+                std::copy(gen_distances[i].begin(), gen_distances[i].end(), res.distances);
+                std::copy(gen_labels[i].begin(), gen_labels[i].end(), res.labels);
+                builder.SetResult(i, res);
+                REQUIRE(res.distances == nullptr);
+            } else {
+                builder.SetResult(i, gen_distances[i].size(), [&](float* o_distances, int64_t* o_labels) {
+                    std::copy(gen_distances[i].begin(), gen_distances[i].end(), o_distances);
+                    std::copy(gen_labels[i].begin(), gen_labels[i].end(), o_labels);
+                });
+            }
+        }
+        builder.Assemble(distances, labels, lims);
+        return knowhere::GenResultDataSet(nq, labels, distances, lims);
+    };
+
+    for (bool is_ip : {true, false}) {
+        float radius = is_ip ? 0.0 : 50.0;
+        float range_filter = is_ip ? 50.0 : 0.0;
+        auto result = build(is_ip, radius, range_filter, -1);
+        REQUIRE(result->GetLims()[nq] == CountValidRangeSearchResult(gen_distances, radius, range_filter, is_ip));
+        for (size_t j = 0; j < result->GetLims()[nq]; j++) {
+            REQUIRE(knowhere::distance_in_range(result->GetDistance()[j], radius, range_filter, is_ip));
+        }
+
+        // keep only the 3 closest hits of each query
+        const int64_t range_search_k = 3;
+        auto capped = build(is_ip, radius, range_filter, range_search_k);
+        auto lims = capped->GetLims();
+        for (int64_t i = 0; i < nq; i++) {
+            auto hits = gen_distances[i];
+            std::vector<float> valid;
+            std::copy_if(hits.begin(), hits.end(), std::back_inserter(valid),
+                         [&](float d) { return knowhere::distance_in_range(d, radius, range_filter, is_ip); });
+            std::sort(valid.begin(), valid.end());
+            if (is_ip) {
+                std::reverse(valid.begin(), valid.end());
+            }
+            valid.resize(std::min<size_t>(valid.size(), range_search_k));
+            std::vector<float> got(capped->GetDistance() + lims[i], capped->GetDistance() + lims[i + 1]);
+            std::sort(got.begin(), got.end());
+            std::sort(valid.begin(), valid.end());
+            REQUIRE(got == valid);
+        }
+    }
+}
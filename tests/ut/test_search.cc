@@ -9,15 +9,28 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <filesystem>
+#include <fstream>
+
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
+#include "common/range_util.h"
+#include "faiss/IndexFlat.h"
+#include "faiss/index_io.h"
 #include "faiss/utils/binary_distances.h"
 #include "hnswlib/hnswalg.h"
+#include "io/FaissIO.h"
 #include "knowhere/bitsetview.h"
 #include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/huge_page.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/knowhere_config.h"
+#include "knowhere/comp/result_cache.h"
+#include "knowhere/comp/segment_group.h"
+#include "knowhere/comp/shared_centroids.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/dataset_reader.h"
 #include "knowhere/factory.h"
 #include "knowhere/log.h"
 #include "utils.h"
@@ -169,6 +182,366 @@ TEST_CASE("Test Mem Index With Float Vector", "[float metrics]") {
         }
     }
 
+    SECTION("Test HNSW Range Search Options") {
+        auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        auto json = hnsw_gen();
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        const bool is_ip = knowhere::IsMetricType(metric, knowhere::metric::COSINE);
+        const float range_filter = json[knowhere::meta::RANGE_FILTER];
+
+        // a radius per query, half of the queries get a tighter one
+        std::vector<float> radii(nq);
+        for (int64_t i = 0; i < nq; ++i) {
+            const float radius = json[knowhere::meta::RADIUS];
+            radii[i] = i % 2 ? radius : (is_ip ? (radius + 1.0f) / 2 : radius / 2);
+        }
+        auto radii_ds = knowhere::GenDataSet(nq, dim, query_ds->GetTensor());
+        radii_ds->SetRadii(radii.data());
+        auto results = idx.RangeSearch(*radii_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        auto ids = results.value()->GetIds();
+        auto dist = results.value()->GetDistance();
+        auto lims = results.value()->GetLims();
+        for (int64_t i = 0; i < nq; ++i) {
+            CHECK(std::find(ids + lims[i], ids + lims[i + 1], i) != ids + lims[i + 1]);
+            for (size_t j = lims[i]; j < lims[i + 1]; ++j) {
+                REQUIRE(knowhere::distance_in_range(dist[j], radii[i], range_filter, is_ip));
+            }
+        }
+
+        // at most range_search_k hits per query, the closest one included
+        auto capped_json = json;
+        capped_json[knowhere::meta::RANGE_SEARCH_K] = 3;
+        results = idx.RangeSearch(*query_ds, capped_json, nullptr);
+        REQUIRE(results.has_value());
+        ids = results.value()->GetIds();
+        lims = results.value()->GetLims();
+        for (int64_t i = 0; i < nq; ++i) {
+            REQUIRE(lims[i + 1] - lims[i] <= 3);
+            CHECK(std::find(ids + lims[i], ids + lims[i + 1], i) != ids + lims[i + 1]);
+        }
+
+        auto adaptive_json = json;
+        adaptive_json[knowhere::indexparam::RANGE_ADAPTIVE_EF] = true;
+        results = idx.RangeSearch(*query_ds, adaptive_json, nullptr);
+        REQUIRE(results.has_value());
+        auto range_gt = knowhere::BruteForce::RangeSearch(train_ds, query_ds, json, nullptr);
+        REQUIRE(range_gt.has_value());
+        REQUIRE(GetRangeSearchRecall(*range_gt.value(), *results.value()) > kKnnRecallThreshold);
+    }
+
+    SECTION("Test Ann Iterator") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto json = gen();
+        CAPTURE(name, json.dump());
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        const bool is_ip = knowhere::IsMetricType(metric, knowhere::metric::COSINE);
+
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto bf_gt = knowhere::BruteForce::Search(train_ds, query_ds, json, bitset);
+        REQUIRE(bf_gt.has_value());
+
+        // the first topk results of each iterator are a regular top k, the rest keeps coming without repeats
+        auto check_iterators = [&](const std::vector<knowhere::IndexNode::IteratorPtr>& iterators, bool exact) {
+            REQUIRE(iterators.size() == (size_t)nq);
+            auto ids = new int64_t[nq * topk];
+            auto dist = new float[nq * topk];
+            for (int64_t i = 0; i < nq; ++i) {
+                std::unordered_set<int64_t> seen;
+                float prev = is_ip ? std::numeric_limits<float>::max() : std::numeric_limits<float>::lowest();
+                while (iterators[i]->HasNext()) {
+                    auto [id, d] = iterators[i]->Next();
+                    REQUIRE(id >= 0);
+                    REQUIRE(!bitset.test(id));
+                    REQUIRE(seen.insert(id).second);
+                    if (seen.size() <= (size_t)topk) {
+                        ids[i * topk + seen.size() - 1] = id;
+                        dist[i * topk + seen.size() - 1] = d;
+                    }
+                    if (exact) {
+                        REQUIRE((is_ip ? d <= prev + 1e-5f : d >= prev - 1e-5f));
+                        prev = d;
+                    }
+                }
+                REQUIRE(seen.size() >= (size_t)topk);
+                REQUIRE(seen.size() <= (size_t)(nb - bitset.count()));
+                if (exact) {
+                    REQUIRE(seen.size() == (size_t)(nb - bitset.count()));
+                }
+            }
+            auto first_k = knowhere::GenResultDataSet(nq, topk, ids, dist);
+            return GetKNNRecall(*bf_gt.value(), *first_k);
+        };
+
+        auto iterators = idx.AnnIterator(*query_ds, json, bitset);
+        REQUIRE(iterators.has_value());
+        REQUIRE(check_iterators(iterators.value(), false) >= kKnnRecallThreshold);
+
+        auto bf_iterators = knowhere::BruteForce::AnnIterator(train_ds, query_ds, json, bitset);
+        REQUIRE(bf_iterators.has_value());
+        REQUIRE(check_iterators(bf_iterators.value(), true) >= kBruteForceRecallThreshold);
+    }
+
+    SECTION("Test Segment Group Search") {
+        // the base split into segments of FLAT indexes, merged results must match a search of the whole base
+        const int64_t num_segments = 5, segment_rows = nb / num_segments;
+        auto json = flat_gen();
+        std::vector<knowhere::Index<knowhere::IndexNode>> segments;
+        std::vector<int64_t> id_offsets;
+        for (int64_t s = 0; s < num_segments; ++s) {
+            auto segment_ds =
+                knowhere::GenDataSet(segment_rows, dim, (const float*)train_ds->GetTensor() + s * segment_rows * dim);
+            auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+            REQUIRE(idx.Build(*segment_ds, json) == knowhere::Status::success);
+            segments.push_back(idx);
+            id_offsets.push_back(s * segment_rows);
+        }
+        knowhere::SegmentGroup group(segments, id_offsets);
+        REQUIRE(group.Size() == (size_t)num_segments);
+
+        auto results = group.Search(*query_ds, json);
+        REQUIRE(results.has_value());
+        REQUIRE(results.value()->GetDim() == topk);
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= kBruteForceRecallThreshold);
+
+        // searched from a task of the search thread pool, the segment searches run there without deadlocking
+        knowhere::DataSetPtr pooled;
+        knowhere::ThreadPool::GetGlobalSearchThreadPool()
+            ->push([&] {
+                auto res = group.Search(*query_ds, json);
+                if (res.has_value()) {
+                    pooled = res.value();
+                }
+            })
+            .wait();
+        REQUIRE(pooled != nullptr);
+        for (int64_t i = 0; i < nq * topk; ++i) {
+            REQUIRE(pooled->GetIds()[i] == results.value()->GetIds()[i]);
+        }
+
+        // a k-th distance bound keeps the results closer than it
+        auto knn_bounds = std::make_unique<float[]>(nq);
+        for (int64_t i = 0; i < nq; ++i) {
+            knn_bounds[i] = gt.value()->GetDistance()[i * topk + 2];
+        }
+        auto bounded_ds = knowhere::GenDataSet(nq, dim, query_ds->GetTensor());
+        bounded_ds->SetKnnBounds(knn_bounds.get());
+        auto whole = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+        REQUIRE(whole.Build(*train_ds, json) == knowhere::Status::success);
+        auto bounded = whole.Search(*bounded_ds, json, nullptr);
+        REQUIRE(bounded.has_value());
+        for (int64_t i = 0; i < nq; ++i) {
+            for (int64_t j = 0; j < topk; ++j) {
+                REQUIRE(bounded.value()->GetIds()[i * topk + j] == (j < 2 ? gt.value()->GetIds()[i * topk + j] : -1));
+            }
+        }
+
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        std::vector<knowhere::BitsetView> bitsets;
+        for (int64_t s = 0; s < num_segments; ++s) {
+            bitsets.emplace_back(bitset_data.data() + s * segment_rows / 8, segment_rows);
+        }
+        results = group.Search(*query_ds, json, bitsets);
+        REQUIRE(results.has_value());
+        auto filtered_gt = knowhere::BruteForce::Search(train_ds, query_ds, json, bitset);
+        REQUIRE(GetKNNRecall(*filtered_gt.value(), *results.value()) >= kBruteForceRecallThreshold);
+        for (int64_t i = 0; i < nq * topk; ++i) {
+            REQUIRE(!bitset.test(results.value()->GetIds()[i]));
+        }
+    }
+
+    SECTION("Test Search Result Cache") {
+        auto json = flat_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        auto uncached = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(uncached.has_value());
+
+        knowhere::KnowhereConfig::SetSearchResultCache(1 << 20);
+        auto require_same_ids = [&](const knowhere::DataSetPtr& a, const knowhere::DataSetPtr& b) {
+            REQUIRE(a->GetRows() == b->GetRows());
+            for (int64_t i = 0; i < a->GetRows() * topk; ++i) {
+                REQUIRE(a->GetIds()[i] == b->GetIds()[i]);
+            }
+        };
+        auto& cache = knowhere::SearchResultCache::Instance();
+        // the second search is answered from the cache
+        for (int round = 0; round < 2; ++round) {
+            auto hits = cache.Hits();
+            auto results = idx.Search(*query_ds, json, nullptr);
+            REQUIRE(results.has_value());
+            require_same_ids(results.value(), uncached.value());
+            REQUIRE(cache.Hits() - hits == static_cast<uint64_t>(round == 0 ? 0 : nq));
+        }
+        // a bitset is part of the key
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto hits = cache.Hits();
+        auto filtered = idx.Search(*query_ds, json, bitset);
+        REQUIRE(filtered.has_value());
+        REQUIRE(cache.Hits() == hits);
+        for (int64_t i = 0; i < nq * topk; ++i) {
+            REQUIRE(!bitset.test(filtered.value()->GetIds()[i]));
+        }
+        // Add renews the index contents, rows added on top of the queries are found
+        REQUIRE(idx.Add(*query_ds, json) == knowhere::Status::success);
+        auto added = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(added.has_value());
+        REQUIRE(cache.Hits() == hits);
+        for (int64_t i = 0; i < nq; ++i) {
+            REQUIRE(added.value()->GetIds()[i * topk] == nb + i);
+        }
+        // a traced search also returns its visits, which the cache doesn't keep
+        auto hnsw = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        REQUIRE(hnsw.Build(*train_ds, hnsw_gen()) == knowhere::Status::success);
+        auto trace_json = hnsw_gen();
+        trace_json[knowhere::meta::TRACE_VISIT] = true;
+        auto one_query = knowhere::GenDataSet(1, dim, query_ds->GetTensor());
+        for (int round = 0; round < 2; ++round) {
+            auto traced = hnsw.Search(*one_query, trace_json, nullptr);
+            REQUIRE(traced.has_value());
+            REQUIRE(!traced.value()->GetJsonInfo().empty());
+        }
+        knowhere::KnowhereConfig::SetSearchResultCache(0);
+    }
+
+    SECTION("Test Calibrate") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        CAPTURE(name);
+        const float target_recall = 0.9f;
+        auto json = gen();
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        knowhere::Json target_json = base_gen();
+        target_json[knowhere::meta::TARGET_RECALL] = target_recall;
+        auto uncalibrated = idx.Search(*query_ds, target_json, nullptr);
+        REQUIRE(!uncalibrated.has_value());
+        REQUIRE(uncalibrated.error() == knowhere::Status::invalid_args);
+
+        // IVF_PQ keeps no raw data, its ground truth is computed on the given base, and its codes cap its recall: it
+        // is calibrated for a share of the recall it reaches probing every list
+        const bool is_pq = name == knowhere::IndexEnum::INDEX_FAISS_IVFPQ;
+        const knowhere::DataSet* base = is_pq ? train_ds.get() : nullptr;
+        float target = target_recall;
+        if (is_pq) {
+            auto all_lists_json = json;
+            all_lists_json[knowhere::indexparam::NPROBE] = 16;
+            auto all_lists = idx.Search(*query_ds, all_lists_json, nullptr);
+            REQUIRE(all_lists.has_value());
+            target = 0.9f * GetKNNRecall(*gt.value(), *all_lists.value());
+            REQUIRE(target > 0.0f);
+            target_json[knowhere::meta::TARGET_RECALL] = target;
+        }
+        REQUIRE(idx.Calibrate(*query_ds, target, json, base) == knowhere::Status::success);
+        auto results = idx.Search(*query_ds, target_json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= target);
+
+        // a target above every measured recall is refused rather than served at the widest measured width, IVF_PQ
+        // can't reach 1 at any width
+        if (is_pq) {
+            knowhere::Json above_json = base_gen();
+            above_json[knowhere::meta::TARGET_RECALL] = 1.0f;
+            auto above = idx.Search(*query_ds, above_json, nullptr);
+            REQUIRE(!above.has_value());
+            REQUIRE(above.error() == knowhere::Status::invalid_args);
+        }
+
+        // the recall curve is serialized with the index
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        REQUIRE(bs.Contains(knowhere::calibration::RECALL_CURVE));
+        if (name == knowhere::IndexEnum::INDEX_FAISS_IVFFLAT) {
+            knowhere::BinaryPtr bptr = std::make_shared<knowhere::Binary>();
+            bptr->data = std::shared_ptr<uint8_t[]>((uint8_t*)train_ds->GetTensor(), [&](uint8_t*) {});
+            bptr->size = dim * nb * sizeof(float);
+            bs.Append("RAW_DATA", bptr);
+        }
+        auto idx_new = knowhere::IndexFactory::Instance().Create(name);
+        REQUIRE(idx_new.Deserialize(bs, json) == knowhere::Status::success);
+        auto loaded = idx_new.Search(*query_ds, target_json, nullptr);
+        REQUIRE(loaded.has_value());
+        for (int64_t i = 0; i < nq * topk; ++i) {
+            REQUIRE(results.value()->GetIds()[i] == loaded.value()->GetIds()[i]);
+        }
+
+        // an exact index has nothing to calibrate
+        auto flat = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+        REQUIRE(flat.Build(*train_ds, flat_gen()) == knowhere::Status::success);
+        REQUIRE(flat.Calibrate(*query_ds, target_recall, flat_gen()) == knowhere::Status::invalid_args);
+    }
+
+    SECTION("Test Shared Centroids") {
+        // two IVF_FLAT segments built on centroids trained once for the whole base
+        const std::string centroids_name = "test_shared_centroids";
+        REQUIRE(knowhere::SharedCentroids::Train(centroids_name, *train_ds, 16, metric) == knowhere::Status::success);
+        // a live name is not replaced
+        REQUIRE(knowhere::SharedCentroids::Train(centroids_name, *train_ds, 16, metric) ==
+                knowhere::Status::invalid_args);
+        auto json = ivfflat_gen();
+        json[knowhere::indexparam::SHARED_CENTROIDS] = centroids_name;
+        const int64_t segment_rows = nb / 2;
+        std::vector<knowhere::Index<knowhere::IndexNode>> segments;
+        for (int64_t s = 0; s < 2; ++s) {
+            auto segment_ds =
+                knowhere::GenDataSet(segment_rows, dim, (const float*)train_ds->GetTensor() + s * segment_rows * dim);
+            auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT);
+            REQUIRE(idx.Build(*segment_ds, json) == knowhere::Status::success);
+            segments.push_back(idx);
+        }
+        knowhere::SegmentGroup group(segments, {0, segment_rows});
+        auto results = group.Search(*query_ds, json);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= kKnnRecallThreshold);
+
+        // only the name of the centroids is serialized, the binset finds them again
+        knowhere::BinarySet bs;
+        REQUIRE(segments[0].Serialize(bs) == knowhere::Status::success);
+        REQUIRE(bs.Contains("SHARED_CENTROIDS"));
+        auto load_json = ivfflat_gen();
+        auto idx_new = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT);
+        REQUIRE(idx_new.Deserialize(bs, load_json) == knowhere::Status::success);
+        auto expected = segments[0].Search(*query_ds, json, nullptr);
+        auto loaded = idx_new.Search(*query_ds, load_json, nullptr);
+        REQUIRE(expected.has_value());
+        REQUIRE(loaded.has_value());
+        for (int64_t i = 0; i < nq * topk; ++i) {
+            REQUIRE(expected.value()->GetIds()[i] == loaded.value()->GetIds()[i]);
+        }
+
+        auto centroids = knowhere::SharedCentroids::Get(centroids_name);
+        REQUIRE(centroids.has_value());
+        REQUIRE(knowhere::SharedCentroids::Unregister(centroids_name) == knowhere::Status::success);
+        auto idx_unregistered = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT);
+        REQUIRE(idx_unregistered.Deserialize(bs, load_json) == knowhere::Status::invalid_args);
+
+        // other centroids registered under the name do not load the binset
+        auto other = CopyDataSet(centroids.value(), centroids.value()->GetRows());
+        const_cast<float*>((const float*)other->GetTensor())[0] += 1.0f;
+        REQUIRE(knowhere::SharedCentroids::Register(centroids_name, *other, metric) == knowhere::Status::success);
+        auto idx_other = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT);
+        REQUIRE(idx_other.Deserialize(bs, load_json) == knowhere::Status::invalid_args);
+        REQUIRE(knowhere::SharedCentroids::Unregister(centroids_name) == knowhere::Status::success);
+        REQUIRE(knowhere::SharedCentroids::Register(centroids_name, *centroids.value(), metric) ==
+                knowhere::Status::success);
+        auto idx_same = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT);
+        REQUIRE(idx_same.Deserialize(bs, load_json) == knowhere::Status::success);
+        REQUIRE(knowhere::SharedCentroids::Unregister(centroids_name) == knowhere::Status::success);
+    }
+
     SECTION("Test Search with Bitset") {
         using std::make_tuple;
         auto [name, gen, threshold] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>, float>({
@@ -200,6 +573,289 @@ TEST_CASE("Test Mem Index With Float Vector", "[float metrics]") {
         }
     }
 
+    SECTION("Test Search with Filter Strategy") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        if (name == knowhere::IndexEnum::INDEX_FAISS_IVFFLAT) {
+            load_raw_data(idx, *train_ds, json);
+        }
+
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, 0.4f * nb);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto gt = knowhere::BruteForce::Search(train_ds, query_ds, json, bitset);
+
+        json[knowhere::meta::FILTER_STRATEGY] = "unknown";
+        REQUIRE(idx.Search(*query_ds, json, bitset).error() == knowhere::Status::invalid_args);
+
+        const auto strategies = {"auto", "filter", "expanded_search", "brute_force"};
+        for (const auto& strategy : strategies) {
+            CAPTURE(strategy);
+            json[knowhere::meta::FILTER_STRATEGY] = strategy;
+            auto results = idx.Search(*query_ds, json, bitset);
+            REQUIRE(results.has_value());
+            float recall = GetKNNRecall(*gt.value(), *results.value());
+            if (std::string(strategy) == "brute_force") {
+                REQUIRE(recall > kBruteForceRecallThreshold);
+                for (int64_t i = 0; i < nq * topk; ++i) {
+                    auto id = results.value()->GetIds()[i];
+                    REQUIRE((id == -1 || !bitset.test(id)));
+                }
+            } else {
+                REQUIRE(recall > kKnnRecallThreshold);
+            }
+        }
+    }
+
+    SECTION("Test Search with Early Abandon") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, ivfflatcc_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto json = gen();
+        REQUIRE(idx.Build(*train_ds, json) == knowhere::Status::success);
+        auto results = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        json[knowhere::meta::EARLY_ABANDON] = true;
+        CAPTURE(name, json.dump());
+        auto abandoned = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(abandoned.has_value());
+        // abandoned distances only lose to the k-th best, so the top k is unchanged
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(abandoned.value()->GetIds()[i] == results.value()->GetIds()[i]);
+            REQUIRE(abandoned.value()->GetDistance()[i] == Approx(results.value()->GetDistance()[i]));
+        }
+
+        auto bf_conf = conf;
+        bf_conf[knowhere::meta::EARLY_ABANDON] = true;
+        auto bf = knowhere::BruteForce::Search(train_ds, query_ds, bf_conf, nullptr);
+        REQUIRE(bf.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(bf.value()->GetIds()[i] == gt.value()->GetIds()[i]);
+        }
+    }
+
+    SECTION("Test HNSW Graph Reorder") {
+        auto json = hnsw_gen();
+        json[knowhere::indexparam::GRAPH_REORDER] = true;
+        auto idx_reorder = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        REQUIRE(idx_reorder.Build(*train_ds, json) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(idx_reorder.Serialize(bs) == knowhere::Status::success);
+        auto idx_loaded = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        REQUIRE(idx_loaded.Deserialize(bs) == knowhere::Status::success);
+
+        // results are reported in the labels given at build time, and the label map survives serialization
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, 0.2f * nb);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        for (auto view : {knowhere::BitsetView(), bitset}) {
+            auto gt = knowhere::BruteForce::Search(train_ds, query_ds, json, view);
+            auto results = idx_reorder.Search(*query_ds, json, view);
+            REQUIRE(results.has_value());
+            REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+            auto loaded_results = idx_loaded.Search(*query_ds, json, view);
+            REQUIRE(loaded_results.has_value());
+            auto ids = results.value()->GetIds();
+            auto loaded_ids = loaded_results.value()->GetIds();
+            for (int64_t i = 0; i < nq * topk; i++) {
+                REQUIRE(ids[i] == loaded_ids[i]);
+                REQUIRE(ids[i] >= 0);
+                REQUIRE((view.empty() || !view.test(ids[i])));
+            }
+        }
+
+        // range search reports labels too, every query is a row of the base
+        auto range_gt = knowhere::BruteForce::RangeSearch(train_ds, query_ds, json, nullptr);
+        REQUIRE(range_gt.has_value());
+        auto range_results = idx_loaded.RangeSearch(*query_ds, json, nullptr);
+        REQUIRE(range_results.has_value());
+        REQUIRE(GetRangeSearchRecall(*range_gt.value(), *range_results.value()) > kKnnRecallThreshold);
+        auto range_ids = range_results.value()->GetIds();
+        auto lims = range_results.value()->GetLims();
+        for (int64_t i = 0; i < nq; ++i) {
+            CHECK(std::find(range_ids + lims[i], range_ids + lims[i + 1], i) != range_ids + lims[i + 1]);
+        }
+
+        // hits found by expanding the neighbours of the first ones are labels too, each with the distance of its row
+        for (auto view : {knowhere::BitsetView(), bitset}) {
+            auto filtered_gt = knowhere::BruteForce::RangeSearch(train_ds, query_ds, json, view);
+            REQUIRE(filtered_gt.has_value());
+            auto gt_ids = filtered_gt.value()->GetIds();
+            auto gt_dis = filtered_gt.value()->GetDistance();
+            auto gt_lims = filtered_gt.value()->GetLims();
+            for (auto index : {&idx_reorder, &idx_loaded}) {
+                auto hits = index->RangeSearch(*query_ds, json, view);
+                REQUIRE(hits.has_value());
+                auto hit_ids = hits.value()->GetIds();
+                auto hit_dis = hits.value()->GetDistance();
+                auto hit_lims = hits.value()->GetLims();
+                for (int64_t i = 0; i < nq; ++i) {
+                    for (auto j = hit_lims[i]; j < hit_lims[i + 1]; ++j) {
+                        auto it = std::find(gt_ids + gt_lims[i], gt_ids + gt_lims[i + 1], hit_ids[j]);
+                        REQUIRE(it != gt_ids + gt_lims[i + 1]);
+                        REQUIRE(hit_dis[j] == Approx(gt_dis[it - gt_ids]).epsilon(1e-4));
+                    }
+                }
+            }
+        }
+
+        std::vector<int64_t> ids = {0, 1, nb / 2, nb - 1};
+        auto ids_ds = GenIdsDataSet(ids.size(), ids);
+        auto vectors = idx_loaded.GetVectorByIds(*ids_ds);
+        REQUIRE(vectors.has_value());
+        auto res = (const float*)vectors.value()->GetTensor();
+        auto xb = (const float*)train_ds->GetTensor();
+        for (size_t i = 0; i < ids.size(); i++) {
+            for (int64_t j = 0; j < dim; j++) {
+                REQUIRE(res[i * dim + j] == xb[ids[i] * dim + j]);
+            }
+        }
+
+        // an index without a label map still loads when unknown data follows the link lists
+        auto idx_plain = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        REQUIRE(idx_plain.Build(*train_ds, hnsw_gen()) == knowhere::Status::success);
+        knowhere::BinarySet plain_bs;
+        REQUIRE(idx_plain.Serialize(plain_bs) == knowhere::Status::success);
+        auto plain = plain_bs.GetByName(idx_plain.Type());
+        std::vector<uint8_t> padded(plain->data.get(), plain->data.get() + plain->size);
+        padded.resize(plain->size + sizeof(uint64_t) + nb * sizeof(int64_t), 0xab);
+        std::shared_ptr<uint8_t[]> padded_data(new uint8_t[padded.size()]);
+        std::copy(padded.begin(), padded.end(), padded_data.get());
+        knowhere::BinarySet padded_bs;
+        padded_bs.Append(idx_plain.Type(), padded_data, padded.size());
+        auto idx_padded = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        REQUIRE(idx_padded.Deserialize(padded_bs) == knowhere::Status::success);
+        auto plain_results = idx_plain.Search(*query_ds, json, nullptr);
+        auto padded_results = idx_padded.Search(*query_ds, json, nullptr);
+        REQUIRE(plain_results.has_value());
+        REQUIRE(padded_results.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(plain_results.value()->GetIds()[i] == padded_results.value()->GetIds()[i]);
+        }
+    }
+
+    SECTION("Test HNSW Neighbor Batches") {
+        // the neighbors of a hop are gathered into a buffer kept with the visited list of the thread, searches of
+        // graphs of different degrees are interleaved. An ef covering every row makes the search exhaustive.
+        auto json_small = hnsw_gen();
+        json_small[knowhere::indexparam::HNSW_M] = 16;
+        json_small[knowhere::indexparam::EF] = nb;
+        auto json_large = hnsw_gen();
+        json_large[knowhere::indexparam::EF] = nb;
+        auto idx_small = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        auto idx_large = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_HNSW);
+        REQUIRE(idx_small.Build(*train_ds, json_small) == knowhere::Status::success);
+        REQUIRE(idx_large.Build(*train_ds, json_large) == knowhere::Status::success);
+        for (int round = 0; round < 3; round++) {
+            auto small_results = idx_small.Search(*query_ds, json_small, nullptr);
+            auto large_results = idx_large.Search(*query_ds, json_large, nullptr);
+            REQUIRE(small_results.has_value());
+            REQUIRE(large_results.has_value());
+            REQUIRE(GetKNNRecall(*gt.value(), *small_results.value()) == Approx(1.0f));
+            REQUIRE(GetKNNRecall(*gt.value(), *large_results.value()) == Approx(1.0f));
+        }
+    }
+
+    SECTION("Test IVF Contiguous Lists") {
+        // lists of more than a huge page are moved into one buffer on load, results, the serialized binary and Add
+        // stay the same
+        const int64_t large_nb = 4 * knowhere::kHugePageSize / dim;
+        auto large_ds = GenDataSet(large_nb, dim);
+        auto json = ivfsq_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8);
+        REQUIRE(idx.Build(*large_ds, json) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto idx_loaded = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8);
+        REQUIRE(idx_loaded.Deserialize(bs) == knowhere::Status::success);
+
+        auto results = idx.Search(*query_ds, json, nullptr);
+        auto loaded_results = idx_loaded.Search(*query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(loaded_results.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(results.value()->GetIds()[i] == loaded_results.value()->GetIds()[i]);
+        }
+
+        knowhere::BinarySet loaded_bs;
+        REQUIRE(idx_loaded.Serialize(loaded_bs) == knowhere::Status::success);
+        auto binary = bs.GetByName(idx.Type());
+        auto loaded_binary = loaded_bs.GetByName(idx.Type());
+        REQUIRE(binary->size == loaded_binary->size);
+        REQUIRE(std::equal(binary->data.get(), binary->data.get() + binary->size, loaded_binary->data.get()));
+
+        REQUIRE(idx_loaded.Add(*query_ds, json) == knowhere::Status::success);
+        REQUIRE(idx_loaded.Count() == large_nb + nq);
+    }
+
+    SECTION("Test Build From Reader") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, ivfflatcc_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto json = gen();
+        // chunks that do not divide nb, and a training sample smaller than nb. IVF_FLAT arranges the vectors of every
+        // chunk after the ones already added
+        json["build_chunk_rows"] = 300;
+        json["train_sample_rows"] = 600;
+        CAPTURE(name, json.dump());
+        knowhere::MemoryDataSetReader reader(train_ds);
+        REQUIRE(idx.BuildFromReader(reader, json) == knowhere::Status::success);
+        REQUIRE(idx.Count() == nb);
+        auto results = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+
+        auto scann = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_SCANN);
+        REQUIRE(reader.Reset() == knowhere::Status::success);
+        REQUIRE(scann.BuildFromReader(reader, scann_gen()) == knowhere::Status::not_implemented);
+    }
+
+    SECTION("Test Build From Fbin File") {
+        auto path = (std::filesystem::temp_directory_path() / "knowhere_build_from_reader.fbin").string();
+        {
+            std::ofstream out(path, std::ios::binary);
+            int32_t header[2] = {(int32_t)nb, (int32_t)dim};
+            out.write((const char*)header, sizeof(header));
+            out.write((const char*)train_ds->GetTensor(), nb * dim * sizeof(float));
+        }
+        knowhere::FbinDataSetReader reader(path);
+        REQUIRE(reader.Valid());
+        REQUIRE(reader.Rows() == nb);
+        REQUIRE(reader.Dim() == dim);
+        auto json = flat_gen();
+        json["build_chunk_rows"] = 128;
+        auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+        REQUIRE(idx.BuildFromReader(reader, json) == knowhere::Status::success);
+        REQUIRE(idx.Count() == nb);
+        auto results = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kBruteForceRecallThreshold);
+
+        // a truncated file fails the build instead of leaving a partial index
+        std::filesystem::resize_file(path, 2 * sizeof(int32_t) + (nb / 2) * dim * sizeof(float));
+        knowhere::FbinDataSetReader truncated(path);
+        REQUIRE(truncated.Valid());
+        auto idx_truncated = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+        REQUIRE(idx_truncated.BuildFromReader(truncated, json) == knowhere::Status::invalid_args);
+        std::filesystem::remove(path);
+    }
+
     SECTION("Test Serialize/Deserialize") {
         using std::make_tuple;
         auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
@@ -229,6 +885,33 @@ TEST_CASE("Test Mem Index With Float Vector", "[float metrics]") {
         REQUIRE(results.has_value());
     }
 
+    SECTION("Test Add to Legacy COSINE Flat") {
+        if (!knowhere::IsMetricType(metric, knowhere::metric::COSINE)) {
+            return;
+        }
+        // a COSINE FLAT serialized before IndexFlatCosine is an IndexFlatIP of normalized rows
+        faiss::IndexFlatIP legacy(dim);
+        auto normalized = knowhere::CopyAndNormalize(*train_ds);
+        legacy.add(nb, (const float*)normalized->GetTensor());
+        knowhere::MemoryIOWriter writer;
+        faiss::write_index(&legacy, &writer);
+        knowhere::BinarySet bs;
+        bs.Append(knowhere::IndexEnum::INDEX_FAISS_IDMAP, std::shared_ptr<uint8_t[]>(writer.data_), writer.rp);
+
+        auto json = flat_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IDMAP);
+        REQUIRE(idx.Deserialize(bs, json) == knowhere::Status::success);
+        REQUIRE(!idx.HasRawData(metric));
+        // the added rows are not unit vectors, they are normalized like the loaded ones
+        REQUIRE(idx.Add(*query_ds, json) == knowhere::Status::success);
+        auto results = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        for (int64_t i = 0; i < nq; ++i) {
+            REQUIRE(results.value()->GetIds()[i * topk] == nb + i);
+            REQUIRE(results.value()->GetDistance()[i * topk] == Approx(1.0f).epsilon(1e-4));
+        }
+    }
+
     SECTION("Test IVFPQ with invalid params") {
         auto idx = knowhere::IndexFactory::Instance().Create(knowhere::IndexEnum::INDEX_FAISS_IVFPQ);
         uint32_t nb = 1000;
@@ -248,6 +931,130 @@ TEST_CASE("Test Mem Index With Float Vector", "[float metrics]") {
     }
 }
 
+TEST_CASE("Test Mem Index With Half Vector", "[float metrics]") {
+    const int64_t nb = 1000, nq = 10;
+    const int64_t dim = 128;
+    const int64_t topk = 5;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+    auto type = GENERATE(as<knowhere::DataType>{}, knowhere::DataType::kFloat16, knowhere::DataType::kBFloat16);
+
+    auto base_gen = [&]() {
+        knowhere::Json json;
+        json[knowhere::meta::DIM] = dim;
+        json[knowhere::meta::METRIC_TYPE] = metric;
+        json[knowhere::meta::TOPK] = topk;
+        return json;
+    };
+
+    auto flat_gen = base_gen;
+
+    auto ivfflat_gen = [&base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::NLIST] = 16;
+        json[knowhere::indexparam::NPROBE] = 8;
+        return json;
+    };
+
+    auto ivfflatcc_gen = [&base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::NLIST] = 16;
+        json[knowhere::indexparam::NPROBE] = 8;
+        json[knowhere::indexparam::SSIZE] = 48;
+        return json;
+    };
+
+    auto hnsw_gen = [&base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::HNSW_M] = 128;
+        json[knowhere::indexparam::EFCONSTRUCTION] = 200;
+        json[knowhere::indexparam::EF] = 64;
+        return json;
+    };
+
+    // integers in [0, 100] are exact in both fp16 and bf16
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim);
+    const auto half_train_ds = ConvertDataSet(train_ds, type);
+    const auto half_query_ds = ConvertDataSet(query_ds, type);
+
+    const knowhere::Json conf = {
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+    };
+    auto gt = knowhere::BruteForce::Search(train_ds, query_ds, conf, nullptr);
+
+    SECTION("Test Search") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, ivfflatcc_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(*half_train_ds, json) == knowhere::Status::success);
+        REQUIRE(idx.Count() == nb);
+        if (name == knowhere::IndexEnum::INDEX_FAISS_IDMAP) {
+            REQUIRE(idx.Size() == nb * dim * 2);
+        }
+        if (name == knowhere::IndexEnum::INDEX_FAISS_IVFFLAT) {
+            // the rows are kept at 2 bytes per element
+            REQUIRE(idx.Size() < nb * dim * sizeof(float));
+        }
+        auto results = idx.Search(*half_query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+
+        // fp32 queries are accepted by half indexes as well
+        auto float_results = idx.Search(*query_ds, json, nullptr);
+        REQUIRE(float_results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *float_results.value()) > kKnnRecallThreshold);
+    }
+
+    SECTION("Test Serialize/Deserialize and GetVectorByIds") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create(name);
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(*half_train_ds, json) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+
+        auto idx_ = knowhere::IndexFactory::Instance().Create(name);
+        REQUIRE(idx_.Deserialize(bs) == knowhere::Status::success);
+        auto results = idx_.Search(*half_query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+
+        // IVF_FLAT keeps the COSINE rows raw as well
+        if (name == knowhere::IndexEnum::INDEX_FAISS_IVFFLAT) {
+            REQUIRE(idx_.HasRawData(metric));
+        }
+        if (metric == knowhere::metric::L2 || name == knowhere::IndexEnum::INDEX_FAISS_IVFFLAT) {
+            std::vector<int64_t> ids = {0, 10, 999};
+            auto ids_ds = GenIdsDataSet(ids.size(), ids);
+            auto vectors = idx_.GetVectorByIds(*ids_ds);
+            REQUIRE(vectors.has_value());
+            REQUIRE(vectors.value()->GetTensorDataType() == type);
+            auto res = (const uint16_t*)vectors.value()->GetTensor();
+            auto src = (const uint16_t*)half_train_ds->GetTensor();
+            for (size_t i = 0; i < ids.size(); ++i) {
+                REQUIRE(std::equal(res + i * dim, res + (i + 1) * dim, src + ids[i] * dim));
+            }
+        }
+    }
+}
+
 TEST_CASE("Test Mem Index With Binary Vector", "[float metrics]") {
     using Catch::Approx;
 
@@ -9,10 +9,15 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <cstring>
+#include <thread>
 #include <vector>
 
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
+#include "hnswlib/visited_list_pool.h"
+#include "knowhere/comp/filter_strategy.h"
+#include "knowhere/comp/huge_page.h"
 #include "knowhere/comp/time_recorder.h"
 #include "knowhere/heap.h"
 #include "knowhere/utils.h"
@@ -45,6 +50,22 @@ TEST_CASE("Test Vector Normalization", "[normalize]") {
             CHECK(std::abs(1.0f - sum) <= floatDiff);
         }
     }
+
+    SECTION("Test normalize query") {
+        auto query_ds = GenDataSet(10, dim, seed);
+        auto query = (const float*)query_ds->GetTensor();
+        std::vector<float> origin(query, query + 10 * dim);
+        for (size_t i = 0; i < 10; ++i) {
+            auto normalized = knowhere::NormalizeQuery(query + i * dim, dim);
+            float sum = 0.0;
+            for (size_t j = 0; j < dim; ++j) {
+                sum += normalized[j] * normalized[j];
+            }
+            CHECK(std::abs(1.0f - sum) <= floatDiff);
+        }
+        // the query buffer itself is left untouched
+        REQUIRE(std::memcmp(origin.data(), query, origin.size() * sizeof(float)) == 0);
+    }
 }
 
 TEST_CASE("Test Bitset Generation", "[utils]") {
@@ -78,6 +99,85 @@ TEST_CASE("Test Bitset Generation", "[utils]") {
     }
 }
 
+TEST_CASE("Test Bitset Cached Count", "[utils]") {
+    for (const auto size : kBitsetSizes) {
+        for (size_t i = 0; i <= size; ++i) {
+            auto bitset_data = GenerateBitsetWithRandomTbitsSet(size, i);
+            knowhere::BitsetView bitset(bitset_data.data(), size);
+            auto cached = bitset.with_cached_count();
+            REQUIRE(cached.data() == bitset.data());
+            REQUIRE(cached.size() == size);
+            REQUIRE(cached.count() == i);
+            REQUIRE(cached.filter_ratio() == Catch::Approx(static_cast<float>(i) / size));
+        }
+    }
+}
+
+TEST_CASE("Test Filter Strategy Planner", "[utils]") {
+    const size_t nb = 100000;
+    const int64_t ef = 64, degree = 32, nprobe = 16, nlist = 1024;
+    auto plan_graph = [&](knowhere::FilterStrategy requested, size_t filtered) {
+        auto bitset_data = GenerateBitsetWithFirstTbitsSet(nb, filtered);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        return knowhere::PlanGraphFilteredSearch(requested, bitset.with_cached_count(), nb, ef, degree, 0.93f);
+    };
+    auto plan_ivf = [&](knowhere::FilterStrategy requested, size_t filtered) {
+        auto bitset_data = GenerateBitsetWithFirstTbitsSet(nb, filtered);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        return knowhere::PlanIvfFilteredSearch(requested, bitset.with_cached_count(), nb, nprobe, nlist);
+    };
+
+    REQUIRE(knowhere::Str2FilterStrategy("auto") == knowhere::FilterStrategy::kAuto);
+    REQUIRE(knowhere::Str2FilterStrategy("brute_force") == knowhere::FilterStrategy::kBruteForce);
+    REQUIRE(!knowhere::Str2FilterStrategy("unknown").has_value());
+
+    SECTION("graph") {
+        auto plan = knowhere::PlanGraphFilteredSearch(knowhere::FilterStrategy::kAuto, nullptr, nb, ef, degree, 0.93f);
+        REQUIRE(plan.strategy == knowhere::FilterStrategy::kFilter);
+        REQUIRE(plan.search_width == ef);
+
+        REQUIRE(plan_graph(knowhere::FilterStrategy::kAuto, nb / 10).strategy == knowhere::FilterStrategy::kFilter);
+        plan = plan_graph(knowhere::FilterStrategy::kAuto, nb * 7 / 10);
+        REQUIRE(plan.strategy == knowhere::FilterStrategy::kExpandedSearch);
+        REQUIRE(plan.search_width > ef);
+        REQUIRE(plan.search_width <= ef * 8);
+        REQUIRE(plan_graph(knowhere::FilterStrategy::kAuto, nb * 999 / 1000).strategy ==
+                knowhere::FilterStrategy::kBruteForce);
+
+        REQUIRE(plan_graph(knowhere::FilterStrategy::kFilter, nb * 999 / 1000).strategy ==
+                knowhere::FilterStrategy::kFilter);
+        REQUIRE(plan_graph(knowhere::FilterStrategy::kBruteForce, nb / 10).strategy ==
+                knowhere::FilterStrategy::kBruteForce);
+    }
+
+    SECTION("ivf") {
+        REQUIRE(plan_ivf(knowhere::FilterStrategy::kAuto, nb / 10).search_width == nprobe);
+        auto plan = plan_ivf(knowhere::FilterStrategy::kAuto, nb * 7 / 10);
+        REQUIRE(plan.strategy == knowhere::FilterStrategy::kExpandedSearch);
+        REQUIRE(plan.search_width > nprobe);
+        plan = plan_ivf(knowhere::FilterStrategy::kAuto, nb * 999 / 1000);
+        REQUIRE(plan.strategy == knowhere::FilterStrategy::kBruteForce);
+        REQUIRE(plan.search_width == nlist);
+    }
+
+    SECTION("gather unfiltered ids") {
+        // a size that is not a multiple of 64 covers the tail of the bitset
+        const int64_t size = 1000;
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(size, 900);
+        knowhere::BitsetView bitset(bitset_data.data(), size);
+        auto ids = knowhere::GatherUnfilteredIds(bitset, size);
+        REQUIRE(ids.size() == 100);
+        int64_t next = 0;
+        for (auto id : ids) {
+            for (; next < id; ++next) {
+                REQUIRE(bitset.test(next));
+            }
+            REQUIRE(!bitset.test(id));
+            next = id + 1;
+        }
+    }
+}
+
 namespace {
 constexpr size_t kHeapSize = 10;
 constexpr size_t kElementCount = 10000;
@@ -99,6 +199,44 @@ TEST_CASE("ResultMaxHeap") {
     REQUIRE(heap.Size() == 0);
 }
 
+TEST_CASE("Top-k Selectors") {
+    auto pairs = GenerateRandomDistanceIdPair(kElementCount);
+    auto sorted = pairs;
+    std::sort(sorted.begin(), sorted.end());
+
+    // one k per selector, plus k larger than the candidate count
+    for (size_t k : {size_t(1), size_t(16), knowhere::kSortedBufferMaxK, size_t(100), knowhere::kQuickselectMinK,
+                     kElementCount + 5}) {
+        CAPTURE(k);
+        auto res = knowhere::WithTopKSelector<float, size_t>(k, [&](auto& selector) {
+            for (const auto& [dist, id] : pairs) {
+                selector.Push(dist, id);
+            }
+            REQUIRE(selector.Size() == std::min(k, kElementCount));
+            return selector.SortedResults();
+        });
+        REQUIRE(res.size() == std::min(k, kElementCount));
+        for (size_t i = 0; i < res.size(); ++i) {
+            REQUIRE(res[i] == sorted[i]);
+        }
+    }
+
+    std::vector<float> dists;
+    std::vector<size_t> ids;
+    for (const auto& [dist, id] : pairs) {
+        dists.push_back(dist);
+        ids.push_back(id);
+    }
+    knowhere::QuickselectTopK<float, size_t> selector(knowhere::kQuickselectMinK);
+    selector.PushBatch(dists.data(), ids.data(), kElementCount);
+    REQUIRE(selector.Threshold() >= sorted[knowhere::kQuickselectMinK - 1].first);
+    auto res = selector.SortedResults();
+    REQUIRE(res.size() == knowhere::kQuickselectMinK);
+    for (size_t i = 0; i < res.size(); ++i) {
+        REQUIRE(res[i] == sorted[i]);
+    }
+}
+
 TEST_CASE("Test Time Recorder") {
     knowhere::TimeRecorder tr("test", 2);
     int64_t sum = 0;
@@ -108,3 +246,66 @@ TEST_CASE("Test Time Recorder") {
     auto span = tr.ElapseFromBegin("done");
     REQUIRE(span > 0);
 }
+
+TEST_CASE("Test Huge Page Allocation", "[utils]") {
+    const size_t size = 3 * knowhere::kHugePageSize + 100;
+    auto ptr = (char*)knowhere::HugePageAlloc(size);
+    REQUIRE(ptr != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(ptr) % knowhere::kHugePageSize == 0);
+    memset(ptr, 1, size);
+    // the allocation stays compatible with realloc and free
+    ptr = (char*)realloc(ptr, 2 * size);
+    REQUIRE(ptr != nullptr);
+    REQUIRE(ptr[size - 1] == 1);
+    free(ptr);
+
+    // small arrays are not padded to a huge page
+    auto small = knowhere::HugePageAlloc(100);
+    REQUIRE(small != nullptr);
+    free(small);
+
+    // only the huge page aligned interior of a region is advised
+    REQUIRE(knowhere::AdviseHugePages(nullptr, size) == 0);
+    std::vector<char> buf(size);
+    REQUIRE(knowhere::AdviseHugePages(buf.data(), knowhere::kHugePageSize) == 0);
+
+    knowhere::SetHugePageEnabled(false);
+    auto plain = knowhere::HugePageAlloc(size);
+    REQUIRE(plain != nullptr);
+    REQUIRE(knowhere::AdviseHugePages(plain, size) == 0);
+    free(plain);
+    knowhere::SetHugePageEnabled(true);
+}
+
+TEST_CASE("Test Visited List Pool", "[utils]") {
+    const int kNumElements = 1000;
+    hnswlib::VisitedListPool pool(kNumElements);
+
+    // every search must start from an empty set, including across the epoch wraparound
+    for (int round = 0; round < 600; round++) {
+        auto& visited = pool.getFreeVisitedList();
+        for (int i = 0; i < kNumElements; i++) {
+            if (visited.get(i)) {
+                FAIL("element " << i << " still visited in round " << round);
+            }
+        }
+        for (int i = round % 3; i < kNumElements; i += 3) {
+            visited.set(i);
+        }
+        for (int i = 0; i < kNumElements; i++) {
+            REQUIRE(visited.get(i) == (i % 3 == round % 3));
+        }
+    }
+
+    // each thread owns its own list
+    hnswlib::VisitedList* main_list = &pool.getFreeVisitedList();
+    hnswlib::VisitedList* other_list = nullptr;
+    std::thread([&]() { other_list = &pool.getFreeVisitedList(); }).join();
+    REQUIRE(other_list != main_list);
+    REQUIRE(&pool.getFreeVisitedList() == main_list);
+
+    // a second pool does not hand out the first pool's list
+    hnswlib::VisitedListPool pool2(kNumElements);
+    REQUIRE(&pool2.getFreeVisitedList() != main_list);
+    REQUIRE(&pool.getFreeVisitedList() == main_list);
+}
@@ -54,6 +54,19 @@ CopyDataSet(knowhere::DataSetPtr dataset, const int64_t copy_rows) {
     return ds;
 }
 
+// fp16 / bf16 copy of a fp32 dataset
+inline knowhere::DataSetPtr
+ConvertDataSet(knowhere::DataSetPtr dataset, knowhere::DataType type) {
+    auto rows = dataset->GetRows();
+    auto dim = dataset->GetDim();
+    uint8_t* ts = new uint8_t[rows * dim * knowhere::DataTypeSize(type)];
+    knowhere::ConvertFromFloat((const float*)dataset->GetTensor(), type, ts, rows * dim);
+    auto ds = knowhere::GenDataSet(rows, dim, ts);
+    ds->SetTensorDataType(type);
+    ds->SetIsOwner(true);
+    return ds;
+}
+
 inline knowhere::DataSetPtr
 GenBinDataSet(int rows, int dim, int seed = 42) {
     std::mt19937 rng(seed);
@@ -23,6 +23,7 @@
 #include "diskann/aux_utils.h"
 #include "diskann/timer.h"
 #include "diskann/utils.h"
+#include "knowhere/comp/huge_page.h"
 #include "knowhere/heap.h"
 
 #include "knowhere/utils.h"
@@ -559,6 +560,11 @@ namespace diskann {
 
     this->num_points = npts_u64;
     this->n_chunks = nchunks_u64;
+    // compressed vectors are read at random for every candidate, keep them
+    // on huge pages to cut TLB misses
+    if (knowhere::AdviseHugePages(this->data, npts_u64 * nchunks_u64) > 0) {
+      knowhere::UpdateHugePageMetric();
+    }
 
 #ifdef EXEC_ENV_OLS
     pq_table.load_pq_centroid_bin(files, pq_table_bin.c_str(), nchunks_u64);
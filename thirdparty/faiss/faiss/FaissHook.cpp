@@ -32,7 +32,7 @@ void sq_hook() {
         sq_get_distance_computer = sq_get_distance_computer_avx;
         sq_sel_quantizer = sq_select_quantizer_avx;
         sq_sel_inv_list_scanner = sq_select_inverted_list_scanner_avx;
-    } else if (use_sse4_2 && cpu_support_sse4_2()) {
+    } else {
         /* for IVFSQ */
         sq_get_distance_computer = sq_get_distance_computer_ref;
         sq_sel_quantizer = sq_select_quantizer_ref;
@@ -41,4 +41,16 @@ void sq_hook() {
 #endif
 }
 
+std::string sq_active_kernel() {
+#ifdef __x86_64__
+    if (sq_get_distance_computer == sq_get_distance_computer_avx512) {
+        return "sq_get_distance_computer_avx512";
+    }
+    if (sq_get_distance_computer == sq_get_distance_computer_avx) {
+        return "sq_get_distance_computer_avx";
+    }
+#endif
+    return "sq_get_distance_computer_ref";
+}
+
 } // namespace faiss
@@ -30,4 +30,7 @@ extern sq_get_distance_computer_func_ptr sq_get_distance_computer;
 extern sq_sel_quantizer_func_ptr sq_sel_quantizer;
 extern sq_sel_inv_list_scanner_func_ptr sq_sel_inv_list_scanner;
 void sq_hook();
+
+/// name of the SQ distance computer installed by sq_hook
+std::string sq_active_kernel();
 } // namespace faiss
@@ -191,6 +191,90 @@ DistanceComputer* IndexFlat::get_distance_computer() const {
     }
 }
 
+/***************************************************
+ * IndexFlatCosine
+ ***************************************************/
+
+namespace {
+
+struct FlatCosineDis : FlatIPDis {
+    const float* inverse_l2_norms;
+
+    float operator()(idx_t i) override {
+        return FlatIPDis::operator()(i) * inverse_l2_norms[i];
+    }
+
+    float symmetric_dis(idx_t i, idx_t j) override {
+        return FlatIPDis::symmetric_dis(i, j) * inverse_l2_norms[i] *
+                inverse_l2_norms[j];
+    }
+
+    explicit FlatCosineDis(const IndexFlatCosine& storage)
+            : FlatIPDis(storage),
+              inverse_l2_norms(storage.inverse_l2_norms.data()) {}
+};
+
+} // namespace
+
+void IndexFlatCosine::add(idx_t n, const float* x) {
+    FAISS_THROW_IF_NOT(is_trained);
+    inverse_l2_norms.resize(ntotal + n);
+    fvec_inverse_norms_L2(inverse_l2_norms.data() + ntotal, x, d, n);
+    IndexFlat::add(n, x);
+}
+
+void IndexFlatCosine::reset() {
+    IndexFlat::reset();
+    inverse_l2_norms.clear();
+}
+
+size_t IndexFlatCosine::remove_ids(const IDSelector& sel) {
+    idx_t j = 0;
+    for (idx_t i = 0; i < ntotal; i++) {
+        if (!sel.is_member(i)) {
+            inverse_l2_norms[j++] = inverse_l2_norms[i];
+        }
+    }
+    size_t nremove = IndexFlat::remove_ids(sel);
+    inverse_l2_norms.resize(ntotal);
+    return nremove;
+}
+
+void IndexFlatCosine::search(
+        idx_t n,
+        const float* x,
+        idx_t k,
+        float* distances,
+        idx_t* labels,
+        const BitsetView bitset) const {
+    FAISS_THROW_IF_NOT(k > 0);
+    float_minheap_array_t res = {size_t(n), size_t(k), labels, distances};
+    knn_inner_product_scaled(
+            x, get_xb(), inverse_l2_norms.data(), d, n, ntotal, &res, bitset);
+}
+
+void IndexFlatCosine::range_search(
+        idx_t n,
+        const float* x,
+        float radius,
+        RangeSearchResult* result,
+        const BitsetView bitset) const {
+    range_search_inner_product_scaled(
+            x,
+            get_xb(),
+            inverse_l2_norms.data(),
+            d,
+            n,
+            ntotal,
+            radius,
+            result,
+            bitset);
+}
+
+DistanceComputer* IndexFlatCosine::get_distance_computer() const {
+    return new FlatCosineDis(*this);
+}
+
 void IndexFlat::reconstruct(idx_t key, float* recons) const {
     memcpy(recons, &(codes[key * code_size]), code_size);
 }
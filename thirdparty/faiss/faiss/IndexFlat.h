@@ -91,6 +91,40 @@ struct IndexFlatL2 : IndexFlat {
     IndexFlatL2() {}
 };
 
+/** Cosine similarity over the raw vectors. The inverse L2 norm of every
+ * vector is stored next to it and scales its inner product with the query,
+ * which must be normalized by the caller. */
+struct IndexFlatCosine : IndexFlat {
+    /// 1 / |x_i| for every stored vector, size ntotal
+    std::vector<float> inverse_l2_norms;
+
+    explicit IndexFlatCosine(idx_t d) : IndexFlat(d, METRIC_INNER_PRODUCT) {}
+    IndexFlatCosine() {}
+
+    void add(idx_t n, const float* x) override;
+
+    void reset() override;
+
+    size_t remove_ids(const IDSelector& sel) override;
+
+    void search(
+            idx_t n,
+            const float* x,
+            idx_t k,
+            float* distances,
+            idx_t* labels,
+            const BitsetView bitset = nullptr) const override;
+
+    void range_search(
+            idx_t n,
+            const float* x,
+            float radius,
+            RangeSearchResult* result,
+            const BitsetView bitset = nullptr) const override;
+
+    DistanceComputer* get_distance_computer() const override;
+};
+
 /// optimized version for 1D "vectors".
 struct IndexFlat1D : IndexFlatL2 {
     bool continuous_update; ///< is the permutation updated continuously?
@@ -22,6 +22,7 @@
 #include <knowhere/utils.h>
 
 #include <faiss/utils/hamming.h>
+#include <faiss/utils/distances.h>
 #include <faiss/utils/utils.h>
 
 #include <faiss/IndexFlat.h>
@@ -515,8 +516,10 @@ void IndexIVF::search_preassigned(
                 return;
             if (metric_type == METRIC_INNER_PRODUCT) {
                 heap_heapify<HeapForIP>(k, simi, idxi);
+                heap_apply_knn_bound<HeapForIP>(k, simi);
             } else {
                 heap_heapify<HeapForL2>(k, simi, idxi);
+                heap_apply_knn_bound<HeapForL2>(k, simi);
             }
         };
 
@@ -543,6 +546,14 @@ void IndexIVF::search_preassigned(
 
         // single list scan using the current scanner (with query
         // set porperly) and storing results in simi and idxi
+        // pull the head of the next probed list into cache while the
+        // current one is scanned
+        auto prefetch_next_list = [&](idx_t key) {
+            if (key >= 0 && key < (idx_t)nlist) {
+                invlists->prefetch_list(key);
+            }
+        };
+
         auto scan_one_list = [&](idx_t key,
                                  float coarse_dis_i,
                                  float* simi,
@@ -581,6 +592,10 @@ void IndexIVF::search_preassigned(
 
                     auto scode_norms = std::make_unique<InvertedLists::ScopedCodeNorms>(invlists, key, segment_offset);
                     const float* code_norms = scode_norms->get();
+                    if (code_norms == nullptr && !arranged_inverse_norms.empty()) {
+                        // lists without norms of their own, scaled by the inverse norms of their raw codes
+                        code_norms = code_inverse_norms(key) + segment_offset;
+                    }
 
                     if (!store_pairs) {
                         sids.reset(new InvertedLists::ScopedIds(invlists, key, segment_offset));
@@ -630,6 +645,9 @@ void IndexIVF::search_preassigned(
 
                 // loop over probes
                 for (size_t ik = 0; ik < nprobe; ik++) {
+                    if (ik + 1 < nprobe) {
+                        prefetch_next_list(keys[i * nprobe + ik + 1]);
+                    }
                     nscan += scan_one_list(
                             keys[i * nprobe + ik],
                             coarse_dis[i * nprobe + ik],
@@ -822,6 +840,12 @@ void IndexIVF::range_search_preassigned(
 
         // prepare the list scanning function
 
+        auto prefetch_next_list = [&](idx_t key) {
+            if (key >= 0 && key < (idx_t)nlist) {
+                invlists->prefetch_list(key);
+            }
+        };
+
         auto scan_list_func = [&](size_t i, size_t ik, RangeQueryResult& qres) {
             idx_t key = keys[i * nprobe + ik]; /* select the list  */
             if (key < 0)
@@ -846,6 +870,10 @@ void IndexIVF::range_search_preassigned(
                     InvertedLists::ScopedCodes scodes(invlists, key, segment_offset);
                     InvertedLists::ScopedIds ids(invlists, key, segment_offset);
                     InvertedLists::ScopedCodeNorms scode_norms(invlists, key, segment_offset);
+                    const float* code_norms = scode_norms.get();
+                    if (code_norms == nullptr && !arranged_inverse_norms.empty()) {
+                        code_norms = code_inverse_norms(key) + segment_offset;
+                    }
 
                     scanner->set_list(key, coarse_dis[i * nprobe + ik]);
                     nlistv++;
@@ -853,7 +881,7 @@ void IndexIVF::range_search_preassigned(
                     scanner->scan_codes_range(
                             segment_size,
                             scodes.get(),
-                            scode_norms.get(),
+                            code_norms,
                             ids.get(),
                             radius,
                             qres,
@@ -875,6 +903,9 @@ void IndexIVF::range_search_preassigned(
             size_t prev_nres = qres.nres;
 
             for (size_t ik = 0; ik < nprobe; ik++) {
+                if (ik + 1 < nprobe) {
+                    prefetch_next_list(keys[i * nprobe + ik + 1]);
+                }
                 scan_list_func(i, ik, qres);
                 if (qres.nres == prev_nres) break;
                 prev_nres = qres.nres;
@@ -1017,6 +1048,7 @@ void IndexIVF::reset() {
     invlists->reset();
     arranged_codes.clear();
     prefix_sum.clear();
+    arranged_inverse_norms.clear();
     ntotal = 0;
 }
 
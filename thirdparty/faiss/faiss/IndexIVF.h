@@ -122,6 +122,20 @@ struct IndexIVF : Index, Level1Quantizer {
     std::vector<uint8_t> arranged_codes;
     std::vector<size_t> prefix_sum;
 
+    /** inverse L2 norms of the vectors in arranged_codes, in the same
+     * order, or of the codes in the lists, list after list. Empty unless the
+     * index scores the raw vectors by cosine (IndexIVFFlat::use_inverse_norms,
+     * IndexIVFScalarQuantizer::use_inverse_norms).
+     */
+    std::vector<float> arranged_inverse_norms;
+
+    /// arranged_inverse_norms of list `key`, nullptr when there are none
+    const float* code_inverse_norms(idx_t key) const {
+        return arranged_inverse_norms.empty()
+                ? nullptr
+                : arranged_inverse_norms.data() + prefix_sum[key];
+    }
+
     /** Parallel mode determines how queries are parallelized with OpenMP
      *
      * 0 (default): split over queries
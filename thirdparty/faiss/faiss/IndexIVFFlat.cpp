@@ -41,20 +41,75 @@ IndexIVFFlat::IndexIVFFlat(
 }
 
 void IndexIVFFlat::arrange_codes(idx_t n, const float* x) {
-    auto ails = dynamic_cast<faiss::ArrayInvertedLists*>(invlists);
+    FAISS_THROW_IF_NOT_MSG(n >= ntotal, "arrange_codes needs every vector");
     prefix_sum.resize(invlists->nlist + 1);
     prefix_sum[0] = 0;
     arranged_codes.resize(d * n * sizeof(float));
     auto dst = (float*)(arranged_codes.data());
     for (size_t i = 0; i < invlists->nlist; i++) {
-        auto list_size = ails->ids[i].size();
+        auto list_size = invlists->list_size(i);
+        InvertedLists::ScopedIds ids(invlists, i);
         for (size_t j = 0; j < list_size; j++) {
-            const float* src = x + d * ails->ids[i][j];
+            FAISS_THROW_IF_NOT(ids[j] >= 0 && ids[j] < n);
+            const float* src = x + d * ids[j];
             std::copy_n(src, d, dst);
             dst += d;
         }
         prefix_sum[i + 1] = prefix_sum[i] + list_size;
     }
+    if (use_inverse_norms) {
+        arranged_inverse_norms.resize(n);
+        fvec_inverse_norms_L2(
+                arranged_inverse_norms.data(),
+                (const float*)arranged_codes.data(),
+                d,
+                n);
+    }
+}
+
+void IndexIVFFlat::append_arranged_codes(
+        idx_t n,
+        const float* x,
+        const idx_t* coarse_idx) {
+    const size_t nlist = invlists->nlist;
+    std::vector<size_t> old_prefix_sum = prefix_sum;
+    if (old_prefix_sum.size() != nlist + 1) {
+        old_prefix_sum.assign(nlist + 1, 0);
+    }
+    // the lists end with the added vectors, in the order of x
+    prefix_sum.resize(nlist + 1);
+    prefix_sum[0] = 0;
+    for (size_t i = 0; i < nlist; i++) {
+        prefix_sum[i + 1] = prefix_sum[i] + invlists->list_size(i);
+    }
+    std::vector<uint8_t> codes(prefix_sum[nlist] * code_size);
+    std::vector<size_t> cursor(nlist);
+    for (size_t i = 0; i < nlist; i++) {
+        size_t old_size = old_prefix_sum[i + 1] - old_prefix_sum[i];
+        FAISS_THROW_IF_NOT(
+                old_size <= prefix_sum[i + 1] - prefix_sum[i]);
+        memcpy(codes.data() + prefix_sum[i] * code_size,
+               arranged_codes.data() + old_prefix_sum[i] * code_size,
+               old_size * code_size);
+        cursor[i] = prefix_sum[i] + old_size;
+    }
+    for (idx_t i = 0; i < n; i++) {
+        idx_t list_no = coarse_idx[i];
+        if (list_no >= 0) {
+            memcpy(codes.data() + cursor[list_no]++ * code_size,
+                   x + i * d,
+                   code_size);
+        }
+    }
+    arranged_codes.swap(codes);
+    if (use_inverse_norms) {
+        arranged_inverse_norms.resize(prefix_sum[nlist]);
+        fvec_inverse_norms_L2(
+                arranged_inverse_norms.data(),
+                (const float*)arranged_codes.data(),
+                d,
+                prefix_sum[nlist]);
+    }
 }
 
 void IndexIVFFlat::add_with_ids_without_codes(
@@ -62,9 +117,16 @@ void IndexIVFFlat::add_with_ids_without_codes(
         const float* x,
         const idx_t* xids) {
     std::unique_ptr<idx_t[]> coarse_idx(new idx_t[n]);
-    quantizer->assign(n, x, coarse_idx.get());
+    if (use_inverse_norms) {
+        // lists are assigned by cosine, only the raw vectors are stored
+        std::vector<float> normalized(x, x + n * d);
+        fvec_renorm_L2(d, n, normalized.data());
+        quantizer->assign(n, normalized.data(), coarse_idx.get());
+    } else {
+        quantizer->assign(n, x, coarse_idx.get());
+    }
     add_core_without_codes(n, x, xids, coarse_idx.get());
-    arrange_codes(n, x);
+    append_arranged_codes(n, x, coarse_idx.get());
 }
 
 void IndexIVFFlat::add_core(
@@ -185,11 +247,23 @@ void IndexIVFFlat::sa_decode(idx_t n, const uint8_t* bytes, float* x) const {
 
 namespace {
 
+// list vectors scored by one call of fvec_inner_products_scaled_ny
+constexpr size_t kScaledScanBlock = 32;
+
 template <MetricType metric, class C>
 struct IVFFlatScanner : InvertedListScanner {
     size_t d;
-
-    IVFFlatScanner(size_t d, bool store_pairs) : d(d) {
+    // L2 distances are abandoned once above the heap top / radius
+    bool early_abandon;
+    // code_norms hold inverse norms to multiply by rather than norms to
+    // divide by
+    bool inverse_norms;
+
+    IVFFlatScanner(size_t d, bool store_pairs, bool inverse_norms = false)
+            : d(d),
+              early_abandon(
+                      metric == METRIC_L2 && distance_compute_early_abandon),
+              inverse_norms(inverse_norms) {
         this->store_pairs = store_pairs;
     }
 
@@ -221,14 +295,36 @@ struct IVFFlatScanner : InvertedListScanner {
             const BitsetView bitset) const override {
         const float* list_vecs = (const float*)codes;
         size_t nup = 0;
+        if (metric == METRIC_INNER_PRODUCT && inverse_norms && code_norms &&
+            bitset.empty()) {
+            // the inverse norms are applied inside the SIMD kernel
+            float dis[kScaledScanBlock];
+            for (size_t j0 = 0; j0 < list_size; j0 += kScaledScanBlock) {
+                size_t nb = std::min(kScaledScanBlock, list_size - j0);
+                fvec_inner_products_scaled_ny(
+                        dis, xi, list_vecs + d * j0, code_norms + j0, d, nb);
+                for (size_t j = 0; j < nb; j++) {
+                    if (C::cmp(simi[0], dis[j])) {
+                        int64_t id = store_pairs ? lo_build(list_no, j0 + j)
+                                                 : ids[j0 + j];
+                        heap_replace_top<C>(k, simi, idxi, dis[j], id);
+                        nup++;
+                    }
+                }
+            }
+            return nup;
+        }
         for (size_t j = 0; j < list_size; j++) {
             if (bitset.empty() || !bitset.test(ids[j])) {
                 const float* yj = list_vecs + d * j;
                 float dis = metric == METRIC_INNER_PRODUCT
                         ? fvec_inner_product(xi, yj, d)
+                        : early_abandon
+                        ? fvec_L2sqr_early_abandon(xi, yj, d, simi[0])
                         : fvec_L2sqr(xi, yj, d);
                 if (code_norms) {
-                    dis /= code_norms[j];
+                    dis = inverse_norms ? dis * code_norms[j]
+                                        : dis / code_norms[j];
                 }
                 if (C::cmp(simi[0], dis)) {
                     int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
@@ -254,9 +350,12 @@ struct IVFFlatScanner : InvertedListScanner {
                 const float* yj = list_vecs + d * j;
                 float dis = metric == METRIC_INNER_PRODUCT
                         ? fvec_inner_product(xi, yj, d)
+                        : early_abandon
+                        ? fvec_L2sqr_early_abandon(xi, yj, d, radius)
                         : fvec_L2sqr(xi, yj, d);
                 if (code_norms) {
-                    dis /= code_norms[j];
+                    dis = inverse_norms ? dis * code_norms[j]
+                                        : dis / code_norms[j];
                 }
                 if (C::cmp(radius, dis)) {
                     int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
@@ -273,7 +372,7 @@ InvertedListScanner* IndexIVFFlat::get_InvertedListScanner(
         bool store_pairs) const {
     if (metric_type == METRIC_INNER_PRODUCT) {
         return new IVFFlatScanner<METRIC_INNER_PRODUCT, CMin<float, int64_t>>(
-                d, store_pairs);
+                d, store_pairs, use_inverse_norms);
     } else if (metric_type == METRIC_L2) {
         return new IVFFlatScanner<METRIC_L2, CMax<float, int64_t>>(
                 d, store_pairs);
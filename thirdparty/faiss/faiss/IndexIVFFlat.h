@@ -22,14 +22,30 @@ namespace faiss {
  * encoded, the code array just contains the raw float entries.
  */
 struct IndexIVFFlat : IndexIVF {
+    /** keep the raw vectors for the cosine similarity: arrange_codes also
+     * fills arranged_inverse_norms, inner products with the (normalized)
+     * query are multiplied by them. Only used by the without_codes paths.
+     */
+    bool use_inverse_norms = false;
+
     IndexIVFFlat(
             Index* quantizer,
             size_t d,
             size_t nlist_,
             MetricType = METRIC_L2);
 
+    /// arrange all n vectors of the index, x holds them in id order
     void arrange_codes(idx_t n, const float* x);
 
+    /** arrange n vectors just added after the ones already arranged,
+     * coarse_idx holds their lists. Ids are not used, x holds only the
+     * added vectors.
+     */
+    void append_arranged_codes(
+            idx_t n,
+            const float* x,
+            const idx_t* coarse_idx);
+
     void add_with_ids_without_codes(
             idx_t n,
             const float* x,
@@ -14,6 +14,7 @@
 
 #include <faiss/IndexIVF.h>
 
+#include <faiss/utils/distances.h>
 #include <faiss/utils/utils.h>
 
 #include <faiss/impl/AuxIndexStructures.h>
@@ -274,8 +275,10 @@ void IndexIVF::search_preassigned_without_codes(
                 return;
             if (metric_type == METRIC_INNER_PRODUCT) {
                 heap_heapify<HeapForIP>(k, simi, idxi);
+                heap_apply_knn_bound<HeapForIP>(k, simi);
             } else {
                 heap_heapify<HeapForL2>(k, simi, idxi);
+                heap_apply_knn_bound<HeapForL2>(k, simi);
             }
         };
 
@@ -302,6 +305,20 @@ void IndexIVF::search_preassigned_without_codes(
 
         // single list scan using the current scanner (with query
         // set porperly) and storing results in simi and idxi
+        // pull the head of the next probed list into cache while the
+        // current one is scanned, its codes live in arranged_codes
+        auto prefetch_next_list = [&](idx_t key) {
+            if (key < 0 || key >= (idx_t)nlist) {
+                return;
+            }
+            invlists->prefetch_list(key);
+#ifndef USE_GPU
+            prefetch_list_head(
+                    arranged_codes.data() + code_size * prefix_sum[key],
+                    invlists->list_size(key) * code_size);
+#endif
+        };
+
         auto scan_one_list = [&](idx_t key,
                                  float coarse_dis_i,
                                  float* simi,
@@ -352,7 +369,7 @@ void IndexIVF::search_preassigned_without_codes(
                 nheap += scanner->scan_codes(
                         list_size,
                         (scodes.get() + code_size * offset),
-                        nullptr,
+                        code_inverse_norms(key),
                         ids,
                         simi,
                         idxi,
@@ -392,6 +409,9 @@ void IndexIVF::search_preassigned_without_codes(
 
                 // loop over probes
                 for (size_t ik = 0; ik < nprobe; ik++) {
+                    if (ik + 1 < nprobe) {
+                        prefetch_next_list(keys[i * nprobe + ik + 1]);
+                    }
                     nscan += scan_one_list(
                             keys[i * nprobe + ik],
                             coarse_dis[i * nprobe + ik],
@@ -624,6 +644,18 @@ void IndexIVF::range_search_preassigned_without_codes(
 
         // prepare the list scanning function
 
+        auto prefetch_next_list = [&](idx_t key) {
+            if (key < 0 || key >= (idx_t)nlist) {
+                return;
+            }
+            invlists->prefetch_list(key);
+#ifndef USE_GPU
+            prefetch_list_head(
+                    arranged_codes.data() + code_size * prefix_sum[key],
+                    invlists->list_size(key) * code_size);
+#endif
+        };
+
         auto scan_list_func = [&](size_t i,
                                   size_t ik,
                                   RangeQueryResult& qres,
@@ -662,7 +694,7 @@ void IndexIVF::range_search_preassigned_without_codes(
                 scanner->scan_codes_range(
                         list_size,
                         (scodes.get() + code_size * offset),
-                        nullptr,
+                        code_inverse_norms(key),
                         ids.get(),
                         radius,
                         qres,
@@ -683,6 +715,9 @@ void IndexIVF::range_search_preassigned_without_codes(
             size_t prev_nres = qres.nres;
 
             for (size_t ik = 0; ik < nprobe; ik++) {
+                if (ik + 1 < nprobe) {
+                    prefetch_next_list(keys[i * nprobe + ik + 1]);
+                }
                 scan_list_func(i, ik, qres, bitset);
                 if (qres.nres == prev_nres) break;
                 prev_nres = qres.nres;
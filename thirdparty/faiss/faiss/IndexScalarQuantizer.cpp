@@ -17,6 +17,7 @@
 #include <faiss/impl/AuxIndexStructures.h>
 #include <faiss/impl/FaissAssert.h>
 #include <faiss/impl/ScalarQuantizer.h>
+#include <faiss/utils/distances.h>
 #include <faiss/utils/utils.h>
 
 namespace faiss {
@@ -32,6 +33,7 @@ IndexScalarQuantizer::IndexScalarQuantizer(
         : IndexFlatCodes(0, d, metric), sq(d, qtype) {
     is_trained =
             qtype == QuantizerType::QT_fp16 ||
+            qtype == QuantizerType::QT_bf16 ||
             qtype == QuantizerType::QT_8bit_direct;
     code_size = sq.code_size;
 }
@@ -71,12 +73,14 @@ void IndexScalarQuantizer::search(
             // re-order heap
             if (metric_type == METRIC_L2) {
                 maxheap_heapify(k, D, I);
+                heap_apply_knn_bound<CMax<float, idx_t>>(k, D);
             } else {
                 minheap_heapify(k, D, I);
+                heap_apply_knn_bound<CMin<float, idx_t>>(k, D);
             }
             scanner->set_query(x + i * d);
             scanner->scan_codes(
-                    ntotal, codes.data(), nullptr, nullptr, D, I, k);
+                    ntotal, codes.data(), nullptr, nullptr, D, I, k, bitset);
 
             // re-order heap
             if (metric_type == METRIC_L2) {
@@ -88,6 +92,41 @@ void IndexScalarQuantizer::search(
     }
 }
 
+void IndexScalarQuantizer::range_search(
+        idx_t n,
+        const float* x,
+        float radius,
+        RangeSearchResult* result,
+        const BitsetView bitset) const {
+    FAISS_THROW_IF_NOT(is_trained);
+    FAISS_THROW_IF_NOT(
+            metric_type == METRIC_L2 || metric_type == METRIC_INNER_PRODUCT);
+
+#pragma omp parallel
+    {
+        InvertedListScanner* scanner =
+                sq.select_InvertedListScanner(metric_type, nullptr, true);
+        ScopeDeleter1<InvertedListScanner> del(scanner);
+        scanner->list_no = 0; // directly the list number
+        RangeSearchPartialResult pres(result);
+
+#pragma omp for
+        for (idx_t i = 0; i < n; i++) {
+            RangeQueryResult& qres = pres.new_result(i);
+            scanner->set_query(x + i * d);
+            scanner->scan_codes_range(
+                    ntotal,
+                    codes.data(),
+                    nullptr,
+                    nullptr,
+                    radius,
+                    qres,
+                    bitset);
+        }
+        pres.finalize();
+    }
+}
+
 DistanceComputer* IndexScalarQuantizer::get_distance_computer() const {
     SQDistanceComputer* dc = sq.get_distance_computer(metric_type);
     dc->code_size = sq.code_size;
@@ -244,6 +283,55 @@ void IndexIVFScalarQuantizer::add_core(
     ntotal += n;
 }
 
+void IndexIVFScalarQuantizer::add_with_ids(
+        idx_t n,
+        const float* x,
+        const idx_t* xids) {
+    if (!use_inverse_norms) {
+        IndexIVF::add_with_ids(n, x, xids);
+        return;
+    }
+    // lists are assigned by cosine, the codes hold the raw vectors
+    std::unique_ptr<idx_t[]> coarse_idx(new idx_t[n]);
+    std::vector<float> normalized(x, x + n * d);
+    fvec_renorm_L2(d, n, normalized.data());
+    quantizer->assign(n, normalized.data(), coarse_idx.get());
+    add_core(n, x, nullptr, xids, coarse_idx.get());
+    update_inverse_norms();
+}
+
+void IndexIVFScalarQuantizer::update_inverse_norms() {
+    FAISS_THROW_IF_NOT_MSG(
+            !by_residual, "inverse norms need the codes of the raw vectors");
+    const size_t nlist = invlists->nlist;
+    prefix_sum.resize(nlist + 1);
+    prefix_sum[0] = 0;
+    for (size_t i = 0; i < nlist; i++) {
+        prefix_sum[i + 1] = prefix_sum[i] + invlists->list_size(i);
+    }
+    arranged_inverse_norms.resize(prefix_sum[nlist]);
+    std::unique_ptr<Quantizer> squant(sq.select_quantizer());
+
+#pragma omp parallel for
+    for (int64_t i = 0; i < (int64_t)nlist; i++) {
+        const size_t list_size = invlists->list_size(i);
+        if (list_size == 0) {
+            continue;
+        }
+        InvertedLists::ScopedCodes codes(invlists, i);
+        std::vector<float> vecs(list_size * d);
+        for (size_t j = 0; j < list_size; j++) {
+            squant->decode_vector(
+                    codes.get() + j * code_size, vecs.data() + j * d);
+        }
+        fvec_inverse_norms_L2(
+                arranged_inverse_norms.data() + prefix_sum[i],
+                vecs.data(),
+                d,
+                list_size);
+    }
+}
+
 void IndexIVFScalarQuantizer::add_with_ids_without_codes(
         idx_t n,
         const float* x,
@@ -53,6 +53,13 @@ struct IndexScalarQuantizer : IndexFlatCodes {
             idx_t* labels,
             const BitsetView bitset = nullptr) const override;
 
+    void range_search(
+            idx_t n,
+            const float* x,
+            float radius,
+            RangeSearchResult* result,
+            const BitsetView bitset = nullptr) const override;
+
     DistanceComputer* get_distance_computer() const override;
 
     /* standalone codec interface */
@@ -75,6 +82,13 @@ struct IndexIVFScalarQuantizer : IndexIVF {
     ScalarQuantizer sq;
     bool by_residual;
 
+    /** fp16 / bf16 codes of raw vectors scored by cosine: the lists are
+     * assigned with the normalized vectors and the inner products with the
+     * (normalized) queries are scaled by arranged_inverse_norms, which are
+     * computed again from the codes instead of being stored.
+     */
+    bool use_inverse_norms = false;
+
     IndexIVFScalarQuantizer(
             Index* quantizer,
             size_t d,
@@ -101,6 +115,11 @@ struct IndexIVFScalarQuantizer : IndexIVF {
             const idx_t* xids,
             const idx_t* precomputed_idx) override;
 
+    void add_with_ids(idx_t n, const float* x, const idx_t* xids) override;
+
+    /// fill prefix_sum and arranged_inverse_norms from the codes in the lists
+    void update_inverse_norms();
+
     void add_with_ids_without_codes(
             idx_t n,
             const float* x,
@@ -78,6 +78,7 @@ Index* Cloner::clone_Index(const Index* index) {
     TRYCLONE(IndexLSH, index)
     TRYCLONE(IndexFlatL2, index)
     TRYCLONE(IndexFlatIP, index)
+    TRYCLONE(IndexFlatCosine, index)
     TRYCLONE(IndexFlat, index)
     TRYCLONE(IndexLattice, index)
     TRYCLONE(IndexResidualQuantizer, index)
@@ -13,6 +13,7 @@
 
 #include <faiss/impl/AuxIndexStructures.h>
 #include <faiss/utils/Heap.h>
+#include <faiss/utils/distances.h>
 #include <faiss/utils/partitioning.h>
 
 namespace faiss {
@@ -86,6 +87,7 @@ struct HeapResultHandler {
             heap_dis = hr.heap_dis_tab + i * k;
             heap_ids = hr.heap_ids_tab + i * k;
             heap_heapify<C>(k, heap_dis, heap_ids);
+            heap_apply_knn_bound<C>(k, heap_dis);
             thresh = heap_dis[0];
         }
 
@@ -115,6 +117,7 @@ struct HeapResultHandler {
         this->i1 = i1;
         for (size_t i = i0; i < i1; i++) {
             heap_heapify<C>(k, heap_dis_tab + i * k, heap_ids_tab + i * k);
+            heap_apply_knn_bound<C>(k, heap_dis_tab + i * k);
         }
     }
 
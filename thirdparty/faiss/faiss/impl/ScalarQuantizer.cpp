@@ -88,6 +88,7 @@ void ScalarQuantizer::set_derived_sizes() {
             bits = 6;
             break;
         case QuantizerType::QT_fp16:
+        case QuantizerType::QT_bf16:
             code_size = d * 2;
             bits = 16;
             break;
@@ -126,6 +127,7 @@ void ScalarQuantizer::train(size_t n, const float* x) {
                     trained);
             break;
         case QuantizerType::QT_fp16:
+        case QuantizerType::QT_bf16:
         case QuantizerType::QT_8bit_direct:
             // no training necessary
             break;
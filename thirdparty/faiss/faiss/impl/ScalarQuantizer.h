@@ -139,8 +139,13 @@ struct IVFSQScannerIP : InvertedListScanner {
         size_t nup = 0;
 
         for (size_t j = 0; j < list_size; j++) {
-            if (bitset.empty() || !bitset.test(ids[j])) {
+            if (bitset.empty() || !bitset.test(ids ? ids[j] : j)) {
                 float accu = accu0 + dc.query_to_code(codes);
+                // code_norms hold the inverse norms of raw cosine codes
+                // (IndexIVFScalarQuantizer::use_inverse_norms)
+                if (code_norms) {
+                    accu *= code_norms[j];
+                }
                 if (accu > simi[0]) {
                     int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
                     minheap_replace_top(k, simi, idxi, accu, id);
@@ -161,8 +166,11 @@ struct IVFSQScannerIP : InvertedListScanner {
             RangeQueryResult& res,
             const BitsetView bitset = nullptr) const override {
         for (size_t j = 0; j < list_size; j++) {
-            if (bitset.empty() || !bitset.test(ids[j])) {
+            if (bitset.empty() || !bitset.test(ids ? ids[j] : j)) {
                 float accu = accu0 + dc.query_to_code(codes);
+                if (code_norms) {
+                    accu *= code_norms[j];
+                }
                 if (accu > radius) {
                     int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
                     res.add(accu, id);
@@ -232,7 +240,7 @@ struct IVFSQScannerL2 : InvertedListScanner {
             const BitsetView bitset = nullptr) const override {
         size_t nup = 0;
         for (size_t j = 0; j < list_size; j++) {
-            if (bitset.empty() || !bitset.test(ids[j])) {
+            if (bitset.empty() || !bitset.test(ids ? ids[j] : j)) {
                 float dis = dc.query_to_code(codes);
                 if (dis < simi[0]) {
                     int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
@@ -254,7 +262,7 @@ struct IVFSQScannerL2 : InvertedListScanner {
             RangeQueryResult& res,
             const BitsetView bitset = nullptr) const override {
         for (size_t j = 0; j < list_size; j++) {
-            if (bitset.empty() || !bitset.test(ids[j])) {
+            if (bitset.empty() || !bitset.test(ids ? ids[j] : j)) {
                 float dis = dc.query_to_code(codes);
                 if (dis < radius) {
                     int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
@@ -24,6 +24,7 @@
 #include <faiss/utils/hamming.h>
 
 #include <faiss/invlists/InvertedListsIOHook.h>
+#include <faiss/invlists/MmapInvertedLists.h>
 #include <faiss/invlists/OnDiskInvertedLists.h>
 
 #include <faiss/Index2Layer.h>
@@ -243,6 +244,43 @@ InvertedLists* read_InvertedLists(IOReader* f, int io_flags) {
             }
         }
         return lca;
+    } else if (
+            h == fourcc("ilar") && (io_flags & IO_FLAG_MMAP) &&
+            !(io_flags & IO_FLAG_SKIP_IVF_DATA)) {
+        // the lists stay in the file and are paged in when probed
+        FileIOReader* reader = dynamic_cast<FileIOReader*>(f);
+        FAISS_THROW_IF_NOT_MSG(reader, "mmap only supported for File objects");
+        FILE* fdesc = reader->f;
+
+        size_t nlist, code_size;
+        READ1(nlist);
+        READ1(code_size);
+        std::vector<size_t> sizes(nlist);
+        read_ArrayInvertedLists_sizes(f, sizes);
+
+        struct stat buf;
+        int ret = fstat(fileno(fdesc), &buf);
+        FAISS_THROW_IF_NOT_FMT(ret == 0, "fstat failed: %s", strerror(errno));
+        size_t totsize = buf.st_size;
+
+        std::vector<MmapInvertedLists::List> lists(nlist);
+        size_t o = ftell(fdesc);
+        for (size_t i = 0; i < nlist; i++) {
+            lists[i].size = sizes[i];
+            lists[i].offset = o;
+            o += sizes[i] * (code_size + sizeof(InvertedLists::idx_t));
+        }
+        FAISS_THROW_IF_NOT_FMT(
+                o <= totsize, "truncated inverted lists in %zd bytes", totsize);
+
+        auto ptr = (uint8_t*)mmap(
+                nullptr, totsize, PROT_READ, MAP_SHARED, fileno(fdesc), 0);
+        FAISS_THROW_IF_NOT_FMT(
+                ptr != MAP_FAILED, "could not mmap: %s", strerror(errno));
+        // resume normal reading of the file after the lists
+        fseek(fdesc, o, SEEK_SET);
+        return new MmapInvertedLists(
+                nlist, code_size, ptr, totsize, std::move(lists));
     } else if (h == fourcc("ilar") && !(io_flags & IO_FLAG_SKIP_IVF_DATA)) {
         auto ails = new ArrayInvertedLists(0, 0);
         READ1(ails->nlist);
@@ -536,6 +574,14 @@ static void read_ivf_header(
     READ1(ivf->nprobe);
     ivf->quantizer = read_index(f);
     ivf->own_fields = true;
+    if (shared_ivf_quantizer && ivf->quantizer->ntotal == 0 &&
+        shared_ivf_quantizer->ntotal == (idx_t)ivf->nlist &&
+        shared_ivf_quantizer->d == ivf->quantizer->d) {
+        // empty placeholder written in place of the shared centroids
+        delete ivf->quantizer;
+        ivf->quantizer = shared_ivf_quantizer;
+        ivf->own_fields = false;
+    }
     if (ids) { // used in legacy "Iv" formats
         ids->resize(ivf->nlist);
         for (size_t i = 0; i < ivf->nlist; i++)
@@ -614,6 +660,16 @@ Index* read_index(IOReader* f, int io_flags) {
                 idxf->codes.size() == idxf->ntotal * idxf->code_size);
         // leak!
         idx = idxf;
+    } else if (h == fourcc("IxFC")) {
+        IndexFlatCosine* idxf = new IndexFlatCosine();
+        read_index_header(idxf, f);
+        idxf->code_size = idxf->d * sizeof(float);
+        READXBVECTOR(idxf->codes);
+        FAISS_THROW_IF_NOT(
+                idxf->codes.size() == idxf->ntotal * idxf->code_size);
+        READVECTOR(idxf->inverse_l2_norms);
+        FAISS_THROW_IF_NOT(idxf->inverse_l2_norms.size() == idxf->ntotal);
+        idx = idxf;
     } else if (h == fourcc("IxHE") || h == fourcc("IxHe")) {
         IndexLSH* idxl = new IndexLSH();
         read_index_header(idxl, f);
@@ -767,7 +823,8 @@ Index* read_index(IOReader* f, int io_flags) {
         for (int i = 0; i < ivsc->nlist; i++)
             READVECTOR(ail->codes[i]);
         idx = ivsc;
-    } else if (h == fourcc("IwSQ") || h == fourcc("IwSq")) {
+    } else if (
+            h == fourcc("IwSQ") || h == fourcc("IwSq") || h == fourcc("IwSn")) {
         IndexIVFScalarQuantizer* ivsc = new IndexIVFScalarQuantizer();
         read_ivf_header(ivsc, f);
         read_ScalarQuantizer(&ivsc->sq, f);
@@ -778,6 +835,10 @@ Index* read_index(IOReader* f, int io_flags) {
             READ1(ivsc->by_residual);
         }
         read_InvertedLists(ivsc, f, io_flags);
+        if (h == fourcc("IwSn")) {
+            ivsc->use_inverse_norms = true;
+            ivsc->update_inverse_norms();
+        }
         idx = ivsc;
     } else if (h == fourcc("IwLS") || h == fourcc("IwRQ")) {
         bool is_LSQ = h == fourcc("IwLS");
@@ -963,19 +1024,22 @@ Index *read_index_nm(IOReader *f, int io_flags) {
     Index * idx = nullptr;
     uint32_t h;
     READ1(h);
-    if (h == fourcc("IwFl")) {
+    if (h == fourcc("IwFl") || h == fourcc("IwFn")) {
         IndexIVFFlat * ivfl = new IndexIVFFlat ();
+        ivfl->use_inverse_norms = h == fourcc("IwFn");
         read_ivf_header (ivfl, f);
         ivfl->code_size = ivfl->d * sizeof(float);
         read_InvertedLists_nm (ivfl, f, io_flags);
         idx = ivfl;
-    } else if(h == fourcc("IwSq")) {
+    } else if(h == fourcc("IwSq") || h == fourcc("IwSn")) {
         IndexIVFScalarQuantizer * ivsc = new IndexIVFScalarQuantizer();
         read_ivf_header(ivsc, f);
         read_ScalarQuantizer(&ivsc->sq, f);
         READ1(ivsc->code_size);
         READ1(ivsc->by_residual);
         read_InvertedLists_nm (ivsc, f, io_flags);
+        // no codes are read, whoever fills them calls update_inverse_norms()
+        ivsc->use_inverse_norms = h == fourcc("IwSn");
         idx = ivsc;
     } else {
         FAISS_THROW_FMT("Index type 0x%08x not supported\n", h);
@@ -19,6 +19,7 @@
 #include <sys/types.h>
 
 #include <faiss/invlists/InvertedListsIOHook.h>
+#include <faiss/invlists/MmapInvertedLists.h>
 #include <faiss/invlists/OnDiskInvertedLists.h>
 
 #include <faiss/impl/FaissAssert.h>
@@ -75,6 +76,8 @@
 
 namespace faiss {
 
+thread_local Index* shared_ivf_quantizer = nullptr;
+
 /*************************************************************
  * Write
  **************************************************************/
@@ -307,22 +310,57 @@ void write_InvertedLists(const InvertedLists* ils, IOWriter* f) {
         }
     } else if (const auto & oa =
             dynamic_cast<const ReadOnlyArrayInvertedLists *>(ils)) {
+#ifdef USE_GPU
         uint32_t h = fourcc("iloa");
         WRITE1(h);
         WRITE1(oa->nlist);
         WRITE1(oa->code_size);
         WRITEVECTOR(oa->readonly_length);
-#ifdef USE_GPU
         size_t n = oa->pin_readonly_ids->size() / sizeof(InvertedLists::idx_t);
         WRITE1(n);
         WRITEANDCHECK((InvertedLists::idx_t*)oa->pin_readonly_ids->data, n);
         WRITEANDCHECK((uint8_t*)oa->pin_readonly_codes->data, n * oa->code_size);
 #else
-        size_t n = oa->readonly_ids.size();
-        WRITE1(n);
-        WRITEANDCHECK(oa->readonly_ids.data(), n);
-        WRITEANDCHECK(oa->readonly_codes.data(), n * oa->code_size);
+        // lists made contiguous after loading are stored like
+        // ArrayInvertedLists, so the format does not depend on it
+        uint32_t h = fourcc("ilar");
+        WRITE1(h);
+        WRITE1(oa->nlist);
+        WRITE1(oa->code_size);
+        uint32_t list_type = fourcc("full");
+        WRITE1(list_type);
+        WRITEVECTOR(oa->readonly_length);
+        for (size_t i = 0; i < oa->nlist; i++) {
+            size_t n = oa->readonly_length[i];
+            if (n > 0) {
+                WRITEANDCHECK(oa->get_codes(i), n * oa->code_size);
+                WRITEANDCHECK(oa->get_ids(i), n);
+            }
+        }
 #endif
+    } else if (const auto& ml = dynamic_cast<const MmapInvertedLists*>(ils)) {
+        // mmapped lists are written back in the "ilar" layout they were
+        // read from
+        uint32_t h = fourcc("ilar");
+        WRITE1(h);
+        WRITE1(ml->nlist);
+        WRITE1(ml->code_size);
+        uint32_t list_type = fourcc("full");
+        WRITE1(list_type);
+        std::vector<size_t> sizes;
+        for (size_t i = 0; i < ml->nlist; i++) {
+            sizes.push_back(ml->list_size(i));
+        }
+        WRITEVECTOR(sizes);
+        for (size_t i = 0; i < ml->nlist; i++) {
+            size_t n = sizes[i];
+            if (n > 0) {
+                InvertedLists::ScopedCodes codes(ml, i);
+                InvertedLists::ScopedIds ids(ml, i);
+                WRITEANDCHECK(codes.get(), n * ml->code_size);
+                WRITEANDCHECK(ids.get(), n);
+            }
+        }
     } else if (const auto & od =
                dynamic_cast<const OnDiskInvertedLists *>(ils)) {
         uint32_t h = fourcc ("ilod");
@@ -396,7 +434,38 @@ void write_InvertedLists_nm(const InvertedLists *ils, IOWriter *f) {
         }
     } else if (const auto & oa =
             dynamic_cast<const ReadOnlyArrayInvertedLists *>(ils)) {
-        // not going to happen
+        uint32_t h = fourcc("ilar");
+        WRITE1(h);
+        WRITE1(oa->nlist);
+        WRITE1(oa->code_size);
+        uint32_t list_type = fourcc("full");
+        WRITE1(list_type);
+        WRITEVECTOR(oa->readonly_length);
+        for (size_t i = 0; i < oa->nlist; i++) {
+            size_t n = oa->readonly_length[i];
+            if (n > 0) {
+                WRITEANDCHECK(oa->get_ids(i), n);
+            }
+        }
+    } else if (const auto& ml = dynamic_cast<const MmapInvertedLists*>(ils)) {
+        uint32_t h = fourcc("ilar");
+        WRITE1(h);
+        WRITE1(ml->nlist);
+        WRITE1(ml->code_size);
+        uint32_t list_type = fourcc("full");
+        WRITE1(list_type);
+        std::vector<size_t> sizes;
+        for (size_t i = 0; i < ml->nlist; i++) {
+            sizes.push_back(ml->list_size(i));
+        }
+        WRITEVECTOR(sizes);
+        for (size_t i = 0; i < ml->nlist; i++) {
+            size_t n = sizes[i];
+            if (n > 0) {
+                InvertedLists::ScopedIds ids(ml, i);
+                WRITEANDCHECK(ids.get(), n);
+            }
+        }
     } else {
         fprintf(stderr, "WARN! write_InvertedLists: unsupported invlist type, "
                 "saving null invlist\n");
@@ -477,12 +546,25 @@ static void write_ivf_header(const IndexIVF* ivf, IOWriter* f) {
     write_index_header(ivf, f);
     WRITE1(ivf->nlist);
     WRITE1(ivf->nprobe);
-    write_index(ivf->quantizer, f);
+    if (shared_ivf_quantizer && ivf->quantizer == shared_ivf_quantizer) {
+        // the shared centroids are stored by their owner
+        IndexFlat placeholder(ivf->quantizer->d, ivf->quantizer->metric_type);
+        write_index(&placeholder, f);
+    } else {
+        write_index(ivf->quantizer, f);
+    }
     write_direct_map(&ivf->direct_map, f);
 }
 
 void write_index(const Index* idx, IOWriter* f) {
-    if (const IndexFlat* idxf = dynamic_cast<const IndexFlat*>(idx)) {
+    if (const IndexFlatCosine* idxf =
+                dynamic_cast<const IndexFlatCosine*>(idx)) {
+        uint32_t h = fourcc("IxFC");
+        WRITE1(h);
+        write_index_header(idx, f);
+        WRITEXBVECTOR(idxf->codes);
+        WRITEVECTOR(idxf->inverse_l2_norms);
+    } else if (const IndexFlat* idxf = dynamic_cast<const IndexFlat*>(idx)) {
         uint32_t h =
                 fourcc(idxf->metric_type == METRIC_INNER_PRODUCT ? "IxFI"
                                : idxf->metric_type == METRIC_L2  ? "IxF2"
@@ -599,7 +681,8 @@ void write_index(const Index* idx, IOWriter* f) {
     } else if (
             const IndexIVFScalarQuantizer* ivsc =
                     dynamic_cast<const IndexIVFScalarQuantizer*>(idx)) {
-        uint32_t h = fourcc("IwSq");
+        // the inverse norms are computed again from the codes on load
+        uint32_t h = fourcc(ivsc->use_inverse_norms ? "IwSn" : "IwSq");
         WRITE1(h);
         write_ivf_header(ivsc, f);
         write_ScalarQuantizer(&ivsc->sq, f);
@@ -758,13 +841,14 @@ void write_index(const Index* idx, const char* fname) {
 void write_index_nm(const Index *idx, IOWriter *f) {
     if(const IndexIVFFlat * ivfl =
               dynamic_cast<const IndexIVFFlat *> (idx)) {
-        uint32_t h = fourcc("IwFl");
+        // the inverse norms are computed again from the raw data on load
+        uint32_t h = fourcc(ivfl->use_inverse_norms ? "IwFn" : "IwFl");
         WRITE1(h);
         write_ivf_header(ivfl, f);
         write_InvertedLists_nm(ivfl->invlists, f);
     } else if(const IndexIVFScalarQuantizer * ivsc =
               dynamic_cast<const IndexIVFScalarQuantizer *> (idx)) {
-        uint32_t h = fourcc("IwSq");
+        uint32_t h = fourcc(ivsc->use_inverse_norms ? "IwSn" : "IwSq");
         WRITE1(h);
         write_ivf_header(ivsc, f);
         write_ScalarQuantizer(&ivsc->sq, f);
@@ -17,6 +17,8 @@
 #include <typeinfo>
 #include <vector>
 
+#include <faiss/impl/platform_macros.h>
+
 /** I/O functions can read/write to a filename, a file handle or to an
  * object that abstracts the medium.
  *
@@ -70,6 +72,29 @@ IndexBinary* read_index_binary(const char* fname, int io_flags = 0);
 IndexBinary* read_index_binary(FILE* f, int io_flags = 0);
 IndexBinary* read_index_binary(IOReader* reader, int io_flags = 0);
 
+/** Coarse quantizer shared by several IVF indexes and stored apart from them.
+ *
+ * While it is set on the calling thread, the IVF indexes written with it as
+ * their quantizer get an empty flat quantizer of the same dimension and
+ * metric in its place, and the IVF indexes read with such an empty quantizer
+ * get it back (without owning it) when its size matches their nlist.
+ */
+FAISS_API extern thread_local Index* shared_ivf_quantizer;
+
+/// sets shared_ivf_quantizer for the lifetime of the object
+struct ScopedSharedIvfQuantizer {
+    Index* prev;
+
+    explicit ScopedSharedIvfQuantizer(Index* quantizer)
+            : prev(shared_ivf_quantizer) {
+        shared_ivf_quantizer = quantizer;
+    }
+
+    ~ScopedSharedIvfQuantizer() {
+        shared_ivf_quantizer = prev;
+    }
+};
+
 void write_VectorTransform(const VectorTransform* vt, const char* fname);
 VectorTransform* read_VectorTransform(const char* fname);
 
@@ -86,6 +86,8 @@ void InvertedLists::release_ids(size_t, const idx_t*) const {}
 
 void InvertedLists::prefetch_lists(const idx_t*, int) const {}
 
+void InvertedLists::prefetch_list(size_t) const {}
+
 const uint8_t* InvertedLists::get_single_code(size_t list_no, size_t offset)
         const {
     assert(offset < list_size(list_no));
@@ -286,6 +288,13 @@ const InvertedLists::idx_t* ArrayInvertedLists::get_ids(size_t list_no) const {
     return ids[list_no].data();
 }
 
+void ArrayInvertedLists::prefetch_list(size_t list_no) const {
+    assert(list_no < nlist);
+    // codes are empty for indexes that keep them elsewhere (IVF_FLAT)
+    prefetch_list_head(codes[list_no].data(), codes[list_no].size());
+    prefetch_list_head(ids[list_no].data(), ids[list_no].size() * sizeof(idx_t));
+}
+
 void ArrayInvertedLists::resize(size_t list_no, size_t new_size) {
     ids[list_no].resize(new_size);
     codes[list_no].resize(new_size * code_size);
@@ -374,6 +383,16 @@ const uint8_t* ConcurrentArrayInvertedLists::get_codes(size_t list_no) const {
 const InvertedLists::idx_t* ConcurrentArrayInvertedLists::get_ids(size_t list_no) const {
     FAISS_THROW_MSG("not implemented get_ids for non-continuous storage");
 }
+
+void ConcurrentArrayInvertedLists::prefetch_list(size_t list_no) const {
+    // only the first segment, the others are separate allocations
+    size_t n = get_segment_size(list_no, 0);
+    if (n == 0) {
+        return;
+    }
+    prefetch_list_head(get_codes(list_no, 0), n * code_size);
+    prefetch_list_head(get_ids(list_no, 0), n * sizeof(idx_t));
+}
 size_t ConcurrentArrayInvertedLists::add_entries(
         size_t list_no,
         size_t n_entry,
@@ -647,7 +666,7 @@ ReadOnlyArrayInvertedLists::ReadOnlyArrayInvertedLists(
     if (!valid) {
         FAISS_THROW_MSG("Invalid list_length");
     }
-    auto total_size = std::accumulate(readonly_length.begin(), readonly_length.end(), 0);
+    auto total_size = std::accumulate(readonly_length.begin(), readonly_length.end(), size_t{0});
     readonly_offset.reserve(nlist);
 
 #ifndef USE_GPU
@@ -813,6 +832,12 @@ const InvertedLists::idx_t* ReadOnlyArrayInvertedLists::get_ids(
 #endif
 }
 
+void ReadOnlyArrayInvertedLists::prefetch_list(size_t list_no) const {
+    size_t n = list_size(list_no);
+    prefetch_list_head(get_codes(list_no), n * code_size);
+    prefetch_list_head(get_ids(list_no), n * sizeof(idx_t));
+}
+
 const InvertedLists::idx_t* ReadOnlyArrayInvertedLists::get_all_ids() const {
     FAISS_ASSERT(valid);
 #ifdef USE_GPU
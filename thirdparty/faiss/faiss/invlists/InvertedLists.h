@@ -136,6 +136,11 @@ struct InvertedLists {
     /// a list can be -1 hence the signed long
     virtual void prefetch_lists(const idx_t* list_nos, int nlist) const;
 
+    /// hint that list_no is scanned next, called while the previous list is
+    /// being scanned: start loading the head of its codes and ids into the
+    /// cache. Must not block (default does nothing)
+    virtual void prefetch_list(size_t list_no) const;
+
     /*************************
      * writing functions     */
 
@@ -297,6 +302,18 @@ struct InvertedLists {
     };
 };
 
+/// Software prefetch of the first bytes of a list about to be scanned, the
+/// hardware prefetcher follows the sequential scan once it has started.
+inline void prefetch_list_head(const void* data, size_t nbytes) {
+    constexpr size_t kMaxPrefetchBytes = 1024;
+    constexpr size_t kCacheLineSize = 64;
+    auto p = static_cast<const char*>(data);
+    nbytes = nbytes < kMaxPrefetchBytes ? nbytes : kMaxPrefetchBytes;
+    for (size_t off = 0; off < nbytes; off += kCacheLineSize) {
+        __builtin_prefetch(p + off);
+    }
+}
+
 /// simple (default) implementation as an array of inverted lists
 struct ArrayInvertedLists : InvertedLists {
     std::vector<std::vector<uint8_t>> codes; // binary codes, size nlist
@@ -308,6 +325,8 @@ struct ArrayInvertedLists : InvertedLists {
     const uint8_t* get_codes(size_t list_no) const override;
     const idx_t* get_ids(size_t list_no) const override;
 
+    void prefetch_list(size_t list_no) const override;
+
     size_t add_entries(
             size_t list_no,
             size_t n_entry,
@@ -373,6 +392,8 @@ struct ConcurrentArrayInvertedLists : InvertedLists {
     const uint8_t* get_codes(size_t list_no, size_t offset) const override;
     const idx_t* get_ids(size_t list_no, size_t offset) const override;
 
+    void prefetch_list(size_t list_no) const override;
+
     const float* get_code_norms(size_t list_no, size_t offset) const override;
     void release_code_norms(size_t list_no, const float* codes)
             const override;
@@ -445,6 +466,8 @@ struct ReadOnlyArrayInvertedLists: InvertedLists {
     const uint8_t * get_codes(size_t list_no) const override;
     const idx_t * get_ids(size_t list_no) const override;
 
+    void prefetch_list(size_t list_no) const override;
+
     const uint8_t * get_all_codes() const;
     const idx_t * get_all_ids() const;
     const std::vector<size_t>& get_list_length() const;
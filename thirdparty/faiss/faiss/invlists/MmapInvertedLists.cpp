@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// -*- c++ -*-
+
+#include <faiss/invlists/MmapInvertedLists.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <faiss/impl/FaissAssert.h>
+
+namespace faiss {
+
+MmapInvertedLists::MmapInvertedLists(
+        size_t nlist,
+        size_t code_size,
+        uint8_t* ptr,
+        size_t totsize,
+        std::vector<List> lists)
+        : ReadOnlyInvertedLists(nlist, code_size),
+          ptr(ptr),
+          totsize(totsize),
+          lists(std::move(lists)),
+          lru_pos(nlist),
+          in_lru(nlist, false) {
+    FAISS_THROW_IF_NOT(this->lists.size() == nlist);
+    // lists are scanned as a whole but probed in random order, kernel read
+    // ahead would only pull in lists nobody asked for
+    madvise(ptr, totsize, MADV_RANDOM);
+}
+
+MmapInvertedLists::~MmapInvertedLists() {
+    if (ptr != nullptr && munmap(ptr, totsize) != 0) {
+        fprintf(stderr, "munmap error: %s\n", strerror(errno));
+    }
+}
+
+size_t MmapInvertedLists::list_size(size_t list_no) const {
+    return lists[list_no].size;
+}
+
+const uint8_t* MmapInvertedLists::get_codes(size_t list_no) const {
+    return ptr + lists[list_no].offset;
+}
+
+const InvertedLists::idx_t* MmapInvertedLists::get_ids(size_t list_no) const {
+    const List& l = lists[list_no];
+    return (const idx_t*)(ptr + l.offset + l.size * code_size);
+}
+
+void MmapInvertedLists::list_extent(
+        size_t list_no,
+        uint8_t** begin,
+        size_t* len) const {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    const List& l = lists[list_no];
+    size_t start = l.offset / page_size * page_size;
+    size_t end = l.offset + l.size * (code_size + sizeof(idx_t));
+    *begin = ptr + start;
+    *len = end - start;
+}
+
+void MmapInvertedLists::prefetch_lists(const idx_t* list_nos, int n) const {
+    for (int i = 0; i < n; i++) {
+        idx_t list_no = list_nos[i];
+        if (list_no < 0 || lists[list_no].size == 0) {
+            continue;
+        }
+        uint8_t* begin;
+        size_t len;
+        list_extent(list_no, &begin, &len);
+        madvise(begin, len, MADV_WILLNEED);
+    }
+    if (cache_size == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex);
+    for (int i = 0; i < n; i++) {
+        idx_t list_no = list_nos[i];
+        if (list_no < 0 || lists[list_no].size == 0) {
+            continue;
+        }
+        if (in_lru[list_no]) {
+            lru.splice(lru.begin(), lru, lru_pos[list_no]);
+            continue;
+        }
+        lru.push_front(list_no);
+        lru_pos[list_no] = lru.begin();
+        in_lru[list_no] = true;
+        cached += lists[list_no].size * (code_size + sizeof(idx_t));
+    }
+    // the lists just probed are at the front and are never dropped here
+    while (cached > cache_size && lru.size() > (size_t)n) {
+        size_t victim = lru.back();
+        lru.pop_back();
+        in_lru[victim] = false;
+        cached -= lists[victim].size * (code_size + sizeof(idx_t));
+        // a reader still scanning the list faults the pages back in from
+        // the file, dropping a read-only file mapping is always safe
+        uint8_t* begin;
+        size_t len;
+        list_extent(victim, &begin, &len);
+        madvise(begin, len, MADV_DONTNEED);
+    }
+}
+
+void MmapInvertedLists::prefetch_list(size_t list_no) const {
+    size_t n = lists[list_no].size;
+    prefetch_list_head(get_codes(list_no), n * code_size);
+    prefetch_list_head(get_ids(list_no), n * sizeof(idx_t));
+}
+
+void MmapInvertedLists::set_cache_size(size_t bytes) {
+    std::lock_guard<std::mutex> guard(mutex);
+    cache_size = bytes;
+    if (cache_size == 0) {
+        lru.clear();
+        std::fill(in_lru.begin(), in_lru.end(), false);
+        cached = 0;
+    }
+}
+
+size_t MmapInvertedLists::cached_bytes() const {
+    std::lock_guard<std::mutex> guard(mutex);
+    return cached;
+}
+
+} // namespace faiss
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// -*- c++ -*-
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include <faiss/invlists/InvertedLists.h>
+
+namespace faiss {
+
+/** Read-only inverted lists served from a mmapped index file.
+ *
+ * The lists stay in the ArrayInvertedLists ("ilar") layout of the file:
+ * each list is one contiguous extent holding its codes followed by its ids.
+ * Pages are only read when a list is scanned, so the index can be larger
+ * than RAM. The mapping is advised MADV_RANDOM so that scanning one list
+ * does not read ahead into its neighbours, and prefetch_lists() asks the
+ * kernel to read the nprobe lists chosen by the coarse quantizer
+ * (MADV_WILLNEED) before they are scanned.
+ *
+ * With cache_size > 0, at most about cache_size bytes of prefetched lists
+ * are kept mapped: the least recently probed lists are dropped from the
+ * mapping with MADV_DONTNEED and fault back in from the file when probed
+ * again.
+ */
+struct MmapInvertedLists : ReadOnlyInvertedLists {
+    struct List {
+        size_t size = 0;   // number of entries
+        size_t offset = 0; // byte offset of the codes in the file
+    };
+
+    /// takes ownership of the mapping [ptr, ptr + totsize)
+    MmapInvertedLists(
+            size_t nlist,
+            size_t code_size,
+            uint8_t* ptr,
+            size_t totsize,
+            std::vector<List> lists);
+
+    ~MmapInvertedLists() override;
+
+    size_t list_size(size_t list_no) const override;
+    const uint8_t* get_codes(size_t list_no) const override;
+    const idx_t* get_ids(size_t list_no) const override;
+
+    void prefetch_lists(const idx_t* list_nos, int nlist) const override;
+
+    /// pages of the list are already requested by prefetch_lists(), this only
+    /// pulls its head from the page cache into the CPU cache
+    void prefetch_list(size_t list_no) const override;
+
+    /// bound of the prefetched list bytes kept mapped, 0 for no bound
+    void set_cache_size(size_t bytes);
+
+    /// bytes of the lists currently tracked as prefetched
+    size_t cached_bytes() const;
+
+   private:
+    /// page-aligned byte range of a list in the mapping
+    void list_extent(size_t list_no, uint8_t** begin, size_t* len) const;
+
+    uint8_t* ptr;
+    size_t totsize;
+    std::vector<List> lists;
+
+    // LRU of prefetched lists, most recent first
+    mutable std::mutex mutex;
+    mutable std::list<size_t> lru;
+    mutable std::vector<std::list<size_t>::iterator> lru_pos;
+    mutable std::vector<bool> in_lru;
+    mutable size_t cached = 0;
+    std::atomic<size_t> cache_size{0};
+};
+
+} // namespace faiss
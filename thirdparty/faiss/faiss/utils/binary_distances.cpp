@@ -464,6 +464,96 @@ void binary_knn_hc(
     ha->reorder();
 }
 
+// codes of at least this size are compared with the batched SIMD kernels of
+// the hook layer instead of the per-pair metric computers
+static constexpr size_t binary_ny_min_code_size = 128;
+// number of database codes compared by one call of a batched kernel
+static constexpr size_t binary_ny_block_size = 256;
+
+template <class C, typename DisT>
+void binary_knn_hc_ny(
+        size_t bytes_per_code,
+        HeapArray<C>* ha,
+        const uint8_t* bs1,
+        const uint8_t* bs2,
+        size_t n2,
+        void (*compute_ny)(
+                DisT*, const uint8_t*, const uint8_t*, size_t, size_t),
+        const BitsetView bitset) {
+    typedef typename C::T T;
+    const size_t k = ha->k;
+    const size_t nh = ha->nh;
+    const size_t n_blocks =
+            (n2 + binary_ny_block_size - 1) / binary_ny_block_size;
+    const size_t thread_max_num = omp_get_max_threads();
+
+    auto scan_block = [&](T* val, int64_t* ids, const uint8_t* query,
+                          size_t j0, DisT* dis) {
+        const size_t j1 = std::min(j0 + binary_ny_block_size, n2);
+        compute_ny(dis, query, bs2 + j0 * bytes_per_code, bytes_per_code,
+                   j1 - j0);
+        for (size_t j = j0; j < j1; j++) {
+            if (bitset.empty() || !bitset.test(j)) {
+                T d = dis[j - j0];
+                if (C::cmp(val[0], d)) {
+                    faiss::heap_replace_top<C>(k, val, ids, d, j);
+                }
+            }
+        }
+    };
+
+    ha->heapify();
+    if (nh >= thread_max_num || n_blocks == 1) {
+#pragma omp parallel for
+        for (int64_t i = 0; i < nh; i++) {
+            DisT dis[binary_ny_block_size];
+            for (size_t b = 0; b < n_blocks; b++) {
+                scan_block(ha->val + i * k, ha->ids + i * k,
+                           bs1 + i * bytes_per_code,
+                           b * binary_ny_block_size, dis);
+            }
+        }
+    } else {
+        // too few queries to keep the threads busy, split the database
+        // instead, with one heap per thread and query merged at the end
+        std::vector<T> value(thread_max_num * nh * k);
+        std::vector<int64_t> labels(thread_max_num * nh * k);
+        for (size_t h = 0; h < thread_max_num * nh; h++) {
+            faiss::heap_heapify<C>(
+                    k, value.data() + h * k, labels.data() + h * k);
+        }
+#pragma omp parallel for
+        for (int64_t b = 0; b < n_blocks; b++) {
+            const size_t thread_no = omp_get_thread_num();
+            DisT dis[binary_ny_block_size];
+            for (size_t i = 0; i < nh; i++) {
+                const size_t h = thread_no * nh + i;
+                scan_block(value.data() + h * k, labels.data() + h * k,
+                           bs1 + i * bytes_per_code,
+                           b * binary_ny_block_size, dis);
+            }
+        }
+        for (size_t t = 0; t < thread_max_num; t++) {
+            for (size_t i = 0; i < nh; i++) {
+                const size_t h = t * nh + i;
+                for (size_t j = 0; j < k; j++) {
+                    const T v = value[h * k + j];
+                    if (labels[h * k + j] != -1 &&
+                        C::cmp(ha->val[i * k], v)) {
+                        faiss::heap_replace_top<C>(
+                                k,
+                                ha->val + i * k,
+                                ha->ids + i * k,
+                                v,
+                                labels[h * k + j]);
+                    }
+                }
+            }
+        }
+    }
+    ha->reorder();
+}
+
 template <class C>
 void binary_knn_hc(
         MetricType metric_type,
@@ -475,6 +565,11 @@ void binary_knn_hc(
         const BitsetView bitset) {
     switch (metric_type) {
         case METRIC_Jaccard: {
+            if (ncodes >= binary_ny_min_code_size) {
+                binary_knn_hc_ny<C, float>(
+                        ncodes, ha, a, b, nb, bvec_jaccard_ny, bitset);
+                break;
+            }
             {
                 switch (ncodes) {
 #define binary_knn_hc_jaccard(ncodes)                     \
@@ -500,6 +595,11 @@ void binary_knn_hc(
         }
 
         case METRIC_Hamming: {
+            if (ncodes >= binary_ny_min_code_size) {
+                binary_knn_hc_ny<C, int32_t>(
+                        ncodes, ha, a, b, nb, bvec_hamming_ny, bitset);
+                break;
+            }
             {
                 switch (ncodes) {
 #define binary_knn_hc_hamming(ncodes)                     \
@@ -524,8 +624,8 @@ void binary_knn_hc(
         }
 
         case METRIC_TLSH: {
-            binary_knn_hc<C, faiss::TLSHComputerDefault>(
-                    ncodes, ha, a, b, nb, bitset);
+            binary_knn_hc_ny<C, float>(
+                    ncodes, ha, a, b, nb, bvec_tlsh_ny, bitset);
             break;
         }
         default:
@@ -551,6 +651,219 @@ template void binary_knn_hc<CMax<float, int64_t>>(
         size_t ncodes,
         const BitsetView bitset);
 
+template <class C, class MetricComputer>
+void binary_knn_hc_by_idx(
+        int bytes_per_code,
+        HeapArray<C>* ha,
+        const uint8_t* bs1,
+        const uint8_t* bs2,
+        const int64_t* ids,
+        size_t ny) {
+    typedef typename C::T T;
+    size_t k = ha->k;
+    ha->heapify();
+
+#pragma omp parallel for
+    for (size_t i = 0; i < ha->nh; i++) {
+        MetricComputer hc(bs1 + i * bytes_per_code, bytes_per_code);
+        const int64_t* ids_i = ids + i * ny;
+        T* __restrict bh_val_ = ha->val + i * k;
+        int64_t* __restrict bh_ids_ = ha->ids + i * k;
+        for (size_t j = 0; j < ny; j++) {
+            if (ids_i[j] < 0)
+                break;
+            if (j + 4 < ny && ids_i[j + 4] >= 0) {
+                __builtin_prefetch(bs2 + ids_i[j + 4] * bytes_per_code);
+            }
+            T dis = hc.compute(bs2 + ids_i[j] * bytes_per_code);
+            if (C::cmp(bh_val_[0], dis)) {
+                faiss::heap_replace_top<C>(k, bh_val_, bh_ids_, dis, ids_i[j]);
+            }
+        }
+    }
+    ha->reorder();
+}
+
+template <class C>
+void binary_knn_hc_by_idx(
+        MetricType metric_type,
+        HeapArray<C>* ha,
+        const uint8_t* a,
+        const uint8_t* b,
+        const int64_t* ids,
+        size_t ny,
+        size_t ncodes) {
+    switch (metric_type) {
+        case METRIC_Jaccard: {
+            switch (ncodes) {
+#define binary_knn_hc_by_idx_jaccard(ncodes)                     \
+    case ncodes:                                                 \
+        binary_knn_hc_by_idx<C, faiss::JaccardComputer##ncodes>( \
+                ncodes, ha, a, b, ids, ny);                      \
+        break;
+                binary_knn_hc_by_idx_jaccard(8);
+                binary_knn_hc_by_idx_jaccard(16);
+                binary_knn_hc_by_idx_jaccard(32);
+                binary_knn_hc_by_idx_jaccard(64);
+                binary_knn_hc_by_idx_jaccard(128);
+                binary_knn_hc_by_idx_jaccard(256);
+                binary_knn_hc_by_idx_jaccard(512);
+#undef binary_knn_hc_by_idx_jaccard
+                default:
+                    binary_knn_hc_by_idx<C, faiss::JaccardComputerDefault>(
+                            ncodes, ha, a, b, ids, ny);
+                    break;
+            }
+            break;
+        }
+
+        case METRIC_Hamming: {
+            switch (ncodes) {
+#define binary_knn_hc_by_idx_hamming(ncodes)                     \
+    case ncodes:                                                 \
+        binary_knn_hc_by_idx<C, faiss::HammingComputer##ncodes>( \
+                ncodes, ha, a, b, ids, ny);                      \
+        break;
+                binary_knn_hc_by_idx_hamming(4);
+                binary_knn_hc_by_idx_hamming(8);
+                binary_knn_hc_by_idx_hamming(16);
+                binary_knn_hc_by_idx_hamming(20);
+                binary_knn_hc_by_idx_hamming(32);
+                binary_knn_hc_by_idx_hamming(64);
+#undef binary_knn_hc_by_idx_hamming
+                default:
+                    binary_knn_hc_by_idx<C, faiss::HammingComputerDefault>(
+                            ncodes, ha, a, b, ids, ny);
+                    break;
+            }
+            break;
+        }
+
+        case METRIC_TLSH: {
+            binary_knn_hc_by_idx<C, faiss::TLSHComputerDefault>(
+                    ncodes, ha, a, b, ids, ny);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template void binary_knn_hc_by_idx<CMax<int, int64_t>>(
+        MetricType metric_type,
+        int_maxheap_array_t* ha,
+        const uint8_t* a,
+        const uint8_t* b,
+        const int64_t* ids,
+        size_t ny,
+        size_t ncodes);
+
+template void binary_knn_hc_by_idx<CMax<float, int64_t>>(
+        MetricType metric_type,
+        float_maxheap_array_t* ha,
+        const uint8_t* a,
+        const uint8_t* b,
+        const int64_t* ids,
+        size_t ny,
+        size_t ncodes);
+
+template <class T>
+void binary_knn_mc_by_idx(
+        int bytes_per_code,
+        const uint8_t* bs1,
+        const uint8_t* bs2,
+        const int64_t* ids,
+        size_t n1,
+        size_t ny,
+        size_t k,
+        float* distances,
+        int64_t* labels) {
+#pragma omp parallel for
+    for (size_t i = 0; i < n1; i++) {
+        T hc(bs1 + i * bytes_per_code, bytes_per_code);
+        const int64_t* ids_i = ids + i * ny;
+        float* dis = distances + i * k;
+        int64_t* lab = labels + i * k;
+        size_t num_i = 0;
+        for (size_t j = 0; j < ny && num_i < k; j++) {
+            if (ids_i[j] < 0)
+                break;
+            if (hc.compute(bs2 + ids_i[j] * bytes_per_code)) {
+                dis[num_i] = 0;
+                lab[num_i] = ids_i[j];
+                num_i++;
+            }
+        }
+        for (; num_i < k; num_i++) {
+            dis[num_i] = 1.0 / 0.0;
+            lab[num_i] = -1;
+        }
+    }
+}
+
+void binary_knn_mc_by_idx(
+        MetricType metric_type,
+        const uint8_t* a,
+        const uint8_t* b,
+        const int64_t* ids,
+        size_t na,
+        size_t ny,
+        size_t k,
+        size_t ncodes,
+        float* distances,
+        int64_t* labels) {
+    switch (metric_type) {
+        case METRIC_Substructure:
+            switch (ncodes) {
+#define binary_knn_mc_by_idx_Substructure(ncodes)                     \
+    case ncodes:                                                      \
+        binary_knn_mc_by_idx<faiss::StructureComputer##ncodes<true>>( \
+                ncodes, a, b, ids, na, ny, k, distances, labels);     \
+        break;
+                binary_knn_mc_by_idx_Substructure(8);
+                binary_knn_mc_by_idx_Substructure(16);
+                binary_knn_mc_by_idx_Substructure(32);
+                binary_knn_mc_by_idx_Substructure(64);
+                binary_knn_mc_by_idx_Substructure(128);
+                binary_knn_mc_by_idx_Substructure(256);
+                binary_knn_mc_by_idx_Substructure(512);
+#undef binary_knn_mc_by_idx_Substructure
+                default:
+                    binary_knn_mc_by_idx<
+                            faiss::StructureComputerDefault<true>>(
+                            ncodes, a, b, ids, na, ny, k, distances, labels);
+                    break;
+            }
+            break;
+
+        case METRIC_Superstructure:
+            switch (ncodes) {
+#define binary_knn_mc_by_idx_Superstructure(ncodes)                    \
+    case ncodes:                                                       \
+        binary_knn_mc_by_idx<faiss::StructureComputer##ncodes<false>>( \
+                ncodes, a, b, ids, na, ny, k, distances, labels);      \
+        break;
+                binary_knn_mc_by_idx_Superstructure(8);
+                binary_knn_mc_by_idx_Superstructure(16);
+                binary_knn_mc_by_idx_Superstructure(32);
+                binary_knn_mc_by_idx_Superstructure(64);
+                binary_knn_mc_by_idx_Superstructure(128);
+                binary_knn_mc_by_idx_Superstructure(256);
+                binary_knn_mc_by_idx_Superstructure(512);
+#undef binary_knn_mc_by_idx_Superstructure
+                default:
+                    binary_knn_mc_by_idx<
+                            faiss::StructureComputerDefault<false>>(
+                            ncodes, a, b, ids, na, ny, k, distances, labels);
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
 template <class C, typename T, class MetricComputer>
 void binary_range_search(
         const uint8_t* a,
@@ -122,6 +122,30 @@ void binary_knn_hc(
         size_t ncodes,
         const BitsetView bitset = nullptr);
 
+/* same as binary_knn_hc / binary_knn_mc, for a subset of b indexed by ids
+ * (ny ids per query, ids < 0 end the list of the query) */
+template <class C>
+void binary_knn_hc_by_idx(
+        MetricType metric_type,
+        HeapArray<C>* ha,
+        const uint8_t* a,
+        const uint8_t* b,
+        const int64_t* ids,
+        size_t ny,
+        size_t ncodes);
+
+void binary_knn_mc_by_idx(
+        MetricType metric_type,
+        const uint8_t* a,
+        const uint8_t* b,
+        const int64_t* ids,
+        size_t na,
+        size_t ny,
+        size_t k,
+        size_t ncodes,
+        float* distances,
+        int64_t* labels);
+
 template <class C, typename T>
 void binary_range_search(
         MetricType metric_type,
@@ -76,6 +76,19 @@ void fvec_norms_L2sqr(
         nr[i] = fvec_norm_L2sqr(x + i * d, d);
 }
 
+void fvec_inverse_norms_L2(
+        float* __restrict nr,
+        const float* __restrict x,
+        size_t d,
+        size_t nx) {
+#pragma omp parallel for
+    for (int64_t i = 0; i < nx; i++) {
+        float norm = sqrtf(fvec_norm_L2sqr(x + i * d, d));
+        // the inner products of a 0-normed vector are 0 whatever its factor
+        nr[i] = norm > 0 ? 1.0f / norm : 1.0f;
+    }
+}
+
 void fvec_renorm_L2(size_t d, size_t nx, float* __restrict x) {
 #pragma omp parallel for
     for (int64_t i = 0; i < nx; i++) {
@@ -198,6 +211,13 @@ void exhaustive_parallel_on_ny(
     delete[] ress;
 }
 
+/* whether exhaustive_L2sqr_IP_seq splits ny rather than nx across threads */
+bool use_parallel_on_ny(size_t nx, size_t ny) {
+    size_t thread_max_num = omp_get_max_threads();
+    return ny > parallel_policy_threshold ||
+            (nx < thread_max_num / 2 && ny >= thread_max_num * 32);
+}
+
 /* Find the nearest neighbors for nx queries in a set of ny vectors */
 template <class ResultHandler>
 void exhaustive_L2sqr_IP_seq(
@@ -209,9 +229,7 @@ void exhaustive_L2sqr_IP_seq(
         ResultHandler& res,
         decltype(fvec_inner_product) dis_compute_func,
         const BitsetView bitset) {
-    size_t thread_max_num = omp_get_max_threads();
-    if (ny > parallel_policy_threshold ||
-        (nx < thread_max_num / 2 && ny >= thread_max_num * 32)) {
+    if (use_parallel_on_ny(nx, ny)) {
         exhaustive_parallel_on_ny(
                 x, y, d, nx, ny, res, dis_compute_func, bitset);
     } else {
@@ -220,6 +238,40 @@ void exhaustive_L2sqr_IP_seq(
     }
 }
 
+/* Same as exhaustive_parallel_on_nx with fvec_L2sqr, each distance is
+ * abandoned once it exceeds the current heap top of its query */
+template <class ResultHandler>
+void exhaustive_L2sqr_early_abandon_seq(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        ResultHandler& res,
+        const BitsetView bitset) {
+    using SingleResultHandler = typename ResultHandler::SingleResultHandler;
+#pragma omp parallel
+    {
+        SingleResultHandler resi(res);
+#pragma omp for
+        for (int64_t i = 0; i < nx; i++) {
+            const float* x_i = x + i * d;
+            const float* y_j = y;
+
+            resi.begin(i);
+            for (size_t j = 0; j < ny; j++) {
+                if (bitset.empty() || !bitset.test(j)) {
+                    float dis =
+                            fvec_L2sqr_early_abandon(x_i, y_j, d, resi.thresh);
+                    resi.add_result(dis, j);
+                }
+                y_j += d;
+            }
+            resi.end();
+        }
+    }
+}
+
 /* Find the nearest neighbors for nx queries in a set of ny vectors */
 template <class ResultHandler>
 void exhaustive_inner_product_seq(
@@ -323,6 +375,56 @@ void exhaustive_cosine_seq(
     }
 }
 
+/* rows of y scored by one call of fvec_inner_products_scaled_ny */
+constexpr size_t kScaledBlockSize = 32;
+
+/* Same as exhaustive_inner_product_seq, the inner product of y_j is
+ * multiplied by y_scale[j] inside the SIMD kernel */
+template <class ResultHandler>
+void exhaustive_inner_product_scaled_seq(
+        const float* x,
+        const float* y,
+        const float* y_scale,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        ResultHandler& res,
+        const BitsetView bitset) {
+    using SingleResultHandler = typename ResultHandler::SingleResultHandler;
+    int nt = std::min(int(nx), omp_get_max_threads());
+
+#pragma omp parallel num_threads(nt)
+    {
+        SingleResultHandler resi(res);
+        float dis[kScaledBlockSize];
+#pragma omp for
+        for (int64_t i = 0; i < nx; i++) {
+            const float* x_i = x + i * d;
+            resi.begin(i);
+            if (bitset.empty()) {
+                for (size_t j0 = 0; j0 < ny; j0 += kScaledBlockSize) {
+                    size_t nb = std::min(kScaledBlockSize, ny - j0);
+                    fvec_inner_products_scaled_ny(
+                            dis, x_i, y + j0 * d, y_scale + j0, d, nb);
+                    for (size_t j = 0; j < nb; j++) {
+                        resi.add_result(dis[j], j0 + j);
+                    }
+                }
+            } else {
+                // filtered rows are not scored
+                for (size_t j = 0; j < ny; j++) {
+                    if (!bitset.test(j)) {
+                        fvec_inner_products_scaled_ny(
+                                dis, x_i, y + j * d, y_scale + j, d, 1);
+                        resi.add_result(dis[0], j);
+                    }
+                }
+            }
+            resi.end();
+        }
+    }
+}
+
 /** Find the nearest neighbors for nx queries in a set of ny vectors */
 template <class ResultHandler>
 void exhaustive_inner_product_blas(
@@ -340,7 +442,7 @@ void exhaustive_inner_product_blas(
     /* block sizes */
     const size_t bs_x = distance_compute_blas_query_bs;
     const size_t bs_y = distance_compute_blas_database_bs;
-    std::unique_ptr<float[]> ip_block(new float[bs_x * bs_y]);
+    std::unique_ptr<float[]> ip_block(new float[std::min(bs_x, nx) * bs_y]);
 
     for (size_t i0 = 0; i0 < nx; i0 += bs_x) {
         size_t i1 = i0 + bs_x;
@@ -399,7 +501,7 @@ void exhaustive_L2sqr_blas(
     const size_t bs_x = distance_compute_blas_query_bs;
     const size_t bs_y = distance_compute_blas_database_bs;
     // const size_t bs_x = 16, bs_y = 16;
-    std::unique_ptr<float[]> ip_block(new float[bs_x * bs_y]);
+    std::unique_ptr<float[]> ip_block(new float[std::min(bs_x, nx) * bs_y]);
     std::unique_ptr<float[]> x_norms(new float[nx]);
     std::unique_ptr<float[]> del2;
 
@@ -473,6 +575,7 @@ void exhaustive_cosine_blas(
         size_t nx,
         size_t ny,
         ResultHandler& res,
+        const float* y_norms = nullptr,
         const BitsetView bitset = nullptr) {
     // BLAS does not like empty matrices
     if (nx == 0 || ny == 0)
@@ -482,11 +585,15 @@ void exhaustive_cosine_blas(
     const size_t bs_x = distance_compute_blas_query_bs;
     const size_t bs_y = distance_compute_blas_database_bs;
     // const size_t bs_x = 16, bs_y = 16;
-    std::unique_ptr<float[]> ip_block(new float[bs_x * bs_y]);
-    std::unique_ptr<float[]> y_norms(new float[nx]);
+    std::unique_ptr<float[]> ip_block(new float[std::min(bs_x, nx) * bs_y]);
     std::unique_ptr<float[]> del2;
 
-    fvec_norms_L2(y_norms.get(), x, d, nx);
+    if (!y_norms) {
+        float* y_norms2 = new float[ny];
+        del2.reset(y_norms2);
+        fvec_norms_L2(y_norms2, y, d, ny);
+        y_norms = y_norms2;
+    }
 
     for (size_t i0 = 0; i0 < nx; i0 += bs_x) {
         size_t i1 = i0 + bs_x;
@@ -627,6 +734,9 @@ int distance_compute_blas_threshold = 16384;
 int distance_compute_blas_query_bs = 4096;
 int distance_compute_blas_database_bs = 1024;
 int distance_compute_min_k_reservoir = 100;
+thread_local bool distance_compute_early_abandon = false;
+thread_local float distance_compute_knn_bound =
+        std::numeric_limits<float>::quiet_NaN();
 
 void knn_inner_product(
         const float* x,
@@ -670,7 +780,14 @@ void knn_L2sqr(
         HeapResultHandler<CMax<float, int64_t>> res(
                 ha->nh, ha->val, ha->ids, ha->k);
 
-        if (nx < distance_compute_blas_threshold) {
+        // the early abandon scan only parallelizes on nx, so it is used when
+        // exhaustive_L2sqr_IP_seq would not split ny across threads
+        bool parallel_on_ny =
+                omp_get_max_threads() > 1 && use_parallel_on_ny(nx, ny);
+        if (distance_compute_early_abandon && !parallel_on_ny &&
+            nx < distance_compute_blas_threshold) {
+            exhaustive_L2sqr_early_abandon_seq(x, y, d, nx, ny, res, bitset);
+        } else if (nx < distance_compute_blas_threshold) {
             exhaustive_L2sqr_IP_seq(x, y, d, nx, ny, res, fvec_L2sqr, bitset);
         } else {
             exhaustive_L2sqr_blas(x, y, d, nx, ny, res, y_norm2, bitset);
@@ -700,7 +817,7 @@ void knn_cosine(
         if (nx < distance_compute_blas_threshold) {
             exhaustive_L2sqr_IP_seq(x, y, d, nx, ny, res, fvec_cosine, bitset);
         } else {
-            exhaustive_cosine_blas(x, y, d, nx, ny, res, bitset);
+            exhaustive_cosine_blas(x, y, d, nx, ny, res, nullptr, bitset);
         }
     } else {
         ReservoirResultHandler<CMin<float, int64_t>> res(
@@ -709,17 +826,98 @@ void knn_cosine(
             exhaustive_L2sqr_IP_seq(
                     x, y, d, nx, ny, res, fvec_inner_product, bitset);
         } else {
-            exhaustive_cosine_blas(x, y, d, nx, ny, res, bitset);
+            exhaustive_cosine_blas(x, y, d, nx, ny, res, nullptr, bitset);
         }
     }
 }
 
+void knn_inner_product_scaled(
+        const float* x,
+        const float* y,
+        const float* y_scale,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* ha,
+        const BitsetView bitset) {
+    if (ha->k < distance_compute_min_k_reservoir) {
+        HeapResultHandler<CMin<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_inner_product_scaled_seq(
+                x, y, y_scale, d, nx, ny, res, bitset);
+    } else {
+        ReservoirResultHandler<CMin<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_inner_product_scaled_seq(
+                x, y, y_scale, d, nx, ny, res, bitset);
+    }
+}
+
 struct NopDistanceCorrection {
     float operator()(float dis, size_t /*qno*/, size_t /*bno*/) const {
         return dis;
     }
 };
 
+void knn_inner_product_blas(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* ha,
+        const BitsetView bitset) {
+    if (ha->k < distance_compute_min_k_reservoir) {
+        HeapResultHandler<CMin<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_inner_product_blas(x, y, d, nx, ny, res, bitset);
+    } else {
+        ReservoirResultHandler<CMin<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_inner_product_blas(x, y, d, nx, ny, res, bitset);
+    }
+}
+
+void knn_L2sqr_blas(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_maxheap_array_t* ha,
+        const float* y_norm2,
+        const BitsetView bitset) {
+    if (ha->k < distance_compute_min_k_reservoir) {
+        HeapResultHandler<CMax<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_L2sqr_blas(x, y, d, nx, ny, res, y_norm2, bitset);
+    } else {
+        ReservoirResultHandler<CMax<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_L2sqr_blas(x, y, d, nx, ny, res, y_norm2, bitset);
+    }
+}
+
+void knn_cosine_blas(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* ha,
+        const float* y_norms,
+        const BitsetView bitset) {
+    if (ha->k < distance_compute_min_k_reservoir) {
+        HeapResultHandler<CMin<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_cosine_blas(x, y, d, nx, ny, res, y_norms, bitset);
+    } else {
+        ReservoirResultHandler<CMin<float, int64_t>> res(
+                ha->nh, ha->val, ha->ids, ha->k);
+        exhaustive_cosine_blas(x, y, d, nx, ny, res, y_norms, bitset);
+    }
+}
+
 void knn_jaccard(
         const float* x,
         const float* y,
@@ -790,10 +988,25 @@ void range_search_cosine(
     if (nx < distance_compute_blas_threshold) {
         exhaustive_cosine_seq(x, y, d, nx, ny, resh, bitset);
     } else {
-        exhaustive_cosine_blas(x, y, d, nx, ny, resh, bitset);
+        exhaustive_cosine_blas(x, y, d, nx, ny, resh, nullptr, bitset);
     }
 }
 
+void range_search_inner_product_scaled(
+        const float* x,
+        const float* y,
+        const float* y_scale,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float radius,
+        RangeSearchResult* res,
+        const BitsetView bitset) {
+    RangeSearchResultHandler<CMin<float, int64_t>> resh(res, radius);
+    exhaustive_inner_product_scaled_seq(
+            x, y, y_scale, d, nx, ny, resh, bitset);
+}
+
 /***************************************************************************
  * compute a subset of  distances
  ***************************************************************************/
@@ -876,6 +1089,28 @@ void pairwise_indexed_inner_product(
     }
 }
 
+namespace {
+// the rows listed in ids are not contiguous, so the hardware prefetcher does
+// not help; fetch the row a few ids ahead of the one being computed
+constexpr size_t by_idx_prefetch_distance = 4;
+
+inline void prefetch_row_by_idx(
+        const float* y,
+        size_t d,
+        const int64_t* ids,
+        size_t j,
+        size_t ny) {
+    if (j + by_idx_prefetch_distance < ny &&
+        ids[j + by_idx_prefetch_distance] >= 0) {
+        const char* row =
+                (const char*)(y + d * ids[j + by_idx_prefetch_distance]);
+        for (size_t off = 0; off < d * sizeof(float); off += 64) {
+            __builtin_prefetch(row + off);
+        }
+    }
+}
+} // namespace
+
 /* Find the nearest neighbors for nx queries in a set of ny vectors
    indexed by ids. May be useful for re-ranking a pre-selected vector list */
 void knn_inner_products_by_idx(
@@ -900,6 +1135,7 @@ void knn_inner_products_by_idx(
         for (j = 0; j < ny; j++) {
             if (idsi[j] < 0)
                 break;
+            prefetch_row_by_idx(y, d, idsi, j, ny);
             float ip = fvec_inner_product(x_, y + d * idsi[j], d);
 
             if (ip > simi[0]) {
@@ -928,6 +1164,7 @@ void knn_L2sqr_by_idx(
         int64_t* __restrict idxi = res->get_ids(i);
         maxheap_heapify(res->k, simi, idxi);
         for (size_t j = 0; j < ny; j++) {
+            prefetch_row_by_idx(y, d, idsi, j, ny);
             float disij = fvec_L2sqr(x_, y + d * idsi[j], d);
 
             if (disij < simi[0]) {
@@ -938,6 +1175,38 @@ void knn_L2sqr_by_idx(
     }
 }
 
+void knn_cosine_by_idx(
+        const float* x,
+        const float* y,
+        const int64_t* ids,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* res) {
+    size_t k = res->k;
+
+#pragma omp parallel for
+    for (int64_t i = 0; i < nx; i++) {
+        const float* x_ = x + i * d;
+        const int64_t* idsi = ids + i * ny;
+        float* __restrict simi = res->get_val(i);
+        int64_t* __restrict idxi = res->get_ids(i);
+        minheap_heapify(k, simi, idxi);
+
+        for (size_t j = 0; j < ny; j++) {
+            if (idsi[j] < 0)
+                break;
+            prefetch_row_by_idx(y, d, idsi, j, ny);
+            float ip = fvec_cosine(x_, y + d * idsi[j], d);
+
+            if (ip > simi[0]) {
+                minheap_replace_top(k, simi, idxi, ip, idsi[j]);
+            }
+        }
+        minheap_reorder(k, simi, idxi);
+    }
+}
+
 void pairwise_L2sqr(
         int64_t d,
         int64_t nq,
@@ -13,6 +13,10 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <faiss/impl/platform_macros.h>
 #include <faiss/utils/Heap.h>
 #include <knowhere/bitsetview.h>
@@ -54,6 +58,9 @@ void fvec_norms_L2(float* norms, const float* x, size_t d, size_t nx);
 /// same as fvec_norms_L2, but computes squared norms
 void fvec_norms_L2sqr(float* norms, const float* x, size_t d, size_t nx);
 
+/// same as fvec_norms_L2, but computes 1 / norm, 1 for 0-normed vectors
+void fvec_inverse_norms_L2(float* inv_norms, const float* x, size_t d, size_t nx);
+
 /* L2-renormalize a set of vector. Nothing done if the vector is 0-normed */
 void fvec_renorm_L2(size_t d, size_t nx, float* x);
 
@@ -170,6 +177,55 @@ FAISS_API extern int distance_compute_blas_database_bs;
 // rather than a heap
 FAISS_API extern int distance_compute_min_k_reservoir;
 
+// when set on the calling thread, the L2 distances of knn_L2sqr (heap, non
+// BLAS path) and of the IndexIVFFlat scanner are abandoned as soon as their
+// partial sum exceeds the current k-th best distance
+FAISS_API extern thread_local bool distance_compute_early_abandon;
+
+/// sets distance_compute_early_abandon for the lifetime of the object
+struct ScopedEarlyAbandon {
+    bool prev;
+
+    explicit ScopedEarlyAbandon(bool enable)
+            : prev(distance_compute_early_abandon) {
+        distance_compute_early_abandon = enable;
+    }
+
+    ~ScopedEarlyAbandon() {
+        distance_compute_early_abandon = prev;
+    }
+};
+
+// when set on the calling thread (not NaN), the result heaps of the knn
+// functions and of IndexIVF searches start at this distance instead of the
+// worst one: only closer results are kept, the slots left have id -1. It
+// carries the k-th distance already found by the search of other segments.
+FAISS_API extern thread_local float distance_compute_knn_bound;
+
+/// sets distance_compute_knn_bound for the lifetime of the object
+struct ScopedKnnBound {
+    float prev;
+
+    explicit ScopedKnnBound(float bound) : prev(distance_compute_knn_bound) {
+        distance_compute_knn_bound = bound;
+    }
+
+    ~ScopedKnnBound() {
+        distance_compute_knn_bound = prev;
+    }
+};
+
+/// start a heap just heapified at distance_compute_knn_bound, when it is set
+template <class C>
+inline void heap_apply_knn_bound(size_t k, typename C::T* heap_dis) {
+    if (!std::isnan(distance_compute_knn_bound)) {
+        std::fill(
+                heap_dis,
+                heap_dis + k,
+                static_cast<typename C::T>(distance_compute_knn_bound));
+    }
+}
+
 /** Return the k nearest neighors of each of the nx vectors x among the ny
  *  vector y, w.r.t to max inner product
  *
@@ -208,6 +264,42 @@ void knn_cosine(
         float_minheap_array_t* ha,
         const BitsetView bitset);
 
+/* same as knn_inner_product / knn_L2sqr / knn_cosine, but always use the
+ * blocked BLAS kernels whatever nx is. Meant for callers that split a large
+ * query set into blocks and search the blocks in parallel.
+ *
+ * @param y_norm2  (optional) squared norms of the y vectors
+ * @param y_norms  (optional) norms of the y vectors
+ */
+void knn_inner_product_blas(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* ha,
+        const BitsetView bitset = nullptr);
+
+void knn_L2sqr_blas(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_maxheap_array_t* ha,
+        const float* y_norm2 = nullptr,
+        const BitsetView bitset = nullptr);
+
+void knn_cosine_blas(
+        const float* x,
+        const float* y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* ha,
+        const float* y_norms = nullptr,
+        const BitsetView bitset = nullptr);
+
 void knn_jaccard(
         const float* x,
         const float* y,
@@ -217,6 +309,22 @@ void knn_jaccard(
         float_maxheap_array_t* res,
         const BitsetView bitset = nullptr);
 
+/** Same as knn_inner_product, with the inner product of y_j multiplied by
+ *  y_scale[j]. With unit length queries and the inverse norms of the y
+ *  vectors as y_scale this is the cosine similarity of raw vectors.
+ *
+ * @param y_scale  per vector factors, size ny
+ */
+void knn_inner_product_scaled(
+        const float* x,
+        const float* y,
+        const float* y_scale,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* ha,
+        const BitsetView bitset = nullptr);
+
 /* Find the nearest neighbors for nx queries in a set of ny vectors
  * indexed by ids. May be useful for re-ranking a pre-selected vector list
  */
@@ -238,6 +346,16 @@ void knn_L2sqr_by_idx(
         size_t ny,
         float_maxheap_array_t* res);
 
+/* same as knn_inner_products_by_idx, divided by the norm of the y vectors */
+void knn_cosine_by_idx(
+        const float* x,
+        const float* y,
+        const int64_t* ids,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float_minheap_array_t* res);
+
 /***************************************************************************
  * Range search
  ***************************************************************************/
@@ -284,6 +402,18 @@ void range_search_cosine(
         RangeSearchResult* result,
         const BitsetView bitset = nullptr);
 
+/// same as range_search_inner_product, see knn_inner_product_scaled
+void range_search_inner_product_scaled(
+        const float* x,
+        const float* y,
+        const float* y_scale,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        float radius,
+        RangeSearchResult* result,
+        const BitsetView bitset = nullptr);
+
 /***************************************************************************
  * PQ tables computations
  ***************************************************************************/
@@ -9,6 +9,7 @@
 #include "common/lru_cache.h"
 #include "io/fileIO.h"
 #include "knowhere/bitsetview.h"
+#include "knowhere/comp/huge_page.h"
 #include "knowhere/utils.h"
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-variable"
@@ -42,6 +43,15 @@ typedef unsigned int linklistsizeint;
 constexpr float kHnswSearchKnnBFThreshold = 0.93f;
 constexpr float kHnswSearchRangeBFThreshold = 0.97f;
 constexpr float kAlpha = 0.15f;
+// number of leading cache lines of a neighbor vector prefetched before the distance batch, the hardware prefetcher
+// streams the rest of the vector once its first lines are requested
+constexpr size_t kMaxPrefetchLines = 4;
+// marks the optional internal id -> label map written after the link lists of a reordered index
+constexpr uint64_t kLabelMapMagic = 0x50414d4c4542414cULL;  // "LABELMAP"
+
+// the element type of the stored vectors is saved in the upper bits of the metric type, fp32 (0) keeps the
+// serialized format of existing indexes
+constexpr size_t kDataTypeShift = 16;
 
 enum Metric {
     L2 = 0,
@@ -90,8 +100,10 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         max_elements_ = max_elements;
 
         num_deleted_ = 0;
+        data_type_ = s->get_data_type();
         data_size_ = s->get_data_size();
         fstdistfunc_ = s->get_dist_func();
+        fstquerydistfunc_ = s->get_query_dist_func();
         dist_func_param_ = s->get_dist_func_param();
         M_ = M;
         maxM_ = M_;
@@ -108,7 +120,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         // label_offset_ = size_links_level0_ + data_size_;
         offsetLevel0_ = 0;
 
-        data_level0_memory_ = (char*)malloc(max_elements_ * size_data_per_element_);  // NOLINT
+        data_level0_memory_ = (char*)knowhere::HugePageAlloc(max_elements_ * size_data_per_element_);  // NOLINT
         if (data_level0_memory_ == nullptr)
             throw std::runtime_error("Not enough memory");
 
@@ -164,6 +176,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     // used for free resource
     SpaceInterface<dist_t>* space_;
     size_t metric_type_;  // 0:L2, 1:IP, 2:COSINE
+    knowhere::DataType data_type_ = knowhere::DataType::kFloat32;
 
     size_t max_elements_;
     size_t cur_element_count;
@@ -202,6 +215,8 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     size_t label_offset_;
     DISTFUNC<dist_t> fstdistfunc_;
+    // queries are fp32 for fp16 / bf16 data, compared to the stored vectors without rounding them
+    DISTFUNC<dist_t> fstquerydistfunc_;
     void* dist_func_param_;
 
     std::default_random_engine level_generator_;
@@ -213,11 +228,40 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     mutable knowhere::lru_cache<uint64_t, tableint> lru_cache;
 
+    // set once the nodes are renumbered by reorderByBFS, both are empty while internal ids equal the labels
+    std::vector<labeltype> internal_to_label_;
+    std::vector<tableint> label_to_internal_;
+
+    inline labeltype
+    getExternalLabel(tableint internal_id) const {
+        return internal_to_label_.empty() ? (labeltype)internal_id : internal_to_label_[internal_id];
+    }
+
+    inline tableint
+    getInternalId(labeltype label) const {
+        return label_to_internal_.empty() ? (tableint)label : label_to_internal_[label];
+    }
+
     inline char*
     getDataByInternalId(tableint internal_id) const {
         return (data_level0_memory_ + internal_id * size_data_per_element_ + offsetData_);
     }
 
+    // request the leading cache lines of a vector (and its norm for COSINE) ahead of the distance computation
+    inline void
+    prefetchData(tableint internal_id) const {
+#if defined(USE_PREFETCH)
+        const char* data = getDataByInternalId(internal_id);
+        const size_t lines = std::min(kMaxPrefetchLines, (data_size_ + 63) / 64);
+        for (size_t l = 0; l < lines; l++) {
+            _mm_prefetch(data + l * 64, _MM_HINT_T0);
+        }
+        if (metric_type_ == Metric::COSINE) {
+            _mm_prefetch((const char*)(data_norm_l2_ + internal_id), _MM_HINT_T0);
+        }
+#endif
+    }
+
     int
     getRandomLevel(double reverse_size) {
         std::uniform_real_distribution<double> distribution(0.0, 1.0);
@@ -225,6 +269,39 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         return (int)r;
     }
 
+    // squared L2 norm of a vector in the element type of the index
+    inline float
+    calcNormL2sqr(const void* data) const {
+        size_t dim = *(size_t*)dist_func_param_;
+        switch (data_type_) {
+            case knowhere::DataType::kFloat16:
+                return faiss::fp16_vec_norm_L2sqr((const uint16_t*)data, dim);
+            case knowhere::DataType::kBFloat16:
+                return faiss::bf16_vec_norm_L2sqr((const uint16_t*)data, dim);
+            default:
+                return faiss::fvec_norm_L2sqr((const float*)data, dim);
+        }
+    }
+
+    // bytes of a query, fp32 for fp16 / bf16 data, in the element type of the index otherwise
+    inline size_t
+    querySize() const {
+        if (data_type_ == knowhere::DataType::kFloat16 || data_type_ == knowhere::DataType::kBFloat16) {
+            return *(size_t*)dist_func_param_ * sizeof(float);
+        }
+        return data_size_;
+    }
+
+    // unit length copy of an fp32 query
+    std::unique_ptr<char[]>
+    copyAndNormalizeQuery(const void* query) const {
+        size_t dim = *(size_t*)dist_func_param_;
+        auto res = std::make_unique<char[]>(dim * sizeof(float));
+        std::copy_n((const char*)query, dim * sizeof(float), res.get());
+        knowhere::NormalizeVec((float*)res.get(), dim);
+        return res;
+    }
+
     inline dist_t
     calcDistance(const tableint id1, const tableint id2) const {
         dist_t dist = fstdistfunc_(getDataByInternalId(id1), getDataByInternalId(id2), dist_func_param_);
@@ -243,6 +320,16 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         return dist;
     }
 
+    // distance of a query, see querySize, to a stored vector
+    inline dist_t
+    calcQueryDistance(const void* query, const tableint id) const {
+        dist_t dist = fstquerydistfunc_(query, getDataByInternalId(id), dist_func_param_);
+        if (metric_type_ == Metric::COSINE) {
+            dist /= data_norm_l2_[id];
+        }
+        return dist;
+    }
+
     std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>, CompareByFirst>
     searchBaseLayer(tableint ep_id, tableint cur_c, int layer) {
         auto& visited = visited_list_pool_->getFreeVisitedList();
@@ -257,7 +344,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         top_candidates.emplace(dist, ep_id);
         lowerBound = dist;
         candidateSet.emplace(-dist, ep_id);
-        visited[ep_id] = true;
+        visited.set(ep_id);
 
         while (!candidateSet.empty()) {
             std::pair<dist_t, tableint> curr_el_pair = candidateSet.top();
@@ -287,10 +374,10 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             for (size_t j = 0; j < size; j++) {
                 tableint candidate_id = *(datal + j);
                 // if (candidate_id == 0) continue;
-                if (visited[candidate_id]) {
+                if (visited.get(candidate_id)) {
                     continue;
                 }
-                visited[candidate_id] = true;
+                visited.set(candidate_id);
 
                 dist_t dist1 = calcDistance(cur_c, candidate_id);
                 if (top_candidates.size() < ef_construction_ || lowerBound > dist1) {
@@ -325,15 +412,19 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         }
         auto& visited = visited_list_pool_->getFreeVisitedList();
         NeighborSet retset(ef);
+        // unvisited neighbors of the current node, gathered so that all their vectors are in flight before the
+        // first distance is computed instead of being fetched one neighbor ahead
+        static_assert(sizeof(tableint) == sizeof(uint32_t));
+        auto batch = visited.neighbors(maxM0_);
 
-        if (!has_deletions || !bitset.test((int64_t)ep_id)) {
-            dist_t dist = calcDistance(data_point, ep_id);
+        if (!has_deletions || !bitset.test(getExternalLabel(ep_id))) {
+            dist_t dist = calcQueryDistance(data_point, ep_id);
             retset.insert(Neighbor(ep_id, dist, Neighbor::kValid));
         } else {
             retset.insert(Neighbor(ep_id, std::numeric_limits<dist_t>::max(), Neighbor::kInvalid));
         }
 
-        visited[ep_id] = true;
+        visited.set(ep_id);
         float accumulative_alpha = 0.0f;
         while (retset.has_next()) {
             auto [u, d, s] = retset.pop();
@@ -344,24 +435,25 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 metric_hops++;
                 metric_distance_computations += size;
             }
-            for (size_t i = 1; i <= size; ++i) {
 #if defined(USE_PREFETCH)
-                if (i + 1 <= size) {
-                    _mm_prefetch(getDataByInternalId(list[i + 1]), _MM_HINT_T0);
-                }
+            for (size_t i = 1; i <= size; ++i) {
+                visited.prefetch(list[i]);
+            }
 #endif
+            size_t batch_size = 0;
+            for (size_t i = 1; i <= size; ++i) {
                 tableint v = list[i];
-                if (visited[v]) {
+                if (visited.get(v)) {
                     if (feder_result != nullptr) {
-                        feder_result->visit_info_.AddVisitRecord(0, u, v, -1.0);
-                        feder_result->id_set_.insert(u);
-                        feder_result->id_set_.insert(v);
+                        feder_result->visit_info_.AddVisitRecord(0, getExternalLabel(u), getExternalLabel(v), -1.0);
+                        feder_result->id_set_.insert(getExternalLabel(u));
+                        feder_result->id_set_.insert(getExternalLabel(v));
                     }
                     continue;
                 }
-                visited[v] = true;
+                visited.set(v);
                 int status = Neighbor::kValid;
-                if (has_deletions && bitset.test((int64_t)v)) {
+                if (has_deletions && bitset.test(getExternalLabel(v))) {
                     status = Neighbor::kInvalid;
 
                     accumulative_alpha += kAlpha;
@@ -370,11 +462,16 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                     }
                     accumulative_alpha -= 1.0f;
                 }
-                dist_t dist = calcDistance(data_point, v);
+                prefetchData(v);
+                batch[batch_size++] = {v, status};
+            }
+            for (size_t i = 0; i < batch_size; ++i) {
+                auto [v, status] = batch[i];
+                dist_t dist = calcQueryDistance(data_point, v);
                 if (feder_result != nullptr) {
-                    feder_result->visit_info_.AddVisitRecord(0, u, v, dist);
-                    feder_result->id_set_.insert(u);
-                    feder_result->id_set_.insert(v);
+                    feder_result->visit_info_.AddVisitRecord(0, getExternalLabel(u), getExternalLabel(v), dist);
+                    feder_result->id_set_.insert(getExternalLabel(u));
+                    feder_result->id_set_.insert(getExternalLabel(v));
                 }
 
                 Neighbor nn(v, dist, status);
@@ -437,7 +534,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     std::vector<std::pair<dist_t, labeltype>>
     getNeighboursWithinRadius(std::vector<std::pair<dist_t, tableint>>& top_candidates, const void* data_point,
-                              float radius, const knowhere::BitsetView bitset) const {
+                              float radius, const knowhere::BitsetView bitset, int64_t max_results = -1) const {
         std::vector<std::pair<dist_t, labeltype>> result;
         auto& visited = visited_list_pool_->getFreeVisitedList();
 
@@ -447,12 +544,14 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             top_candidates.pop_back();
             if (cand.first < radius) {
                 radius_queue.push(cand);
-                result.emplace_back(cand.first, cand.second);
+                result.emplace_back(cand.first, getExternalLabel(cand.second));
             }
-            visited[cand.second] = true;
+            visited.set(cand.second);
         }
 
-        while (!radius_queue.empty()) {
+        // stop expanding once enough hits are found
+        auto enough = [&]() { return max_results >= 0 && result.size() >= (size_t)max_results; };
+        while (!radius_queue.empty() && !enough()) {
             auto cur = radius_queue.front();
             radius_queue.pop();
 
@@ -467,13 +566,13 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 #endif
             for (size_t j = 1; j <= size; j++) {
                 int candidate_id = *(data + j);
-                if (!visited[candidate_id]) {
-                    visited[candidate_id] = true;
-                    if (bitset.empty() || !bitset.test((int64_t)candidate_id)) {
-                        dist_t dist = calcDistance(data_point, candidate_id);
+                if (!visited.get(candidate_id)) {
+                    visited.set(candidate_id);
+                    if (bitset.empty() || !bitset.test(getExternalLabel(candidate_id))) {
+                        dist_t dist = calcQueryDistance(data_point, candidate_id);
                         if (dist < radius) {
                             radius_queue.push({dist, candidate_id});
-                            result.emplace_back(dist, candidate_id);
+                            result.emplace_back(dist, getExternalLabel(candidate_id));
                         }
                     }
                 }
@@ -635,6 +734,9 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         if (data_level0_memory_new == nullptr)
             throw std::runtime_error("Not enough memory: resizeIndex failed to allocate base layer");
         data_level0_memory_ = data_level0_memory_new;
+        if (knowhere::AdviseHugePages(data_level0_memory_, new_max_elements * size_data_per_element_) > 0) {
+            knowhere::UpdateHugePageMetric();
+        }
 
         // for COSINE, resize data_norm_l2_
         if (metric_type_ == Metric::COSINE) {
@@ -663,14 +765,16 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
         size_t dim;
         readBinaryPOD(input, metric_type_);
+        data_type_ = static_cast<knowhere::DataType>(metric_type_ >> kDataTypeShift);
+        metric_type_ &= (1UL << kDataTypeShift) - 1;
         readBinaryPOD(input, data_size_);
         readBinaryPOD(input, dim);
         if (metric_type_ == Metric::L2) {
-            space_ = new hnswlib::L2Space(dim);
+            space_ = new hnswlib::L2Space(dim, data_type_);
         } else if (metric_type_ == Metric::INNER_PRODUCT) {
-            space_ = new hnswlib::InnerProductSpace(dim);
+            space_ = new hnswlib::InnerProductSpace(dim, data_type_);
         } else if (metric_type_ == Metric::COSINE) {
-            space_ = new hnswlib::CosineSpace(dim);
+            space_ = new hnswlib::CosineSpace(dim, data_type_);
         } else if (metric_type_ == Metric::HAMMING) {
             space_ = new hnswlib::HammingSpace(dim);
         } else if (metric_type_ == Metric::JACCARD) {
@@ -681,6 +785,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             throw std::runtime_error("Invalid metric type " + std::to_string(metric_type_));
         }
         fstdistfunc_ = space_->get_dist_func();
+        fstquerydistfunc_ = space_->get_query_dist_func();
         dist_func_param_ = space_->get_dist_func_param();
 
         readBinaryPOD(input, offsetLevel0_);
@@ -717,7 +822,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 input.advance(cur_element_count * sizeof(float));
             }
         } else {
-            data_level0_memory_ = (char*)malloc(max_elements * size_data_per_element_);  // NOLINT
+            data_level0_memory_ = (char*)knowhere::HugePageAlloc(max_elements * size_data_per_element_);  // NOLINT
             input.read(data_level0_memory_, cur_element_count * size_data_per_element_);
 
             // for COSINE, need load data_norm_l2_
@@ -756,6 +861,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 input.read(linkLists_[i], linkListSize);
             }
         }
+        loadLabelMap(input, input.size() - input.offset());
 
         input.close();
     }
@@ -763,7 +869,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     void
     saveIndex(knowhere::MemoryIOWriter& output) {
         // write l2/ip calculator
-        writeBinaryPOD(output, metric_type_);
+        writeBinaryPOD(output, metric_type_ | (static_cast<size_t>(data_type_) << kDataTypeShift));
         writeBinaryPOD(output, data_size_);
         writeBinaryPOD(output, *((size_t*)dist_func_param_));
 
@@ -794,22 +900,136 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             if (linkListSize)
                 output.write(linkLists_[i], linkListSize);
         }
+        if (!internal_to_label_.empty()) {
+            writeBinaryPOD(output, kLabelMapMagic);
+            output.write(internal_to_label_.data(), cur_element_count * sizeof(labeltype));
+        }
         // output.close();
     }
 
+    // reads the label map of a reordered index, indexes without one end right after the link lists. Trailing data
+    // that is not a label map is left alone.
+    template <typename Reader>
+    void
+    loadLabelMap(Reader& input, size_t remaining) {
+        uint64_t magic = 0;
+        if (remaining < sizeof(magic) + cur_element_count * sizeof(labeltype)) {
+            return;
+        }
+        readBinaryPOD(input, magic);
+        if (magic != kLabelMapMagic) {
+            return;
+        }
+        internal_to_label_.resize(cur_element_count);
+        input.read((char*)internal_to_label_.data(), cur_element_count * sizeof(labeltype));
+        buildLabelToInternal();
+    }
+
+    void
+    buildLabelToInternal() {
+        labeltype max_label = 0;
+        for (auto label : internal_to_label_) {
+            max_label = std::max(max_label, label);
+        }
+        label_to_internal_.assign(max_label + 1, 0);
+        for (tableint i = 0; i < internal_to_label_.size(); i++) {
+            label_to_internal_[internal_to_label_[i]] = i;
+        }
+    }
+
+    // Renumber the nodes in BFS order of the level 0 graph, starting from the entry point, so that graph neighbors
+    // sit next to each other in memory. Search results, bitsets and GetVectorByIds keep using the labels given to
+    // addPoint. Meant for a finished index: no point may be added afterwards.
+    void
+    reorderByBFS() {
+        if (mmap_enabled_ || cur_element_count <= 1) {
+            return;
+        }
+        const size_t n = cur_element_count;
+        constexpr tableint kUnassigned = std::numeric_limits<tableint>::max();
+        std::vector<tableint> new_id(n, kUnassigned);
+        std::vector<tableint> order;
+        order.reserve(n);
+        auto bfs = [&](tableint root) {
+            size_t head = order.size();
+            new_id[root] = order.size();
+            order.push_back(root);
+            while (head < order.size()) {
+                tableint* list = (tableint*)get_linklist0(order[head++]);
+                size_t size = getListCount((linklistsizeint*)list);
+                for (size_t j = 1; j <= size; j++) {
+                    if (new_id[list[j]] == kUnassigned) {
+                        new_id[list[j]] = order.size();
+                        order.push_back(list[j]);
+                    }
+                }
+            }
+        };
+        bfs(enterpoint_node_);
+        for (tableint i = 0; i < n; i++) {
+            if (new_id[i] == kUnassigned) {
+                bfs(i);
+            }
+        }
+
+        auto remap_links = [&](linklistsizeint* ll) {
+            size_t size = getListCount(ll);
+            tableint* links = (tableint*)(ll + 1);
+            for (size_t j = 0; j < size; j++) {
+                links[j] = new_id[links[j]];
+            }
+        };
+        char* level0 = (char*)knowhere::HugePageAlloc(max_elements_ * size_data_per_element_);  // NOLINT
+        if (level0 == nullptr) {
+            throw std::runtime_error("Not enough memory: reorderByBFS failed to allocate level0");
+        }
+        std::vector<char*> link_lists(n);
+        std::vector<int> levels(n);
+        std::vector<labeltype> labels(n);
+        for (tableint i = 0; i < n; i++) {
+            tableint old = order[i];
+            memcpy(level0 + i * size_data_per_element_, data_level0_memory_ + old * size_data_per_element_,
+                   size_data_per_element_);
+            remap_links(get_linklist0(i, level0));
+            link_lists[i] = linkLists_[old];
+            levels[i] = element_levels_[old];
+            for (int level = 1; level <= levels[i]; level++) {
+                remap_links((linklistsizeint*)(link_lists[i] + (level - 1) * size_links_per_element_));
+            }
+            labels[i] = getExternalLabel(old);
+        }
+        free(data_level0_memory_);
+        data_level0_memory_ = level0;
+        if (metric_type_ == Metric::COSINE) {
+            std::vector<float> norms(data_norm_l2_, data_norm_l2_ + n);
+            for (tableint i = 0; i < n; i++) {
+                data_norm_l2_[i] = norms[order[i]];
+            }
+        }
+        std::copy(link_lists.begin(), link_lists.end(), linkLists_);
+        std::copy(levels.begin(), levels.end(), element_levels_.begin());
+        enterpoint_node_ = new_id[enterpoint_node_];
+        internal_to_label_ = std::move(labels);
+        buildLabelToInternal();
+        // cached entry points are internal ids of the old numbering
+        lru_cache.clear();
+    }
+
     void
     loadIndex(knowhere::MemoryIOReader& input, size_t max_elements_i = 0) {
         // linxj: init with metrictype
         size_t dim;
         readBinaryPOD(input, metric_type_);
+        data_type_ = static_cast<knowhere::DataType>(metric_type_ >> kDataTypeShift);
+        metric_type_ &= (1UL << kDataTypeShift) - 1;
         readBinaryPOD(input, data_size_);
         readBinaryPOD(input, dim);
         if (metric_type_ == Metric::L2) {
-            space_ = new hnswlib::L2Space(dim);
+            space_ = new hnswlib::L2Space(dim, data_type_);
         } else if (metric_type_ == Metric::INNER_PRODUCT) {
-            space_ = new hnswlib::InnerProductSpace(dim);
+            space_ = new hnswlib::InnerProductSpace(dim, data_type_);
         } else if (metric_type_ == Metric::COSINE) {
-            space_ = new hnswlib::CosineSpace(dim);
+            space_ = new hnswlib::CosineSpace(dim, data_type_);
         } else if (metric_type_ == Metric::HAMMING) {
             space_ = new hnswlib::HammingSpace(dim);
         } else if (metric_type_ == Metric::JACCARD) {
@@ -820,6 +1040,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             throw std::runtime_error("Invalid metric type " + std::to_string(metric_type_));
         }
         fstdistfunc_ = space_->get_dist_func();
+        fstquerydistfunc_ = space_->get_query_dist_func();
         dist_func_param_ = space_->get_dist_func_param();
 
         readBinaryPOD(input, offsetLevel0_);
@@ -843,7 +1064,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         readBinaryPOD(input, mult_);
         readBinaryPOD(input, ef_construction_);
 
-        data_level0_memory_ = (char*)malloc(max_elements * size_data_per_element_);  // NOLINT
+        data_level0_memory_ = (char*)knowhere::HugePageAlloc(max_elements * size_data_per_element_);  // NOLINT
         if (data_level0_memory_ == nullptr)
             throw std::runtime_error("Not enough memory: loadIndex failed to allocate level0");
         input.read(data_level0_memory_, cur_element_count * size_data_per_element_);
@@ -883,6 +1104,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 input.read(linkLists_[i], linkListSize);
             }
         }
+        loadLabelMap(input, input.total - input.rp);
     }
 
     unsigned short int
@@ -1088,8 +1310,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         memcpy(getDataByInternalId(cur_c), data_point, data_size_);
 
         if (metric_type_ == Metric::COSINE) {
-            data_norm_l2_[cur_c] =
-                std::sqrt(faiss::fvec_norm_L2sqr((const float*)data_point, *(size_t*)(dist_func_param_)));
+            data_norm_l2_[cur_c] = std::sqrt(calcNormL2sqr(data_point));
         }
 
         if (curlevel) {
@@ -1153,20 +1374,27 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     std::vector<std::pair<dist_t, labeltype>>
     searchKnnBF(const void* query_data, size_t k, const knowhere::BitsetView bitset) const {
-        knowhere::ResultMaxHeap<dist_t, labeltype> max_heap(k);
-        for (labeltype id = 0; id < cur_element_count; ++id) {
-            if (!bitset.test(id)) {
-                dist_t dist = calcDistance(query_data, id);
-                max_heap.Push(dist, id);
+        return knowhere::WithTopKSelector<dist_t, labeltype>(k, [&](auto& selector) {
+            for (tableint id = 0; id < cur_element_count; ++id) {
+                auto label = getExternalLabel(id);
+                if (!bitset.test(label)) {
+                    dist_t dist = calcQueryDistance(query_data, id);
+                    selector.Push(dist, label);
+                }
             }
-        }
-        const size_t len = std::min(max_heap.Size(), k);
-        std::vector<std::pair<dist_t, labeltype>> result(len);
-        for (int64_t i = len - 1; i >= 0; --i) {
-            const auto op = max_heap.Pop();
-            result[i] = op.value();
-        }
-        return result;
+            return selector.SortedResults();
+        });
+    }
+
+    // brute force over the given labels only, gathered once from the bitset by the caller
+    std::vector<std::pair<dist_t, labeltype>>
+    searchKnnBF(const void* query_data, size_t k, const std::vector<labeltype>& labels) const {
+        return knowhere::WithTopKSelector<dist_t, labeltype>(k, [&](auto& selector) {
+            for (auto label : labels) {
+                selector.Push(calcQueryDistance(query_data, getInternalId(label)), label);
+            }
+            return selector.SortedResults();
+        });
     }
 
     std::vector<std::pair<dist_t, labeltype>>
@@ -1182,20 +1410,32 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         // }
 
         // do normalize for COSINE metric type
-        std::unique_ptr<float[]> query_data_norm;
+        std::unique_ptr<char[]> query_data_norm;
         if (metric_type_ == Metric::COSINE) {
-            query_data_norm = knowhere::CopyAndNormalizeFloatVec((const float*)query_data, dim);
+            query_data_norm = copyAndNormalizeQuery(query_data);
             query_data = query_data_norm.get();
         }
 
-        // do bruteforce search when delete rate high
+        // choose the filtered search strategy, do bruteforce search when delete rate high
+        size_t ef = param ? param->ef_ : this->ef_;
         if (!bitset.empty()) {
             const auto bs_cnt = bitset.count();
             if (bs_cnt == cur_element_count)
                 return {};
-            if (bs_cnt >= (cur_element_count * kHnswSearchKnnBFThreshold)) {
+            // a strategy already resolved by the caller comes with its ef
+            auto plan = knowhere::FilterSearchPlan{param ? param->filter_strategy_ : knowhere::FilterStrategy::kAuto,
+                                                   static_cast<int64_t>(ef)};
+            if (plan.strategy == knowhere::FilterStrategy::kAuto) {
+                plan = knowhere::PlanGraphFilteredSearch(knowhere::FilterStrategy::kAuto, bitset, cur_element_count,
+                                                         std::max(ef, k), maxM0_, kHnswSearchKnnBFThreshold);
+            }
+            if (plan.strategy == knowhere::FilterStrategy::kBruteForce) {
+                if (param != nullptr && param->unfiltered_labels_ != nullptr) {
+                    return searchKnnBF(query_data, k, *param->unfiltered_labels_);
+                }
                 return searchKnnBF(query_data, k, bitset);
             }
+            ef = plan.search_width;
         }
 
         tableint currObj = enterpoint_node_;
@@ -1207,7 +1447,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         }
         // for tuning, do not use cache
         if (param->for_tuning || !lru_cache.try_get(vec_hash, currObj)) {
-            dist_t curdist = calcDistance(query_data, enterpoint_node_);
+            dist_t curdist = calcQueryDistance(query_data, enterpoint_node_);
 
             for (int level = maxlevel_; level > 0; level--) {
                 bool changed = true;
@@ -1232,11 +1472,12 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                         tableint cand = datal[i];
                         if (cand < 0 || cand > max_elements_)
                             throw std::runtime_error("cand error");
-                        dist_t d = calcDistance(query_data, cand);
+                        dist_t d = calcQueryDistance(query_data, cand);
                         if (feder_result != nullptr) {
-                            feder_result->visit_info_.AddVisitRecord(level, currObj, cand, d);
-                            feder_result->id_set_.insert(currObj);
-                            feder_result->id_set_.insert(cand);
+                            feder_result->visit_info_.AddVisitRecord(level, getExternalLabel(currObj),
+                                                                     getExternalLabel(cand), d);
+                            feder_result->id_set_.insert(getExternalLabel(currObj));
+                            feder_result->id_set_.insert(getExternalLabel(cand));
                         }
 
                         if (d < curdist) {
@@ -1249,7 +1490,6 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             }
         }
         std::vector<std::pair<dist_t, tableint>> top_candidates;
-        size_t ef = param ? param->ef_ : this->ef_;
         if (!bitset.empty()) {
             top_candidates = searchBaseLayerST<true, true>(currObj, query_data, std::max(ef, k), bitset, feder_result);
         } else {
@@ -1259,10 +1499,10 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         size_t len = std::min(k, top_candidates.size());
         result.reserve(len);
         for (int i = 0; i < len; ++i) {
-            result.emplace_back(top_candidates[i].first, (labeltype)top_candidates[i].second);
+            result.emplace_back(top_candidates[i].first, getExternalLabel(top_candidates[i].second));
         }
         if (len > 0) {
-            lru_cache.put(vec_hash, result[0].second);
+            lru_cache.put(vec_hash, top_candidates[0].second);
         }
         return result;
     };
@@ -1270,11 +1510,12 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     std::vector<std::pair<dist_t, labeltype>>
     searchRangeBF(const void* query_data, float radius, const knowhere::BitsetView bitset) const {
         std::vector<std::pair<dist_t, labeltype>> result;
-        for (labeltype id = 0; id < cur_element_count; ++id) {
-            if (!bitset.test(id)) {
-                dist_t dist = calcDistance(query_data, id);
+        for (tableint id = 0; id < cur_element_count; ++id) {
+            auto label = getExternalLabel(id);
+            if (!bitset.test(label)) {
+                dist_t dist = calcQueryDistance(query_data, id);
                 if (dist < radius) {
-                    result.emplace_back(dist, id);
+                    result.emplace_back(dist, label);
                 }
             }
         }
@@ -1296,9 +1537,9 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         // }
 
         // do normalize for COSINE metric type
-        std::unique_ptr<float[]> query_data_norm;
+        std::unique_ptr<char[]> query_data_norm;
         if (metric_type_ == Metric::COSINE) {
-            query_data_norm = knowhere::CopyAndNormalizeFloatVec((const float*)query_data, dim);
+            query_data_norm = copyAndNormalizeQuery(query_data);
             query_data = query_data_norm.get();
         }
 
@@ -1321,7 +1562,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         }
         // for tuning, do not use cache
         if (param->for_tuning || !lru_cache.try_get(vec_hash, currObj)) {
-            dist_t curdist = calcDistance(query_data, enterpoint_node_);
+            dist_t curdist = calcQueryDistance(query_data, enterpoint_node_);
 
             for (int level = maxlevel_; level > 0; level--) {
                 bool changed = true;
@@ -1342,11 +1583,12 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                         tableint cand = datal[i];
                         if (cand < 0 || cand > max_elements_)
                             throw std::runtime_error("cand error");
-                        dist_t d = calcDistance(query_data, cand);
+                        dist_t d = calcQueryDistance(query_data, cand);
                         if (feder_result != nullptr) {
-                            feder_result->visit_info_.AddVisitRecord(level, currObj, cand, d);
-                            feder_result->id_set_.insert(currObj);
-                            feder_result->id_set_.insert(cand);
+                            feder_result->visit_info_.AddVisitRecord(level, getExternalLabel(currObj),
+                                                                     getExternalLabel(cand), d);
+                            feder_result->id_set_.insert(getExternalLabel(currObj));
+                            feder_result->id_set_.insert(getExternalLabel(cand));
                         }
                         if (d < curdist) {
                             curdist = d;
@@ -1358,13 +1600,15 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             }
         }
 
-        std::vector<std::pair<dist_t, tableint>> top_candidates;
+        auto search_base_layer = [&](size_t ef) {
+            if (!bitset.empty()) {
+                return searchBaseLayerST<true, true>(currObj, query_data, ef, bitset, feder_result);
+            }
+            return searchBaseLayerST<false, true>(currObj, query_data, ef, bitset, feder_result);
+        };
         size_t ef = param ? param->ef_ : this->ef_;
-        if (!bitset.empty()) {
-            top_candidates = searchBaseLayerST<true, true>(currObj, query_data, ef, bitset, feder_result);
-        } else {
-            top_candidates = searchBaseLayerST<false, true>(currObj, query_data, ef, bitset, feder_result);
-        }
+        const int64_t max_results = param ? param->range_search_k_ : -1;
+        std::vector<std::pair<dist_t, tableint>> top_candidates = search_base_layer(ef);
 
         if (top_candidates.size() == 0) {
             return {};
@@ -1372,7 +1616,135 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             lru_cache.put(vec_hash, top_candidates[0].second);
         }
 
-        return getNeighboursWithinRadius(top_candidates, query_data, radius, bitset);
+        if (param && param->range_adaptive_ef_) {
+            return searchRangeAdaptiveEf(top_candidates, search_base_layer, ef, radius, max_results);
+        }
+        return getNeighboursWithinRadius(top_candidates, query_data, radius, bitset, max_results);
+    }
+
+    // Widen ef while every candidate of the last base layer search is in range and the widening found new hits.
+    template <typename SearchBaseLayer>
+    std::vector<std::pair<dist_t, labeltype>>
+    searchRangeAdaptiveEf(std::vector<std::pair<dist_t, tableint>>& top_candidates, SearchBaseLayer& search_base_layer,
+                          size_t ef, float radius, int64_t max_results) const {
+        auto count_in_range = [&]() {
+            return (size_t)std::count_if(top_candidates.begin(), top_candidates.end(),
+                                         [&](const auto& cand) { return cand.first < radius; });
+        };
+        size_t in_range = count_in_range();
+        size_t prev_in_range = 0;
+        while (in_range == top_candidates.size() && in_range > prev_in_range && ef < cur_element_count &&
+               (max_results < 0 || in_range < (size_t)max_results)) {
+            prev_in_range = in_range;
+            ef = std::min<size_t>(ef * 2, cur_element_count);
+            top_candidates = search_base_layer(ef);
+            in_range = count_in_range();
+        }
+
+        std::vector<std::pair<dist_t, labeltype>> result;
+        result.reserve(in_range);
+        for (const auto& cand : top_candidates) {
+            if (cand.first < radius) {
+                result.emplace_back(cand.first, getExternalLabel(cand.second));
+            }
+        }
+        return result;
+    }
+
+    using MinHeap = std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>,
+                                        std::greater<std::pair<dist_t, tableint>>>;
+
+    // State of a level 0 best-first search resumed by getIteratorNext: the nodes whose neighbors are still to be
+    // expanded, the unfiltered nodes found but not returned yet, and the visited nodes. It does not use the visited
+    // list pool, since the search outlives the thread that started it.
+    struct IteratorWorkspace {
+        std::unique_ptr<char[]> query;
+        knowhere::BitsetView bitset;
+        // number of found nodes kept ahead of the returned ones
+        size_t ef;
+        std::vector<bool> visited;
+        MinHeap to_expand;
+        MinHeap found;
+    };
+
+    std::unique_ptr<IteratorWorkspace>
+    getIteratorWorkspace(const void* query_data, size_t ef, const knowhere::BitsetView bitset) const {
+        auto workspace = std::make_unique<IteratorWorkspace>();
+        if (metric_type_ == Metric::COSINE) {
+            workspace->query = copyAndNormalizeQuery(query_data);
+        } else {
+            workspace->query = std::make_unique<char[]>(querySize());
+            std::copy_n((const char*)query_data, querySize(), workspace->query.get());
+        }
+        workspace->bitset = bitset;
+        workspace->ef = std::max<size_t>(ef, 1);
+        if (cur_element_count == 0) {
+            return workspace;
+        }
+        workspace->visited.resize(cur_element_count);
+
+        // greedy descent of the upper levels, as in searchKnn
+        const void* query = workspace->query.get();
+        tableint currObj = enterpoint_node_;
+        dist_t curdist = calcQueryDistance(query, currObj);
+        for (int level = maxlevel_; level > 0; level--) {
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                auto data = (unsigned int*)get_linklist(currObj, level);
+                int size = getListCount(data);
+                auto datal = (tableint*)(data + 1);
+                for (int i = 0; i < size; i++) {
+                    dist_t d = calcQueryDistance(query, datal[i]);
+                    if (d < curdist) {
+                        curdist = d;
+                        currObj = datal[i];
+                        changed = true;
+                    }
+                }
+            }
+        }
+        workspace->visited[currObj] = true;
+        workspace->to_expand.emplace(curdist, currObj);
+        if (bitset.empty() || !bitset.test(getExternalLabel(currObj))) {
+            workspace->found.emplace(curdist, currObj);
+        }
+        return workspace;
+    }
+
+    // Next closest unfiltered node of the search in `workspace`, false once the reachable nodes are exhausted.
+    // Nodes are expanded until `ef` found nodes are ahead of the returned ones and none of the nodes left to expand
+    // is closer than the one returned, filtered nodes are expanded too but never returned.
+    bool
+    getIteratorNext(IteratorWorkspace* workspace, std::pair<dist_t, labeltype>& result) const {
+        auto& to_expand = workspace->to_expand;
+        auto& found = workspace->found;
+        const auto& bitset = workspace->bitset;
+        const void* query = workspace->query.get();
+        while (!to_expand.empty() && (found.size() < workspace->ef || to_expand.top().first <= found.top().first)) {
+            tableint u = to_expand.top().second;
+            to_expand.pop();
+            auto list = (tableint*)get_linklist0(u);
+            int size = list[0];
+            for (int i = 1; i <= size; ++i) {
+                tableint v = list[i];
+                if (workspace->visited[v]) {
+                    continue;
+                }
+                workspace->visited[v] = true;
+                dist_t dist = calcQueryDistance(query, v);
+                to_expand.emplace(dist, v);
+                if (bitset.empty() || !bitset.test(getExternalLabel(v))) {
+                    found.emplace(dist, v);
+                }
+            }
+        }
+        if (found.empty()) {
+            return false;
+        }
+        result = {found.top().first, getExternalLabel(found.top().second)};
+        found.pop();
+        return true;
     }
 
     void
@@ -1418,6 +1790,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         ret += element_levels_.size() * sizeof(int);
         ret += max_elements_ * size_data_per_element_;
         ret += max_elements_ * sizeof(void*);
+        ret += internal_to_label_.size() * sizeof(labeltype) + label_to_internal_.size() * sizeof(tableint);
         for (auto i = 0; i < max_elements_; ++i) {
             if (element_levels_[i] > 0) {
                 ret += size_links_per_element_ * element_levels_[i];
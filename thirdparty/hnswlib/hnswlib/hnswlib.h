@@ -124,7 +124,9 @@ AVX512Capable() {
 #endif
 
 #include <knowhere/bitsetview.h>
+#include <knowhere/comp/filter_strategy.h>
 #include <knowhere/feder/HNSW.h>
+#include <knowhere/operands.h>
 #include <string.h>
 
 #include <fstream>
@@ -183,9 +185,21 @@ class SpaceInterface {
     virtual DISTFUNC<MTYPE>
     get_dist_func() = 0;
 
+    // distance from a query to a stored vector, queries are fp32 for fp16 / bf16 data
+    virtual DISTFUNC<MTYPE>
+    get_query_dist_func() {
+        return get_dist_func();
+    }
+
     virtual void*
     get_dist_func_param() = 0;
 
+    // element type of the stored vectors
+    virtual knowhere::DataType
+    get_data_type() {
+        return knowhere::DataType::kFloat32;
+    }
+
     virtual ~SpaceInterface() {
     }
 };
@@ -193,6 +207,15 @@ class SpaceInterface {
 struct SearchParam {
     size_t ef_;
     bool for_tuning;
+    // how searches with a bitset are executed, planned once per batch by the caller with ef_ already enlarged for
+    // kExpandedSearch, kAuto lets searchKnn plan for itself
+    knowhere::FilterStrategy filter_strategy_ = knowhere::FilterStrategy::kAuto;
+    // labels not set in the bitset, gathered once per batch for kBruteForce, null to test the bitset per row
+    const std::vector<labeltype>* unfiltered_labels_ = nullptr;
+    // range search stops expanding once this many hits are found, < 0 for no limit
+    int64_t range_search_k_ = -1;
+    // range search doubles ef while all candidates are in range, instead of expanding from the in range candidates
+    bool range_adaptive_ef_ = false;
 };
 
 template <typename dist_t>
@@ -15,16 +15,50 @@ CosineDistance(const void* pVect1, const void* pVect2, const void* qty_ptr) {
     return -1.0f * Cosine(pVect1, pVect2, qty_ptr);
 }
 
+static float
+CosineDistanceFp16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f *
+           faiss::fp16_vec_inner_product((const uint16_t*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
+static float
+CosineDistanceBf16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f *
+           faiss::bf16_vec_inner_product((const uint16_t*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
+// fp32 query against fp16 / bf16 data
+static float
+CosineDistanceFp32Fp16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f * faiss::fvec_fp16_inner_product((const float*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
+static float
+CosineDistanceFp32Bf16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f * faiss::fvec_bf16_inner_product((const float*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
 class CosineSpace : public SpaceInterface<float> {
     DISTFUNC<float> fstdistfunc_;
+    DISTFUNC<float> querydistfunc_;
     size_t data_size_;
     size_t dim_;
+    knowhere::DataType data_type_;
 
  public:
-    CosineSpace(size_t dim) {
+    CosineSpace(size_t dim, knowhere::DataType data_type = knowhere::DataType::kFloat32) {
         fstdistfunc_ = CosineDistance;
+        querydistfunc_ = CosineDistance;
+        if (data_type == knowhere::DataType::kFloat16) {
+            fstdistfunc_ = CosineDistanceFp16;
+            querydistfunc_ = CosineDistanceFp32Fp16;
+        } else if (data_type == knowhere::DataType::kBFloat16) {
+            fstdistfunc_ = CosineDistanceBf16;
+            querydistfunc_ = CosineDistanceFp32Bf16;
+        }
         dim_ = dim;
-        data_size_ = dim * sizeof(float);
+        data_type_ = data_type;
+        data_size_ = dim * knowhere::DataTypeSize(data_type);
     }
 
     size_t
@@ -37,11 +71,21 @@ class CosineSpace : public SpaceInterface<float> {
         return fstdistfunc_;
     }
 
+    DISTFUNC<float>
+    get_query_dist_func() {
+        return querydistfunc_;
+    }
+
     void*
     get_dist_func_param() {
         return &dim_;
     }
 
+    knowhere::DataType
+    get_data_type() {
+        return data_type_;
+    }
+
     ~CosineSpace() {
     }
 };
@@ -24,6 +24,29 @@ InnerProductDistance(const void* pVect1, const void* pVect2, const void* qty_ptr
     return -1.0f * InnerProduct(pVect1, pVect2, qty_ptr);
 }
 
+static float
+InnerProductDistanceFp16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f *
+           faiss::fp16_vec_inner_product((const uint16_t*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
+static float
+InnerProductDistanceBf16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f *
+           faiss::bf16_vec_inner_product((const uint16_t*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
+// fp32 query against fp16 / bf16 data
+static float
+InnerProductDistanceFp32Fp16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f * faiss::fvec_fp16_inner_product((const float*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
+static float
+InnerProductDistanceFp32Bf16(const void* pVect1, const void* pVect2, const void* qty_ptr) {
+    return -1.0f * faiss::fvec_bf16_inner_product((const float*)pVect1, (const uint16_t*)pVect2, *((size_t*)qty_ptr));
+}
+
 #if defined(USE_AVX)
 
 // Favor using AVX if available.
@@ -321,11 +344,13 @@ InnerProductDistanceSIMD4ExtResiduals(const void* pVect1v, const void* pVect2v,
 
 class InnerProductSpace : public SpaceInterface<float> {
     DISTFUNC<float> fstdistfunc_;
+    DISTFUNC<float> querydistfunc_;
     size_t data_size_;
     size_t dim_;
+    knowhere::DataType data_type_;
 
  public:
-    InnerProductSpace(size_t dim) {
+    InnerProductSpace(size_t dim, knowhere::DataType data_type = knowhere::DataType::kFloat32) {
         fstdistfunc_ = InnerProductDistance;
 #if 0 /* use FAISS distance calculation algorithm instead */
 #if defined(USE_AVX) || defined(USE_SSE) || defined(USE_AVX512)
@@ -360,8 +385,20 @@ class InnerProductSpace : public SpaceInterface<float> {
             fstdistfunc_ = InnerProductDistanceSIMD4ExtResiduals;
 #endif
 #endif
+        if (data_type == knowhere::DataType::kFloat16) {
+            fstdistfunc_ = InnerProductDistanceFp16;
+        } else if (data_type == knowhere::DataType::kBFloat16) {
+            fstdistfunc_ = InnerProductDistanceBf16;
+        }
+        querydistfunc_ = fstdistfunc_;
+        if (data_type == knowhere::DataType::kFloat16) {
+            querydistfunc_ = InnerProductDistanceFp32Fp16;
+        } else if (data_type == knowhere::DataType::kBFloat16) {
+            querydistfunc_ = InnerProductDistanceFp32Bf16;
+        }
         dim_ = dim;
-        data_size_ = dim * sizeof(float);
+        data_type_ = data_type;
+        data_size_ = dim * knowhere::DataTypeSize(data_type);
     }
 
     size_t
@@ -374,11 +411,21 @@ class InnerProductSpace : public SpaceInterface<float> {
         return fstdistfunc_;
     }
 
+    DISTFUNC<float>
+    get_query_dist_func() {
+        return querydistfunc_;
+    }
+
     void*
     get_dist_func_param() {
         return &dim_;
     }
 
+    knowhere::DataType
+    get_data_type() {
+        return data_type_;
+    }
+
     ~InnerProductSpace() {
     }
 };
@@ -25,6 +25,27 @@ L2Sqr(const void* pVect1v, const void* pVect2v, const void* qty_ptr) {
 #endif
 }
 
+static float
+L2SqrFp16(const void* pVect1v, const void* pVect2v, const void* qty_ptr) {
+    return faiss::fp16_vec_L2sqr((const uint16_t*)pVect1v, (const uint16_t*)pVect2v, *((size_t*)qty_ptr));
+}
+
+static float
+L2SqrBf16(const void* pVect1v, const void* pVect2v, const void* qty_ptr) {
+    return faiss::bf16_vec_L2sqr((const uint16_t*)pVect1v, (const uint16_t*)pVect2v, *((size_t*)qty_ptr));
+}
+
+// fp32 query against fp16 / bf16 data
+static float
+L2SqrFp32Fp16(const void* pVect1v, const void* pVect2v, const void* qty_ptr) {
+    return faiss::fvec_fp16_L2sqr((const float*)pVect1v, (const uint16_t*)pVect2v, *((size_t*)qty_ptr));
+}
+
+static float
+L2SqrFp32Bf16(const void* pVect1v, const void* pVect2v, const void* qty_ptr) {
+    return faiss::fvec_bf16_L2sqr((const float*)pVect1v, (const uint16_t*)pVect2v, *((size_t*)qty_ptr));
+}
+
 #if defined(USE_AVX512)
 
 // Favor using AVX512 if available.
@@ -210,11 +231,13 @@ L2SqrSIMD4ExtResiduals(const void* pVect1v, const void* pVect2v, const void* qty
 
 class L2Space : public SpaceInterface<float> {
     DISTFUNC<float> fstdistfunc_;
+    DISTFUNC<float> querydistfunc_;
     size_t data_size_;
     size_t dim_;
+    knowhere::DataType data_type_;
 
  public:
-    L2Space(size_t dim) {
+    L2Space(size_t dim, knowhere::DataType data_type = knowhere::DataType::kFloat32) {
         fstdistfunc_ = L2Sqr;
 #if 0 /* use FAISS distance calculation algorithm instead */
 #if defined(USE_SSE) || defined(USE_AVX) || defined(USE_AVX512)
@@ -238,8 +261,17 @@ class L2Space : public SpaceInterface<float> {
             fstdistfunc_ = L2SqrSIMD4ExtResiduals;
 #endif
 #endif
+        querydistfunc_ = fstdistfunc_;
+        if (data_type == knowhere::DataType::kFloat16) {
+            fstdistfunc_ = L2SqrFp16;
+            querydistfunc_ = L2SqrFp32Fp16;
+        } else if (data_type == knowhere::DataType::kBFloat16) {
+            fstdistfunc_ = L2SqrBf16;
+            querydistfunc_ = L2SqrFp32Bf16;
+        }
         dim_ = dim;
-        data_size_ = dim * sizeof(float);
+        data_type_ = data_type;
+        data_size_ = dim * knowhere::DataTypeSize(data_type);
     }
 
     size_t
@@ -252,11 +284,21 @@ class L2Space : public SpaceInterface<float> {
         return fstdistfunc_;
     }
 
+    DISTFUNC<float>
+    get_query_dist_func() {
+        return querydistfunc_;
+    }
+
     void*
     get_dist_func_param() {
         return &dim_;
     }
 
+    knowhere::DataType
+    get_data_type() {
+        return data_type_;
+    }
+
     ~L2Space() {
     }
 };
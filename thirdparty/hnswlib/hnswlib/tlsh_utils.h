@@ -4171,9 +4171,9 @@ namespace tlsh {
         }
     }
 
-    static void transform_lsh_bin(const void* lsh_bytes, int size)
+    static inline void transform_lsh_bin(const void* lsh_bytes, int size)
     {
-        if ((lsh_bytes == nullptr) || (size < sizeof(lsh_bin_struct))) {
+        if ((lsh_bytes == nullptr) || (size < static_cast<int>(sizeof(lsh_bin_struct)))) {
             return;
         }
         lsh_bin_struct* tmp = (lsh_bin_struct*)lsh_bytes;
@@ -4185,7 +4185,8 @@ namespace tlsh {
         reverse_bytes(tmp->tmp_code, CODE_SIZE);
     }
 
-    static int diff(const lsh_bin_struct *lsh_bin_l, const lsh_bin_struct *lsh_bin_r)
+    // distance of the checksum, length and quartile ratios, i.e. everything but the body
+    static inline int diff_header(const lsh_bin_struct *lsh_bin_l, const lsh_bin_struct *lsh_bin_r)
     {
         int diff = 0;
 
@@ -4216,8 +4217,11 @@ namespace tlsh {
             }
         }
 
-        diff += h_distance(CODE_SIZE, lsh_bin_l->tmp_code, lsh_bin_r->tmp_code);
-
         return (diff);
     }
+
+    static inline int diff(const lsh_bin_struct *lsh_bin_l, const lsh_bin_struct *lsh_bin_r)
+    {
+        return diff_header(lsh_bin_l, lsh_bin_r) + h_distance(CODE_SIZE, lsh_bin_l->tmp_code, lsh_bin_r->tmp_code);
+    }
 }
@@ -1,13 +1,76 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace hnswlib {
 
+///////////////////////////////////////////////////////////
+//
+// Visited set of a single search. A node is visited iff its tag equals the
+// current epoch, so starting a new search only bumps the epoch; the tags are
+// cleared once every 255 searches when the epoch wraps around.
+//
+/////////////////////////////////////////////////////////
+
+class VisitedList {
+ public:
+    using tag_t = uint8_t;
+
+    explicit VisitedList(int numelements) : tags_(numelements, 0) {
+    }
+
+    void
+    reset() {
+        if (++epoch_ == 0) {
+            std::fill(tags_.begin(), tags_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    bool
+    get(int64_t id) const {
+        return tags_[id] == epoch_;
+    }
+
+    void
+    set(int64_t id) {
+        tags_[id] = epoch_;
+    }
+
+    void
+    prefetch(int64_t id) const {
+        __builtin_prefetch(tags_.data() + id);
+    }
+
+    // room for the (id, status) of n neighbors gathered by one hop of the level 0 search, kept with the list of the
+    // thread so that searches do not allocate it
+    std::pair<uint32_t, int>*
+    neighbors(size_t n) {
+        if (neighbors_.size() < n) {
+            neighbors_.resize(n);
+        }
+        return neighbors_.data();
+    }
+
+    int64_t
+    size() const {
+        return tags_.size() * sizeof(tag_t) + neighbors_.size() * sizeof(neighbors_[0]) + sizeof(*this);
+    }
+
+ private:
+    std::vector<tag_t> tags_;
+    tag_t epoch_ = 0;
+    std::vector<std::pair<uint32_t, int>> neighbors_;
+};
+
 ///////////////////////////////////////////////////////////
 //
 // Class for multi-threaded pool-management of VisitedLists
@@ -16,30 +79,52 @@ namespace hnswlib {
 
 class VisitedListPool {
     int numelements;
-    std::unordered_map<std::thread::id, std::vector<bool>> map;
+    // unique across all pools, so a thread local cache entry never matches a
+    // destroyed pool that happened to live at the same address
+    uint64_t pool_id;
+    std::unordered_map<std::thread::id, std::unique_ptr<VisitedList>> map;
     std::mutex mtx;
 
+    static uint64_t
+    nextPoolId() {
+        static std::atomic<uint64_t> next_id{1};
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
  public:
-    VisitedListPool(int numelements1) {
-        numelements = numelements1;
+    VisitedListPool(int numelements1) : numelements(numelements1), pool_id(nextPoolId()) {
     }
 
-    std::vector<bool>&
+    // Returns the visited list owned by the calling thread, already reset.
+    // The mutex is only taken the first time a thread uses this pool, or when
+    // it switches between pools.
+    VisitedList&
     getFreeVisitedList() {
-        std::unique_lock lk(mtx);
-        auto& res = map[std::this_thread::get_id()];
-        lk.unlock();
-        if (res.size() != numelements) {
-            res.assign(numelements, false);
-        } else {
-            std::fill(res.begin(), res.end(), false);
+        struct Cache {
+            uint64_t pool_id = 0;
+            VisitedList* list = nullptr;
+        };
+        thread_local Cache cache;
+        if (cache.pool_id != pool_id) {
+            std::lock_guard lk(mtx);
+            auto& res = map[std::this_thread::get_id()];
+            if (res == nullptr) {
+                res = std::make_unique<VisitedList>(numelements);
+            }
+            cache = {pool_id, res.get()};
         }
-        return res;
+        cache.list->reset();
+        return *cache.list;
     };
 
     int64_t
     size() {
-        return numelements * (sizeof(std::thread::id) + numelements / 8) + sizeof(*this);
+        std::lock_guard lk(mtx);
+        int64_t res = sizeof(*this);
+        for (auto& [id, list] : map) {
+            res += sizeof(id) + list->size();
+        }
+        return res;
     }
 };
 }  // namespace hnswlib